@@ -34,6 +34,11 @@
 #define PSM_WANMANAGER_IF_TYPE                              "dmsb.wanmanager.if.%d.Type"
 #define PSM_WANMANAGER_IF_PRIORITY                          "dmsb.wanmanager.if.%d.Priority"
 #define PSM_WANMANAGER_IF_SELECTIONTIMEOUT                  "dmsb.wanmanager.if.%d.SelectionTimeout"
+#define PSM_WANMANAGER_IF_WEIGHT                            "dmsb.wanmanager.if.%d.Weight"
+#define PSM_WANMANAGER_IF_PROBE_INTERVAL                    "dmsb.wanmanager.if.%d.ProbeInterval"
+#define PSM_WANMANAGER_IF_PROBE_FAILURECOUNT                "dmsb.wanmanager.if.%d.ProbeFailureCount"
+#define PSM_WANMANAGER_IF_PROBE_METHODS                     "dmsb.wanmanager.if.%d.ProbeMethods"
+#define PSM_WANMANAGER_IF_PROBE_HOST                        "dmsb.wanmanager.if.%d.ProbeHost"
 #define PSM_WANMANAGER_IF_DYNTRIGGERENABLE                  "dmsb.wanmanager.if.%d.DynTriggerEnable"
 #define PSM_WANMANAGER_IF_DYNTRIGGERDELAY                   "dmsb.wanmanager.if.%d.DynTriggerDelay"
 #define PSM_WANMANAGER_IF_WAN_ENABLE_MAPT                   "dmsb.wanmanager.if.%d.EnableMAPT"
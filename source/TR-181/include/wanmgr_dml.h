@@ -20,6 +20,7 @@
 #ifndef  _WANMGR_DML_H_
 #define  _WANMGR_DML_H_
 
+#include <netinet/in.h>
 #include "ipc_msg.h"
 
 #define PAM_COMPONENT_NAME          "eRT.com.cisco.spvtg.ccsp.pam"
@@ -216,6 +217,14 @@ typedef struct _DML_WANIFACE_WANCFG_VALID
     BOOL                        PadiPado;
 } DML_WANIFACE_WANCFG_VALID;
 
+typedef struct _DML_WANIFACE_PROBE
+{
+    UINT                        Interval;           /* ms between probe rounds, 0 disables probing */
+    UINT                        FailureCount;       /* rounds lost in a row before the connection is down */
+    CHAR                        Methods[BUFLEN_64]; /* comma separated list of Gateway, ICMP, DNS */
+    CHAR                        Host[BUFLEN_64];    /* ICMP target, the gateway if empty */
+} DML_WANIFACE_PROBE;
+
 typedef struct _DML_WANIFACE_INFO
 {
     CHAR                        Name[BUFLEN_64];
@@ -223,6 +232,8 @@ typedef struct _DML_WANIFACE_INFO
     INT                         Priority;
     DML_WAN_IFACE_TYPE          Type;
     UINT                        SelectionTimeout;
+    UINT                        Weight;             /* share of new flows in MULTIWAN_MODE */
+    DML_WANIFACE_PROBE          Probe;
     BOOL                        EnableMAPT;
     BOOL                        EnableDSLite;
     BOOL                        EnableIPoE;
@@ -231,6 +242,7 @@ typedef struct _DML_WANIFACE_INFO
     DML_WAN_IFACE_LINKSTATUS    LinkStatus;
     BOOL                        Refresh;
     DML_WANIFACE_WANCFG_VALID   Validation;
+    BOOL                        ValidationFailed;   /* last validation got no answer, set by the state machine */
 } DML_WANIFACE_INFO;
 
 typedef struct _DML_WANIFACE_DYNTRIGGER
@@ -240,6 +252,18 @@ typedef struct _DML_WANIFACE_DYNTRIGGER
 } DML_WANIFACE_DYNTRIGGER;
 
 
+/* Binary form of the IPv4 lease, parsed once when the IPC message is ingested.
+ * All members are 32 bit wide so the block can be compared with memcmp(). */
+typedef struct _WANMGR_IPV4_ADDR_BIN
+{
+    struct in_addr ip;
+    struct in_addr mask;
+    struct in_addr gateway;
+    struct in_addr dnsServer;
+    struct in_addr dnsServer1;
+    uint32_t       prefixLen;          /** Number of bits set in mask */
+} WANMGR_IPV4_ADDR_BIN;
+
 typedef struct _WANMGR_IPV4_DATA
 {
     char ifname[BUFLEN_64];
@@ -248,8 +272,22 @@ typedef struct _WANMGR_IPV4_DATA
     char gateway[BUFLEN_32];           /** New gateway, if addressAssigned==TRUE */
     char dnsServer[BUFLEN_64];         /** New dns Server, if addressAssigned==TRUE */
     char dnsServer1[BUFLEN_64];        /** New dns Server, if addressAssigned==TRUE */
+    WANMGR_IPV4_ADDR_BIN bin;          /** Binary copy of the fields above */
 } WANMGR_IPV4_DATA;
 
+/* Binary form of the IPv6 lease, parsed once when the IPC message is ingested. */
+typedef struct _WANMGR_IPV6_ADDR_BIN
+{
+    struct in6_addr address;
+    struct in6_addr pdIfAddress;
+    struct in6_addr nameserver;
+    struct in6_addr nameserver1;
+    struct in6_addr sitePrefix;
+    uint32_t        addressLen;
+    uint32_t        pdIfAddressLen;
+    uint32_t        sitePrefixLen;
+} WANMGR_IPV6_ADDR_BIN;
+
 
 typedef struct _WANMGR_IPV6_DATA
 {
@@ -263,6 +301,7 @@ typedef struct _WANMGR_IPV6_DATA
    uint32_t prefixPltime;
    uint32_t prefixVltime;
    char sitePrefixOld[BUFLEN_48]; /**< add support for RFC7084 requirement L-13 */
+   WANMGR_IPV6_ADDR_BIN bin;      /**< Binary copy of the address fields above */
 } WANMGR_IPV6_DATA;
 
 
@@ -1512,7 +1512,7 @@ Server2_GetEntry
     ANSC_STATUS                       returnStatus    = ANSC_STATUS_SUCCESS;
     PDHCPCV6_CONTEXT_LINK_OBJECT pCxtLink        = (PDHCPCV6_CONTEXT_LINK_OBJECT)hInsContext;
 
-    *pInsNumber  = nIndex + 1; 
+    *pInsNumber  = pCxtLink->pServerInsNum[nIndex];
 
     return (ANSC_HANDLE)&pCxtLink->pServerEntry[nIndex]; /* return the handle */
 }
@@ -1597,13 +1597,6 @@ Server2_Synchronize
     PDHCPCV6_CONTEXT_LINK_OBJECT pCxtLink        = (PDHCPCV6_CONTEXT_LINK_OBJECT)hInsContext;
     PDML_DHCPCV6_SVR             pDhcpcServer    = NULL;
     ULONG                             count           = 0;
-    
-    if ( pCxtLink->pServerEntry )
-    {
-        AnscFreeMemory(pCxtLink->pServerEntry);
-        pCxtLink->pServerEntry   = NULL;
-        pCxtLink->NumberOfServer = 0;
-    }
 
     returnStatus = WanMgr_DmlDhcpv6cGetServerCfg
                     (
@@ -1615,8 +1608,25 @@ Server2_Synchronize
 
     if ( returnStatus == ANSC_STATUS_SUCCESS )
     {
-        pCxtLink->pServerEntry    = pDhcpcServer;
-        pCxtLink->NumberOfServer  = count;
+        /* only touch the rows that changed, the table buffer is kept */
+        WanMgr_DmlSyncTable
+            (
+                (PVOID*)&pCxtLink->pServerEntry,
+                &pCxtLink->NumberOfServer,
+                &pCxtLink->CapacityOfServer,
+                &pCxtLink->pServerInsNum,
+                &pCxtLink->maxInstanceOfServer,
+                pDhcpcServer,
+                count,
+                sizeof(DML_DHCPCV6_SVR),
+                WanMgr_DmlDhcpv6cServerKeyMatch,
+                WanMgr_DmlDhcpv6cServerRowEqual
+            );
+    }
+
+    if ( pDhcpcServer )
+    {
+        AnscFreeMemory(pDhcpcServer);
     }
 
     return returnStatus;
@@ -2922,7 +2932,7 @@ ReceivedOption_GetEntry
     ANSC_STATUS                       returnStatus    = ANSC_STATUS_SUCCESS;
     PDHCPCV6_CONTEXT_LINK_OBJECT pCxtLink        = (PDHCPCV6_CONTEXT_LINK_OBJECT)hInsContext;
 
-    *pInsNumber  = nIndex + 1; 
+    *pInsNumber  = pCxtLink->pRecvInsNum[nIndex];
 
     return (ANSC_HANDLE)&pCxtLink->pRecvEntry[nIndex]; /* return the handle */
 }
@@ -3007,13 +3017,6 @@ ReceivedOption_Synchronize
     PDHCPCV6_CONTEXT_LINK_OBJECT pCxtLink        = (PDHCPCV6_CONTEXT_LINK_OBJECT)hInsContext;
     PDML_DHCPCV6_RECV            pDhcpcRecv      = NULL;
     ULONG                             count           = 0;
-    
-    if ( pCxtLink->pRecvEntry )
-    {
-        AnscFreeMemory(pCxtLink->pRecvEntry);
-        pCxtLink->pRecvEntry   = NULL;
-        pCxtLink->NumberOfRecv = 0;
-    }
 
     returnStatus = WanMgr_DmlDhcpv6cGetReceivedOptionCfg
                     (
@@ -3025,8 +3028,25 @@ ReceivedOption_Synchronize
 
     if ( returnStatus == ANSC_STATUS_SUCCESS )
     {
-        pCxtLink->pRecvEntry    = pDhcpcRecv;
-        pCxtLink->NumberOfRecv  = count;
+        /* only touch the rows that changed, the table buffer is kept */
+        WanMgr_DmlSyncTable
+            (
+                (PVOID*)&pCxtLink->pRecvEntry,
+                &pCxtLink->NumberOfRecv,
+                &pCxtLink->CapacityOfRecv,
+                &pCxtLink->pRecvInsNum,
+                &pCxtLink->maxInstanceOfRecv,
+                pDhcpcRecv,
+                count,
+                sizeof(DML_DHCPCV6_RECV),
+                WanMgr_DmlDhcpv6cRecvKeyMatch,
+                WanMgr_DmlDhcpv6cRecvRowEqual
+            );
+    }
+
+    if ( pDhcpcRecv )
+    {
+        AnscFreeMemory(pDhcpcRecv);
     }
 
     return returnStatus;
@@ -506,6 +506,21 @@ BOOL WanIfCfg_GetParamUlongValue(ANSC_HANDLE hInsContext, char* ParamName, ULONG
                 *puLong = pWanDmlIface->Wan.SelectionTimeout;
                 ret = TRUE;
             }
+            if( AnscEqualString(ParamName, "Weight", TRUE))
+            {
+                *puLong = pWanDmlIface->Wan.Weight;
+                ret = TRUE;
+            }
+            if( AnscEqualString(ParamName, "ProbeInterval", TRUE))
+            {
+                *puLong = pWanDmlIface->Wan.Probe.Interval;
+                ret = TRUE;
+            }
+            if( AnscEqualString(ParamName, "ProbeFailureCount", TRUE))
+            {
+                *puLong = pWanDmlIface->Wan.Probe.FailureCount;
+                ret = TRUE;
+            }
             if( AnscEqualString(ParamName, "Status", TRUE))
             {
                 *puLong = pWanDmlIface->Wan.Status;
@@ -580,6 +595,25 @@ BOOL WanIfCfg_SetParamUlongValue(ANSC_HANDLE hInsContext, char* ParamName, ULONG
                 pWanDmlIface->Wan.SelectionTimeout = uValue;
                 ret = TRUE;
             }
+            if( AnscEqualString(ParamName, "Weight", TRUE))
+            {
+                pWanDmlIface->Wan.Weight = uValue;
+                ret = TRUE;
+            }
+            if( AnscEqualString(ParamName, "ProbeInterval", TRUE))
+            {
+                pWanDmlIface->Wan.Probe.Interval = uValue;
+                ret = TRUE;
+            }
+            if( AnscEqualString(ParamName, "ProbeFailureCount", TRUE))
+            {
+                /* a single lost round must not take the connection down */
+                if (uValue >= 2)
+                {
+                    pWanDmlIface->Wan.Probe.FailureCount = uValue;
+                    ret = TRUE;
+                }
+            }
             if( AnscEqualString(ParamName, "Type", TRUE))
             {
                 IfIndex =  pWanDmlIface->uiIfaceIdx;
@@ -808,16 +842,35 @@ ULONG WanIfCfg_GetParamStringValue(ANSC_HANDLE hInsContext, char* ParamName, cha
         if(pWanDmlIfaceData != NULL)
         {
             DML_WAN_IFACE* pWanDmlIface = &(pWanDmlIfaceData->data);
+            char* pString = NULL;
+            ULONG len = 0;
+
+            /* check the parameter name and return the corresponding value */
+            if( AnscEqualString(ParamName, "ProbeMethods", TRUE) )
+            {
+                pString = pWanDmlIface->Wan.Probe.Methods;
+                len = sizeof( pWanDmlIface->Wan.Probe.Methods );
+            }
+            else if( AnscEqualString(ParamName, "ProbeHost", TRUE) )
+            {
+                pString = pWanDmlIface->Wan.Probe.Host;
+                len = sizeof( pWanDmlIface->Wan.Probe.Host );
+            }
+            else
+            {
+                pString = pWanDmlIface->Wan.Name;
+                len = sizeof( pWanDmlIface->Wan.Name );
+            }
 
             /* collect value */
-            if ( ( sizeof( pWanDmlIface->Wan.Name ) - 1 ) < *pUlSize )
+            if ( ( len - 1 ) < *pUlSize )
             {
-                AnscCopyString( pValue, pWanDmlIface->Wan.Name );
+                AnscCopyString( pValue, pString );
                 ret = 0;
             }
             else
             {
-                *pUlSize = sizeof( pWanDmlIface->Wan.Name );
+                *pUlSize = len;
                 ret = 1;
             }
 
@@ -870,6 +923,16 @@ BOOL WanIfCfg_SetParamStringValue(ANSC_HANDLE hInsContext, char* ParamName, char
                 AnscCopyString(pWanDmlIface->Wan.Name, pString);
                 ret = TRUE;
             }
+            if( AnscEqualString(ParamName, "ProbeMethods", TRUE) && (strlen(pString) < sizeof(pWanDmlIface->Wan.Probe.Methods)))
+            {
+                AnscCopyString(pWanDmlIface->Wan.Probe.Methods, pString);
+                ret = TRUE;
+            }
+            if( AnscEqualString(ParamName, "ProbeHost", TRUE) && (strlen(pString) < sizeof(pWanDmlIface->Wan.Probe.Host)))
+            {
+                AnscCopyString(pWanDmlIface->Wan.Probe.Host, pString);
+                ret = TRUE;
+            }
 
             WanMgrDml_GetIfaceData_release(pWanDmlIfaceData);
         }
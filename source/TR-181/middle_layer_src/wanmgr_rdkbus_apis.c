@@ -138,6 +138,41 @@ static int get_Wan_Interface_ParametersFromPSM(ULONG instancenum, DML_WAN_IFACE*
         ((CCSP_MESSAGE_BUS_INFO *)bus_handle)->freefunc(param_value);
     }
 
+    _PSM_READ_PARAM(PSM_WANMANAGER_IF_WEIGHT);
+    if (retPsmGet == CCSP_SUCCESS)
+    {
+        _ansc_sscanf(param_value, "%u", &(p_Interface->Wan.Weight));
+        ((CCSP_MESSAGE_BUS_INFO *)bus_handle)->freefunc(param_value);
+    }
+
+    _PSM_READ_PARAM(PSM_WANMANAGER_IF_PROBE_INTERVAL);
+    if (retPsmGet == CCSP_SUCCESS)
+    {
+        _ansc_sscanf(param_value, "%u", &(p_Interface->Wan.Probe.Interval));
+        ((CCSP_MESSAGE_BUS_INFO *)bus_handle)->freefunc(param_value);
+    }
+
+    _PSM_READ_PARAM(PSM_WANMANAGER_IF_PROBE_FAILURECOUNT);
+    if (retPsmGet == CCSP_SUCCESS)
+    {
+        _ansc_sscanf(param_value, "%u", &(p_Interface->Wan.Probe.FailureCount));
+        ((CCSP_MESSAGE_BUS_INFO *)bus_handle)->freefunc(param_value);
+    }
+
+    _PSM_READ_PARAM(PSM_WANMANAGER_IF_PROBE_METHODS);
+    if (retPsmGet == CCSP_SUCCESS)
+    {
+        AnscCopyString(p_Interface->Wan.Probe.Methods, param_value);
+        ((CCSP_MESSAGE_BUS_INFO *)bus_handle)->freefunc(param_value);
+    }
+
+    _PSM_READ_PARAM(PSM_WANMANAGER_IF_PROBE_HOST);
+    if (retPsmGet == CCSP_SUCCESS)
+    {
+        AnscCopyString(p_Interface->Wan.Probe.Host, param_value);
+        ((CCSP_MESSAGE_BUS_INFO *)bus_handle)->freefunc(param_value);
+    }
+
     _PSM_READ_PARAM(PSM_WANMANAGER_IF_WAN_ENABLE_MAPT);
     if (retPsmGet == CCSP_SUCCESS)
     {
@@ -384,8 +419,23 @@ static int write_Wan_Interface_ParametersFromPSM(ULONG instancenum, DML_WAN_IFAC
     _ansc_sprintf(param_value, "%d", p_Interface->Wan.Priority );
     _PSM_WRITE_PARAM(PSM_WANMANAGER_IF_PRIORITY);
 
-    _PSM_WRITE_PARAM(PSM_WANMANAGER_IF_SELECTIONTIMEOUT);
+    _ansc_sprintf(param_value, "%u", p_Interface->Wan.Weight );
+    _PSM_WRITE_PARAM(PSM_WANMANAGER_IF_WEIGHT);
+
+    _ansc_sprintf(param_value, "%u", p_Interface->Wan.Probe.Interval );
+    _PSM_WRITE_PARAM(PSM_WANMANAGER_IF_PROBE_INTERVAL);
+
+    _ansc_sprintf(param_value, "%u", p_Interface->Wan.Probe.FailureCount );
+    _PSM_WRITE_PARAM(PSM_WANMANAGER_IF_PROBE_FAILURECOUNT);
+
+    _ansc_sprintf(param_value, "%s", p_Interface->Wan.Probe.Methods );
+    _PSM_WRITE_PARAM(PSM_WANMANAGER_IF_PROBE_METHODS);
+
+    _ansc_sprintf(param_value, "%s", p_Interface->Wan.Probe.Host );
+    _PSM_WRITE_PARAM(PSM_WANMANAGER_IF_PROBE_HOST);
+
     _ansc_sprintf(param_value, "%d", p_Interface->Wan.SelectionTimeout );
+    _PSM_WRITE_PARAM(PSM_WANMANAGER_IF_SELECTIONTIMEOUT);
 
     if(p_Interface->DynamicTrigger.Enable) {
         _ansc_sprintf(param_value, "TRUE");
@@ -17,46 +17,74 @@
  * limitations under the License.
 */
 
+#include <unistd.h>
 #include "ansc_platform.h"
 #include "wanmgr_controller.h"
 #include "wanmgr_rdkbus_utils.h"
 #include "wanmgr_data.h"
+#include "wanmgr_net_utils.h"
 
 
-ANSC_STATUS WanController_Policy_Change(void)
+#define POLICY_SWITCH_POLL_US 500000 // poll interval while no policy is running
+
+static DML_WAN_POLICY WanController_GetPolicy(void)
 {
-    /* Wan policy changed. Cpe needs a restart! */
-    FILE *fp = NULL;
-    char value[25] = {0};
-    char cmd[128] = {0};
-    char acOutput[64] = {0};
-    int seconds = 30;
-    int rebootCount = 1;
-
-    memset(value, 0, sizeof(value));
-    fp = popen("syscfg get X_RDKCENTRAL-COM_LastRebootCounter", "r");
-    if (fp == NULL) {
-        return ANSC_STATUS_FAILURE;
+    DML_WAN_POLICY wan_policy = FIXED_MODE;
+
+    WanMgr_Config_Data_t* pWanConfigData = WanMgr_GetConfigData_locked();
+    if(pWanConfigData != NULL)
+    {
+        wan_policy = pWanConfigData->data.Policy;
+
+        WanMgrDml_GetConfigData_release(pWanConfigData);
     }
-    pclose(fp);
 
-    rebootCount = atoi(value);
+    return wan_policy;
+}
+
+/* Returns TRUE if an interface state machine runs on any interface but exceptIdx */
+static BOOL WanController_IfaceSMRunning(INT exceptIdx)
+{
+    BOOL bRunning = FALSE;
+    UINT uiLoopCount;
+    UINT uiTotalIfaces = 0;
+
+    WanMgr_IfaceCtrl_Data_t*   pWanIfaceCtrl = WanMgr_GetIfaceCtrl_locked();
+    if(pWanIfaceCtrl != NULL)
+    {
+        uiTotalIfaces = pWanIfaceCtrl->ulTotalNumbWanInterfaces;
 
-    CcspTraceInfo(("Updating the last reboot reason and last reboot counter\n"));
-    sprintf(cmd, "syscfg set X_RDKCENTRAL-COM_LastRebootReason Wan_Policy_Change ");
-    system(cmd);
-    sprintf(cmd, "syscfg set X_RDKCENTRAL-COM_LastRebootCounter %d ",rebootCount);
-    system(cmd);
-    system("syscfg commit");
+        WanMgrDml_GetIfaceCtrl_release(pWanIfaceCtrl);
+    }
 
-    while(seconds > 0)
+    for( uiLoopCount = 0; uiLoopCount < uiTotalIfaces; uiLoopCount++ )
     {
-        printf("...(%d)...\n", seconds);
-        seconds -= 10;
-        sleep(10);
+        if((INT)uiLoopCount == exceptIdx)
+        {
+            continue;
+        }
+
+        WanMgr_Iface_Data_t*   pWanDmlIfaceData = WanMgr_GetIfaceData_locked(uiLoopCount);
+        if(pWanDmlIfaceData != NULL)
+        {
+            if(pWanDmlIfaceData->SMRunning == TRUE)
+            {
+                bRunning = TRUE;
+            }
+
+            WanMgrDml_GetIfaceData_release(pWanDmlIfaceData);
+        }
     }
 
-    system("/rdklogger/backupLogs.sh true");
+    return bRunning;
+}
+
+ANSC_STATUS WanController_Policy_Change(void)
+{
+    /* The running policy notices the new value on its next loop and hands
+       its interfaces over, no reboot is needed. Called with the config
+       data locked, so do not lock it here. */
+    CcspTraceInfo(("%s %d - Wan policy change requested, switching policy\n", __FUNCTION__, __LINE__));
 
     return ANSC_STATUS_SUCCESS;
 }
@@ -66,53 +94,52 @@ ANSC_STATUS WanController_Start_StateMachine(DML_WAN_POLICY swan_policy)
 {
     ANSC_STATUS retStatus = ANSC_STATUS_FAILURE;
     DML_WAN_POLICY wan_policy = FIXED_MODE;
-    int iErrorCode = 0;
 
     CcspTraceInfo(("%s %d \n", __FUNCTION__, __LINE__ ));
 
-    //Get Policy
-    WanMgr_Config_Data_t* pWanConfigData = WanMgr_GetConfigData_locked();
-    if(pWanConfigData != NULL)
+    //Run the configured policy, a policy returns when the configured one changes
+    for(;;)
     {
-        DML_WANMGR_CONFIG* pWanConfig = &(pWanConfigData->data);
-
-        wan_policy = pWanConfig->Policy;
-
-        WanMgrDml_GetConfigData_release(pWanConfigData);
-    }
-
-
-    //Starts wan controller threads
-    switch (wan_policy) {
-        case FIXED_MODE:
-            retStatus = WanMgr_Policy_FixedModePolicy();
-            break;
-
-        case FIXED_MODE_ON_BOOTUP:
-            retStatus = WanMgr_Policy_FixedModeOnBootupPolicy();
-            break;
-
-        case PRIMARY_PRIORITY:
-            retStatus = WanMgr_Policy_PrimaryPriorityPolicy();
-            break;
-
-        case PRIMARY_PRIORITY_ON_BOOTUP:
-            retStatus = WanMgr_Policy_PrimaryPriorityOnBootupPolicy();
-            break;
-
-        case MULTIWAN_MODE:
-            break;
+        wan_policy = WanController_GetPolicy();
+        retStatus = ANSC_STATUS_FAILURE;
+
+        CcspTraceInfo(("%s %d - Starting policy %d\n", __FUNCTION__, __LINE__, wan_policy ));
+
+        switch (wan_policy) {
+            case FIXED_MODE:
+                retStatus = WanMgr_Policy_FixedModePolicy();
+                break;
+
+            case FIXED_MODE_ON_BOOTUP:
+                retStatus = WanMgr_Policy_FixedModeOnBootupPolicy();
+                break;
+
+            case PRIMARY_PRIORITY:
+                retStatus = WanMgr_Policy_PrimaryPriorityPolicy();
+                break;
+
+            case PRIMARY_PRIORITY_ON_BOOTUP:
+                retStatus = WanMgr_Policy_PrimaryPriorityOnBootupPolicy();
+                break;
+
+            case MULTIWAN_MODE:
+                retStatus = WanMgr_Policy_MultiWanPolicy();
+                break;
+        }
+
+        if( ANSC_STATUS_SUCCESS != retStatus )
+        {
+            CcspTraceInfo(("%s %d Error: Failed to run policy %d error code: %lu \n", __FUNCTION__, __LINE__, wan_policy, retStatus ));
+
+            //Nothing can run this policy, wait for another one to be configured
+            while(WanController_GetPolicy() == wan_policy)
+            {
+                usleep(POLICY_SWITCH_POLL_US);
+            }
+        }
     }
 
-    if( ANSC_STATUS_SUCCESS != retStatus )
-    {
-        CcspTraceInfo(("%s %d Error: Failed to start State Machine Thread error code: %d \n", __FUNCTION__, __LINE__, retStatus ));
-        retStatus = ANSC_STATUS_SUCCESS;
-    }
-
-    WanController_Policy_Change();
-
-    return retStatus;
+    return ANSC_STATUS_SUCCESS;
 }
 
 /* WanController_Init_StateMachine */
@@ -149,8 +176,89 @@ ANSC_STATUS WanMgr_Controller_PolicyCtrlInit(WanMgr_Policy_Controller_t* pWanPol
         pWanPolicyCtrl->selSecondaryInterfaceIdx = -1;
         pWanPolicyCtrl->pWanActiveIfaceData = NULL;
 
+        //Interface state machines left running by the previous policy
+        pWanPolicyCtrl->handOffPending = WanController_IfaceSMRunning(-1);
+        pWanPolicyCtrl->handOffTeardown = FALSE;
+        pWanPolicyCtrl->flowsShed = FALSE;
+
         retStatus = ANSC_STATUS_SUCCESS;
     }
 
    return retStatus;
 }
+
+BOOL WanMgr_Controller_AdoptIfaceSM(WanMgr_Policy_Controller_t* pWanPolicyCtrl, INT selectedIdx)
+{
+    BOOL bAdopted = FALSE;
+    UINT uiLoopCount;
+    UINT uiTotalIfaces = 0;
+
+    if((pWanPolicyCtrl == NULL) || (pWanPolicyCtrl->handOffPending != TRUE))
+    {
+        return FALSE;
+    }
+
+    pWanPolicyCtrl->handOffPending = FALSE;
+
+    WanMgr_IfaceCtrl_Data_t*   pWanIfaceCtrl = WanMgr_GetIfaceCtrl_locked();
+    if(pWanIfaceCtrl != NULL)
+    {
+        uiTotalIfaces = pWanIfaceCtrl->ulTotalNumbWanInterfaces;
+
+        WanMgrDml_GetIfaceCtrl_release(pWanIfaceCtrl);
+    }
+
+    for( uiLoopCount = 0; uiLoopCount < uiTotalIfaces; uiLoopCount++ )
+    {
+        WanMgr_Iface_Data_t*   pWanDmlIfaceData = WanMgr_GetIfaceData_locked(uiLoopCount);
+        if(pWanDmlIfaceData != NULL)
+        {
+            DML_WAN_IFACE* pWanIfaceData = &(pWanDmlIfaceData->data);
+
+            if(pWanDmlIfaceData->SMRunning == TRUE)
+            {
+                if((INT)uiLoopCount == selectedIdx)
+                {
+                    //Keep the running WAN up, the new policy takes it over
+                    pWanIfaceData->Wan.ActiveLink = TRUE;
+                    bAdopted = TRUE;
+
+                    //Under the multi WAN policy the state machine left the default route to the policy
+                    if(pWanIfaceData->IP.Ipv4Status == WAN_IFACE_IPV4_STATE_UP &&
+                       WanManager_AddDefaultGatewayRoute(&pWanIfaceData->IP.Ipv4Data) != RETURN_OK)
+                    {
+                        CcspTraceError(("%s %d - Failed to set up the default route of '%s'\n", __FUNCTION__, __LINE__, pWanIfaceData->Name));
+                    }
+                    CcspTraceInfo(("%s %d - Interface '%s' adopted by the new policy\n", __FUNCTION__, __LINE__, pWanIfaceData->Name));
+                }
+                else
+                {
+                    //Not selected by the new policy, let its state machine tear down
+                    pWanIfaceData->Wan.ActiveLink = FALSE;
+                    pWanPolicyCtrl->handOffTeardown = TRUE;
+                    CcspTraceInfo(("%s %d - Interface '%s' released by the new policy\n", __FUNCTION__, __LINE__, pWanIfaceData->Name));
+                }
+            }
+
+            WanMgrDml_GetIfaceData_release(pWanDmlIfaceData);
+        }
+    }
+
+    return bAdopted;
+}
+
+BOOL WanMgr_Controller_HandOffDone(WanMgr_Policy_Controller_t* pWanPolicyCtrl)
+{
+    if((pWanPolicyCtrl == NULL) || (pWanPolicyCtrl->handOffTeardown != TRUE))
+    {
+        return TRUE;
+    }
+
+    if(WanController_IfaceSMRunning(pWanPolicyCtrl->activeInterfaceIdx) == TRUE)
+    {
+        return FALSE;
+    }
+
+    pWanPolicyCtrl->handOffTeardown = FALSE;
+    return TRUE;
+}
@@ -30,6 +30,9 @@ typedef  struct _WANMGR_POLICY_CONTROLLER_
     INT                     activeInterfaceIdx;
     INT                     selSecondaryInterfaceIdx;
     WanMgr_Iface_Data_t*    pWanActiveIfaceData;
+    BOOL                    handOffPending;     /* interface SMs of the previous policy still to be adopted */
+    BOOL                    handOffTeardown;    /* interface SMs released by the hand-off still tearing down */
+    BOOL                    flowsShed;          /* new flows of a degraded WAN are steered to the standby WAN */
 } WanMgr_Policy_Controller_t;
 
 
@@ -37,11 +40,17 @@ ANSC_STATUS WanController_Init_StateMachine(void);
 ANSC_STATUS WanController_Policy_Change(void);
 ANSC_STATUS WanMgr_Controller_PolicyCtrlInit(WanMgr_Policy_Controller_t* pWanPolicyCtrl);
 
+/* Policy hand-off: on its first selection a new policy keeps the interface
+   state machine of the selected interface and releases the others */
+BOOL WanMgr_Controller_AdoptIfaceSM(WanMgr_Policy_Controller_t* pWanPolicyCtrl, INT selectedIdx);
+BOOL WanMgr_Controller_HandOffDone(WanMgr_Policy_Controller_t* pWanPolicyCtrl);
+
 
 /* Policies routines */
 ANSC_STATUS WanMgr_Policy_FixedModePolicy(void);
 ANSC_STATUS WanMgr_Policy_FixedModeOnBootupPolicy(void);
 ANSC_STATUS WanMgr_Policy_PrimaryPriorityPolicy(void);
 ANSC_STATUS WanMgr_Policy_PrimaryPriorityOnBootupPolicy(void);
+ANSC_STATUS WanMgr_Policy_MultiWanPolicy(void);
 
 #endif /*_WANMGR_CONTROLLER_H_*/
@@ -22,12 +22,20 @@
 #include "wanmgr_core.h"
 #include "wanmgr_sysevents.h"
 #include "wanmgr_rdkbus_apis.h"
+#include "wanmgr_netlink.h"
+#include "wanmgr_event_loop.h"
 
 
 ANSC_STATUS WanMgr_Core_Init(void)
 {
     ANSC_STATUS retStatus = ANSC_STATUS_SUCCESS;
 
+    //Starts the event loop, sysevent/IPC/FIFO sources register with it
+    if(WanMgr_EventLoop_Start() != ANSC_STATUS_SUCCESS)
+    {
+        CcspTraceError(("%s %d - Event loop failed to start!\n", __FUNCTION__, __LINE__ ));
+    }
+
     //Initialise system messages
     retStatus = WanMgr_SysEvents_Init();
     if(retStatus != ANSC_STATUS_SUCCESS)
@@ -35,6 +43,12 @@ ANSC_STATUS WanMgr_Core_Init(void)
         CcspTraceInfo(("%s %d - WanManager failed to initialise!\n", __FUNCTION__, __LINE__ ));
     }
 
+    //Starts the IPv6 address monitor
+    if(WanMgr_Netlink_StartAddrMonitor() != ANSC_STATUS_SUCCESS)
+    {
+        CcspTraceInfo(("%s %d - Address monitor failed to start, addresses will be dumped on demand\n", __FUNCTION__, __LINE__ ));
+    }
+
     //Starts the IPC thread
     retStatus = WanMgr_StartIpcServer();
     if(retStatus != ANSC_STATUS_SUCCESS)
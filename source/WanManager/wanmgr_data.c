@@ -165,6 +165,7 @@ void WanMgr_IfaceData_Init(WanMgr_Iface_Data_t* pIfaceData, UINT iface_index)
     {
         DML_WAN_IFACE* pWanDmlIface = &(pIfaceData->data);
 
+        pIfaceData->SMRunning = FALSE;
         pWanDmlIface->uiIfaceIdx = iface_index;
         pWanDmlIface->uiInstanceNumber = iface_index+1;
         memset(pWanDmlIface->Name, 0, 64);
@@ -176,6 +177,11 @@ void WanMgr_IfaceData_Init(WanMgr_Iface_Data_t* pIfaceData, UINT iface_index)
         pWanDmlIface->Wan.Priority = -1;
         pWanDmlIface->Wan.Type = WAN_IFACE_TYPE_UNCONFIGURED;
         pWanDmlIface->Wan.SelectionTimeout = 0;
+        pWanDmlIface->Wan.Weight = 1;
+        pWanDmlIface->Wan.Probe.Interval = 0;
+        pWanDmlIface->Wan.Probe.FailureCount = 3;
+        strncpy(pWanDmlIface->Wan.Probe.Methods, "Gateway", sizeof(pWanDmlIface->Wan.Probe.Methods));
+        memset(pWanDmlIface->Wan.Probe.Host, 0, sizeof(pWanDmlIface->Wan.Probe.Host));
         pWanDmlIface->Wan.EnableMAPT = FALSE;
         pWanDmlIface->Wan.EnableDSLite = FALSE;
         pWanDmlIface->Wan.EnableIPoE = FALSE;
@@ -187,6 +193,7 @@ void WanMgr_IfaceData_Init(WanMgr_Iface_Data_t* pIfaceData, UINT iface_index)
         pWanDmlIface->Wan.Validation.SolicitAdvertise = FALSE;
         pWanDmlIface->Wan.Validation.RS_RA = FALSE;
         pWanDmlIface->Wan.Validation.PadiPado = FALSE;
+        pWanDmlIface->Wan.ValidationFailed = FALSE;
         pWanDmlIface->DynamicTrigger.Enable = FALSE;
         pWanDmlIface->DynamicTrigger.Delay = 0;
         memset(pWanDmlIface->IP.Path, 0, 64);
@@ -37,6 +37,7 @@ typedef struct _WANMGR_CONFIG_DATA_
 typedef struct _WANMGR_IFACE_DATA_
 {
     DML_WAN_IFACE           data;
+    BOOL                    SMRunning;      /* an interface state machine thread runs on it */
 }WanMgr_Iface_Data_t;
 
 
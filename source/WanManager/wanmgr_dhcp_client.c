@@ -0,0 +1,509 @@
+/*
+ * If not stated otherwise in this file or this component's Licenses.txt file the
+ * following copyright and licenses apply:
+ *
+ * Copyright 2020 RDK Management
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+*/
+
+/* ---- Include Files ---------------------------------------- */
+#include <errno.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <net/if.h>
+#include <sys/timerfd.h>
+#include <sys/wait.h>
+#include "wanmgr_dhcp_client.h"
+#include "wanmgr_event_loop.h"
+#include "wanmgr_utils.h"
+#ifdef FEATURE_EMBEDDED_DHCPV4_CLIENT
+#include "wanmgr_dhcpv4_client.h"
+#endif
+#ifdef FEATURE_EMBEDDED_DHCPV6_CLIENT
+#include "wanmgr_dhcpv6_client.h"
+#endif
+
+/* ---- Private Types ----------------------------------------- */
+typedef enum
+{
+    DHCPC_STATE_IDLE = 0,       /* slot free */
+    DHCPC_STATE_RUNNING,
+    DHCPC_STATE_STOPPING        /* signalled to exit, not collected yet */
+} DhcpcState_t;
+
+/* How a client type is commanded, 0 if it has no such command */
+typedef struct _DhcpcSignals_t
+{
+    int     renew;
+    int     release;            /* sent ahead of stop to release the lease */
+    int     stop;
+} DhcpcSignals_t;
+
+typedef struct _DhcpcClient_t
+{
+    DhcpcState_t                state;
+    WanMgr_DhcpClientType_t     type;
+    char                        ifName[IFNAMSIZ];
+    int                         pid;
+    uint64_t                    deadlineMs;
+    BOOL                        startPending;   /* start again once collected */
+    char                        appName[BUFLEN_64];
+    char                        args[BUFLEN_256];
+} DhcpcClient_t;
+
+/* ---- Private Variables ------------------------------------ */
+/* udhcpc: SIGUSR1 renew, SIGUSR2 release. dibbler-client: SIGUSR2 renew, releases on SIGTERM. */
+static const DhcpcSignals_t gSignals[WANMGR_DHCPC_MAX_TYPES] =
+{
+    { SIGUSR1, SIGUSR2, SIGTERM },
+    { SIGUSR2, 0,       SIGTERM }
+};
+
+static DhcpcClient_t gClients[WANMGR_DHCPC_MAX_CLIENTS];
+static int gTimerFd = -1;
+static UINT gTimerMs = 0;
+static BOOL gDhcpcReady = FALSE;
+static pthread_mutex_t gDhcpcMutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_once_t gDhcpcOnce = PTHREAD_ONCE_INIT;
+
+/* ---- Private Functions ------------------------------------ */
+
+static uint64_t Dhcpc_NowMs(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t) ts.tv_sec * 1000ULL + (uint64_t) ts.tv_nsec / 1000000ULL;
+}
+
+static const char *Dhcpc_TypeName(WanMgr_DhcpClientType_t type)
+{
+    return (type == WANMGR_DHCPC_V4) ? "DHCPv4" : "DHCPv6";
+}
+
+static BOOL Dhcpc_Matches(const DhcpcClient_t *pClient, const char *ifName, WanMgr_DhcpClientType_t type)
+{
+    return (pClient->state != DHCPC_STATE_IDLE && pClient->type == type &&
+            (ifName == NULL || strcmp(pClient->ifName, ifName) == 0)) ? TRUE : FALSE;
+}
+
+/* Poll fast while a client is stopping, slowly while clients run, not at all
+ * otherwise. Called with gDhcpcMutex held. */
+static void Dhcpc_ArmTimer(void)
+{
+    struct itimerspec its;
+    UINT intervalMs = 0;
+    int idx;
+
+    for (idx = 0; idx < WANMGR_DHCPC_MAX_CLIENTS; idx++)
+    {
+        if (gClients[idx].state == DHCPC_STATE_STOPPING)
+        {
+            intervalMs = WANMGR_DHCPC_REAP_MS;
+            break;
+        }
+        if (gClients[idx].state == DHCPC_STATE_RUNNING)
+        {
+            intervalMs = WANMGR_DHCPC_WATCH_MS;
+        }
+    }
+
+    if (intervalMs == gTimerMs)
+    {
+        return;
+    }
+
+    memset(&its, 0, sizeof(its));
+    its.it_value.tv_sec = intervalMs / 1000;
+    its.it_value.tv_nsec = (long)(intervalMs % 1000) * 1000000L;
+    its.it_interval = its.it_value;
+    timerfd_settime(gTimerFd, 0, &its, NULL);
+    gTimerMs = intervalMs;
+}
+
+/* Called with gDhcpcMutex held */
+static ANSC_STATUS Dhcpc_Spawn(DhcpcClient_t *pClient)
+{
+    char exeBuf[BUFLEN_1024] = {0};
+    int pid = -1;
+
+    if (GetPathToApp(pClient->appName, exeBuf, sizeof(exeBuf) - 1) != ANSC_STATUS_SUCCESS)
+    {
+        CcspTraceError(("%s %d - could not find %s \n", __FUNCTION__, __LINE__, pClient->appName));
+        return ANSC_STATUS_FAILURE;
+    }
+
+    if (util_spawnProcess(exeBuf, pClient->args, &pid) != RETURN_OK || pid <= 0)
+    {
+        CcspTraceError(("%s %d - could not spawn %s %s \n", __FUNCTION__, __LINE__, exeBuf, pClient->args));
+        return ANSC_STATUS_FAILURE;
+    }
+
+    pClient->pid = pid;
+    pClient->state = DHCPC_STATE_RUNNING;
+    pClient->startPending = FALSE;
+    CcspTraceInfo(("%s %d - %s client of %s started, %s %s pid %d \n", __FUNCTION__, __LINE__,
+                   Dhcpc_TypeName(pClient->type), pClient->ifName, pClient->appName, pClient->args, pid));
+    return ANSC_STATUS_SUCCESS;
+}
+
+/* Called with gDhcpcMutex held */
+static void Dhcpc_Signal(DhcpcClient_t *pClient, int sig)
+{
+    if (sig != 0 && kill(pClient->pid, sig) < 0)
+    {
+        CcspTraceWarning(("%s %d - signal %d to %s pid %d failed, errno %d \n", __FUNCTION__, __LINE__,
+                          sig, pClient->appName, pClient->pid, errno));
+    }
+}
+
+static void Dhcpc_OnTimer(int fd, uint32_t events, void *arg)
+{
+    uint64_t expirations;
+    uint64_t nowMs;
+    int idx;
+    int status;
+    int rc;
+
+    (void) events;
+    (void) arg;
+
+    while (read(fd, &expirations, sizeof(expirations)) > 0);
+
+    pthread_mutex_lock(&gDhcpcMutex);
+    nowMs = Dhcpc_NowMs();
+
+    for (idx = 0; idx < WANMGR_DHCPC_MAX_CLIENTS; idx++)
+    {
+        DhcpcClient_t *pClient = &gClients[idx];
+
+        if (pClient->state == DHCPC_STATE_IDLE)
+        {
+            continue;
+        }
+
+        /* the zombie keeps the PID ours until it is collected here */
+        rc = waitpid(pClient->pid, &status, WNOHANG);
+        if (rc == pClient->pid || (rc < 0 && errno == ECHILD))
+        {
+            if (pClient->state == DHCPC_STATE_RUNNING)
+            {
+                CcspTraceWarning(("%s %d - %s client of %s pid %d exited unexpectedly, status %d \n", __FUNCTION__, __LINE__,
+                                  Dhcpc_TypeName(pClient->type), pClient->ifName, pClient->pid, (rc > 0) ? status : -1));
+            }
+            else
+            {
+                CcspTraceInfo(("%s %d - %s client of %s pid %d stopped \n", __FUNCTION__, __LINE__,
+                               Dhcpc_TypeName(pClient->type), pClient->ifName, pClient->pid));
+            }
+
+            pClient->pid = 0;
+            if (pClient->startPending == FALSE || Dhcpc_Spawn(pClient) != ANSC_STATUS_SUCCESS)
+            {
+                memset(pClient, 0, sizeof(DhcpcClient_t));
+            }
+        }
+        else if (pClient->state == DHCPC_STATE_STOPPING && nowMs >= pClient->deadlineMs)
+        {
+            CcspTraceWarning(("%s %d - %s pid %d did not exit, killing it \n", __FUNCTION__, __LINE__, pClient->appName, pClient->pid));
+            Dhcpc_Signal(pClient, SIGKILL);
+            pClient->deadlineMs = nowMs + WANMGR_DHCPC_STOP_TIMEOUT_MS;
+        }
+    }
+
+    Dhcpc_ArmTimer();
+    pthread_mutex_unlock(&gDhcpcMutex);
+}
+
+static void Dhcpc_Init(void)
+{
+    if ((gTimerFd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC)) < 0)
+    {
+        CcspTraceError(("%s %d - timerfd_create failed, errno %d \n", __FUNCTION__, __LINE__, errno));
+        return;
+    }
+
+    if (WanMgr_EventLoop_AddFd(gTimerFd, "dhcpc-reap", Dhcpc_OnTimer, NULL) != ANSC_STATUS_SUCCESS)
+    {
+        close(gTimerFd);
+        gTimerFd = -1;
+        return;
+    }
+
+    gDhcpcReady = TRUE;
+}
+
+/* ---- Global Functions ------------------------------------- */
+
+ANSC_STATUS WanMgr_DhcpClient_Start(const char *ifName, WanMgr_DhcpClientType_t type, const char *appName, const char *args)
+{
+    ANSC_STATUS ret = ANSC_STATUS_SUCCESS;
+    DhcpcClient_t *pClient = NULL;
+    int idx;
+
+    if (ifName == NULL || appName == NULL || type >= WANMGR_DHCPC_MAX_TYPES)
+    {
+        return ANSC_STATUS_BAD_PARAMETER;
+    }
+
+#ifdef FEATURE_EMBEDDED_DHCPV4_CLIENT
+    if (type == WANMGR_DHCPC_V4)
+    {
+        return WanMgr_Dhcpv4c_Start(ifName);
+    }
+#endif
+#ifdef FEATURE_EMBEDDED_DHCPV6_CLIENT
+    if (type == WANMGR_DHCPC_V6)
+    {
+        return WanMgr_Dhcpv6c_Start(ifName);
+    }
+#endif
+
+    pthread_once(&gDhcpcOnce, Dhcpc_Init);
+    if (gDhcpcReady == FALSE)
+    {
+        return ANSC_STATUS_FAILURE;
+    }
+
+    pthread_mutex_lock(&gDhcpcMutex);
+
+    for (idx = 0; idx < WANMGR_DHCPC_MAX_CLIENTS; idx++)
+    {
+        if (Dhcpc_Matches(&gClients[idx], ifName, type) == TRUE)
+        {
+            pClient = &gClients[idx];
+            break;
+        }
+        if (pClient == NULL && gClients[idx].state == DHCPC_STATE_IDLE)
+        {
+            pClient = &gClients[idx];
+        }
+    }
+
+    if (pClient == NULL)
+    {
+        CcspTraceError(("%s %d - no free client slot for %s \n", __FUNCTION__, __LINE__, ifName));
+        ret = ANSC_STATUS_RESOURCES;
+    }
+    else if (pClient->state == DHCPC_STATE_RUNNING)
+    {
+        CcspTraceInfo(("%s %d - %s client of %s already running, pid %d \n", __FUNCTION__, __LINE__, Dhcpc_TypeName(type), ifName, pClient->pid));
+    }
+    else
+    {
+        pClient->type = type;
+        snprintf(pClient->ifName, sizeof(pClient->ifName), "%s", ifName);
+        snprintf(pClient->appName, sizeof(pClient->appName), "%s", appName);
+        snprintf(pClient->args, sizeof(pClient->args), "%s", (args != NULL) ? args : "");
+
+        if (pClient->state == DHCPC_STATE_STOPPING)
+        {
+            CcspTraceInfo(("%s %d - %s client of %s still stopping, starting it once pid %d has exited \n", __FUNCTION__, __LINE__,
+                           Dhcpc_TypeName(type), ifName, pClient->pid));
+            pClient->startPending = TRUE;
+        }
+        else if ((ret = Dhcpc_Spawn(pClient)) != ANSC_STATUS_SUCCESS)
+        {
+            memset(pClient, 0, sizeof(DhcpcClient_t));
+        }
+    }
+
+    Dhcpc_ArmTimer();
+    pthread_mutex_unlock(&gDhcpcMutex);
+
+    return ret;
+}
+
+ANSC_STATUS WanMgr_DhcpClient_Renew(const char *ifName, WanMgr_DhcpClientType_t type)
+{
+    ANSC_STATUS ret = ANSC_STATUS_FAILURE;
+    int idx;
+
+    if (type >= WANMGR_DHCPC_MAX_TYPES)
+    {
+        return ANSC_STATUS_BAD_PARAMETER;
+    }
+
+#ifdef FEATURE_EMBEDDED_DHCPV4_CLIENT
+    if (type == WANMGR_DHCPC_V4)
+    {
+        return WanMgr_Dhcpv4c_Renew(ifName);
+    }
+#endif
+#ifdef FEATURE_EMBEDDED_DHCPV6_CLIENT
+    if (type == WANMGR_DHCPC_V6)
+    {
+        return WanMgr_Dhcpv6c_Renew(ifName);
+    }
+#endif
+
+    pthread_mutex_lock(&gDhcpcMutex);
+
+    for (idx = 0; idx < WANMGR_DHCPC_MAX_CLIENTS; idx++)
+    {
+        DhcpcClient_t *pClient = &gClients[idx];
+
+        if (Dhcpc_Matches(pClient, ifName, type) == TRUE && pClient->state == DHCPC_STATE_RUNNING)
+        {
+            CcspTraceInfo(("%s %d - renewing %s client of %s, pid %d \n", __FUNCTION__, __LINE__, Dhcpc_TypeName(type), pClient->ifName, pClient->pid));
+            Dhcpc_Signal(pClient, gSignals[type].renew);
+            ret = ANSC_STATUS_SUCCESS;
+        }
+    }
+
+    pthread_mutex_unlock(&gDhcpcMutex);
+
+    return ret;
+}
+
+ANSC_STATUS WanMgr_DhcpClient_Stop(const char *ifName, WanMgr_DhcpClientType_t type, BOOL release)
+{
+    int idx;
+
+    if (type >= WANMGR_DHCPC_MAX_TYPES)
+    {
+        return ANSC_STATUS_BAD_PARAMETER;
+    }
+
+#ifdef FEATURE_EMBEDDED_DHCPV4_CLIENT
+    if (type == WANMGR_DHCPC_V4)
+    {
+        return WanMgr_Dhcpv4c_Stop(ifName, release);
+    }
+#endif
+#ifdef FEATURE_EMBEDDED_DHCPV6_CLIENT
+    if (type == WANMGR_DHCPC_V6)
+    {
+        return WanMgr_Dhcpv6c_Stop(ifName, release);
+    }
+#endif
+
+    pthread_mutex_lock(&gDhcpcMutex);
+
+    for (idx = 0; idx < WANMGR_DHCPC_MAX_CLIENTS; idx++)
+    {
+        DhcpcClient_t *pClient = &gClients[idx];
+
+        if (Dhcpc_Matches(pClient, ifName, type) == FALSE)
+        {
+            continue;
+        }
+
+        pClient->startPending = FALSE;
+        if (pClient->state == DHCPC_STATE_RUNNING)
+        {
+            CcspTraceInfo(("%s %d - stopping %s client of %s, pid %d%s \n", __FUNCTION__, __LINE__, Dhcpc_TypeName(type),
+                           pClient->ifName, pClient->pid, (release == TRUE) ? ", releasing the lease" : ""));
+            if (release == TRUE)
+            {
+                Dhcpc_Signal(pClient, gSignals[type].release);
+            }
+            Dhcpc_Signal(pClient, gSignals[type].stop);
+            pClient->state = DHCPC_STATE_STOPPING;
+            pClient->deadlineMs = Dhcpc_NowMs() + WANMGR_DHCPC_STOP_TIMEOUT_MS;
+        }
+    }
+
+    if (gDhcpcReady == TRUE)
+    {
+        Dhcpc_ArmTimer();
+    }
+    pthread_mutex_unlock(&gDhcpcMutex);
+
+    return ANSC_STATUS_SUCCESS;
+}
+
+int WanMgr_DhcpClient_GetPid(const char *ifName, WanMgr_DhcpClientType_t type)
+{
+    int pid = 0;
+    int idx;
+
+    if (type >= WANMGR_DHCPC_MAX_TYPES)
+    {
+        return 0;
+    }
+
+#ifdef FEATURE_EMBEDDED_DHCPV4_CLIENT
+    if (type == WANMGR_DHCPC_V4)
+    {
+        //Runs inside WAN Manager, there is no client process
+        return 0;
+    }
+#endif
+#ifdef FEATURE_EMBEDDED_DHCPV6_CLIENT
+    if (type == WANMGR_DHCPC_V6)
+    {
+        return 0;
+    }
+#endif
+
+    pthread_mutex_lock(&gDhcpcMutex);
+
+    for (idx = 0; idx < WANMGR_DHCPC_MAX_CLIENTS; idx++)
+    {
+        if (Dhcpc_Matches(&gClients[idx], ifName, type) == TRUE && gClients[idx].state == DHCPC_STATE_RUNNING)
+        {
+            pid = gClients[idx].pid;
+            break;
+        }
+    }
+
+    pthread_mutex_unlock(&gDhcpcMutex);
+
+    return pid;
+}
+
+BOOL WanMgr_DhcpClient_IsRunning(const char *ifName, WanMgr_DhcpClientType_t type)
+{
+    BOOL running = FALSE;
+    int idx;
+
+    if (type >= WANMGR_DHCPC_MAX_TYPES)
+    {
+        return FALSE;
+    }
+
+#ifdef FEATURE_EMBEDDED_DHCPV4_CLIENT
+    if (type == WANMGR_DHCPC_V4)
+    {
+        return WanMgr_Dhcpv4c_IsRunning(ifName);
+    }
+#endif
+#ifdef FEATURE_EMBEDDED_DHCPV6_CLIENT
+    if (type == WANMGR_DHCPC_V6)
+    {
+        return WanMgr_Dhcpv6c_IsRunning(ifName);
+    }
+#endif
+
+    pthread_mutex_lock(&gDhcpcMutex);
+
+    for (idx = 0; idx < WANMGR_DHCPC_MAX_CLIENTS; idx++)
+    {
+        if (Dhcpc_Matches(&gClients[idx], ifName, type) == TRUE && gClients[idx].state == DHCPC_STATE_RUNNING)
+        {
+            running = TRUE;
+            break;
+        }
+    }
+
+    pthread_mutex_unlock(&gDhcpcMutex);
+
+    return running;
+}
@@ -0,0 +1,93 @@
+/*
+ * If not stated otherwise in this file or this component's Licenses.txt file the
+ * following copyright and licenses apply:
+ *
+ * Copyright 2020 RDK Management
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+*/
+
+#ifndef _WANMGR_DHCP_CLIENT_H_
+#define _WANMGR_DHCP_CLIENT_H_
+
+/* DHCP client controller. Every client is spawned by us and tracked by the
+ * PID fork() returned, commands are signals to that PID only. Stopping does
+ * not wait: the exit is collected on the event loop, a client started again
+ * before the previous instance is gone is spawned once it has exited. */
+
+/* ---- Include Files ---------------------------------------- */
+#include "ansc_platform.h"
+
+/* ---- Global Constants -------------------------------------- */
+#define WANMGR_DHCPC_MAX_CLIENTS        16
+#define WANMGR_DHCPC_STOP_TIMEOUT_MS    5000    /* killed if still running this long after a stop */
+#define WANMGR_DHCPC_REAP_MS            200     /* exit polling while a client is stopping */
+#define WANMGR_DHCPC_WATCH_MS           2000    /* exit polling while clients are running */
+
+/* ---- Global Types -------------------------------------------- */
+typedef enum
+{
+    WANMGR_DHCPC_V4 = 0,
+    WANMGR_DHCPC_V6,
+    WANMGR_DHCPC_MAX_TYPES
+} WanMgr_DhcpClientType_t;
+
+/* ---- Global Prototypes -------------------------------------- */
+
+/***************************************************************************
+ * @brief Start the DHCP client of an interface. Nothing is done if it is
+ * already running, if it is still stopping it is started once it has exited.
+ * @param ifName WAN interface name
+ * @param type client type
+ * @param appName client executable, looked up like WanManager_DoStartApp()
+ * @param args command line arguments
+ * @return ANSC_STATUS_SUCCESS upon success else returned error code.
+ ****************************************************************************/
+ANSC_STATUS WanMgr_DhcpClient_Start(const char *ifName, WanMgr_DhcpClientType_t type, const char *appName, const char *args);
+
+/***************************************************************************
+ * @brief Ask the DHCP client of an interface to renew its lease.
+ * @param ifName WAN interface name, NULL for every client of the type
+ * @param type client type
+ * @return ANSC_STATUS_SUCCESS if a client was signalled else ANSC_STATUS_FAILURE.
+ ****************************************************************************/
+ANSC_STATUS WanMgr_DhcpClient_Renew(const char *ifName, WanMgr_DhcpClientType_t type);
+
+/***************************************************************************
+ * @brief Stop the DHCP client of an interface without waiting for it to exit.
+ * @param ifName WAN interface name, NULL for every client of the type
+ * @param type client type
+ * @param release TRUE to release the lease before exiting
+ * @return ANSC_STATUS_SUCCESS upon success else returned error code.
+ ****************************************************************************/
+ANSC_STATUS WanMgr_DhcpClient_Stop(const char *ifName, WanMgr_DhcpClientType_t type, BOOL release);
+
+/***************************************************************************
+ * @brief PID of the running DHCP client of an interface.
+ * @param ifName WAN interface name, NULL for the first client of the type
+ * @param type client type
+ * @return PID, 0 if no client is running or the client is embedded in
+ * WAN Manager.
+ ****************************************************************************/
+int WanMgr_DhcpClient_GetPid(const char *ifName, WanMgr_DhcpClientType_t type);
+
+/***************************************************************************
+ * @brief Check whether the DHCP client of an interface is running, a client
+ * process or the client embedded in WAN Manager.
+ * @param ifName WAN interface name, NULL for any client of the type
+ * @param type client type
+ * @return TRUE if a client is running else FALSE.
+ ****************************************************************************/
+BOOL WanMgr_DhcpClient_IsRunning(const char *ifName, WanMgr_DhcpClientType_t type);
+
+#endif /* _WANMGR_DHCP_CLIENT_H_ */
@@ -22,6 +22,7 @@
 #include "wanmgr_sysevents.h"
 #include "wanmgr_ipc.h"
 #include "wanmgr_utils.h"
+#include "wanmgr_net_utils.h"
 #include "wanmgr_rdkbus_apis.h"
 #include "wanmgr_dhcpv4_internal.h"
 #include <sys/types.h>
@@ -38,6 +39,7 @@
 #include <sys/stat.h>
 #include <sys/file.h>
 #include <fcntl.h>
+#include <pthread.h>
 
 
 #include "ccsp_psm_helper.h"
@@ -71,6 +73,36 @@ extern char g_Subsystem[32];
 #define DHCP_STATE_UP      "Up"
 #define DHCP_STATE_DOWN    "Down"
 
+/* Lease of the erouter client as last reported over IPC. The platform
+ * dhcpv4c_get_ert_* calls are only used until the first lease arrives. */
+typedef struct {
+    BOOL               valid;
+    char               ifname[BUFLEN_64];
+    DML_DHCPC_INFO     info;
+    uint32_t           leaseObtained;       /* uptime when the lease was reported */
+    uint32_t           leaseTime;
+    BOOL               serverKnown;         /* server id is not part of the ipc message */
+} DHCPC_LEASE_CACHE;
+
+static DHCPC_LEASE_CACHE g_dhcpc_lease;
+static pthread_mutex_t   g_dhcpc_lease_mutex = PTHREAD_MUTEX_INITIALIZER;
+static char              g_dhcpc_ert_ifname[BUFLEN_32];
+
+/* erouter client interface, asked from the platform until it is known */
+static const char* WanMgr_DmlDhcpcErtIfname(void)
+{
+    char ifname[BUFLEN_32] = {0};
+
+    pthread_mutex_lock(&g_dhcpc_lease_mutex);
+    if (g_dhcpc_ert_ifname[0] == '\0' && dhcpv4c_get_ert_ifname(ifname) == 0)
+    {
+        snprintf(g_dhcpc_ert_ifname, sizeof(g_dhcpc_ert_ifname), "%s", ifname);
+    }
+    pthread_mutex_unlock(&g_dhcpc_lease_mutex);
+
+    return g_dhcpc_ert_ifname;
+}
+
 static ANSC_STATUS wanmgr_dchpv4_get_ipc_msg_info(WANMGR_IPV4_DATA* pDhcpv4Data, ipc_dhcpv4_data_t* pIpcIpv4Data)
 {
     if((pDhcpv4Data == NULL) || (pIpcIpv4Data == NULL))
@@ -84,7 +116,8 @@ static ANSC_STATUS wanmgr_dchpv4_get_ipc_msg_info(WANMGR_IPV4_DATA* pDhcpv4Data,
     memcpy(pDhcpv4Data->dnsServer, pIpcIpv4Data->dnsServer, BUFLEN_64);
     memcpy(pDhcpv4Data->dnsServer1, pIpcIpv4Data->dnsServer1, BUFLEN_64);
 
-    return ANSC_STATUS_SUCCESS;
+    /* parse once here, consumers work on the binary copy */
+    return WanManager_Ipv4DataToBin(pDhcpv4Data);
 }
 
 
@@ -103,13 +136,12 @@ ANSC_STATUS wanmgr_handle_dchpv4_event_data(DML_WAN_IFACE* pIfaceData)
 
     CcspTraceInfo(("%s %d - Enter \n", __FUNCTION__, __LINE__));
     bool IPv4ConfigChanged = FALSE;
+    WANMGR_IPV4_DATA Ipv4DataNew;
 
+    memset(&Ipv4DataNew, 0, sizeof(Ipv4DataNew));
+    wanmgr_dchpv4_get_ipc_msg_info(&Ipv4DataNew, pDhcpcInfo);
 
-    if (strcmp(pIfaceData->IP.Ipv4Data.ip, pDhcpcInfo->ip) ||
-      strcmp(pIfaceData->IP.Ipv4Data.mask, pDhcpcInfo->mask) ||
-      strcmp(pIfaceData->IP.Ipv4Data.gateway, pDhcpcInfo->gateway) ||
-      strcmp(pIfaceData->IP.Ipv4Data.dnsServer, pDhcpcInfo->dnsServer) ||
-      strcmp(pIfaceData->IP.Ipv4Data.dnsServer1, pDhcpcInfo->dnsServer1))
+    if (memcmp(&pIfaceData->IP.Ipv4Data.bin, &Ipv4DataNew.bin, sizeof(WANMGR_IPV4_ADDR_BIN)) != 0)
     {
         CcspTraceInfo(("%s %d - IPV4 configuration changed \n", __FUNCTION__, __LINE__));
         IPv4ConfigChanged = TRUE;
@@ -177,14 +209,14 @@ ANSC_STATUS wanmgr_handle_dchpv4_event_data(DML_WAN_IFACE* pIfaceData)
         }
 
         // update current IPv4 data
-        wanmgr_dchpv4_get_ipc_msg_info(&(pIfaceData->IP.Ipv4Data), pDhcpcInfo);
+        memcpy(&(pIfaceData->IP.Ipv4Data), &Ipv4DataNew, sizeof(WANMGR_IPV4_DATA));
         WanManager_UpdateInterfaceStatus(pIfaceData, WANMGR_IFACE_CONNECTION_UP);
     }
     else if (pDhcpcInfo->isExpired)
     {
         CcspTraceInfo(("DHCPC Lease expired!!!!!!!!!!\n"));
         // update current IPv4 data
-        wanmgr_dchpv4_get_ipc_msg_info(&(pIfaceData->IP.Ipv4Data), pDhcpcInfo);
+        memcpy(&(pIfaceData->IP.Ipv4Data), &Ipv4DataNew, sizeof(WANMGR_IPV4_DATA));
         WanManager_UpdateInterfaceStatus(pIfaceData, WANMGR_IFACE_CONNECTION_DOWN);
     }
 
@@ -329,167 +361,6 @@ EXIT:
     return NULL;
 }
 
-static ANSC_STATUS DhcpcDmlScan()
-{
-    CHAR            tmpBuff[64]    = {0};
-    CHAR            tmp[3][64];
-    CHAR            ip[32];   
-    CHAR            subnet[32];
-    CHAR            str_val[64] = {0};
-    CHAR            str_key[64] = {0};
-    CHAR            dns[3][32]  = {"","",""};
-    CHAR            line[128];
-    char            *tok;
-    int             nmu_dns_server =  0;
-    FILE            *fp = NULL;
-
-    PDML_DHCPC_FULL  pEntry = NULL;
-
-    ULONG ulIndex = 0;
-
-    g_Dhcp4ClientNum = 0;
-
-    for (ulIndex = 0; ulIndex < 2; ulIndex++)
-    {
-        if (ulIndex == 0)
-        {
-            fp = fopen("/tmp/udhcp.log", "r");
-        }       
-        else if (ulIndex == 1)
-        {
-
-            /*RDKB-6750, CID-33082, free resources before exit*/
-            if(fp)
-            {
-                fclose(fp);
-                fp = NULL;
-            }
-
-#ifdef _COSA_DRG_TPG_
-            fp = fopen("/tmp/udhcp_lan.log", "r"); 
-#else
-            return ANSC_STATUS_SUCCESS;
-#endif
-
-        }
-        pEntry = &CH_g_dhcpv4_client[ulIndex];
-
-        if (!fp) 
-        {
-            return ANSC_STATUS_FAILURE;
-        }   
-
-        while ( fgets(line, sizeof(line), fp) )
-        {         
-            memset(str_key, 0, sizeof(str_key));
-            memset(str_val, 0, sizeof(str_val));
-
-            tok = strtok( line, ":");
-            if(tok) strncpy(str_key, tok, sizeof(str_key)-1 );
-
-            tok = strtok(NULL, ":");
-            while( tok && (tok[0] == ' ') ) tok++; /*RDKB-6750, CID-33384, CID-32954; null check before use*/
-            if(tok) strncpy(str_val, tok, sizeof(str_val)-1 );
-
-            if ( str_val[ _ansc_strlen(str_val) - 1 ] == '\n' )
-            {
-                str_val[ _ansc_strlen(str_val) - 1 ] = '\0';
-            }
-
-            if( !strcmp(str_key, "interface     ") )
-            {
-                AnscCopyString( pEntry->Cfg.Interface, str_val);
-            }
-            else if( !strcmp(str_key, "ip address    ") )
-            {
-                sscanf(str_val, "%s", ip);
-                AnscWriteUlong(&pEntry->Info.IPAddress.Value, _ansc_inet_addr(ip));
-            }
-            else if( !strcmp(str_key, "subnet mask   ") )
-            {
-                sscanf(str_val, "%s", subnet );
-                AnscWriteUlong(&pEntry->Info.SubnetMask.Value, _ansc_inet_addr(subnet));
-            }
-            else if( !strcmp(str_key, "lease time    ") )
-            {
-                pEntry->Info.LeaseTimeRemaining = atoi(str_val);
-            }
-            else if( !strcmp(str_key, "router        ") )
-            {
-                sscanf(str_val, "%s", ip ); 
-                AnscWriteUlong(&pEntry->Info.IPRouters[0].Value, _ansc_inet_addr(ip) ); 
-            }
-            else if( !strcmp(str_key, "server id     ") )
-            {
-                sscanf(str_val, "%s", ip ); 
-                AnscWriteUlong(&pEntry->Info.DHCPServer.Value, _ansc_inet_addr(ip));
-            }
-            else if( !strcmp(str_key, "dns server    ") )
-            {
-                nmu_dns_server = 0;               
-                char *tok;
-
-                tok = strtok( str_val, " ");
-                if(tok) strncpy(dns[0], tok, sizeof(dns[0])-1 ); 
-                if( dns[0] ) 
-                {
-                    ++nmu_dns_server;
-                    AnscWriteUlong(&pEntry->Info.DNSServers[0].Value, _ansc_inet_addr(dns[0]));
-                }
-                while( tok != NULL)
-                {
-                    tok = strtok(NULL, " ");
-                    if(tok) strncpy(dns[nmu_dns_server], tok, sizeof(dns[nmu_dns_server])-1 );
-                    if (strlen(dns[nmu_dns_server]) > 1 )
-                    {    
-                        AnscWriteUlong(&pEntry->Info.DNSServers[nmu_dns_server].Value, _ansc_inet_addr(dns[nmu_dns_server]));
-                        ++nmu_dns_server;
-                        if( nmu_dns_server > 2) /*RDKB-6750, CID-33057, Fixing Out-of-bounds read of dns[3][] */
-                            nmu_dns_server = 2;
-                    }
-                }
-            }
-        }
-
-        if ( !_ansc_strncmp(pEntry->Cfg.Interface, DML_DHCP_CLIENT_IFNAME, _ansc_strlen(DML_DHCP_CLIENT_IFNAME)) )
-        {
-            memset(tmpBuff, 0, sizeof(tmpBuff));
-            syscfg_get(NULL, "tr_dhcp4_instance_wan", tmpBuff, sizeof(tmpBuff));
-            CH_g_dhcpv4_client[ulIndex].Cfg.InstanceNumber  = atoi(tmpBuff);
-
-            memset(tmpBuff, 0, sizeof(tmpBuff));
-            syscfg_get(NULL, "tr_dhcp4_alias_wan", tmpBuff, sizeof(tmpBuff));
-            AnscCopyString(CH_g_dhcpv4_client[ulIndex].Cfg.Alias, tmpBuff);
-        }
-        else if ( !_ansc_strncmp(pEntry->Cfg.Interface, "lan0", _ansc_strlen("lan0")) )
-        {
-            memset(tmpBuff, 0, sizeof(tmpBuff));
-            syscfg_get(NULL, "tr_dhcp4_instance_lan", tmpBuff, sizeof(tmpBuff));
-            CH_g_dhcpv4_client[ulIndex].Cfg.InstanceNumber  = atoi(tmpBuff);
-
-            memset(tmpBuff, 0, sizeof(tmpBuff));
-            syscfg_get(NULL, "tr_dhcp4_alias_lan", tmpBuff, sizeof(tmpBuff));
-            AnscCopyString(CH_g_dhcpv4_client[ulIndex].Cfg.Alias, tmpBuff);
-        }
-
-        pEntry->Cfg.PassthroughEnable   = FALSE;
-
-        //AnscCopyString( pEntry->Cfg.PassthroughDHCPPool, "");  
-        pEntry->Cfg.bEnabled                     = TRUE;
-        //pEntry->Cfg.bRenew                       = FALSE;
-
-        pEntry->Info.Status                      = DML_DHCP_STATUS_Enabled;
-        pEntry->Info.DHCPStatus                  = DML_DHCPC_STATUS_Bound;
-
-        pEntry->Info.NumIPRouters                = 1;
-        pEntry->Info.NumDnsServers               = nmu_dns_server;
-        g_Dhcp4ClientNum++;
-
-    }    
-    fclose(fp);
-    return ANSC_STATUS_SUCCESS;
-}
-
 /*
     Description:
         The API retrieves the number of DHCP clients in the system.
@@ -652,7 +523,6 @@ WanMgr_DmlDhcpcGetCfg
 {
     UNREFERENCED_PARAMETER(hContext);
     ULONG       i = 0;
-    char ifname[32];
 
     if ( !pCfg )
     {
@@ -662,16 +532,104 @@ WanMgr_DmlDhcpcGetCfg
     sprintf(pCfg->Alias,"eRouter");
     pCfg->bEnabled = TRUE;
     pCfg->InstanceNumber = 1;
-    if(dhcpv4c_get_ert_ifname(ifname))
-        pCfg->Interface[0] = 0;
-    else
-        sprintf(pCfg->Interface,"%s", ifname);
+    sprintf(pCfg->Interface,"%s", WanMgr_DmlDhcpcErtIfname());
     pCfg->PassthroughEnable = TRUE;
     pCfg->PassthroughDHCPPool[0] = 0;
 
     return ANSC_STATUS_SUCCESS;
 }
 
+void WanMgr_DmlDhcpcLeaseUpdate(const ipc_dhcpv4_data_t* pMsg)
+{
+    DML_DHCPC_INFO *pInfo = &g_dhcpc_lease.info;
+    const char *ertIfname = NULL;
+    ULONG numDns = 0;
+
+    if (pMsg == NULL)
+    {
+        return;
+    }
+
+    /* the table has a single erouter entry, other clients are not tracked.
+     * Until the platform names the erouter interface no lease can be told apart. */
+    ertIfname = WanMgr_DmlDhcpcErtIfname();
+    if (ertIfname[0] == '\0')
+    {
+        CcspTraceWarning(("%s %d - erouter interface unknown, lease on %s not recorded\n", __FUNCTION__, __LINE__, pMsg->dhcpcInterface));
+        return;
+    }
+
+    if (strcmp(ertIfname, pMsg->dhcpcInterface) != 0)
+    {
+        return;
+    }
+
+    pthread_mutex_lock(&g_dhcpc_lease_mutex);
+    memset(&g_dhcpc_lease, 0, sizeof(g_dhcpc_lease));
+    snprintf(g_dhcpc_lease.ifname, sizeof(g_dhcpc_lease.ifname), "%s", pMsg->dhcpcInterface);
+    pInfo->Status = DML_DHCP_STATUS_Enabled;
+
+    if (pMsg->addressAssigned)
+    {
+        pInfo->DHCPStatus = DML_DHCPC_STATUS_Bound;
+        AnscWriteUlong(&pInfo->IPAddress.Value, _ansc_inet_addr(pMsg->ip));
+        AnscWriteUlong(&pInfo->SubnetMask.Value, _ansc_inet_addr(pMsg->mask));
+        pInfo->NumIPRouters = 1;
+        AnscWriteUlong(&pInfo->IPRouters[0].Value, _ansc_inet_addr(pMsg->gateway));
+        if (pMsg->dnsServer[0] != '\0')
+        {
+            AnscWriteUlong(&pInfo->DNSServers[numDns++].Value, _ansc_inet_addr(pMsg->dnsServer));
+        }
+        if (pMsg->dnsServer1[0] != '\0')
+        {
+            AnscWriteUlong(&pInfo->DNSServers[numDns++].Value, _ansc_inet_addr(pMsg->dnsServer1));
+        }
+        pInfo->NumDnsServers = numDns;
+        g_dhcpc_lease.leaseTime = (pMsg->leaseTime > 0) ? (uint32_t) pMsg->leaseTime : 0;
+        g_dhcpc_lease.leaseObtained = WanManager_getUpTime();
+    }
+    else
+    {
+        pInfo->DHCPStatus = DML_DHCPC_STATUS_Init;
+        g_dhcpc_lease.serverKnown = TRUE;
+    }
+
+    g_dhcpc_lease.valid = TRUE;
+    pthread_mutex_unlock(&g_dhcpc_lease_mutex);
+}
+
+/* Fills pInfo from the ipc lease cache, fails if no lease was reported yet */
+static ANSC_STATUS WanMgr_DmlDhcpcGetLeaseInfo(PDML_DHCPC_INFO pInfo)
+{
+    uint32_t elapsed;
+    unsigned int server = 0;
+
+    pthread_mutex_lock(&g_dhcpc_lease_mutex);
+    if (g_dhcpc_lease.valid != TRUE)
+    {
+        pthread_mutex_unlock(&g_dhcpc_lease_mutex);
+        return ANSC_STATUS_FAILURE;
+    }
+
+    if (g_dhcpc_lease.serverKnown != TRUE)
+    {
+        /* once per lease, the ipc message does not carry the server id */
+        dhcpv4c_get_ert_dhcp_svr(&server);
+        g_dhcpc_lease.info.DHCPServer.Value = server;
+        g_dhcpc_lease.serverKnown = TRUE;
+    }
+
+    memcpy(pInfo, &g_dhcpc_lease.info, sizeof(DML_DHCPC_INFO));
+    if (pInfo->DHCPStatus == DML_DHCPC_STATUS_Bound)
+    {
+        elapsed = WanManager_getUpTime() - g_dhcpc_lease.leaseObtained;
+        pInfo->LeaseTimeRemaining = (elapsed < g_dhcpc_lease.leaseTime) ? (int) (g_dhcpc_lease.leaseTime - elapsed) : 0;
+    }
+    pthread_mutex_unlock(&g_dhcpc_lease_mutex);
+
+    return ANSC_STATUS_SUCCESS;
+}
+
 ANSC_STATUS
 WanMgr_DmlDhcpcGetInfo
     (
@@ -690,6 +648,11 @@ WanMgr_DmlDhcpcGetInfo
         return ANSC_STATUS_FAILURE;
     }
 
+    if (WanMgr_DmlDhcpcGetLeaseInfo(pInfo) == ANSC_STATUS_SUCCESS)
+    {
+        return ANSC_STATUS_SUCCESS;
+    }
+
     pInfo->Status = DML_DHCP_STATUS_Enabled;
     dhcpv4c_get_ert_fsm_state((int*)&pInfo->DHCPStatus);
     dhcpv4c_get_ert_ip_addr((unsigned int*)&pInfo->IPAddress.Value);
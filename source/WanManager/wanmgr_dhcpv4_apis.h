@@ -43,6 +43,13 @@
 ANSC_STATUS wanmgr_handle_dchpv4_event_data(DML_WAN_IFACE* pIfaceData);
 void* IPCPStateChangeHandler (void *arg);
 
+/**
+ * @brief Record a lease received from the DHCPv4 client over IPC, so the
+ * Device.DHCPv4.Client. table is served from memory.
+ * @param pMsg - lease message as received from the client
+ */
+void WanMgr_DmlDhcpcLeaseUpdate(const ipc_dhcpv4_data_t* pMsg);
+
 /**********************************************************************
                 STRUCTURE AND CONSTANT DEFINITIONS
 **********************************************************************/
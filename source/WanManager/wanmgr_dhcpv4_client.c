@@ -0,0 +1,1148 @@
+/*
+ * If not stated otherwise in this file or this component's Licenses.txt file the
+ * following copyright and licenses apply:
+ *
+ * Copyright 2020 RDK Management
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+*/
+
+#ifdef FEATURE_EMBEDDED_DHCPV4_CLIENT
+
+/* ---- Include Files ---------------------------------------- */
+#include <errno.h>
+#include <pthread.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <sys/ioctl.h>
+#include <sys/socket.h>
+#include <sys/timerfd.h>
+#include <net/if.h>
+#include <netinet/in.h>
+#include <netinet/ip.h>
+#include <netinet/udp.h>
+#include <linux/if_packet.h>
+#include <linux/if_ether.h>
+#include <linux/filter.h>
+#include "wanmgr_dhcpv4_client.h"
+#include "wanmgr_event_loop.h"
+#include "wanmgr_ipc.h"
+
+#define DHCPV4C_CLIENT_PORT         68
+#define DHCPV4C_SERVER_PORT         67
+#define DHCPV4C_MAGIC_COOKIE        0x63825363
+#define DHCPV4C_OPTIONS_LEN         308     /* a 548 byte BOOTP message, the minimum a server must accept */
+#define DHCPV4C_MAX_MSG_SIZE        576
+#define DHCPV4C_PKT_MAX             1536
+#define DHCPV4C_INFINITE_LEASE      0xFFFFFFFF
+#define DHCPV4C_BACKOFF_JITTER_MS   1000
+#define DHCPV4C_REPORT_RETRY_MS     100     /* a lease the state machine has not taken yet is offered again */
+
+#define DHCPV4C_BOOTREQUEST         1
+#define DHCPV4C_BOOTREPLY           2
+
+#define DHCPV4C_DISCOVER            1
+#define DHCPV4C_OFFER               2
+#define DHCPV4C_REQUEST             3
+#define DHCPV4C_ACK                 5
+#define DHCPV4C_NAK                 6
+#define DHCPV4C_RELEASE             7
+
+#define DHCPV4C_OPT_PAD             0
+#define DHCPV4C_OPT_SUBNET_MASK     1
+#define DHCPV4C_OPT_TIME_OFFSET     2
+#define DHCPV4C_OPT_ROUTER          3
+#define DHCPV4C_OPT_DNS             6
+#define DHCPV4C_OPT_REQUESTED_IP    50
+#define DHCPV4C_OPT_LEASE_TIME      51
+#define DHCPV4C_OPT_OVERLOAD        52
+#define DHCPV4C_OPT_MSG_TYPE        53
+#define DHCPV4C_OPT_SERVER_ID       54
+#define DHCPV4C_OPT_PARAM_LIST      55
+#define DHCPV4C_OPT_MAX_MSG_SIZE    57
+#define DHCPV4C_OPT_T1              58
+#define DHCPV4C_OPT_T2              59
+#define DHCPV4C_OPT_CLIENT_ID       61
+#define DHCPV4C_OPT_POSIX_TZ        100
+#define DHCPV4C_OPT_TZ_DATABASE     101
+#define DHCPV4C_OPT_END             255
+
+#define DHCPV4C_STATE_UP            "Up"
+#define DHCPV4C_STATE_DOWN          "Down"
+
+typedef enum
+{
+    DHCPV4C_SELECTING = 0,      /* discovering, the first OFFER is taken */
+    DHCPV4C_REQUESTING,         /* OFFER requested, waiting for the ACK */
+    DHCPV4C_BOUND,
+    DHCPV4C_RENEWING,           /* unicast to the server of the lease from T1 */
+    DHCPV4C_REBINDING           /* broadcast to any server from T2 */
+} Dhcpv4cState_t;
+
+typedef struct __attribute__((packed)) _Dhcpv4cMsg_t
+{
+    uint8_t     op;
+    uint8_t     htype;
+    uint8_t     hlen;
+    uint8_t     hops;
+    uint32_t    xid;
+    uint16_t    secs;
+    uint16_t    flags;
+    uint32_t    ciaddr;
+    uint32_t    yiaddr;
+    uint32_t    siaddr;
+    uint32_t    giaddr;
+    uint8_t     chaddr[16];
+    uint8_t     sname[64];
+    uint8_t     file[128];
+    uint32_t    cookie;
+    uint8_t     options[DHCPV4C_OPTIONS_LEN];
+} Dhcpv4cMsg_t;
+
+/* Options of a received message */
+typedef struct _Dhcpv4cOptions_t
+{
+    uint8_t         msgType;
+    struct in_addr  serverId;
+    struct in_addr  mask;
+    struct in_addr  router;
+    struct in_addr  dns[2];
+    uint32_t        leaseSecs;
+    uint32_t        t1Secs;
+    uint32_t        t2Secs;
+    int32_t         timeOffset;
+    BOOL            hasLease;
+    BOOL            hasT1;
+    BOOL            hasT2;
+    BOOL            hasTimeOffset;
+    char            timeZone[BUFLEN_64];
+} Dhcpv4cOptions_t;
+
+/* Lease report on its way to the interface state machine */
+typedef struct _Dhcpv4cReport_t
+{
+    uint32_t            seq;
+    ipc_dhcpv4_data_t   data;
+} Dhcpv4cReport_t;
+
+typedef struct _Dhcpv4cSession_t
+{
+    BOOL                inUse;
+    char                ifName[IFNAMSIZ];
+    int                 ifIndex;
+    uint8_t             ifMac[ETH_ALEN];
+    Dhcpv4cState_t      state;
+    uint32_t            xid;
+    uint64_t            startMs;        /* of the current exchange, for the secs field */
+    uint64_t            nextMs;         /* next transmission or state change, 0 for none */
+    UINT                backoffMs;
+    UINT                tries;
+    BOOL                forced;         /* renewal asked for before T1 */
+    BOOL                leased;         /* a lease is reported up */
+    struct in_addr      address;        /* offered, then leased */
+    struct in_addr      serverId;
+    uint8_t             serverMac[ETH_ALEN];
+    uint64_t            t1Ms;           /* 0 for an infinite lease */
+    uint64_t            t2Ms;
+    uint64_t            expiryMs;
+    uint32_t            reportSeq;      /* of the newest report */
+    Dhcpv4cReport_t    *pReport;        /* report not taken yet, offered again at reportMs */
+    uint64_t            reportMs;
+} Dhcpv4cSession_t;
+
+/* ---- Private Variables ------------------------------------ */
+static Dhcpv4cSession_t gSessions[WANMGR_DHCPV4C_MAX_IFACES];
+static int gTimerFd = -1;
+static int gPktFd = -1;
+static int gSinkFd = -1;
+static unsigned int gSeed = 0;
+static BOOL gDhcpv4cReady = FALSE;
+static pthread_mutex_t gDhcpv4cMutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_once_t gDhcpv4cOnce = PTHREAD_ONCE_INIT;
+
+static const uint8_t gBroadcastMac[ETH_ALEN] = { 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF };
+static const uint8_t gZeroMac[ETH_ALEN];
+static const uint8_t gParamList[] =
+{
+    DHCPV4C_OPT_SUBNET_MASK, DHCPV4C_OPT_ROUTER, DHCPV4C_OPT_DNS, DHCPV4C_OPT_TIME_OFFSET,
+    DHCPV4C_OPT_LEASE_TIME, DHCPV4C_OPT_T1, DHCPV4C_OPT_T2, DHCPV4C_OPT_POSIX_TZ, DHCPV4C_OPT_TZ_DATABASE
+};
+
+/* ---- Private Functions ------------------------------------ */
+
+static uint64_t Dhcpv4c_NowMs(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t) ts.tv_sec * 1000ULL + (uint64_t) ts.tv_nsec / 1000000ULL;
+}
+
+static uint16_t Dhcpv4c_Checksum(uint32_t sum, const void *data, size_t len)
+{
+    const uint8_t *p = (const uint8_t *) data;
+
+    while (len > 1)
+    {
+        sum += (uint32_t)((p[0] << 8) | p[1]);
+        p += 2;
+        len -= 2;
+    }
+    if (len > 0)
+    {
+        sum += (uint32_t)(p[0] << 8);
+    }
+    while (sum >> 16)
+    {
+        sum = (sum & 0xFFFF) + (sum >> 16);
+    }
+
+    return htons((uint16_t) ~sum);
+}
+
+static const char *Dhcpv4c_StateName(Dhcpv4cState_t state)
+{
+    switch (state)
+    {
+        case DHCPV4C_SELECTING:  return "SELECTING";
+        case DHCPV4C_REQUESTING: return "REQUESTING";
+        case DHCPV4C_BOUND:      return "BOUND";
+        case DHCPV4C_RENEWING:   return "RENEWING";
+        case DHCPV4C_REBINDING:  return "REBINDING";
+    }
+    return "UNKNOWN";
+}
+
+/* Next retransmission delay: doubled from 4 up to 64 seconds, randomised by a second (RFC 2131 4.1) */
+static UINT Dhcpv4c_Backoff(Dhcpv4cSession_t *pSession)
+{
+    if (pSession->backoffMs == 0)
+    {
+        pSession->backoffMs = WANMGR_DHCPV4C_MIN_BACKOFF_MS;
+    }
+    else if (pSession->backoffMs < WANMGR_DHCPV4C_MAX_BACKOFF_MS)
+    {
+        pSession->backoffMs *= 2;
+    }
+
+    return pSession->backoffMs - DHCPV4C_BACKOFF_JITTER_MS + (UINT)(rand_r(&gSeed) % (2 * DHCPV4C_BACKOFF_JITTER_MS + 1));
+}
+
+/* ---- Reporting, run on the event loop urgent worker ---- */
+
+static int Dhcpv4c_FindSession(const char *ifName);
+static void Dhcpv4c_ArmTimer(void);
+
+/* Hand the lease to the same code as a lease from the udhcpc action handler. The
+   worker is never held up: a lease the state machine has not made room for yet is
+   offered again from the session timer, unless a newer report replaced it. */
+static void Dhcpv4c_RunReport(void *arg)
+{
+    Dhcpv4cReport_t *pReport = (Dhcpv4cReport_t *) arg;
+    int idx;
+
+    if (WanMgr_IpcTryNewIpv4Msg(&pReport->data) == ANSC_STATUS_SUCCESS)
+    {
+        free(pReport);
+        return;
+    }
+
+    pthread_mutex_lock(&gDhcpv4cMutex);
+    idx = Dhcpv4c_FindSession(pReport->data.dhcpcInterface);
+    if (idx >= 0 && gSessions[idx].reportSeq == pReport->seq && gSessions[idx].pReport == NULL)
+    {
+        gSessions[idx].pReport = pReport;
+        gSessions[idx].reportMs = Dhcpv4c_NowMs() + DHCPV4C_REPORT_RETRY_MS;
+        Dhcpv4c_ArmTimer();
+        pReport = NULL;
+    }
+    pthread_mutex_unlock(&gDhcpv4cMutex);
+
+    free(pReport);
+}
+
+/* Queue a report to the urgent worker, called with gDhcpv4cMutex held */
+static void Dhcpv4c_QueueReport(Dhcpv4cSession_t *pSession, Dhcpv4cReport_t *pReport)
+{
+    if (WanMgr_EventLoop_QueueUrgentWork(Dhcpv4c_RunReport, pReport) != ANSC_STATUS_SUCCESS)
+    {
+        pSession->pReport = pReport;
+        pSession->reportMs = Dhcpv4c_NowMs() + DHCPV4C_REPORT_RETRY_MS;
+    }
+}
+
+/* Queue the lease of the session up, or expired, called with gDhcpv4cMutex held */
+static void Dhcpv4c_Report(Dhcpv4cSession_t *pSession, BOOL up, const Dhcpv4cOptions_t *pOpts)
+{
+    Dhcpv4cReport_t *pReport = (Dhcpv4cReport_t *) calloc(1, sizeof(Dhcpv4cReport_t));
+    ipc_dhcpv4_data_t *pData;
+
+    if (pReport == NULL)
+    {
+        return;
+    }
+    pData = &pReport->data;
+
+    //Only the newest report matters, one still waiting is dropped
+    pReport->seq = ++pSession->reportSeq;
+    free(pSession->pReport);
+    pSession->pReport = NULL;
+    pSession->reportMs = 0;
+
+    snprintf(pData->dhcpcInterface, sizeof(pData->dhcpcInterface), "%s", pSession->ifName);
+    pData->addressAssigned = up;
+    pData->isExpired = (up == TRUE) ? FALSE : TRUE;
+    snprintf(pData->dhcpState, sizeof(pData->dhcpState), "%s", (up == TRUE) ? DHCPV4C_STATE_UP : DHCPV4C_STATE_DOWN);
+
+    if (up == TRUE && pOpts != NULL)
+    {
+        inet_ntop(AF_INET, &pSession->address, pData->ip, sizeof(pData->ip));
+        inet_ntop(AF_INET, &pOpts->mask, pData->mask, sizeof(pData->mask));
+        inet_ntop(AF_INET, &pOpts->router, pData->gateway, sizeof(pData->gateway));
+        inet_ntop(AF_INET, &pSession->serverId, pData->dhcpServerId, sizeof(pData->dhcpServerId));
+        if (pOpts->dns[0].s_addr != INADDR_ANY)
+        {
+            inet_ntop(AF_INET, &pOpts->dns[0], pData->dnsServer, sizeof(pData->dnsServer));
+        }
+        if (pOpts->dns[1].s_addr != INADDR_ANY)
+        {
+            inet_ntop(AF_INET, &pOpts->dns[1], pData->dnsServer1, sizeof(pData->dnsServer1));
+        }
+        pData->leaseTime = pOpts->leaseSecs;
+        pData->renewalTime = pOpts->t1Secs;
+        pData->rebindingTime = pOpts->t2Secs;
+        pData->isTimeOffsetAssigned = pOpts->hasTimeOffset;
+        pData->timeOffset = pOpts->timeOffset;
+        snprintf(pData->timeZone, sizeof(pData->timeZone), "%s", pOpts->timeZone);
+    }
+
+    Dhcpv4c_QueueReport(pSession, pReport);
+}
+
+/* ---- Sending, called with gDhcpv4cMutex held ---- */
+
+static uint8_t *Dhcpv4c_AddOption(uint8_t *pOpt, uint8_t code, const void *data, uint8_t len)
+{
+    pOpt[0] = code;
+    pOpt[1] = len;
+    memcpy(pOpt + 2, data, len);
+    return pOpt + 2 + len;
+}
+
+static void Dhcpv4c_Send(Dhcpv4cSession_t *pSession, uint8_t type, uint64_t now)
+{
+    uint8_t pkt[sizeof(struct iphdr) + sizeof(struct udphdr) + sizeof(Dhcpv4cMsg_t)];
+    BOOL unicast = (type == DHCPV4C_RELEASE || pSession->state == DHCPV4C_RENEWING) ? TRUE : FALSE;
+    BOOL haveCiaddr = (type == DHCPV4C_RELEASE || pSession->state == DHCPV4C_RENEWING ||
+                       pSession->state == DHCPV4C_REBINDING) ? TRUE : FALSE;
+    uint16_t maxSize = htons(DHCPV4C_MAX_MSG_SIZE);
+    uint8_t clientId[1 + ETH_ALEN];
+    uint8_t addrs[2 * sizeof(uint32_t)];
+    struct sockaddr_ll sll;
+    struct iphdr ip;
+    struct udphdr udp;
+    Dhcpv4cMsg_t msg;
+    uint8_t *pOpt;
+    uint32_t sum = 0;
+    int i;
+
+    memset(&msg, 0, sizeof(msg));
+    msg.op = DHCPV4C_BOOTREQUEST;
+    msg.htype = 1;
+    msg.hlen = ETH_ALEN;
+    msg.xid = pSession->xid;
+    msg.secs = htons((uint16_t)((now - pSession->startMs) / 1000));
+    msg.cookie = htonl(DHCPV4C_MAGIC_COOKIE);
+    memcpy(msg.chaddr, pSession->ifMac, ETH_ALEN);
+    if (haveCiaddr == TRUE)
+    {
+        msg.ciaddr = pSession->address.s_addr;
+    }
+
+    clientId[0] = 1;
+    memcpy(clientId + 1, pSession->ifMac, ETH_ALEN);
+
+    pOpt = Dhcpv4c_AddOption(msg.options, DHCPV4C_OPT_MSG_TYPE, &type, 1);
+    pOpt = Dhcpv4c_AddOption(pOpt, DHCPV4C_OPT_CLIENT_ID, clientId, sizeof(clientId));
+    if (type == DHCPV4C_RELEASE)
+    {
+        pOpt = Dhcpv4c_AddOption(pOpt, DHCPV4C_OPT_SERVER_ID, &pSession->serverId, sizeof(struct in_addr));
+    }
+    else
+    {
+        pOpt = Dhcpv4c_AddOption(pOpt, DHCPV4C_OPT_MAX_MSG_SIZE, &maxSize, sizeof(maxSize));
+        pOpt = Dhcpv4c_AddOption(pOpt, DHCPV4C_OPT_PARAM_LIST, gParamList, sizeof(gParamList));
+        //Ask for the previous address again when discovering, the OFFER when selecting
+        if (haveCiaddr == FALSE && pSession->address.s_addr != INADDR_ANY)
+        {
+            pOpt = Dhcpv4c_AddOption(pOpt, DHCPV4C_OPT_REQUESTED_IP, &pSession->address, sizeof(struct in_addr));
+        }
+        if (pSession->state == DHCPV4C_REQUESTING)
+        {
+            pOpt = Dhcpv4c_AddOption(pOpt, DHCPV4C_OPT_SERVER_ID, &pSession->serverId, sizeof(struct in_addr));
+        }
+    }
+    *pOpt = DHCPV4C_OPT_END;
+
+    memset(&ip, 0, sizeof(ip));
+    ip.version = 4;
+    ip.ihl = sizeof(ip) / 4;
+    ip.tot_len = htons(sizeof(pkt));
+    ip.id = htons((uint16_t) rand_r(&gSeed));
+    ip.ttl = 64;
+    ip.protocol = IPPROTO_UDP;
+    ip.saddr = (haveCiaddr == TRUE) ? pSession->address.s_addr : htonl(INADDR_ANY);
+    ip.daddr = (unicast == TRUE) ? pSession->serverId.s_addr : htonl(INADDR_BROADCAST);
+    ip.check = Dhcpv4c_Checksum(0, &ip, sizeof(ip));
+
+    memset(&udp, 0, sizeof(udp));
+    udp.source = htons(DHCPV4C_CLIENT_PORT);
+    udp.dest = htons(DHCPV4C_SERVER_PORT);
+    udp.len = htons(sizeof(udp) + sizeof(msg));
+
+    //UDP checksum over the pseudo header first
+    memcpy(addrs, &ip.saddr, sizeof(uint32_t));
+    memcpy(addrs + sizeof(uint32_t), &ip.daddr, sizeof(uint32_t));
+    for (i = 0; i < (int) sizeof(addrs); i += 2)
+    {
+        sum += (uint32_t)((addrs[i] << 8) | addrs[i + 1]);
+    }
+    sum += IPPROTO_UDP + ntohs(udp.len);
+    memcpy(pkt + sizeof(ip), &udp, sizeof(udp));
+    memcpy(pkt + sizeof(ip) + sizeof(udp), &msg, sizeof(msg));
+    udp.check = Dhcpv4c_Checksum(sum, pkt + sizeof(ip), sizeof(udp) + sizeof(msg));
+    if (udp.check == 0)
+    {
+        udp.check = 0xFFFF;
+    }
+    memcpy(pkt, &ip, sizeof(ip));
+    memcpy(pkt + sizeof(ip), &udp, sizeof(udp));
+
+    //Unicast goes to the MAC the lease came from, the server or its relay
+    memset(&sll, 0, sizeof(sll));
+    sll.sll_family = AF_PACKET;
+    sll.sll_protocol = htons(ETH_P_IP);
+    sll.sll_ifindex = pSession->ifIndex;
+    sll.sll_halen = ETH_ALEN;
+    memcpy(sll.sll_addr, (unicast == TRUE && memcmp(pSession->serverMac, gZeroMac, ETH_ALEN) != 0) ? pSession->serverMac : gBroadcastMac, ETH_ALEN);
+
+    if (sendto(gPktFd, pkt, sizeof(pkt), 0, (struct sockaddr *) &sll, sizeof(sll)) < 0)
+    {
+        CcspTraceWarning(("%s %d - %s: send failed (%s)\n", __FUNCTION__, __LINE__, pSession->ifName, strerror(errno)));
+    }
+}
+
+/* ---- State machine, called with gDhcpv4cMutex held ---- */
+
+/* Back to discovery, a lease held is reported expired */
+static void Dhcpv4c_Restart(Dhcpv4cSession_t *pSession, uint64_t now, BOOL expired)
+{
+    struct ifreq ifr;
+
+    if (expired == TRUE && pSession->leased == TRUE)
+    {
+        CcspTraceInfo(("%s %d - %s: lease lost\n", __FUNCTION__, __LINE__, pSession->ifName));
+        Dhcpv4c_Report(pSession, FALSE, NULL);
+        pSession->leased = FALSE;
+        pSession->address.s_addr = INADDR_ANY;
+    }
+
+    //The interface index and MAC can change across link flaps
+    pSession->ifIndex = if_nametoindex(pSession->ifName);
+    memset(&ifr, 0, sizeof(ifr));
+    snprintf(ifr.ifr_name, sizeof(ifr.ifr_name), "%s", pSession->ifName);
+    if (ioctl(gPktFd, SIOCGIFHWADDR, &ifr) == 0)
+    {
+        memcpy(pSession->ifMac, ifr.ifr_hwaddr.sa_data, ETH_ALEN);
+    }
+
+    pSession->state = DHCPV4C_SELECTING;
+    pSession->xid = (uint32_t) rand_r(&gSeed);
+    pSession->startMs = now;
+    pSession->nextMs = now;
+    pSession->backoffMs = 0;
+    pSession->tries = 0;
+    pSession->forced = FALSE;
+    pSession->serverId.s_addr = INADDR_ANY;
+}
+
+/* Retransmission deadline in RENEWING or REBINDING: half the time left, at least a minute (RFC 2131 4.4.5) */
+static uint64_t Dhcpv4c_LeaseRetry(uint64_t now, uint64_t limitMs)
+{
+    uint64_t wait = (limitMs > now) ? (limitMs - now) / 2 : 0;
+
+    if (wait < WANMGR_DHCPV4C_MIN_LEASE_RETRY_MS)
+    {
+        wait = WANMGR_DHCPV4C_MIN_LEASE_RETRY_MS;
+    }
+    return (now + wait < limitMs) ? now + wait : limitMs;
+}
+
+static void Dhcpv4c_OnDeadline(Dhcpv4cSession_t *pSession, uint64_t now)
+{
+    switch (pSession->state)
+    {
+        case DHCPV4C_SELECTING:
+            Dhcpv4c_Send(pSession, DHCPV4C_DISCOVER, now);
+            pSession->nextMs = now + Dhcpv4c_Backoff(pSession);
+            break;
+
+        case DHCPV4C_REQUESTING:
+            if (pSession->tries >= WANMGR_DHCPV4C_REQUEST_TRIES)
+            {
+                CcspTraceWarning(("%s %d - %s: no ACK from the server, discovering again\n", __FUNCTION__, __LINE__, pSession->ifName));
+                Dhcpv4c_Restart(pSession, now, FALSE);
+                break;
+            }
+            Dhcpv4c_Send(pSession, DHCPV4C_REQUEST, now);
+            pSession->tries++;
+            pSession->nextMs = now + Dhcpv4c_Backoff(pSession);
+            break;
+
+        case DHCPV4C_BOUND:
+        case DHCPV4C_RENEWING:
+        case DHCPV4C_REBINDING:
+            if (pSession->forced == TRUE)
+            {
+                if (pSession->tries >= WANMGR_DHCPV4C_RENEW_TRIES)
+                {
+                    CcspTraceWarning(("%s %d - %s: renewal not answered, discovering again\n", __FUNCTION__, __LINE__, pSession->ifName));
+                    Dhcpv4c_Restart(pSession, now, TRUE);
+                    break;
+                }
+                Dhcpv4c_Send(pSession, DHCPV4C_REQUEST, now);
+                pSession->tries++;
+                pSession->nextMs = now + WANMGR_DHCPV4C_MIN_BACKOFF_MS;
+                break;
+            }
+
+            if (pSession->expiryMs != 0 && now >= pSession->expiryMs)
+            {
+                Dhcpv4c_Restart(pSession, now, TRUE);
+                break;
+            }
+            if (pSession->state != DHCPV4C_REBINDING)
+            {
+                if (pSession->state == DHCPV4C_BOUND)
+                {
+                    pSession->startMs = now;
+                }
+                pSession->state = (now >= pSession->t2Ms) ? DHCPV4C_REBINDING : DHCPV4C_RENEWING;
+                if (pSession->tries == 0 || pSession->state == DHCPV4C_REBINDING)
+                {
+                    CcspTraceInfo(("%s %d - %s: %s\n", __FUNCTION__, __LINE__, pSession->ifName, Dhcpv4c_StateName(pSession->state)));
+                }
+            }
+            Dhcpv4c_Send(pSession, DHCPV4C_REQUEST, now);
+            pSession->tries++;
+            pSession->nextMs = Dhcpv4c_LeaseRetry(now, (pSession->state == DHCPV4C_RENEWING) ? pSession->t2Ms : pSession->expiryMs);
+            break;
+    }
+}
+
+static void Dhcpv4c_Bind(Dhcpv4cSession_t *pSession, const Dhcpv4cMsg_t *pMsg, Dhcpv4cOptions_t *pOpts,
+                         const struct sockaddr_ll *pFrom, uint64_t now)
+{
+    uint32_t lease = (pOpts->hasLease == TRUE) ? pOpts->leaseSecs : DHCPV4C_INFINITE_LEASE;
+    char addr[INET_ADDRSTRLEN] = {0};
+
+    pSession->address.s_addr = pMsg->yiaddr;
+    if (pOpts->serverId.s_addr != INADDR_ANY)
+    {
+        pSession->serverId = pOpts->serverId;
+    }
+    if (pFrom->sll_halen == ETH_ALEN)
+    {
+        memcpy(pSession->serverMac, pFrom->sll_addr, ETH_ALEN);
+    }
+
+    //T1 and T2 default to half and seven eighths of the lease, an infinite lease is never renewed
+    if (lease == DHCPV4C_INFINITE_LEASE)
+    {
+        pOpts->t1Secs = pOpts->t2Secs = DHCPV4C_INFINITE_LEASE;
+        pSession->t1Ms = pSession->t2Ms = pSession->expiryMs = 0;
+    }
+    else
+    {
+        if (pOpts->hasT2 != TRUE || pOpts->t2Secs > lease)
+        {
+            pOpts->t2Secs = (uint32_t)((uint64_t) lease * 7 / 8);
+        }
+        if (pOpts->hasT1 != TRUE || pOpts->t1Secs > pOpts->t2Secs)
+        {
+            pOpts->t1Secs = (pOpts->t2Secs < lease / 2) ? pOpts->t2Secs : lease / 2;
+        }
+        pSession->t1Ms = now + (uint64_t) pOpts->t1Secs * 1000ULL;
+        pSession->t2Ms = now + (uint64_t) pOpts->t2Secs * 1000ULL;
+        pSession->expiryMs = now + (uint64_t) lease * 1000ULL;
+    }
+    pOpts->leaseSecs = lease;
+
+    pSession->state = DHCPV4C_BOUND;
+    pSession->nextMs = pSession->t1Ms;
+    pSession->backoffMs = 0;
+    pSession->tries = 0;
+    pSession->forced = FALSE;
+    pSession->leased = TRUE;
+
+    inet_ntop(AF_INET, &pSession->address, addr, sizeof(addr));
+    CcspTraceInfo(("%s %d - %s: bound to %s for %u s\n", __FUNCTION__, __LINE__, pSession->ifName, addr, lease));
+    Dhcpv4c_Report(pSession, TRUE, pOpts);
+}
+
+static void Dhcpv4c_OnReply(Dhcpv4cSession_t *pSession, const Dhcpv4cMsg_t *pMsg, Dhcpv4cOptions_t *pOpts,
+                            const struct sockaddr_ll *pFrom, uint64_t now)
+{
+    switch (pSession->state)
+    {
+        case DHCPV4C_SELECTING:
+            if (pOpts->msgType != DHCPV4C_OFFER || pMsg->yiaddr == INADDR_ANY || pOpts->serverId.s_addr == INADDR_ANY)
+            {
+                return;
+            }
+            pSession->address.s_addr = pMsg->yiaddr;
+            pSession->serverId = pOpts->serverId;
+            pSession->state = DHCPV4C_REQUESTING;
+            pSession->backoffMs = 0;
+            pSession->tries = 0;
+            Dhcpv4c_OnDeadline(pSession, now);
+            break;
+
+        case DHCPV4C_REQUESTING:
+            //The REQUEST named the server, answers of the others are for them
+            if (pOpts->serverId.s_addr != INADDR_ANY && pOpts->serverId.s_addr != pSession->serverId.s_addr)
+            {
+                return;
+            }
+            /* fall through */
+        case DHCPV4C_RENEWING:
+        case DHCPV4C_REBINDING:
+            if (pOpts->msgType == DHCPV4C_ACK && pMsg->yiaddr != INADDR_ANY)
+            {
+                Dhcpv4c_Bind(pSession, pMsg, pOpts, pFrom, now);
+            }
+            else if (pOpts->msgType == DHCPV4C_NAK)
+            {
+                CcspTraceWarning(("%s %d - %s: NAK in %s\n", __FUNCTION__, __LINE__, pSession->ifName, Dhcpv4c_StateName(pSession->state)));
+                Dhcpv4c_Restart(pSession, now, TRUE);
+                pSession->address.s_addr = INADDR_ANY;
+                pSession->nextMs = now + WANMGR_DHCPV4C_NAK_DELAY_MS;
+            }
+            break;
+
+        case DHCPV4C_BOUND:
+            break;
+    }
+}
+
+/* ---- Receiving ---- */
+
+/* First address of an address list option */
+static void Dhcpv4c_GetAddr(const uint8_t *v, uint8_t len, struct in_addr *pAddr)
+{
+    if (len >= sizeof(struct in_addr))
+    {
+        memcpy(pAddr, v, sizeof(struct in_addr));
+    }
+}
+
+static BOOL Dhcpv4c_GetUint32(const uint8_t *v, uint8_t len, uint32_t *pValue)
+{
+    uint32_t value;
+
+    if (len != sizeof(value))
+    {
+        return FALSE;
+    }
+    memcpy(&value, v, sizeof(value));
+    *pValue = ntohl(value);
+    return TRUE;
+}
+
+static void Dhcpv4c_ParseOptions(const uint8_t *p, size_t len, Dhcpv4cOptions_t *pOpts, uint8_t *pOverload)
+{
+    size_t off = 0;
+
+    while (off < len && p[off] != DHCPV4C_OPT_END)
+    {
+        uint8_t code = p[off];
+        uint8_t optLen;
+        const uint8_t *v;
+
+        if (code == DHCPV4C_OPT_PAD)
+        {
+            off++;
+            continue;
+        }
+        if (off + 2 > len || off + 2 + p[off + 1] > len)
+        {
+            break;
+        }
+        optLen = p[off + 1];
+        v = p + off + 2;
+        off += 2 + optLen;
+
+        switch (code)
+        {
+            case DHCPV4C_OPT_MSG_TYPE:
+                if (optLen == 1)
+                {
+                    pOpts->msgType = v[0];
+                }
+                break;
+            case DHCPV4C_OPT_SERVER_ID:
+                Dhcpv4c_GetAddr(v, optLen, &pOpts->serverId);
+                break;
+            case DHCPV4C_OPT_SUBNET_MASK:
+                Dhcpv4c_GetAddr(v, optLen, &pOpts->mask);
+                break;
+            case DHCPV4C_OPT_ROUTER:
+                Dhcpv4c_GetAddr(v, optLen, &pOpts->router);
+                break;
+            case DHCPV4C_OPT_DNS:
+                Dhcpv4c_GetAddr(v, optLen, &pOpts->dns[0]);
+                if (optLen >= 2 * sizeof(struct in_addr))
+                {
+                    Dhcpv4c_GetAddr(v + sizeof(struct in_addr), optLen - sizeof(struct in_addr), &pOpts->dns[1]);
+                }
+                break;
+            case DHCPV4C_OPT_LEASE_TIME:
+                pOpts->hasLease = Dhcpv4c_GetUint32(v, optLen, &pOpts->leaseSecs);
+                break;
+            case DHCPV4C_OPT_T1:
+                pOpts->hasT1 = Dhcpv4c_GetUint32(v, optLen, &pOpts->t1Secs);
+                break;
+            case DHCPV4C_OPT_T2:
+                pOpts->hasT2 = Dhcpv4c_GetUint32(v, optLen, &pOpts->t2Secs);
+                break;
+            case DHCPV4C_OPT_TIME_OFFSET:
+                pOpts->hasTimeOffset = Dhcpv4c_GetUint32(v, optLen, (uint32_t *) &pOpts->timeOffset);
+                break;
+            case DHCPV4C_OPT_POSIX_TZ:
+            case DHCPV4C_OPT_TZ_DATABASE:
+                //The POSIX string is preferred, the database name is only taken without one
+                if (code == DHCPV4C_OPT_POSIX_TZ || pOpts->timeZone[0] == '\0')
+                {
+                    snprintf(pOpts->timeZone, sizeof(pOpts->timeZone), "%.*s", (int) optLen, (const char *) v);
+                }
+                break;
+            case DHCPV4C_OPT_OVERLOAD:
+                if (optLen == 1 && pOverload != NULL)
+                {
+                    *pOverload = v[0];
+                }
+                break;
+        }
+    }
+}
+
+/* Parse a received IP packet, FALSE unless it is a BOOTREPLY with a message type */
+static BOOL Dhcpv4c_Parse(const uint8_t *pkt, int len, const Dhcpv4cMsg_t **ppMsg, Dhcpv4cOptions_t *pOpts)
+{
+    const struct iphdr *pIp = (const struct iphdr *) pkt;
+    const Dhcpv4cMsg_t *pMsg;
+    size_t ipLen;
+    size_t totLen;
+    size_t msgLen;
+    uint8_t overload = 0;
+
+    if (len < (int) sizeof(struct iphdr) || pIp->version != 4)
+    {
+        return FALSE;
+    }
+
+    //Trailing link layer padding is not part of the message
+    ipLen = pIp->ihl * 4;
+    totLen = ntohs(pIp->tot_len);
+    if (ipLen < sizeof(struct iphdr) || totLen > (size_t) len ||
+        totLen < ipLen + sizeof(struct udphdr) + offsetof(Dhcpv4cMsg_t, options))
+    {
+        return FALSE;
+    }
+
+    pMsg = (const Dhcpv4cMsg_t *)(pkt + ipLen + sizeof(struct udphdr));
+    msgLen = totLen - ipLen - sizeof(struct udphdr);
+    if (pMsg->op != DHCPV4C_BOOTREPLY || pMsg->cookie != htonl(DHCPV4C_MAGIC_COOKIE))
+    {
+        return FALSE;
+    }
+
+    memset(pOpts, 0, sizeof(Dhcpv4cOptions_t));
+    Dhcpv4c_ParseOptions(pMsg->options, msgLen - offsetof(Dhcpv4cMsg_t, options), pOpts, &overload);
+    if (overload & 1)
+    {
+        Dhcpv4c_ParseOptions(pMsg->file, sizeof(pMsg->file), pOpts, NULL);
+    }
+    if (overload & 2)
+    {
+        Dhcpv4c_ParseOptions(pMsg->sname, sizeof(pMsg->sname), pOpts, NULL);
+    }
+
+    *ppMsg = pMsg;
+    return (pOpts->msgType != 0) ? TRUE : FALSE;
+}
+
+/* Arm the timer for the earliest session, called with gDhcpv4cMutex held */
+static void Dhcpv4c_ArmTimer(void)
+{
+    struct itimerspec its;
+    uint64_t next = 0;
+    int idx;
+
+    for (idx = 0; idx < WANMGR_DHCPV4C_MAX_IFACES; idx++)
+    {
+        if (gSessions[idx].inUse == TRUE && gSessions[idx].nextMs != 0 && (next == 0 || gSessions[idx].nextMs < next))
+        {
+            next = gSessions[idx].nextMs;
+        }
+        if (gSessions[idx].inUse == TRUE && gSessions[idx].pReport != NULL && (next == 0 || gSessions[idx].reportMs < next))
+        {
+            next = gSessions[idx].reportMs;
+        }
+    }
+
+    memset(&its, 0, sizeof(its));
+    if (next != 0)
+    {
+        its.it_value.tv_sec = next / 1000;
+        its.it_value.tv_nsec = (long)(next % 1000) * 1000000L;
+    }
+    timerfd_settime(gTimerFd, TFD_TIMER_ABSTIME, &its, NULL);
+}
+
+static void Dhcpv4c_OnPacket(int fd, uint32_t events, void *arg)
+{
+    uint8_t pkt[DHCPV4C_PKT_MAX];
+    const Dhcpv4cMsg_t *pMsg = NULL;
+    Dhcpv4cOptions_t opts;
+    struct sockaddr_ll sll;
+    socklen_t sllLen;
+    int len;
+    int idx;
+
+    for (;;)
+    {
+        sllLen = sizeof(sll);
+        if ((len = recvfrom(fd, pkt, sizeof(pkt), 0, (struct sockaddr *) &sll, &sllLen)) < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            break;
+        }
+
+        if (Dhcpv4c_Parse(pkt, len, &pMsg, &opts) != TRUE)
+        {
+            continue;
+        }
+
+        pthread_mutex_lock(&gDhcpv4cMutex);
+        for (idx = 0; idx < WANMGR_DHCPV4C_MAX_IFACES; idx++)
+        {
+            Dhcpv4cSession_t *pSession = &gSessions[idx];
+
+            if (pSession->inUse == TRUE && pSession->ifIndex == sll.sll_ifindex && pSession->xid == pMsg->xid &&
+                memcmp(pMsg->chaddr, pSession->ifMac, ETH_ALEN) == 0)
+            {
+                Dhcpv4c_OnReply(pSession, pMsg, &opts, &sll, Dhcpv4c_NowMs());
+                break;
+            }
+        }
+        Dhcpv4c_ArmTimer();
+        pthread_mutex_unlock(&gDhcpv4cMutex);
+    }
+}
+
+static void Dhcpv4c_OnTimer(int fd, uint32_t events, void *arg)
+{
+    uint64_t expirations;
+    uint64_t now;
+    int idx;
+
+    if (read(fd, &expirations, sizeof(expirations)) != sizeof(expirations))
+    {
+        return;
+    }
+
+    pthread_mutex_lock(&gDhcpv4cMutex);
+    now = Dhcpv4c_NowMs();
+    for (idx = 0; idx < WANMGR_DHCPV4C_MAX_IFACES; idx++)
+    {
+        Dhcpv4cSession_t *pSession = &gSessions[idx];
+
+        if (pSession->inUse == TRUE && pSession->nextMs != 0 && pSession->nextMs <= now)
+        {
+            Dhcpv4c_OnDeadline(pSession, now);
+        }
+        if (pSession->inUse == TRUE && pSession->pReport != NULL && pSession->reportMs <= now)
+        {
+            Dhcpv4cReport_t *pReport = pSession->pReport;
+
+            pSession->pReport = NULL;
+            pSession->reportMs = 0;
+            Dhcpv4c_QueueReport(pSession, pReport);
+        }
+    }
+    Dhcpv4c_ArmTimer();
+    pthread_mutex_unlock(&gDhcpv4cMutex);
+}
+
+/* ---- Setup ---- */
+
+static void Dhcpv4c_Init(void)
+{
+    /* Runs on the packet from the IP header: UDP, not a fragment, to the client port, not our own */
+    struct sock_filter filter[] =
+    {
+        BPF_STMT(BPF_LD | BPF_W | BPF_ABS, SKF_AD_OFF + SKF_AD_PKTTYPE),
+        BPF_JUMP(BPF_JMP | BPF_JEQ | BPF_K, PACKET_OUTGOING, 8, 0),
+        BPF_STMT(BPF_LD | BPF_B | BPF_ABS, 9),
+        BPF_JUMP(BPF_JMP | BPF_JEQ | BPF_K, IPPROTO_UDP, 0, 6),
+        BPF_STMT(BPF_LD | BPF_H | BPF_ABS, 6),
+        BPF_JUMP(BPF_JMP | BPF_JSET | BPF_K, 0x1FFF, 4, 0),
+        BPF_STMT(BPF_LDX | BPF_B | BPF_MSH, 0),
+        BPF_STMT(BPF_LD | BPF_H | BPF_IND, 2),
+        BPF_JUMP(BPF_JMP | BPF_JEQ | BPF_K, DHCPV4C_CLIENT_PORT, 0, 1),
+        BPF_STMT(BPF_RET | BPF_K, 0xFFFF),
+        BPF_STMT(BPF_RET | BPF_K, 0),
+    };
+    struct sock_filter dropAll[] =
+    {
+        BPF_STMT(BPF_RET | BPF_K, 0),
+    };
+    struct sock_fprog prog;
+    struct sockaddr_in sin;
+    int on = 1;
+
+    gSeed = (unsigned int)(Dhcpv4c_NowMs() ^ (uint64_t) getpid());
+
+    if ((gTimerFd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC)) < 0 ||
+        (gPktFd = socket(AF_PACKET, SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC, htons(ETH_P_IP))) < 0)
+    {
+        CcspTraceError(("%s %d - DHCPv4 client sockets failed (%s)\n", __FUNCTION__, __LINE__, strerror(errno)));
+        return;
+    }
+
+    prog.len = sizeof(filter) / sizeof(filter[0]);
+    prog.filter = filter;
+    if (setsockopt(gPktFd, SOL_SOCKET, SO_ATTACH_FILTER, &prog, sizeof(prog)) < 0)
+    {
+        CcspTraceError(("%s %d - DHCPv4 client filter failed (%s)\n", __FUNCTION__, __LINE__, strerror(errno)));
+        return;
+    }
+
+    //Replies to a configured address also reach the UDP stack, a socket on the port keeps
+    //it from answering them with port unreachable. Nothing is read from it.
+    memset(&sin, 0, sizeof(sin));
+    sin.sin_family = AF_INET;
+    sin.sin_port = htons(DHCPV4C_CLIENT_PORT);
+    prog.len = sizeof(dropAll) / sizeof(dropAll[0]);
+    prog.filter = dropAll;
+    if ((gSinkFd = socket(AF_INET, SOCK_DGRAM | SOCK_CLOEXEC, 0)) < 0 ||
+        setsockopt(gSinkFd, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on)) < 0 ||
+        setsockopt(gSinkFd, SOL_SOCKET, SO_ATTACH_FILTER, &prog, sizeof(prog)) < 0 ||
+        bind(gSinkFd, (struct sockaddr *) &sin, sizeof(sin)) < 0)
+    {
+        CcspTraceWarning(("%s %d - DHCPv4 client port not held (%s)\n", __FUNCTION__, __LINE__, strerror(errno)));
+    }
+
+    if (WanMgr_EventLoop_AddFd(gTimerFd, "dhcpv4c-timer", Dhcpv4c_OnTimer, NULL) != ANSC_STATUS_SUCCESS ||
+        WanMgr_EventLoop_AddFd(gPktFd, "dhcpv4c-pkt", Dhcpv4c_OnPacket, NULL) != ANSC_STATUS_SUCCESS)
+    {
+        return;
+    }
+
+    gDhcpv4cReady = TRUE;
+}
+
+/* Session of ifName, called with gDhcpv4cMutex held */
+static int Dhcpv4c_FindSession(const char *ifName)
+{
+    int idx;
+
+    for (idx = 0; idx < WANMGR_DHCPV4C_MAX_IFACES; idx++)
+    {
+        if (gSessions[idx].inUse == TRUE && strcmp(gSessions[idx].ifName, ifName) == 0)
+        {
+            return idx;
+        }
+    }
+    return -1;
+}
+
+/* ---- Public Functions ------------------------------------- */
+
+ANSC_STATUS WanMgr_Dhcpv4c_Start(const char *ifName)
+{
+    Dhcpv4cSession_t *pSession;
+    int idx;
+
+    if (ifName == NULL || ifName[0] == '\0')
+    {
+        return ANSC_STATUS_BAD_PARAMETER;
+    }
+
+    pthread_once(&gDhcpv4cOnce, Dhcpv4c_Init);
+    if (gDhcpv4cReady != TRUE)
+    {
+        CcspTraceError(("%s %d - embedded DHCPv4 client unavailable\n", __FUNCTION__, __LINE__));
+        return ANSC_STATUS_FAILURE;
+    }
+
+    pthread_mutex_lock(&gDhcpv4cMutex);
+    if (Dhcpv4c_FindSession(ifName) >= 0)
+    {
+        pthread_mutex_unlock(&gDhcpv4cMutex);
+        CcspTraceInfo(("%s %d - DHCPv4 client of %s already running\n", __FUNCTION__, __LINE__, ifName));
+        return ANSC_STATUS_SUCCESS;
+    }
+
+    for (idx = 0; idx < WANMGR_DHCPV4C_MAX_IFACES; idx++)
+    {
+        if (gSessions[idx].inUse != TRUE)
+        {
+            break;
+        }
+    }
+
+    if (idx >= WANMGR_DHCPV4C_MAX_IFACES)
+    {
+        pthread_mutex_unlock(&gDhcpv4cMutex);
+        CcspTraceError(("%s %d - no free DHCPv4 client for %s\n", __FUNCTION__, __LINE__, ifName));
+        return ANSC_STATUS_RESOURCES;
+    }
+
+    pSession = &gSessions[idx];
+    memset(pSession, 0, sizeof(Dhcpv4cSession_t));
+    snprintf(pSession->ifName, sizeof(pSession->ifName), "%s", ifName);
+    pSession->inUse = TRUE;
+    Dhcpv4c_Restart(pSession, Dhcpv4c_NowMs(), FALSE);
+    Dhcpv4c_ArmTimer();
+    pthread_mutex_unlock(&gDhcpv4cMutex);
+
+    CcspTraceInfo(("%s %d - DHCPv4 client started on %s\n", __FUNCTION__, __LINE__, ifName));
+    return ANSC_STATUS_SUCCESS;
+}
+
+ANSC_STATUS WanMgr_Dhcpv4c_Renew(const char *ifName)
+{
+    ANSC_STATUS ret = ANSC_STATUS_FAILURE;
+    uint64_t now;
+    int idx;
+
+    pthread_mutex_lock(&gDhcpv4cMutex);
+    now = Dhcpv4c_NowMs();
+    for (idx = 0; idx < WANMGR_DHCPV4C_MAX_IFACES; idx++)
+    {
+        Dhcpv4cSession_t *pSession = &gSessions[idx];
+
+        if (pSession->inUse != TRUE || (ifName != NULL && strcmp(pSession->ifName, ifName) != 0))
+        {
+            continue;
+        }
+
+        CcspTraceInfo(("%s %d - renewing the DHCPv4 lease of %s in %s\n", __FUNCTION__, __LINE__, pSession->ifName, Dhcpv4c_StateName(pSession->state)));
+        if (pSession->leased == TRUE)
+        {
+            //Unicast to the server of the lease, a few quick tries then discovery
+            pSession->state = DHCPV4C_RENEWING;
+            pSession->xid = (uint32_t) rand_r(&gSeed);
+            pSession->startMs = now;
+            pSession->nextMs = now;
+            pSession->tries = 0;
+            pSession->forced = TRUE;
+        }
+        else
+        {
+            Dhcpv4c_Restart(pSession, now, FALSE);
+        }
+        ret = ANSC_STATUS_SUCCESS;
+    }
+
+    if (gDhcpv4cReady == TRUE)
+    {
+        Dhcpv4c_ArmTimer();
+    }
+    pthread_mutex_unlock(&gDhcpv4cMutex);
+
+    return ret;
+}
+
+ANSC_STATUS WanMgr_Dhcpv4c_Stop(const char *ifName, BOOL release)
+{
+    uint64_t now;
+    int idx;
+
+    pthread_mutex_lock(&gDhcpv4cMutex);
+    now = Dhcpv4c_NowMs();
+    for (idx = 0; idx < WANMGR_DHCPV4C_MAX_IFACES; idx++)
+    {
+        Dhcpv4cSession_t *pSession = &gSessions[idx];
+
+        if (pSession->inUse != TRUE || (ifName != NULL && strcmp(pSession->ifName, ifName) != 0))
+        {
+            continue;
+        }
+
+        if (release == TRUE && pSession->leased == TRUE)
+        {
+            char addr[INET_ADDRSTRLEN] = {0};
+
+            inet_ntop(AF_INET, &pSession->address, addr, sizeof(addr));
+            CcspTraceInfo(("%s %d - releasing %s on %s\n", __FUNCTION__, __LINE__, addr, pSession->ifName));
+            pSession->xid = (uint32_t) rand_r(&gSeed);
+            pSession->startMs = now;
+            Dhcpv4c_Send(pSession, DHCPV4C_RELEASE, now);
+        }
+        CcspTraceInfo(("%s %d - DHCPv4 client stopped on %s\n", __FUNCTION__, __LINE__, pSession->ifName));
+        free(pSession->pReport);
+        pSession->pReport = NULL;
+        pSession->inUse = FALSE;
+    }
+
+    if (gDhcpv4cReady == TRUE)
+    {
+        Dhcpv4c_ArmTimer();
+    }
+    pthread_mutex_unlock(&gDhcpv4cMutex);
+
+    return ANSC_STATUS_SUCCESS;
+}
+
+BOOL WanMgr_Dhcpv4c_IsRunning(const char *ifName)
+{
+    BOOL running = FALSE;
+    int idx;
+
+    pthread_mutex_lock(&gDhcpv4cMutex);
+    for (idx = 0; idx < WANMGR_DHCPV4C_MAX_IFACES; idx++)
+    {
+        if (gSessions[idx].inUse == TRUE && (ifName == NULL || strcmp(gSessions[idx].ifName, ifName) == 0))
+        {
+            running = TRUE;
+            break;
+        }
+    }
+    pthread_mutex_unlock(&gDhcpv4cMutex);
+
+    return running;
+}
+
+#endif /* FEATURE_EMBEDDED_DHCPV4_CLIENT */
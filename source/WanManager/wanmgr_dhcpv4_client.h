@@ -0,0 +1,75 @@
+/*
+ * If not stated otherwise in this file or this component's Licenses.txt file the
+ * following copyright and licenses apply:
+ *
+ * Copyright 2020 RDK Management
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+*/
+
+#ifndef _WANMGR_DHCPV4_CLIENT_H_
+#define _WANMGR_DHCPV4_CLIENT_H_
+
+/* Embedded DHCPv4 client (FEATURE_EMBEDDED_DHCPV4_CLIENT). Runs the RFC 2131
+ * client state machine on the event loop over one packet socket shared by
+ * all interfaces, instead of a udhcpc process and its action handler. A
+ * lease is handed to the same code as a lease received over IPC, so the
+ * interface state machine, sysevents and Device.DHCPv4.Client see no
+ * difference. The address itself is configured by the state machine. */
+
+/* ---- Include Files ---------------------------------------- */
+#include "ansc_platform.h"
+
+/* ---- Global Constants -------------------------------------- */
+#define WANMGR_DHCPV4C_MAX_IFACES           8
+#define WANMGR_DHCPV4C_MIN_BACKOFF_MS       4000    /* first retransmission, doubled up to the max */
+#define WANMGR_DHCPV4C_MAX_BACKOFF_MS       64000
+#define WANMGR_DHCPV4C_REQUEST_TRIES        4       /* REQUEST retransmissions before discovering again */
+#define WANMGR_DHCPV4C_RENEW_TRIES          3       /* unanswered forced renewals before discovering again */
+#define WANMGR_DHCPV4C_MIN_LEASE_RETRY_MS   60000   /* RENEWING/REBINDING retransmit at least this far apart */
+#define WANMGR_DHCPV4C_NAK_DELAY_MS         3000    /* discovery restarts this long after a NAK */
+
+/* ---- Global Prototypes -------------------------------------- */
+
+/***************************************************************************
+ * @brief Start the DHCPv4 client of an interface. Discovery starts right
+ * away, nothing is done if the client is already running.
+ * @param ifName WAN interface name
+ * @return ANSC_STATUS_SUCCESS upon success else returned error code.
+ ****************************************************************************/
+ANSC_STATUS WanMgr_Dhcpv4c_Start(const char *ifName);
+
+/***************************************************************************
+ * @brief Renew the lease now. Without a lease discovery is restarted.
+ * @param ifName WAN interface name, NULL for every interface
+ * @return ANSC_STATUS_SUCCESS if a client was renewed else ANSC_STATUS_FAILURE.
+ ****************************************************************************/
+ANSC_STATUS WanMgr_Dhcpv4c_Renew(const char *ifName);
+
+/***************************************************************************
+ * @brief Stop the DHCPv4 client of an interface. The lease is not reported
+ * down, the caller tears the connection down itself.
+ * @param ifName WAN interface name, NULL for every interface
+ * @param release TRUE to send a DHCPRELEASE for the lease held
+ * @return ANSC_STATUS_SUCCESS upon success else returned error code.
+ ****************************************************************************/
+ANSC_STATUS WanMgr_Dhcpv4c_Stop(const char *ifName, BOOL release);
+
+/***************************************************************************
+ * @brief Check whether the DHCPv4 client of an interface is running.
+ * @param ifName WAN interface name, NULL for any interface
+ * @return TRUE if running else FALSE.
+ ****************************************************************************/
+BOOL WanMgr_Dhcpv4c_IsRunning(const char *ifName);
+
+#endif /* _WANMGR_DHCPV4_CLIENT_H_ */
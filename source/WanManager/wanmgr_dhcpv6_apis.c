@@ -23,11 +23,17 @@
 #include "wanmgr_ipc.h"
 #include "wanmgr_utils.h"
 #include "wanmgr_net_utils.h"
+#include "wanmgr_event_loop.h"
+#include "wanmgr_ipv6_subprefix.h"
+#ifdef FEATURE_EMBEDDED_DHCPV6_CLIENT
+#include "wanmgr_dhcpv6_client.h"
+#endif
 
 
 #include <sysevent/sysevent.h>
 #include <net/if.h>
 #include <sys/ioctl.h>
+#include <sys/socket.h>
 #include <ctype.h>
 #include "syscfg.h"
 
@@ -36,9 +42,6 @@ extern token_t sysevent_token;
 extern ANSC_HANDLE bus_handle;
 extern char g_Subsystem[32];
 
-#define IFADDRCONF_ADD 0
-#define IFADDRCONF_REMOVE 1
-
 
 #ifdef _HUB4_PRODUCT_REQ_
 #include "wanmgr_ipc.h"
@@ -59,12 +62,32 @@ extern char g_Subsystem[32];
 #define CLIENT_BIN     "dibbler-client"
 
 
+#define DHCPV6C_FIFO_MSG_SIZE   1024
+#define DHCPV6C_FIFO_RING_SIZE  4096    /* several messages, dibbler writes one line per event */
+
+/* Line framing of the dibbler fifo, a read can end in the middle of a
+ * message or hold several of them. */
+typedef struct {
+    char               data[DHCPV6C_FIFO_RING_SIZE];
+    size_t             head;        /* first unread byte */
+    size_t             count;       /* bytes buffered */
+    UINT               records;
+    UINT               dropped;     /* bytes discarded on overflow */
+} dhcpv6c_fifo_ring_t;
+
 static struct {
-    pthread_t          dhcpv6c_thread;
-}gDhcpv6c_ctx;
+    int                fifoFd;
+    BOOL               lanIfEventsEnabled;   /* LnF/XHS route handling armed */
+    BOOL               leasePending;
+    WANMGR_DHCPV6C_LEASE pendingLease;    /* waiting for multinet_1 */
+    dhcpv6c_fifo_ring_t ring;
+}gDhcpv6c_ctx = { -1, FALSE, FALSE };
 
 extern WANMGR_BACKEND_OBJ* g_pWanMgrBE;
-static void * dhcpv6c_dbg_thrd(void * in);
+static ANSC_STATUS dhcpv6c_fifo_init(void);
+static void dhcpv6c_multinet_lan_status(const char *name, const char *val);
+static void dhcpv6c_multinet_lnf_status(const char *name, const char *val);
+static void dhcpv6c_multinet_xhs_status(const char *name, const char *val);
 
 /*erouter topology mode*/
 enum tp_mod {
@@ -100,8 +123,6 @@ typedef struct ipv6_prefix {
 static char v6addr_prev[IPV6_PREF_MAXLEN] = {0};
 #endif
 
-void _get_shell_output(char * cmd, char * out, int len);
-int _get_shell_output2(char * cmd, char * dststr);
 static int _prepare_client_conf(PDML_DHCPCV6_CFG       pCfg);
 static int _dibbler_client_operation(char * arg);
 
@@ -112,52 +133,45 @@ void _cosa_dhcpsv6_refresh_config();
 
 static int DHCPv6sDmlTriggerRestart(BOOL OnlyTrigger);
 
-void _get_shell_output(char * cmd, char * out, int len)
+/* Turns on net.ipv6.conf.<ifName>.autoconf, TRUE if it was off before */
+static BOOL dhcpv6_enable_autoconf(const char *ifName)
 {
-    FILE * fp;
-    char   buf[256];
-    char * p;
+    char path[BUFLEN_128] = {0};
+    char oldValue[BUFLEN_32] = {0};
 
-    fp = popen(cmd, "r");
-
-    if (fp)
+    snprintf(path, sizeof(path), "/proc/sys/net/ipv6/conf/%s/autoconf", ifName);
+    if (WanManager_SetProcSysValue(path, "1", oldValue, sizeof(oldValue)) != RETURN_OK)
     {
-        fgets(buf, sizeof(buf), fp);
-
-        /*we need to remove the \n char in buf*/
-        if ((p = strchr(buf, '\n'))) *p = 0;
-
-        strncpy(out, buf, len-1);
-
-        pclose(fp);
+        return FALSE;
     }
 
+    return (strcmp(oldValue, "0") == 0) ? TRUE : FALSE;
 }
 
-int _get_shell_output2(char * cmd, char * dststr)
+/* MAC address of ifName as "XX:XX:XX:XX:XX:XX", the format ifconfig prints */
+static int dhcpv6_get_if_hwaddr(const char *ifName, char *out, size_t len)
 {
-    FILE * fp;
-    char   buf[256];
-    char * p;
-    int   bFound = 0;
+    struct ifreq ifr;
+    unsigned char *mac;
+    int fd;
 
-    fp = popen(cmd, "r");
-
-    if (fp)
+    if ((fd = socket(AF_INET, SOCK_DGRAM | SOCK_CLOEXEC, 0)) < 0)
     {
-        while( fgets(buf, sizeof(buf), fp) )
-        {
-            if (strstr(buf, dststr))
-            {
-                bFound = 1;;
-                break;
-            }
-        }
+        return RETURN_ERR;
+    }
 
-        pclose(fp);
+    memset(&ifr, 0, sizeof(ifr));
+    strncpy(ifr.ifr_name, ifName, IFNAMSIZ - 1);
+    if (ioctl(fd, SIOCGIFHWADDR, &ifr) < 0)
+    {
+        close(fd);
+        return RETURN_ERR;
     }
+    close(fd);
 
-    return bFound;
+    mac = (unsigned char *) ifr.ifr_hwaddr.sa_data;
+    snprintf(out, len, "%02X:%02X:%02X:%02X:%02X:%02X", mac[0], mac[1], mac[2], mac[3], mac[4], mac[5]);
+    return RETURN_OK;
 }
 
 #if defined(CISCO_CONFIG_DHCPV6_PREFIX_DELEGATION) && ! defined(_CBR_PRODUCT_REQ_) && ! defined(_BCI_FEATURE_REQ)
@@ -172,14 +186,20 @@ WanMgr_DmlDhcpv6SMsgHandler
     UNREFERENCED_PARAMETER(hContext);
     char ret[16] = {0};
     CcspTraceWarning(("%s -- %d Inside WanMgr_DmlDhcpv6SMsgHandler \n", __FUNCTION__, __LINE__));
-    CcspTraceWarning(("%s -- %d dhcpv6c_dbg_thrd invoking  \n", __FUNCTION__, __LINE__));
-    /*we start a thread to hear dhcpv6 client message about prefix/address */
+    CcspTraceWarning(("%s -- %d dhcpv6c fifo listener registering  \n", __FUNCTION__, __LINE__));
+    /*we listen on the fifo for dhcpv6 client message about prefix/address */
     if ( ( !mkfifo(CCSP_COMMON_FIFO, 0666) || errno == EEXIST ) )
     {
-        if (pthread_create(&gDhcpv6c_ctx.dhcpv6c_thread, NULL, dhcpv6c_dbg_thrd, NULL)  || pthread_detach(gDhcpv6c_ctx.dhcpv6c_thread))
-            CcspTraceWarning(("%s error in creating dhcpv6c_dbg_thrd\n", __FUNCTION__));
+        if (dhcpv6c_fifo_init() != ANSC_STATUS_SUCCESS)
+            CcspTraceWarning(("%s error in registering dhcpv6c fifo\n", __FUNCTION__));
     }
 
+    /* The multinet handlers are armed later, they must be subscribed before
+     * the sysevent module starts receiving. */
+    wanmgr_sysevents_registerHandler("multinet_1-status", dhcpv6c_multinet_lan_status, TRUE);
+    wanmgr_sysevents_registerHandler("multinet_6-status", dhcpv6c_multinet_lnf_status, TRUE);
+    wanmgr_sysevents_registerHandler("multinet_2-status", dhcpv6c_multinet_xhs_status, TRUE);
+
     //WanMgr_DmlStartDHCP6Client();
 //    dhcp v6 client is now initialized in service_wan, no need to initialize from PandM
     #if 0
@@ -442,11 +462,124 @@ iface wan0 {
 #define CLIENT_CONF_LOCATION  "/etc/dibbler/client.conf"
 #define TMP_SERVER_CONF "/tmp/.dibbler_server_conf"
 #define SERVER_CONF_LOCATION  "/etc/dibbler/server.conf"
+#define DIBBLER_CONF_MAX_SEED 8192  /* largest file read back to seed the hash */
+
+/* Hash of the last content written to a dibbler file, so an unchanged
+ * configuration neither rewrites the file nor restarts the client. */
+typedef struct {
+    BOOL               valid;
+    UINT32             hash;
+} dibbler_file_state_t;
+
+static dibbler_file_state_t g_client_conf_state;
+static dibbler_file_state_t g_sent_option_state;
+
+static UINT32 _dibbler_content_hash(const char *content, size_t len)
+{
+    UINT32 hash = 2166136261U;      /* FNV-1a */
+    size_t i;
+
+    for (i = 0; i < len; i++)
+    {
+        hash ^= (unsigned char) content[i];
+        hash *= 16777619U;
+    }
+
+    return hash;
+}
+
+/* After a restart the hash is taken from whatever is on disk already */
+static void _dibbler_seed_state(const char *path, dibbler_file_state_t *pState)
+{
+    char *content = NULL;
+    FILE *fp = NULL;
+    size_t len;
+
+    pState->valid = TRUE;
+    pState->hash = 0;
+
+    if ((fp = fopen(path, "r")) == NULL)
+    {
+        pState->valid = FALSE;
+        return;
+    }
+
+    if ((content = malloc(DIBBLER_CONF_MAX_SEED)) == NULL)
+    {
+        fclose(fp);
+        pState->valid = FALSE;
+        return;
+    }
+
+    len = fread(content, 1, DIBBLER_CONF_MAX_SEED, fp);
+    if (len == DIBBLER_CONF_MAX_SEED)
+    {
+        pState->valid = FALSE;
+    }
+    else
+    {
+        pState->hash = _dibbler_content_hash(content, len);
+    }
+
+    free(content);
+    fclose(fp);
+}
+
+/* Writes content through tmpPath + rename if it differs from what was last
+ * written. Returns 1 if the file changed, 0 if unchanged, -1 on error. */
+static int _dibbler_write_if_changed(const char *path, const char *tmpPath, const char *content, size_t len, dibbler_file_state_t *pState)
+{
+    UINT32 hash = _dibbler_content_hash(content, len);
+    FILE *fp = NULL;
+
+    if (pState->valid != TRUE)
+    {
+        _dibbler_seed_state(path, pState);
+    }
+
+    if (pState->valid == TRUE && pState->hash == hash)
+    {
+        CcspTraceInfo(("%s: %s unchanged\n", __FUNCTION__, path));
+        return 0;
+    }
+
+    if ((fp = fopen(tmpPath, "w")) == NULL)
+    {
+        CcspTraceWarning(("%s open %s failed %s\n", __FUNCTION__, tmpPath, strerror(errno)));
+        return -1;
+    }
+
+    if (fwrite(content, 1, len, fp) != len)
+    {
+        CcspTraceWarning(("%s write %s failed\n", __FUNCTION__, tmpPath));
+        fclose(fp);
+        unlink(tmpPath);
+        return -1;
+    }
+    fclose(fp);
+
+    /*we will copy the updated conf file at once*/
+    if (rename(tmpPath, path))
+    {
+        CcspTraceWarning(("%s rename failed %s\n", __FUNCTION__, strerror(errno)));
+        unlink(tmpPath);
+        pState->valid = FALSE;
+        return -1;
+    }
+
+    pState->valid = TRUE;
+    pState->hash = hash;
+    return 1;
+}
 
+/* Returns 1 if client.conf changed, 0 if it is unchanged, -1 on error */
 static int _prepare_client_conf(PDML_DHCPCV6_CFG       pCfg)
 {
-    FILE * fp = fopen(TMP_CLIENT_CONF, "w+");
+    char * content = NULL;
+    size_t contentLen = 0;
+    FILE * fp = open_memstream(&content, &contentLen);
     char line[256] = {0};
+    int ret = -1;
 
     if (fp)
     {
@@ -505,11 +638,13 @@ static int _prepare_client_conf(PDML_DHCPCV6_CFG       pCfg)
         fclose(fp);
     }
 
-    /*we will copy the updated conf file at once*/
-    if (rename(TMP_CLIENT_CONF, CLIENT_CONF_LOCATION))
-        CcspTraceWarning(("%s rename failed %s\n", __FUNCTION__, strerror(errno)));
+    if (content)
+    {
+        ret = _dibbler_write_if_changed(CLIENT_CONF_LOCATION, TMP_CLIENT_CONF, content, contentLen, &g_client_conf_state);
+        free(content);
+    }
 
-    return 0;
+    return ret;
 }
 
 static int _dibbler_client_operation(char * arg)
@@ -520,6 +655,12 @@ static int _dibbler_client_operation(char * arg)
     int watchdog = NO_OF_RETRY;
 #endif
 
+#ifdef FEATURE_EMBEDDED_DHCPV6_CLIENT
+    //The client runs inside WAN Manager, started and stopped by the interface state machine
+    CcspTraceInfo(("%s %s ignored, embedded DHCPv6 client\n", __func__, arg));
+    return 0;
+#endif
+
     if (!strncmp(arg, "stop", 4))
     {
         CcspTraceInfo(("%s stop\n", __func__));
@@ -535,9 +676,7 @@ static int _dibbler_client_operation(char * arg)
         sprintf(cmd, "killall %s", CLIENT_BIN);
         system(cmd);
         sleep(2);
-        sprintf(cmd, "ps -A|grep %s", CLIENT_BIN);
-        _get_shell_output(cmd, out, sizeof(out));
-         if (strstr(out, CLIENT_BIN))
+         if (util_getPidByName(CLIENT_BIN) > 0)
          {
             sprintf(cmd, "killall -9 %s", CLIENT_BIN);
             system(cmd);
@@ -555,8 +694,8 @@ static int _dibbler_client_operation(char * arg)
         /* Waiting for the TLV file to be parsed correctly so that the right erouter mode can be used in the code below.
         For ANYWAN please extend the below code to support the case of TLV config file not being there. */
       do{
-         sprintf(cmd, "sysevent get TLV202-status");
-         _get_shell_output(cmd, out, sizeof(out));
+         memset(out, 0, sizeof(out));
+         sysevent_get(sysevent_fd, sysevent_token, "TLV202-status", out, sizeof(out));
          fprintf( stderr, "\n%s:%s(): Waiting for CcspGwProvApp to parse TLV config file\n", __FILE__, __FUNCTION__);
          sleep(1);//sleep(1) is to avoid lots of trace msgs when there is latency
          watchdog--;
@@ -570,8 +709,8 @@ static int _dibbler_client_operation(char * arg)
 #endif
 #ifndef _HUB4_PRODUCT_REQ_
         /* This wait loop is not required as we are not configuring IPv6 address on erouter0 interface */
-        sprintf(cmd, "syscfg get last_erouter_mode");
-        _get_shell_output(cmd, out, sizeof(out));
+        memset(out, 0, sizeof(out));
+        syscfg_get(NULL, "last_erouter_mode", out, sizeof(out));
     /* TODO: To be fixed by Comcast
              IPv6 address assigned to erouter0 gets deleted when erouter_mode=3(IPV4 and IPV6 both)
              Don't start v6 service in parallel. Wait for wan-status to be set to 'started' by IPv4 DHCP client.
@@ -579,8 +718,8 @@ static int _dibbler_client_operation(char * arg)
         if (strstr(out, "3"))// If last_erouter_mode is both IPV4/IPV6
     {
              do{
-                    sprintf(cmd, "sysevent get wan-status");
-                _get_shell_output(cmd, out, sizeof(out));
+                memset(out, 0, sizeof(out));
+                sysevent_get(sysevent_fd, sysevent_token, "wan-status", out, sizeof(out));
                 CcspTraceInfo(("%s waiting for wan-status to started\n", __func__));
             sleep(1);//sleep(1) is to avoid lots of trace msgs when there is latency
         }while(!strstr(out,"started"));
@@ -730,8 +869,9 @@ WanMgr_DmlDhcpv6cSetCfg
         }
         else if (pCfg->bEnabled == g_dhcpv6_client.Cfg.bEnabled && pCfg->bEnabled)
         {
-            _prepare_client_conf(pCfg);
-            _dibbler_client_operation("restart");
+            /*a commit that renders the same client.conf must not bounce IPv6*/
+            if (_prepare_client_conf(pCfg) != 0)
+                _dibbler_client_operation("restart");
         }
     }
 
@@ -765,9 +905,12 @@ WanMgr_DmlDhcpv6cGetEnabled
 {
     UNREFERENCED_PARAMETER(hContext);
     BOOL bEnabled = FALSE;
-    char out[256] = {0};
     BOOL dibblerEnabled = FALSE;
 
+#ifdef FEATURE_EMBEDDED_DHCPV6_CLIENT
+    return WanMgr_Dhcpv6c_IsRunning(NULL);
+#endif
+
 // For XB3, AXB6 if dibbler flag enabled, check dibbler-client process status
 #if defined(_COSA_INTEL_XB3_ARM_) || defined(INTEL_PUMA7)
         char buf[8];
@@ -777,39 +920,16 @@ WanMgr_DmlDhcpv6cGetEnabled
     }
 #endif
 
-#if defined (_COSA_BCM_ARM_) || defined (_HUB4_PRODUCT_REQ_)
-    FILE *fp = popen("ps |grep -i dibbler-client | grep -v grep", "r");
-
-#elif defined (_XF3_PRODUCT_REQ_)
-   FILE *fp = popen("/usr/sbin/dibbler-client status |grep  client", "r");
-
-#else
-    FILE *fp;
-    // For XB3, AXB6 if dibbler flag enabled, check dibbler-client process status
-    if(dibblerEnabled)
-        fp = popen("ps |grep -i dibbler-client | grep -v grep", "r");
-    else
-            fp = popen("ps |grep -i ti_dhcp6c | grep erouter0 | grep -v grep", "r");
-#endif
-
-    if ( fp != NULL){
-        if ( fgets(out, sizeof(out), fp) != NULL ){
-#if defined (_COSA_BCM_ARM_) || defined (_HUB4_PRODUCT_REQ_)
-            if ( _ansc_strstr(out, "dibbler-client") )
-                bEnabled = TRUE;
-#elif defined (_XF3_PRODUCT_REQ_)
-            if ( strstr(out, "RUNNING,") )
-                bEnabled = TRUE;
+#if defined (_COSA_BCM_ARM_) || defined (_HUB4_PRODUCT_REQ_) || defined (_XF3_PRODUCT_REQ_)
+    if ( util_getPidByName(CLIENT_BIN) > 0 )
+        bEnabled = TRUE;
 #else
     // For XB3, AXB6 if dibbler flag enabled, check dibbler-client process status
-    if ( dibblerEnabled && _ansc_strstr(out, "dibbler-client") )
-                bEnabled = TRUE;
-        if ( _ansc_strstr(out, "erouter_dhcp6c") )
-                bEnabled = TRUE;
+    if ( dibblerEnabled && (util_getPidByName(CLIENT_BIN) > 0) )
+        bEnabled = TRUE;
+    if ( !dibblerEnabled && (util_getPidByNameAndArg("ti_dhcp6c", "erouter_dhcp6c") > 0) )
+        bEnabled = TRUE;
 #endif
-       }
-        pclose(fp);
-    }
 
     return bEnabled;
 }
@@ -923,8 +1043,12 @@ WanMgr_DmlDhcpv6cRenew
     UNREFERENCED_PARAMETER(ulInstanceNumber);
     char cmd[256] = {0};
 
+#ifdef FEATURE_EMBEDDED_DHCPV6_CLIENT
+    WanMgr_Dhcpv6c_Renew(NULL);
+#else
     sprintf(cmd, "killall -SIGUSR2 %s", CLIENT_BIN);
     system(cmd);
+#endif
 
     return ANSC_STATUS_SUCCESS;
 }
@@ -938,9 +1062,102 @@ WanMgr_DmlDhcpv6cRenew
 #define SYSCFG_DHCP6C_SENT_OPTION_FORMAT "tr_dhcp6c_sent_option_%lu"
 static int g_sent_option_num;
 static DML_DHCPCV6_SENT * g_sent_options;
+static BOOL g_sent_options_loaded = FALSE;
 static int g_recv_option_num   = 0;
 static DML_DHCPCV6_RECV * g_recv_options = NULL;
 
+static int _write_dibbler_sent_option_file(void);
+
+/* Set without commit, the caller commits once per table change */
+static void _sent_option_syscfg_set(const char *name, const char *value)
+{
+    if (syscfg_set(NULL, name, value) != 0)
+    {
+        CcspTraceError(("syscfg_set failed: %s %s\n", name, value));
+    }
+}
+
+static void _sent_option_syscfg_commit(void)
+{
+    if (syscfg_commit() != 0)
+    {
+        CcspTraceError(("%s: syscfg_commit failed\n", __FUNCTION__));
+    }
+}
+
+/* Reads the whole sent option table from syscfg once, TR-181 reads are
+ * served from g_sent_options afterwards */
+static void _sent_option_table_load(void)
+{
+    char out[256] = {0};
+    char buf[256] = {0};
+    char namespace[256] = {0};
+    int  i = 0;
+
+    g_sent_options_loaded = TRUE;
+    g_sent_option_num = 0;
+
+    if( syscfg_get( NULL, "tr_dhcp6c_sent_option_num", out, sizeof(out)) == 0 )
+    {
+        g_sent_option_num = atoi(out);
+    }
+
+    if (g_sent_option_num <= 0)
+    {
+        g_sent_option_num = 0;
+        return;
+    }
+
+    g_sent_options = (DML_DHCPCV6_SENT *)AnscAllocateMemory(sizeof(DML_DHCPCV6_SENT)* g_sent_option_num);
+    if (!g_sent_options)
+    {
+        g_sent_option_num = 0;
+        return;
+    }
+
+    for (i = 0; i < g_sent_option_num; i++)
+    {
+        /*note in syscfg, sent_options start from 1*/
+        snprintf(namespace, sizeof(namespace), SYSCFG_DHCP6C_SENT_OPTION_FORMAT, (ULONG)(i+1));
+
+        memset(out, 0, sizeof(out));
+        if( syscfg_get( NULL, namespace, out, sizeof(out)) == 0 )
+        {
+            sscanf(out, "%lu", &g_sent_options[i].InstanceNumber);
+        }
+
+        memset(out, 0, sizeof(out));
+        snprintf(buf, sizeof(buf), "%s_alias", namespace);
+        if( syscfg_get( NULL, buf, out, sizeof(out)) == 0 )
+        {
+            snprintf((char*)g_sent_options[i].Alias, sizeof(g_sent_options[i].Alias), "%s", out);
+        }
+
+        memset(out, 0, sizeof(out));
+        snprintf(buf, sizeof(buf), "%s_enabled", namespace);
+        if( syscfg_get( NULL, buf, out, sizeof(out)) == 0 )
+        {
+            g_sent_options[i].bEnabled = (out[0] == '1') ? TRUE:FALSE;
+        }
+
+        memset(out, 0, sizeof(out));
+        snprintf(buf, sizeof(buf), "%s_tag", namespace);
+        if( syscfg_get( NULL, buf, out, sizeof(out)) == 0 )
+        {
+            sscanf(out, "%lu", &g_sent_options[i].Tag);
+        }
+
+        memset(out, 0, sizeof(out));
+        snprintf(buf, sizeof(buf), "%s_value", namespace);
+        if( syscfg_get( NULL, buf, out, sizeof(out)) == 0 )
+        {
+            snprintf((char*)g_sent_options[i].Value, sizeof(g_sent_options[i].Value), "%s", out);
+        }
+    }
+
+    _write_dibbler_sent_option_file();
+}
+
 ULONG
 WanMgr_DmlDhcpv6cGetNumberOfSentOption
     (
@@ -950,33 +1167,27 @@ WanMgr_DmlDhcpv6cGetNumberOfSentOption
 {
     UNREFERENCED_PARAMETER(hContext);
     UNREFERENCED_PARAMETER(ulClientInstanceNumber);
-    char buf[256] = {0};
-    char out[256] = {0};
 
-
-    strncpy(buf, "tr_dhcp6c_sent_option_num", sizeof(out));
-    if( syscfg_get( NULL, buf, out, sizeof(out)) == 0 )
-    {
-    g_sent_option_num = atoi(out);
-    }
-
-    if (g_sent_option_num)
-    {
-        g_sent_options = (DML_DHCPCV6_SENT *)AnscAllocateMemory(sizeof(DML_DHCPCV6_SENT)* g_sent_option_num);
-    }
+    if (!g_sent_options_loaded)
+        _sent_option_table_load();
 
     return g_sent_option_num;
 
 }
 
 #define CLIENT_SENT_OPTIONS_FILE "/tmp/.dibbler-info/client_sent_options"
+#define TMP_CLIENT_SENT_OPTIONS_FILE "/tmp/.dibbler-info/.client_sent_options"
 /*this function will generate sent_option info file to dibbler-client,
  the format of CLIENT_SENT_OPTIONS_FILE:
-    option-type:option-len:option-data*/
+    option-type:option-len:option-data
+ returns 1 if the file changed, 0 if it is unchanged, -1 on error*/
 static int _write_dibbler_sent_option_file(void)
 {
-    FILE * fp = fopen(CLIENT_SENT_OPTIONS_FILE, "w+");
+    char * content = NULL;
+    size_t contentLen = 0;
+    FILE * fp = open_memstream(&content, &contentLen);
     int  i = 0;
+    int  ret = -1;
 
     if (fp)
     {
@@ -992,7 +1203,13 @@ static int _write_dibbler_sent_option_file(void)
         fclose(fp);
     }
 
-    return 0;
+    if (content)
+    {
+        ret = _dibbler_write_if_changed(CLIENT_SENT_OPTIONS_FILE, TMP_CLIENT_SENT_OPTIONS_FILE, content, contentLen, &g_sent_option_state);
+        free(content);
+    }
+
+    return ret;
 }
 
 ANSC_STATUS
@@ -1006,62 +1223,16 @@ WanMgr_DmlDhcpv6cGetSentOption
 {
     UNREFERENCED_PARAMETER(hContext);
     UNREFERENCED_PARAMETER(ulClientInstanceNumber);
-    char out[256] = {0};
-    char buf[256] = {0};
-    char namespace[256] = {0};
+
+    if (!g_sent_options_loaded)
+        _sent_option_table_load();
 
     if ( (int)ulIndex > g_sent_option_num - 1  || !g_sent_options)
     {
         return ANSC_STATUS_FAILURE;
     }
 
-    /*note in syscfg, sent_options start from 1*/
-    sprintf(namespace, SYSCFG_DHCP6C_SENT_OPTION_FORMAT, ulIndex+1);
-    memset(buf, 0, sizeof(buf));
-    memset(out, 0, sizeof(out));
-    if( syscfg_get( NULL, namespace, out, sizeof(out)) == 0 )
-    {
-    sscanf(out, "%lu", &pEntry->InstanceNumber);
-    }
-
-    memset(buf, 0, sizeof(buf));
-    memset(out, 0, sizeof(out));
-    snprintf(buf, sizeof(buf), "%s_alias", namespace);
-    if( syscfg_get( NULL, buf, out, sizeof(out)) == 0 )
-    {
-        strncpy(pEntry->Alias, out, sizeof(pEntry->Alias));
-    }
-
-    memset(buf, 0, sizeof(buf));
-    memset(out, 0, sizeof(out));
-    snprintf(buf, sizeof(buf), "%s_enabled", namespace);
-    if( syscfg_get( NULL, buf, out, sizeof(out)) == 0 )
-    {
-        pEntry->bEnabled = (out[0] == '1') ? TRUE:FALSE;
-    }
-
-    memset(buf, 0, sizeof(buf));
-    memset(out, 0, sizeof(out));
-    snprintf(buf, sizeof(buf), "%s_tag", namespace);
-    if( syscfg_get( NULL, namespace, out, sizeof(out)) == 0 )
-    {
-        sscanf(out, "%lu", &pEntry->Tag);
-    }
-
-    memset(buf, 0, sizeof(buf));
-    memset(out, 0, sizeof(out));
-    snprintf(buf, sizeof(buf), "%s_value", namespace);
-    if( syscfg_get( NULL, buf, out, sizeof(out)) == 0 )
-    {
-        strncpy(pEntry->Value, out, sizeof(pEntry->Value));
-    }
-
-    AnscCopyMemory( &g_sent_options[ulIndex], pEntry, sizeof(DML_DHCPCV6_SENT));
-
-    /*we only wirte to file when obtaining the last entry*/
-    if (ulIndex == g_sent_option_num-1)
-        _write_dibbler_sent_option_file();
-
+    AnscCopyMemory( pEntry, &g_sent_options[ulIndex], sizeof(DML_DHCPCV6_SENT));
 
     return ANSC_STATUS_SUCCESS;
 }
@@ -1118,14 +1289,16 @@ WanMgr_DmlDhcpv6cSetSentOptionValues
 
     sprintf(namespace, SYSCFG_DHCP6C_SENT_OPTION_FORMAT, ulIndex+1);
     snprintf(out, sizeof(out), "%lu", ulInstanceNumber);
-    syscfg_set_string(namespace, out);
+    _sent_option_syscfg_set(namespace, out);
 
     snprintf(out, sizeof(out), "%s_alias", namespace);
-    syscfg_set_string(out, pAlias);
+    _sent_option_syscfg_set(out, pAlias);
+    _sent_option_syscfg_commit();
 
     return ANSC_STATUS_SUCCESS;
 }
 
+/* Stages one entry in syscfg, the caller commits */
 static int _syscfg_add_sent_option(PDML_DHCPCV6_SENT      pEntry, int index)
 {
     char out[256] = {0};
@@ -1137,24 +1310,24 @@ static int _syscfg_add_sent_option(PDML_DHCPCV6_SENT      pEntry, int index)
 
     sprintf(namespace, SYSCFG_DHCP6C_SENT_OPTION_FORMAT, index);
     snprintf(out, sizeof(out), "%lu", pEntry->InstanceNumber);
-    syscfg_set_string(namespace, out);
+    _sent_option_syscfg_set(namespace, out);
 
     snprintf(out, sizeof(out), "%s_alias", namespace);
-    syscfg_set_string(out, pEntry->Alias);
+    _sent_option_syscfg_set(out, (char*)pEntry->Alias);
 
     snprintf(buf, sizeof(buf), "%s_enabled", namespace);
     if (pEntry->bEnabled)
         sprintf(out, "1");
     else
         sprintf(out, "0");
-    syscfg_set_string(buf, out);
+    _sent_option_syscfg_set(buf, out);
 
     snprintf(buf, sizeof(buf), "%s_tag", namespace);
     snprintf(out, sizeof(out)-1, "%lu", pEntry->Tag);
-    syscfg_set_string(buf, out);
+    _sent_option_syscfg_set(buf, out);
 
     snprintf(buf, sizeof(buf), "%s_value", namespace);
-    syscfg_set_string(buf, pEntry->Value);
+    _sent_option_syscfg_set(buf, (char*)pEntry->Value);
 
     return 0;
 }
@@ -1182,15 +1355,16 @@ WanMgr_DmlDhcpv6cAddSentOption
     _syscfg_add_sent_option(pEntry, g_sent_option_num);
 
     snprintf(out, sizeof(out)-1, "%d", g_sent_option_num);
-    syscfg_set_string("tr_dhcp6c_sent_option_num", out);
+    _sent_option_syscfg_set("tr_dhcp6c_sent_option_num", out);
+    _sent_option_syscfg_commit();
 
     g_sent_options[g_sent_option_num-1] = *pEntry;
 
     /*if the added entry is disabled, don't update dibbler-info file*/
     if (pEntry->bEnabled)
     {
-        _write_dibbler_sent_option_file();
-        _dibbler_client_operation("restart");
+        if (_write_dibbler_sent_option_file() != 0)
+            _dibbler_client_operation("restart");
     }
 
     return ANSC_STATUS_SUCCESS;
@@ -1240,21 +1414,26 @@ WanMgr_DmlDhcpv6cDelSentOption
 
     /*syscfg unset the last one, since we move the syscfg table ahead*/
     sprintf(namespace, SYSCFG_DHCP6C_SENT_OPTION_FORMAT, (ULONG)(g_sent_option_num+1));
-    syscfg_unset(namespace, "inst_num");
-    syscfg_unset(namespace, "alias");
-    syscfg_unset(namespace, "enabled");
-    syscfg_unset(namespace, "tag");
-    syscfg_unset(namespace, "value");
+    syscfg_unset(NULL, namespace);
+    snprintf(out, sizeof(out), "%s_alias", namespace);
+    syscfg_unset(NULL, out);
+    snprintf(out, sizeof(out), "%s_enabled", namespace);
+    syscfg_unset(NULL, out);
+    snprintf(out, sizeof(out), "%s_tag", namespace);
+    syscfg_unset(NULL, out);
+    snprintf(out, sizeof(out), "%s_value", namespace);
+    syscfg_unset(NULL, out);
 
     snprintf(out, sizeof(out)-1, "%d", g_sent_option_num);
-    syscfg_set_string("tr_dhcp6c_sent_option_num", out);
+    _sent_option_syscfg_set("tr_dhcp6c_sent_option_num", out);
+    _sent_option_syscfg_commit();
 
 
     /*only take effect when the deleted entry was enabled*/
     if (saved_enable)
     {
-        _write_dibbler_sent_option_file();
-        _dibbler_client_operation("restart");
+        if (_write_dibbler_sent_option_file() != 0)
+            _dibbler_client_operation("restart");
     }
 
     return ANSC_STATUS_SUCCESS;
@@ -1292,7 +1471,7 @@ WanMgr_DmlDhcpv6cSetSentOption
             if (!AnscEqualString(pEntry->Alias, p_old_entry->Alias, TRUE))
             {
                 sprintf(buf, "%s_alias", namespace);
-                syscfg_set_string(buf, pEntry->Alias);
+                _sent_option_syscfg_set(buf, (char*)pEntry->Alias);
             }
 
             if (pEntry->bEnabled != p_old_entry->bEnabled)
@@ -1302,7 +1481,7 @@ WanMgr_DmlDhcpv6cSetSentOption
                 else
                     sprintf(out, "0");
                 sprintf(buf, "%s_enabled", namespace);
-                syscfg_set_string(buf, out);
+                _sent_option_syscfg_set(buf, out);
                 need_restart_service = 1;
             }
 
@@ -1311,23 +1490,26 @@ WanMgr_DmlDhcpv6cSetSentOption
             {
                 sprintf(buf, "%s_tag", namespace);
                 snprintf(out, sizeof(out)-1, "%lu", pEntry->Tag);
-                syscfg_set_string(buf, out);
+                _sent_option_syscfg_set(buf, out);
                 need_restart_service = 1;
             }
 
             if (!AnscEqualString(pEntry->Value, p_old_entry->Value, TRUE))
             {
                 sprintf(buf, "%s_value", namespace);
-                syscfg_set_string(buf, pEntry->Value);
+                _sent_option_syscfg_set(buf, (char*)pEntry->Value);
                 need_restart_service = 1;
             }
 
+            if (need_restart_service || !AnscEqualString(pEntry->Alias, p_old_entry->Alias, TRUE))
+                _sent_option_syscfg_commit();
+
             AnscCopyMemory( &g_sent_options[index], pEntry, sizeof(DML_DHCPCV6_SENT));
 
             if (need_restart_service)
             {
-                _write_dibbler_sent_option_file();
-                _dibbler_client_operation("restart");
+                if (_write_dibbler_sent_option_file() != 0)
+                    _dibbler_client_operation("restart");
             }
 
             return ANSC_STATUS_SUCCESS;
@@ -1548,17 +1730,11 @@ int dhcpv6_assign_global_ip(char * prefix, char * intfName, char * ipAddr)
 
 
     /* prepare second part */
-    _ansc_sprintf(cmd, "ifconfig %s | grep HWaddr\n", intfName );
-    _get_shell_output(cmd, out, sizeof(out));
-    pMac =_ansc_strstr(out, "HWaddr");
-    if ( pMac == NULL ){
+    if ( dhcpv6_get_if_hwaddr(intfName, cmd, sizeof(cmd)) != RETURN_OK ){
         AnscTrace("error, this interface has not a mac address .\n");
         return 1;
     }
-
-    pMac += _ansc_strlen("HWaddr");
-    while( pMac && (pMac[0] == ' ') )
-        pMac++;
+    pMac = cmd;
 
     /* switch 7bit to 1*/
     tmp[0] = pMac[1];
@@ -1600,443 +1776,214 @@ int dhcpv6_assign_global_ip(char * prefix, char * intfName, char * ipAddr)
     return 0;
 }
 
-#define POS_PREFIX_DELEGATION 7
-int CalcIPv6Prefix(char *GlobalPref, char *pref,int index)
+/* These handlers are added to handle the LnF interface IPv6 rule, because LnF is coming up late in XB6 devices.
+They can be generic to handle the operations depending on the interfaces. Other interface and their events can be register here later based on requirement */
+static void dhcpv6c_multinet_lnf_status(const char *name, const char *val)
 {
-    unsigned char buf[sizeof(struct in6_addr)];
-    int domain, s;
-    char str[INET6_ADDRSTRLEN];
-   domain = AF_INET6;
-   s = inet_pton(domain, GlobalPref, buf);
-    if (s <= 0) {
-        if (s == 0)
-            fprintf(stderr, "Not in presentation format");
-        else
-            perror("inet_pton");
-           return 0;
-    }
-   buf[POS_PREFIX_DELEGATION] = buf[POS_PREFIX_DELEGATION] + index;
-   if (inet_ntop(domain, buf, str, INET6_ADDRSTRLEN) == NULL) {
-        perror("inet_ntop");
-            return 0;
-    }
-    printf("%s\n", str);
-    strcpy(pref,str);
-    return 1;
-}
+    char buf[128],cmd[128];
 
-int GenIPv6Prefix(char *ifName,char *GlobalPref, char *pref)
-{
-int len = 0;
-int index = 0;
-char cmd[100];
-char out[100];
-static int interface_num = 4; // Reserving first 4 /64s for dhcp configurations
-    if(ifName == NULL)
-    return 0;
-
-    memset(cmd,0,sizeof(cmd));
-    memset(out,0,sizeof(out));
-    _ansc_sprintf(cmd, "%s%s",ifName,"_ipv6_index");
-    sysevent_get(sysevent_fd, sysevent_token,cmd, out, sizeof(out));
-    if(strlen(out) != 0)
+    if (gDhcpv6c_ctx.lanIfEventsEnabled != TRUE)
     {
-        index = atoi(out);
+        return;
     }
 
-    len = strlen(GlobalPref);
-    strcpy(pref,GlobalPref);
-    if(index == 0)
+    CcspTraceWarning(("%s Recieved notification event  %s\n",__FUNCTION__,name));
+    if(strcmp(val, "ready") == 0)
     {
-        if(CalcIPv6Prefix(GlobalPref,pref,interface_num)== 0)
-        return 0;
+        sysevent_get(sysevent_fd, sysevent_token,"br106_ipaddr_v6", buf, sizeof(buf));
         memset(cmd,0,sizeof(cmd));
-        _ansc_sprintf(cmd, "%s%s",ifName,"_ipv6_index");
-        _ansc_sprintf(out, "%d",interface_num);
-        sysevent_set(sysevent_fd, sysevent_token, cmd, out , 0);
-        interface_num++;
-    }
-    else
-    {
-        if(CalcIPv6Prefix(GlobalPref,pref,index)==0 )
-        return 0;
+        _ansc_sprintf(cmd, "ip -6 route add %s dev br106",buf);
+        system(cmd);
+        #ifdef _COSA_INTEL_XB3_ARM_
+        memset(cmd,0,sizeof(cmd));
+        _ansc_sprintf(cmd, "ip -6 route add %s dev br106 table erouter",buf);
+        system(cmd);
+        #endif
+        memset(cmd,0,sizeof(cmd));
+        sprintf(cmd, "ip -6 rule add iif br106 lookup erouter");
+        system(cmd);
     }
-    strcat(pref,"/64");
-        CcspTraceInfo(("%s: pref %s\n", __func__, pref));
-return 1;
-
 }
-/* This thread is added to handle the LnF interface IPv6 rule, because LnF is coming up late in XB6 devices.
-This thread can be generic to handle the operations depending on the interfaces. Other interface and their events can be register here later based on requirement */
-static int sysevent_fd_1;
-static token_t sysevent_token_1;
-static pthread_t InfEvtHandle_tid;
-static void *InterfaceEventHandler_thrd(void *data)
-{
-    UNREFERENCED_PARAMETER(data);
-    async_id_t interface_asyncid;
-    async_id_t interface_XHS_asyncid;
-
-    CcspTraceWarning(("%s started\n",__FUNCTION__));
-    sysevent_fd_1 = sysevent_open("127.0.0.1", SE_SERVER_WELL_KNOWN_PORT, SE_VERSION, "Interface_evt_handler", &sysevent_token_1);
-
-    sysevent_set_options(sysevent_fd_1, sysevent_token_1, "multinet_6-status", TUPLE_FLAG_EVENT);
-    sysevent_setnotification(sysevent_fd_1, sysevent_token_1, "multinet_6-status",  &interface_asyncid);
-    sysevent_set_options(sysevent_fd_1, sysevent_token_1, "multinet_2-status", TUPLE_FLAG_EVENT);
-    sysevent_setnotification(sysevent_fd_1, sysevent_token_1, "multinet_2-status",  &interface_XHS_asyncid);
-    while(1)
-    {
-         async_id_t getnotification_asyncid;
-         int err;
-         unsigned char name[25], val[42],buf[128],cmd[128];
-         int namelen = sizeof(name);
-         int vallen  = sizeof(val);
-        err = sysevent_getnotification(sysevent_fd_1, sysevent_token_1, name, &namelen,  val, &vallen, &getnotification_asyncid);
-
-            if (err)
-            {
-                   CcspTraceWarning(("sysevent_getnotification failed with error: %d %s\n", err,__FUNCTION__));
-                   CcspTraceWarning(("sysevent_getnotification failed name: %s val : %s\n", name,val));
-            if ( 0 != system("pidof syseventd")) {
 
-                       CcspTraceWarning(("%s syseventd not running ,breaking the receive notification loop \n",__FUNCTION__));
-                break;
-            }
-            }
-            else
-            {
+static void dhcpv6c_multinet_xhs_status(const char *name, const char *val)
+{
+    char buf[128],cmd[128];
 
-                   CcspTraceWarning(("%s Recieved notification event  %s\n",__FUNCTION__,name));
-            if(strcmp((const char*)name,"multinet_6-status") == 0)
-            {
-                if(strcmp((const char*)val, "ready") == 0)
-                {
-                                        sysevent_get(sysevent_fd, sysevent_token,"br106_ipaddr_v6", buf, sizeof(buf));
-                                        memset(cmd,0,sizeof(cmd));
-                                        _ansc_sprintf(cmd, "ip -6 route add %s dev br106",buf);
-                    system(cmd);
-                    #ifdef _COSA_INTEL_XB3_ARM_
-                                        memset(cmd,0,sizeof(cmd));
-                                        _ansc_sprintf(cmd, "ip -6 route add %s dev br106 table erouter",buf);
-                    system(cmd);
-                    #endif
-                                        memset(cmd,0,sizeof(cmd));
-                                        sprintf(cmd, "ip -6 rule add iif br106 lookup erouter");
-                                        system(cmd);
-                }
+    if (gDhcpv6c_ctx.lanIfEventsEnabled != TRUE)
+    {
+        return;
+    }
 
-            }
-            if(strcmp((const char*)name,"multinet_2-status") == 0)
+    CcspTraceWarning(("%s Recieved notification event  %s\n",__FUNCTION__,name));
+    if(strcmp(val, "ready") == 0)
+    {
+        char *Inf_name = NULL;
+        int retPsmGet = CCSP_SUCCESS;
+        retPsmGet = PSM_Get_Record_Value2(bus_handle,g_Subsystem, "dmsb.l2net.2.Port.1.Name", NULL, &Inf_name);
+        if (retPsmGet == CCSP_SUCCESS)
+        {
+            if(dhcpv6_enable_autoconf(Inf_name) == TRUE)
             {
-                if(strcmp((const char*)val, "ready") == 0)
-                {
-                    char *Inf_name = NULL;
-                    int retPsmGet = CCSP_SUCCESS;
-                    retPsmGet = PSM_Get_Record_Value2(bus_handle,g_Subsystem, "dmsb.l2net.2.Port.1.Name", NULL, &Inf_name);
-                            if (retPsmGet == CCSP_SUCCESS)
-                    {
-                        char tbuff[100];
-                                        memset(cmd,0,sizeof(cmd));
-                        memset(tbuff,0,sizeof(tbuff));
-                        sprintf(cmd,"sysctl net.ipv6.conf.%s.autoconf",Inf_name);
-                        _get_shell_output(cmd, tbuff, sizeof(tbuff));
-                        if(tbuff[strlen(tbuff)-1] == '0')
-                        {
-                            memset(cmd,0,sizeof(cmd));
-                            sprintf(cmd,"sysctl -w net.ipv6.conf.%s.autoconf=1",Inf_name);
-                            system(cmd);
-                            memset(cmd,0,sizeof(cmd));
-                            sprintf(cmd,"ifconfig %s down;ifconfig %s up",Inf_name,Inf_name);
-                            system(cmd);
-                        }
-
-                                        memset(cmd,0,sizeof(cmd));
-                                        _ansc_sprintf(cmd, "%s_ipaddr_v6",Inf_name);
-                                        sysevent_get(sysevent_fd, sysevent_token,cmd, buf, sizeof(buf));
-                                        memset(cmd,0,sizeof(cmd));
-                                        _ansc_sprintf(cmd, "ip -6 route add %s dev %s",buf,Inf_name);
-                        system(cmd);
-                        #ifdef _COSA_INTEL_XB3_ARM_
-                                        memset(cmd,0,sizeof(cmd));
-                                        _ansc_sprintf(cmd, "ip -6 route add %s dev %s table erouter",buf,Inf_name);
-                        system(cmd);
-                        #endif
-                                        memset(cmd,0,sizeof(cmd));
-                                        sprintf(cmd, "ip -6 rule add iif %s lookup erouter",Inf_name);
-                                        system(cmd);
-                        ((CCSP_MESSAGE_BUS_INFO *)bus_handle)->freefunc(Inf_name);
-                    }
-                    else
-                    {
-                        CcspTraceWarning(("%s PSM get failed for interface name\n", __FUNCTION__));
-                    }
-                }
-
+                memset(cmd,0,sizeof(cmd));
+                sprintf(cmd,"ifconfig %s down;ifconfig %s up",Inf_name,Inf_name);
+                system(cmd);
             }
 
+            memset(cmd,0,sizeof(cmd));
+            _ansc_sprintf(cmd, "%s_ipaddr_v6",Inf_name);
+            sysevent_get(sysevent_fd, sysevent_token,cmd, buf, sizeof(buf));
+            memset(cmd,0,sizeof(cmd));
+            _ansc_sprintf(cmd, "ip -6 route add %s dev %s",buf,Inf_name);
+            system(cmd);
+            #ifdef _COSA_INTEL_XB3_ARM_
+            memset(cmd,0,sizeof(cmd));
+            _ansc_sprintf(cmd, "ip -6 route add %s dev %s table erouter",buf,Inf_name);
+            system(cmd);
+            #endif
+            memset(cmd,0,sizeof(cmd));
+            sprintf(cmd, "ip -6 rule add iif %s lookup erouter",Inf_name);
+            system(cmd);
+            ((CCSP_MESSAGE_BUS_INFO *)bus_handle)->freefunc(Inf_name);
+        }
+        else
+        {
+            CcspTraceWarning(("%s PSM get failed for interface name\n", __FUNCTION__));
         }
     }
-
 }
-static int sysevent_fd_global = 0;
-static token_t sysevent_token_global;
+//When PaM restart, this is to get previous addr.
+static char globalIP2[128] = {0};
 
-static void *
-dhcpv6c_dbg_thrd(void * in)
+void WanMgr_Dhcpv6c_ProcessLease(const WANMGR_DHCPV6C_LEASE *pLease)
 {
-    UNREFERENCED_PARAMETER(in);
-    int fd=0 , fd1=0;
-    char msg[1024] = {0};
-    int i;
-    char * p = NULL;
-    char globalIP2[128] = {0};
     char out[128] = {0};
-    //When PaM restart, this is to get previous addr.
-    sysevent_get(sysevent_fd, sysevent_token,"lan_ipaddr_v6", globalIP2, sizeof(globalIP2));
-    if ( globalIP2[0] )
-        CcspTraceWarning((stderr,"%s  It seems there is old value(%s)\n", __FUNCTION__, globalIP2));
-
-    sysevent_fd_global = sysevent_open("127.0.0.1", SE_SERVER_WELL_KNOWN_PORT, SE_VERSION, "Multinet Status", &sysevent_token_global);
-
-    CcspTraceWarning(("%s sysevent_fd_global is %d\n", __FUNCTION__, sysevent_fd_global));
-
     unsigned char lan_multinet_state[16] ;
-
     int return_val=0;
+    char v6pref[128] = {0};
+    char v6pref_addr[128] = {0};
+    int t1 = 0;
+    int idx = 0;
+    char objName[128] = {0};
+    char globalIP[128] = {0};
+    BOOL bRestartLan = FALSE;
+    int  ret = 0;
+#ifdef _HUB4_PRODUCT_REQ_
+    char ula_address[64] = {0};
+#endif
 
-    fd_set rfds;
-    struct timeval tm;
-
-    fd= open(CCSP_COMMON_FIFO, O_RDWR);
-
-    if (fd< 0)
-    {
-        fprintf(stderr,"open common fifo!!!!!!!!!!!!\n");
-        goto EXIT;
-    }
+    CcspTraceInfo(("%s: %s address %s prefix %s/%d\n", __func__, pLease->action, pLease->v6addr, pLease->v6pref, pLease->prefLen));
 
-    while (1)
+    if (!strncmp(pLease->action, "add", 3))
     {
-    int retCode = 0;
-        tm.tv_sec  = 60;
-        tm.tv_usec = 0;
+        CcspTraceInfo(("%s: add\n", __func__));
 
-        FD_ZERO(&rfds);
-        FD_SET(fd, &rfds);
-        retCode = select( (fd+1), &rfds, NULL, NULL, &tm);
-        /* When return -1, it's error.
-           When return 0, it's timeout
-           When return >0, it's the number of valid fds */
-        if (retCode < 0) {
-        fprintf(stderr, "dbg_thrd : select returns error \n" );
+        // Private lan interface must be ready, so that we can assign global ipv6 address and also start dhcp server.
+        // If it isn't, keep the message and replay it from the multinet_1-status handler.
+        memset(lan_multinet_state,0,sizeof(lan_multinet_state));
+        return_val=sysevent_get(sysevent_fd, sysevent_token, "multinet_1-status", lan_multinet_state, sizeof(lan_multinet_state));
 
-            if (errno == EINTR)
-                continue;
+        CcspTraceWarning(("%s multinet_1-status is %s, ret val is %d\n",__FUNCTION__,lan_multinet_state,return_val));
 
-            CcspTraceWarning(("%s -- select(): %s", __FUNCTION__, strerror(errno)));
-            goto EXIT;
-        }
-    else if(retCode == 0 )
-        continue;
-        if ( FD_ISSET(fd, &rfds) )
+        if(strcmp((const char*)lan_multinet_state, "ready") != 0)
         {
-         memset(msg, 0, sizeof(msg));
-             read(fd, msg, sizeof(msg));
-
+            gDhcpv6c_ctx.pendingLease = *pLease;
+            gDhcpv6c_ctx.leasePending = TRUE;
+            return;
         }
-    else
-        continue;
+        gDhcpv6c_ctx.leasePending = FALSE;
 
-        if (msg[0] != 0)
+        /*for now we only support one address, one prefix notify, if need multiple addr/prefix, must modify dibbler-client code*/
+        if (strncmp(pLease->v6addr, "::", 2) != 0)
         {
-            CcspTraceInfo(("%s: get message %s\n", __func__, msg));
-        } else {
-        //Message is empty. Wait 5 sec before trying the select again.
-            sleep(5);
-            continue;
+            sysevent_set(sysevent_fd, sysevent_token, COSA_DML_DHCPV6C_ADDR_SYSEVENT_NAME, pLease->v6addr , 0);
+            sysevent_set(sysevent_fd, sysevent_token, COSA_DML_DHCPV6C_ADDR_IAID_SYSEVENT_NAME,  pLease->ianaIaid , 0);
+            sysevent_set(sysevent_fd, sysevent_token, COSA_DML_DHCPV6C_ADDR_T1_SYSEVENT_NAME,    pLease->ianaT1 , 0);
+            sysevent_set(sysevent_fd, sysevent_token, COSA_DML_DHCPV6C_ADDR_T2_SYSEVENT_NAME,    pLease->ianaT2 , 0);
+            sysevent_set(sysevent_fd, sysevent_token, COSA_DML_DHCPV6C_ADDR_PRETM_SYSEVENT_NAME, pLease->ianaPretm , 0);
+            sysevent_set(sysevent_fd, sysevent_token, COSA_DML_DHCPV6C_ADDR_VLDTM_SYSEVENT_NAME, pLease->ianaVldtm , 0);
         }
 
-        if (!strncmp(msg, "dibbler-client", strlen("dibbler-client")))
+        if (strncmp(pLease->v6pref, "::", 2) != 0)
         {
-            char v6addr[64] = {0};
-            char v6pref[128] = {0};
-            char v6pref_addr[128] = {0};
-            char v6Tpref[128] = {0};
-            int pref_len = 0;
-
-            char iana_t1[32]    = {0};
-            char iana_t2[32]    = {0};
-            char iana_iaid[32]  = {0};
-            char iana_pretm[32] = {0};
-            char iana_vldtm[32] = {0};
-
-            char iapd_t1[32]    = {0};
-            char iapd_t2[32]    = {0};
-            char iapd_iaid[32]  = {0};
-            char iapd_pretm[32] = {0};
-            char iapd_vldtm[32] = {0};
-
-            int t1 = 0;
-            int idx = 0;
-            char action[64] = {0};
-            char objName[128] = {0};
-            char globalIP[128] = {0};
-            BOOL bRestartLan = FALSE;
-            int  ret = 0;
-#ifdef _HUB4_PRODUCT_REQ_
-            char ula_address[64] = {0};
-#endif
-            /*the format is :
-             add 2000::ba7a:1ed4:99ea:cd9f :: 0 t1
-             action, address, prefix, pref_len 3600
-            now action only supports "add", "del"*/
-
-            p = msg+strlen("dibbler-client");
-            while(isblank(*p)) p++;
-
-            fprintf(stderr, "%s -- %d !!! get event from v6 client: %s \n", __FUNCTION__, __LINE__,p);
-
-            if (sscanf(p, "%63s %63s %s %s %s %s %s %63s %d %s %s %s %s %s",
-                       action, v6addr,    iana_iaid, iana_t1, iana_t2, iana_pretm, iana_vldtm,
-                       v6pref, &pref_len, iapd_iaid, iapd_t1, iapd_t2, iapd_pretm, iapd_vldtm ) == 14)
-            {
-                if (!strncmp(action, "add", 3))
-                {
-                    CcspTraceInfo(("%s: add\n", __func__));
-
-// Waiting until private lan interface is ready , so that we can assign global ipv6 address and also start dhcp server.
-            while (1)
-            {
-
-                    memset(lan_multinet_state,0,sizeof(lan_multinet_state));
-                            return_val=sysevent_get(sysevent_fd_global, sysevent_token_global, "multinet_1-status", lan_multinet_state, sizeof(lan_multinet_state));
-
-                            CcspTraceWarning(("%s multinet_1-status is %s, ret val is %d\n",__FUNCTION__,lan_multinet_state,return_val));
-
-                if(strcmp((const char*)lan_multinet_state, "ready") == 0)
-                {
-                    break;
-                }
-
-                sleep(5);
-              }
-
-                    /*for now we only support one address, one prefix notify, if need multiple addr/prefix, must modify dibbler-client code*/
-                    if (strncmp(v6addr, "::", 2) != 0)
-                    {
-                        sysevent_set(sysevent_fd, sysevent_token, COSA_DML_DHCPV6C_ADDR_SYSEVENT_NAME, v6addr , 0);
-                        sysevent_set(sysevent_fd, sysevent_token, COSA_DML_DHCPV6C_ADDR_IAID_SYSEVENT_NAME,  iana_iaid , 0);
-                        sysevent_set(sysevent_fd, sysevent_token, COSA_DML_DHCPV6C_ADDR_T1_SYSEVENT_NAME,    iana_t1 , 0);
-                        sysevent_set(sysevent_fd, sysevent_token, COSA_DML_DHCPV6C_ADDR_T2_SYSEVENT_NAME,    iana_t2 , 0);
-                        sysevent_set(sysevent_fd, sysevent_token, COSA_DML_DHCPV6C_ADDR_PRETM_SYSEVENT_NAME, iana_pretm , 0);
-                        sysevent_set(sysevent_fd, sysevent_token, COSA_DML_DHCPV6C_ADDR_VLDTM_SYSEVENT_NAME, iana_vldtm , 0);
-                    }
-
-                    if (strncmp(v6pref, "::", 2) != 0)
-                    {
-            memset(v6Tpref,0,sizeof(v6Tpref));
-            strncpy(v6Tpref,v6pref,sizeof(v6Tpref));
-                        /*We just delegate longer and equal 64bits. Use zero to fill in the slot naturally. */
-#if defined (MULTILAN_FEATURE)
-                        sprintf(v6pref+strlen(v6pref), "/%d", pref_len);
-#else
-            if ( pref_len >= 64 )
-                            sprintf(v6pref+strlen(v6pref), "/%d", pref_len);
-                        else
-                        {
-#if defined(CISCO_CONFIG_DHCPV6_PREFIX_DELEGATION)
-                            sprintf(v6pref+strlen(v6pref), "/%d", pref_len);
+            /*We just delegate longer and equal 64bits. Use zero to fill in the slot naturally. */
+#if defined (MULTILAN_FEATURE) || defined(CISCO_CONFIG_DHCPV6_PREFIX_DELEGATION)
+            snprintf(v6pref, sizeof(v6pref), "%s/%d", pLease->v6pref, pLease->prefLen);
 #else
-                            sprintf(v6pref+strlen(v6pref), "/%d", 64);
-#endif
-                        }
+            snprintf(v6pref, sizeof(v6pref), "%s/%d", pLease->v6pref, (pLease->prefLen >= 64) ? pLease->prefLen : 64);
 #endif
-    char cmd[100];
+            char cmd[100];
 #if defined(CISCO_CONFIG_DHCPV6_PREFIX_DELEGATION) && defined(_CBR_PRODUCT_REQ_)
 #else
             char out1[100];
             char *token = NULL;char *pt;
-            char s[2] = ",";
-            if(pref_len < 64)
+            if(pLease->prefLen <= 64)
             {
                 memset(out,0,sizeof(out));
-                memset(cmd,0,sizeof(cmd));
                 memset(out1,0,sizeof(out1));
-                sprintf(cmd, "syscfg get IPv6subPrefix");
-                      _get_shell_output(cmd, out, sizeof(out));
+                syscfg_get(NULL, "IPv6subPrefix", out, sizeof(out));
                 if(!strcmp(out,"true"))
                 {
-                                static int first = 0;
+                    static int first = 0;
 
-                memset(out,0,sizeof(out));
-                memset(cmd,0,sizeof(cmd));
-                sprintf(cmd, "syscfg get IPv6_Interface");
-                      _get_shell_output(cmd, out, sizeof(out));
-                pt = out;
-                while((token = strtok_r(pt, ",", &pt)))
-                 {
-
-                    if(GenIPv6Prefix(token,v6Tpref,out1))
+                    memset(out,0,sizeof(out));
+                    syscfg_get(NULL, "IPv6_Interface", out, sizeof(out));
+                    WanMgr_SubPrefix_Retain(out);
+                    pt = out;
+                    while((token = strtok_r(pt, ",", &pt)))
                     {
-                        char tbuff[100];
-                        memset(cmd,0,sizeof(cmd));
-                        _ansc_sprintf(cmd, "%s%s",token,"_ipaddr_v6");
-                        sysevent_set(sysevent_fd, sysevent_token, cmd, out1 , 0);
-                        memset(cmd,0,sizeof(cmd));
-                        memset(tbuff,0,sizeof(tbuff));
-                        sprintf(cmd,"sysctl net.ipv6.conf.%s.autoconf",token);
-                        _get_shell_output(cmd, tbuff, sizeof(tbuff));
-                        if(tbuff[strlen(tbuff)-1] == '0')
+                        if(WanMgr_SubPrefix_Get(token, pLease->v6pref, pLease->prefLen, out1, sizeof(out1)) == ANSC_STATUS_SUCCESS)
                         {
                             memset(cmd,0,sizeof(cmd));
-                            sprintf(cmd,"sysctl -w net.ipv6.conf.%s.autoconf=1",token);
+                            _ansc_sprintf(cmd, "%s%s",token,"_ipaddr_v6");
+                            sysevent_set(sysevent_fd, sysevent_token, cmd, out1 , 0);
+                            if(dhcpv6_enable_autoconf(token) == TRUE)
+                            {
+                                memset(cmd,0,sizeof(cmd));
+                                sprintf(cmd,"ifconfig %s down;ifconfig %s up",token,token);
+                                system(cmd);
+                            }
+                            memset(cmd,0,sizeof(cmd));
+                            sprintf(cmd, "ip -6 route add %s dev %s", out1, token);
+                            system(cmd);
+#ifdef _COSA_INTEL_XB3_ARM_
+                            memset(cmd,0,sizeof(cmd));
+                            sprintf(cmd, "ip -6 route add %s dev %s table erouter", out1, token);
                             system(cmd);
+#endif
                             memset(cmd,0,sizeof(cmd));
-                            sprintf(cmd,"ifconfig %s down;ifconfig %s up",token,token);
+                            sprintf(cmd, "ip -6 rule add iif %s lookup erouter",token);
                             system(cmd);
+                            memset(out1,0,sizeof(out1));
                         }
-                        memset(cmd,0,sizeof(cmd));
-                        sprintf(cmd, "ip -6 route add %s dev %s", out1, token);
-                                    system(cmd);
-                        #ifdef _COSA_INTEL_XB3_ARM_
-                        memset(cmd,0,sizeof(cmd));
-                        sprintf(cmd, "ip -6 route add %s dev %s table erouter", out1, token);
-                                    system(cmd);
-                        #endif
-                        memset(cmd,0,sizeof(cmd));
-                        sprintf(cmd, "ip -6 rule add iif %s lookup erouter",token);
-                        system(cmd);
-                        memset(out1,0,sizeof(out1));
                     }
-                }
-                                        memset(out,0,sizeof(out));
-                                        if(first == 0)
-                                        {       first = 1;
-                                                pthread_create(&InfEvtHandle_tid, NULL, InterfaceEventHandler_thrd, NULL);
-                                        }
+                    memset(out,0,sizeof(out));
+                    if(first == 0)
+                    {
+                        first = 1;
+                        gDhcpv6c_ctx.lanIfEventsEnabled = TRUE;
+                    }
                 }
             }
 #endif
 
             sysevent_set(sysevent_fd, sysevent_token,COSA_DML_DHCPV6C_PREF_SYSEVENT_NAME, v6pref , 0);
-            sysevent_set(sysevent_fd, sysevent_token,COSA_DML_DHCPV6C_PREF_IAID_SYSEVENT_NAME,  iapd_iaid , 0);
-            sysevent_set(sysevent_fd, sysevent_token,COSA_DML_DHCPV6C_PREF_IAID_SYSEVENT_NAME,  iapd_iaid , 0);
-            sysevent_set(sysevent_fd, sysevent_token,COSA_DML_DHCPV6C_PREF_T1_SYSEVENT_NAME,    iapd_t1 , 0);
-            sysevent_set(sysevent_fd, sysevent_token,COSA_DML_DHCPV6C_PREF_T2_SYSEVENT_NAME,    iapd_t2 , 0);
-            sysevent_set(sysevent_fd, sysevent_token,COSA_DML_DHCPV6C_PREF_PRETM_SYSEVENT_NAME, iapd_pretm , 0);
-            sysevent_set(sysevent_fd, sysevent_token,COSA_DML_DHCPV6C_PREF_VLDTM_SYSEVENT_NAME, iapd_vldtm , 0);
+            sysevent_set(sysevent_fd, sysevent_token,COSA_DML_DHCPV6C_PREF_IAID_SYSEVENT_NAME,  pLease->iapdIaid , 0);
+            sysevent_set(sysevent_fd, sysevent_token,COSA_DML_DHCPV6C_PREF_T1_SYSEVENT_NAME,    pLease->iapdT1 , 0);
+            sysevent_set(sysevent_fd, sysevent_token,COSA_DML_DHCPV6C_PREF_T2_SYSEVENT_NAME,    pLease->iapdT2 , 0);
+            sysevent_set(sysevent_fd, sysevent_token,COSA_DML_DHCPV6C_PREF_PRETM_SYSEVENT_NAME, pLease->iapdPretm , 0);
+            sysevent_set(sysevent_fd, sysevent_token,COSA_DML_DHCPV6C_PREF_VLDTM_SYSEVENT_NAME, pLease->iapdVldtm , 0);
 
 
 #if defined (MULTILAN_FEATURE)
-                        if ((v6addr_prev[0] == '\0') || ( _ansc_strcmp(v6addr_prev, v6pref ) !=0))
-                        {
-                            _ansc_strncpy( v6addr_prev, v6pref, sizeof(v6pref));
-                            sysevent_set(sysevent_fd, sysevent_token,"ipv6-restart", "1", 0);
-                        }
-                        else
-                        {
-                            sysevent_set(sysevent_fd, sysevent_token,"ipv6_addr-set", "", 0);
-                        }
+            if ((v6addr_prev[0] == '\0') || ( _ansc_strcmp(v6addr_prev, v6pref ) !=0))
+            {
+                _ansc_strncpy( v6addr_prev, v6pref, sizeof(v6pref));
+                sysevent_set(sysevent_fd, sysevent_token,"ipv6-restart", "1", 0);
+            }
+            else
+            {
+                sysevent_set(sysevent_fd, sysevent_token,"ipv6_addr-set", "", 0);
+            }
 #endif
 
 #ifdef MULTILAN_FEATURE
@@ -2044,266 +1991,438 @@ dhcpv6c_dbg_thrd(void * in)
    for all lan interfaces.
 */
 #if !defined(INTEL_PUMA7) && !defined(_COSA_INTEL_XB3_ARM_)
-                        // not the best place to add route, just to make it work
-                        // delegated prefix need to route to LAN interface
+            // not the best place to add route, just to make it work
+            // delegated prefix need to route to LAN interface
             memset(cmd,0,sizeof(cmd));
-                        sprintf(cmd, "ip -6 route add %s dev %s", v6pref, COSA_DML_DHCPV6_SERVER_IFNAME);
-                        system(cmd);
-            #ifdef _COSA_INTEL_XB3_ARM_
+            sprintf(cmd, "ip -6 route add %s dev %s", v6pref, COSA_DML_DHCPV6_SERVER_IFNAME);
+            system(cmd);
+#ifdef _COSA_INTEL_XB3_ARM_
             memset(cmd,0,sizeof(cmd));
-                        sprintf(cmd, "ip -6 route add %s dev %s table erouter", v6pref, COSA_DML_DHCPV6_SERVER_IFNAME);
-                        system(cmd);
-            #endif
+            sprintf(cmd, "ip -6 route add %s dev %s table erouter", v6pref, COSA_DML_DHCPV6_SERVER_IFNAME);
+            system(cmd);
+#endif
             memset(cmd,0,sizeof(cmd));
-                        /* we need save this for zebra to send RA
-                           ipv6_prefix           // xx:xx::/yy
-                         */
-                        sprintf(cmd, "sysevent set ipv6_prefix %s \n",v6pref);
-                        system(cmd);
-                        CcspTraceWarning(("!run cmd1:%s", cmd));
-
-                        DHCPv6sDmlTriggerRestart(FALSE);
+            /* we need save this for zebra to send RA
+               ipv6_prefix           // xx:xx::/yy
+             */
+            sprintf(cmd, "sysevent set ipv6_prefix %s \n",v6pref);
+            system(cmd);
+            CcspTraceWarning(("!run cmd1:%s", cmd));
+
+            DHCPv6sDmlTriggerRestart(FALSE);
 #if defined(_COSA_BCM_ARM_) || defined(INTEL_PUMA7)
-                        CcspTraceWarning((" %s dhcpv6_assign_global_ip to brlan0 \n", __FUNCTION__));
-                        ret = dhcpv6_assign_global_ip(v6pref, "brlan0", globalIP);
+            CcspTraceWarning((" %s dhcpv6_assign_global_ip to brlan0 \n", __FUNCTION__));
+            ret = dhcpv6_assign_global_ip(v6pref, "brlan0", globalIP);
 #elif defined _COSA_BCM_MIPS_
-                        ret = dhcpv6_assign_global_ip(v6pref, COSA_DML_DHCPV6_SERVER_IFNAME, globalIP);
+            ret = dhcpv6_assign_global_ip(v6pref, COSA_DML_DHCPV6_SERVER_IFNAME, globalIP);
 #else
-                        /*We need get a global ip addres */
-                        ret = dhcpv6_assign_global_ip(v6pref, "l2sd0", globalIP);
+            /*We need get a global ip addres */
+            ret = dhcpv6_assign_global_ip(v6pref, "l2sd0", globalIP);
 #endif
-                        CcspTraceWarning(("%s: globalIP %s globalIP2 %s\n", __func__,
-                            globalIP, globalIP2));
-                        if ( _ansc_strcmp(globalIP, globalIP2 ) ){
-                            bRestartLan = TRUE;
-
-                            //PaM may restart. When this happen, we should not overwrite previous ipv6
-                            if ( globalIP2[0] )
-                               sysevent_set(sysevent_fd, sysevent_token,"lan_ipaddr_v6_prev", globalIP2, 0);
-
-                            _ansc_strcpy(globalIP2, globalIP);
-                        }else{
-                                char lanrestart[8] = {0};
-                                sysevent_get(sysevent_fd, sysevent_token,"lan_restarted",lanrestart, sizeof(lanrestart));
-                                fprintf(stderr,"lan restart staus is %s \n",lanrestart);
-                                      if (strcmp("true",lanrestart) == 0)
-                                    bRestartLan = TRUE;
-                                else
-                                    bRestartLan = FALSE;
-                        }
-                        CcspTraceWarning(("%s: bRestartLan %d\n", __func__, bRestartLan));
+            CcspTraceWarning(("%s: globalIP %s globalIP2 %s\n", __func__,
+                globalIP, globalIP2));
+            if ( _ansc_strcmp(globalIP, globalIP2 ) ){
+                bRestartLan = TRUE;
 
-                        fprintf(stderr, "%s -- %d !!! ret:%d bRestartLan:%d %s %s \n", __FUNCTION__, __LINE__,ret,  bRestartLan,  globalIP, globalIP2);
+                //PaM may restart. When this happen, we should not overwrite previous ipv6
+                if ( globalIP2[0] )
+                   sysevent_set(sysevent_fd, sysevent_token,"lan_ipaddr_v6_prev", globalIP2, 0);
 
-                        if ( ret != 0 )
-                        {
-                            AnscTrace("error, assign global ip error.\n");
-                        }else if ( bRestartLan == FALSE ){
-                            AnscTrace("Same global IP, Need not restart.\n");
-                        }else{
-                            /* This is for IP.Interface.1. use */
-                            sysevent_set(sysevent_fd, sysevent_token,COSA_DML_DHCPV6S_ADDR_SYSEVENT_NAME, globalIP, 0);
-
-                            /*This is for brlan0 interface */
-                            sysevent_set(sysevent_fd, sysevent_token,"lan_ipaddr_v6", globalIP, 0);
-                            _ansc_sprintf(cmd, "%d", pref_len);
-                            sysevent_set(sysevent_fd, sysevent_token,"lan_prefix_v6", cmd, 0);
-
-                            sysevent_set(sysevent_fd, sysevent_token,"lan-restart", "1", 0);
-                        }
+                _ansc_strcpy(globalIP2, globalIP);
+            }else{
+                char lanrestart[8] = {0};
+                sysevent_get(sysevent_fd, sysevent_token,"lan_restarted",lanrestart, sizeof(lanrestart));
+                fprintf(stderr,"lan restart staus is %s \n",lanrestart);
+                if (strcmp("true",lanrestart) == 0)
+                    bRestartLan = TRUE;
+                else
+                    bRestartLan = FALSE;
+            }
+            CcspTraceWarning(("%s: bRestartLan %d\n", __func__, bRestartLan));
+
+            fprintf(stderr, "%s -- %d !!! ret:%d bRestartLan:%d %s %s \n", __FUNCTION__, __LINE__,ret,  bRestartLan,  globalIP, globalIP2);
+
+            if ( ret != 0 )
+            {
+                AnscTrace("error, assign global ip error.\n");
+            }else if ( bRestartLan == FALSE ){
+                AnscTrace("Same global IP, Need not restart.\n");
+            }else{
+                /* This is for IP.Interface.1. use */
+                sysevent_set(sysevent_fd, sysevent_token,COSA_DML_DHCPV6S_ADDR_SYSEVENT_NAME, globalIP, 0);
+
+                /*This is for brlan0 interface */
+                sysevent_set(sysevent_fd, sysevent_token,"lan_ipaddr_v6", globalIP, 0);
+                _ansc_sprintf(cmd, "%d", pLease->prefLen);
+                sysevent_set(sysevent_fd, sysevent_token,"lan_prefix_v6", cmd, 0);
+
+                sysevent_set(sysevent_fd, sysevent_token,"lan-restart", "1", 0);
+            }
 #endif
 #else
 #ifdef _HUB4_PRODUCT_REQ_
-                        if ((iapd_vldtm[0]=='\0') || (iapd_pretm[0]=='\0')){
-                            strncpy(iapd_pretm, "forever", sizeof(iapd_pretm));
-                            strncpy(iapd_vldtm, "forever", sizeof(iapd_vldtm));
-                        }
-                        sysevent_get(sysevent_fd, sysevent_token,SYSEVENT_FIELD_IPV6_ULA_ADDRESS, ula_address, sizeof(ula_address));
-                        if(ula_address[0] != '\0') {
-                            sprintf(cmd, "ip -6 addr add %s/64 dev %s", ula_address, COSA_DML_DHCPV6_SERVER_IFNAME);
-                            system(cmd);
-                        }
-                        ret = dhcpv6_assign_global_ip(v6pref, COSA_DML_DHCPV6_SERVER_IFNAME, globalIP);
-                        if(ret != 0) {
-                            CcspTraceInfo(("Assign global ip error \n"));
-                        }
-                        else {
-                            sysevent_set(sysevent_fd, sysevent_token,"lan_ipaddr_v6", globalIP, 0);
-                            sprintf(cmd, "ip -6 addr add %s/64 dev %s valid_lft %s preferred_lft %s",
-                                globalIP, COSA_DML_DHCPV6_SERVER_IFNAME, iapd_vldtm, iapd_pretm);
-                            CcspTraceInfo(("Going to execute: %s \n", cmd));
-                            system(cmd);
-                        }
-                        if(strlen(v6pref) > 0) {
-                            strncpy(v6pref_addr, v6pref, (strlen(v6pref)-5));
-                            CcspTraceInfo(("Going to set ::1 address on brlan0 interface \n"));
-                            sprintf(cmd, "ip -6 addr add %s::1/64 dev %s valid_lft %s preferred_lft %s",
-                                v6pref_addr, COSA_DML_DHCPV6_SERVER_IFNAME, iapd_vldtm, iapd_pretm);
-                            CcspTraceInfo(("Going to execute: %s \n", cmd));
-                            system(cmd);
+            const char *iapd_pretm = pLease->iapdPretm;
+            const char *iapd_vldtm = pLease->iapdVldtm;
+            if ((iapd_vldtm[0]=='\0') || (iapd_pretm[0]=='\0')){
+                iapd_pretm = "forever";
+                iapd_vldtm = "forever";
+            }
+            sysevent_get(sysevent_fd, sysevent_token,SYSEVENT_FIELD_IPV6_ULA_ADDRESS, ula_address, sizeof(ula_address));
+            if(ula_address[0] != '\0') {
+                sprintf(cmd, "ip -6 addr add %s/64 dev %s", ula_address, COSA_DML_DHCPV6_SERVER_IFNAME);
+                system(cmd);
+            }
+            ret = dhcpv6_assign_global_ip(v6pref, COSA_DML_DHCPV6_SERVER_IFNAME, globalIP);
+            if(ret != 0) {
+                CcspTraceInfo(("Assign global ip error \n"));
+            }
+            else {
+                sysevent_set(sysevent_fd, sysevent_token,"lan_ipaddr_v6", globalIP, 0);
+                sprintf(cmd, "ip -6 addr add %s/64 dev %s valid_lft %s preferred_lft %s",
+                    globalIP, COSA_DML_DHCPV6_SERVER_IFNAME, iapd_vldtm, iapd_pretm);
+                CcspTraceInfo(("Going to execute: %s \n", cmd));
+                system(cmd);
+            }
+            if(strlen(v6pref) > 0) {
+                strncpy(v6pref_addr, v6pref, (strlen(v6pref)-5));
+                CcspTraceInfo(("Going to set ::1 address on brlan0 interface \n"));
+                sprintf(cmd, "ip -6 addr add %s::1/64 dev %s valid_lft %s preferred_lft %s",
+                    v6pref_addr, COSA_DML_DHCPV6_SERVER_IFNAME, iapd_vldtm, iapd_pretm);
+                CcspTraceInfo(("Going to execute: %s \n", cmd));
+                system(cmd);
+            }
+            // send an event to Sky-pro app manager that Global-prefix is set
+            sysevent_set(sysevent_fd, sysevent_token,"lan_prefix_set", globalIP, 0);
+            /**
+            * Send data to wanmanager.
+            */
+            int ipv6_wan_status = 0;
+            char dns_server[256] = {'\0'};
+            unsigned int prefix_pref_time = 0;
+            unsigned int prefix_valid_time = 0;
+            char c;
+            WanMgr_Iface_Data_t* pWanDmlIfaceData = WanMgr_GetIfaceDataByName_locked(PHY_WAN_IF_NAME);
+            if(pWanDmlIfaceData != NULL)
+            {
+                DML_WAN_IFACE* pIfaceData = &(pWanDmlIfaceData->data);
+                if(pIfaceData->IP.pIpcIpv6Data == NULL)
+                {
+                    pIfaceData->IP.pIpcIpv6Data = (ipc_dhcpv6_data_t*) calloc(1, WANMGR_IPV6_MSG_SIZE);
+                    if(pIfaceData->IP.pIpcIpv6Data != NULL)
+                    {
+                        strncpy(pIfaceData->IP.pIpcIpv6Data->ifname, pIfaceData->Wan.Name, sizeof(pIfaceData->IP.pIpcIpv6Data->ifname));
+                        if(strlen(v6pref) == 0)
+                        {
+                            pIfaceData->IP.pIpcIpv6Data->isExpired = TRUE;
                         }
-                        // send an event to Sky-pro app manager that Global-prefix is set
-                        sysevent_set(sysevent_fd, sysevent_token,"lan_prefix_set", globalIP, 0);
-                        /**
-                        * Send data to wanmanager.
-                        */
-                        int ipv6_wan_status = 0;
-                        char dns_server[256] = {'\0'};
-                        unsigned int prefix_pref_time = 0;
-                        unsigned int prefix_valid_time = 0;
-                        char c;
-                        WanMgr_Iface_Data_t* pWanDmlIfaceData = WanMgr_GetIfaceDataByName_locked(PHY_WAN_IF_NAME);
-                        if(pWanDmlIfaceData != NULL)
+                        else
                         {
-                            DML_WAN_IFACE* pIfaceData = &(pWanDmlIfaceData->data);
-                            if(pIfaceData->IP.pIpcIpv6Data == NULL)
+                            pIfaceData->IP.pIpcIpv6Data->isExpired = FALSE;
+                            pIfaceData->IP.pIpcIpv6Data->prefixAssigned = TRUE;
+                            strncpy(pIfaceData->IP.pIpcIpv6Data->sitePrefix, v6pref, sizeof(pIfaceData->IP.pIpcIpv6Data->sitePrefix));
+                            strncpy(pIfaceData->IP.pIpcIpv6Data->pdIfAddress, "", sizeof(pIfaceData->IP.pIpcIpv6Data->pdIfAddress));
+                            /** DNS servers. **/
+                            sysevent_get(sysevent_fd, sysevent_token,SYSEVENT_FIELD_IPV6_DNS_SERVER, dns_server, sizeof(dns_server));
+                            if (strlen(dns_server) != 0)
                             {
-                                pIfaceData->IP.pIpcIpv6Data = (ipc_dhcpv6_data_t*) malloc(sizeof(ipc_dhcpv6_data_t));
-                                if(pIfaceData->IP.pIpcIpv6Data != NULL)
-                                {
-                                    strncpy(pIfaceData->IP.pIpcIpv6Data->ifname, pIfaceData->Wan.Name, sizeof(pIfaceData->IP.pIpcIpv6Data->ifname));
-                                    if(strlen(v6pref) == 0)
-                                    {
-                                        pIfaceData->IP.pIpcIpv6Data->isExpired = TRUE;
-                                    }
-                                    else
-                                    {
-                                        pIfaceData->IP.pIpcIpv6Data->isExpired = FALSE;
-                                        pIfaceData->IP.pIpcIpv6Data->prefixAssigned = TRUE;
-                                        strncpy(pIfaceData->IP.pIpcIpv6Data->sitePrefix, v6pref, sizeof(pIfaceData->IP.pIpcIpv6Data->sitePrefix));
-                                        strncpy(pIfaceData->IP.pIpcIpv6Data->pdIfAddress, "", sizeof(pIfaceData->IP.pIpcIpv6Data->pdIfAddress));
-                                        /** DNS servers. **/
-                                        sysevent_get(sysevent_fd, sysevent_token,SYSEVENT_FIELD_IPV6_DNS_SERVER, dns_server, sizeof(dns_server));
-                                        if (strlen(dns_server) != 0)
-                                        {
-                                            pIfaceData->IP.pIpcIpv6Data->dnsAssigned = TRUE;
-                                            sscanf (dns_server, "%s %s", pIfaceData->IP.pIpcIpv6Data->nameserver,
-                                                                         pIfaceData->IP.pIpcIpv6Data->nameserver1);
-                                        }
-                                        sscanf(iapd_pretm, "%c%u%c", &c, &prefix_pref_time, &c);
-                                        sscanf(iapd_vldtm, "%c%u%c", &c, &prefix_valid_time, &c);
-                                        pIfaceData->IP.pIpcIpv6Data->prefixPltime = prefix_pref_time;
-                                        pIfaceData->IP.pIpcIpv6Data->prefixVltime = prefix_valid_time;
-                                        pIfaceData->IP.pIpcIpv6Data->maptAssigned = FALSE;
-                                        pIfaceData->IP.pIpcIpv6Data->mapeAssigned = FALSE;
-                                        pIfaceData->IP.pIpcIpv6Data->prefixCmd = 0;
-                                    }
-                                    if (wanmgr_handle_dchpv6_event_data(pIfaceData) != ANSC_STATUS_SUCCESS)
-                                    {
-                                        CcspTraceError(("[%s-%d] Failed to send dhcpv6 data to wanmanager!!! \n", __FUNCTION__, __LINE__));
-                                    }
-                                }
+                                pIfaceData->IP.pIpcIpv6Data->dnsAssigned = TRUE;
+                                sscanf (dns_server, "%s %s", pIfaceData->IP.pIpcIpv6Data->nameserver,
+                                                             pIfaceData->IP.pIpcIpv6Data->nameserver1);
                             }
-                            WanMgrDml_GetIfaceData_release(pWanDmlIfaceData);
+                            sscanf(iapd_pretm, "%c%u%c", &c, &prefix_pref_time, &c);
+                            sscanf(iapd_vldtm, "%c%u%c", &c, &prefix_valid_time, &c);
+                            pIfaceData->IP.pIpcIpv6Data->prefixPltime = prefix_pref_time;
+                            pIfaceData->IP.pIpcIpv6Data->prefixVltime = prefix_valid_time;
+                            pIfaceData->IP.pIpcIpv6Data->maptAssigned = FALSE;
+                            pIfaceData->IP.pIpcIpv6Data->mapeAssigned = FALSE;
+                            pIfaceData->IP.pIpcIpv6Data->prefixCmd = 0;
+                        }
+                        if (wanmgr_handle_dchpv6_event_data(pIfaceData) != ANSC_STATUS_SUCCESS)
+                        {
+                            CcspTraceError(("[%s-%d] Failed to send dhcpv6 data to wanmanager!!! \n", __FUNCTION__, __LINE__));
                         }
+                    }
+                }
+                WanMgrDml_GetIfaceData_release(pWanDmlIfaceData);
+            }
 #endif
-                        // not the best place to add route, just to make it work
-                        // delegated prefix need to route to LAN interface
-                        sprintf(cmd, "ip -6 route add %s dev %s", v6pref, COSA_DML_DHCPV6_SERVER_IFNAME);
-                        system(cmd);
-            #ifdef _COSA_INTEL_XB3_ARM_
+            // not the best place to add route, just to make it work
+            // delegated prefix need to route to LAN interface
+            sprintf(cmd, "ip -6 route add %s dev %s", v6pref, COSA_DML_DHCPV6_SERVER_IFNAME);
+            system(cmd);
+#ifdef _COSA_INTEL_XB3_ARM_
             memset(cmd,0,sizeof(cmd));
-                        sprintf(cmd, "ip -6 route add %s dev %s table erouter", v6pref, COSA_DML_DHCPV6_SERVER_IFNAME);
-                        system(cmd);
-            #endif
-                        /* we need save this for zebra to send RA
-                           ipv6_prefix           // xx:xx::/yy
-                         */
+            sprintf(cmd, "ip -6 route add %s dev %s table erouter", v6pref, COSA_DML_DHCPV6_SERVER_IFNAME);
+            system(cmd);
+#endif
+            /* we need save this for zebra to send RA
+               ipv6_prefix           // xx:xx::/yy
+             */
 #ifndef _HUB4_PRODUCT_REQ_
-                        sprintf(cmd, "sysevent set ipv6_prefix %s \n",v6pref);
-                        system(cmd);
+            sprintf(cmd, "sysevent set ipv6_prefix %s \n",v6pref);
+            system(cmd);
 #else
-                        sprintf(cmd, "sysevent set zebra-restart \n");
-                        system(cmd);
+            sprintf(cmd, "sysevent set zebra-restart \n");
+            system(cmd);
 #endif
-                        CcspTraceWarning(("!run cmd1:%s", cmd));
+            CcspTraceWarning(("!run cmd1:%s", cmd));
 
-                        DHCPv6sDmlTriggerRestart(FALSE);
+            DHCPv6sDmlTriggerRestart(FALSE);
 
-                        /*We need get a global ip addres */
+            /*We need get a global ip addres */
 #if defined(_COSA_BCM_ARM_) || defined(INTEL_PUMA7)
-                        /*this is for tchxb6*/
-                        CcspTraceWarning((" %s dhcpv6_assign_global_ip to brlan0 \n", __FUNCTION__));
-                        ret = dhcpv6_assign_global_ip(v6pref, "brlan0", globalIP);
+            /*this is for tchxb6*/
+            CcspTraceWarning((" %s dhcpv6_assign_global_ip to brlan0 \n", __FUNCTION__));
+            ret = dhcpv6_assign_global_ip(v6pref, "brlan0", globalIP);
 #elif defined _COSA_BCM_MIPS_
-                        ret = dhcpv6_assign_global_ip(v6pref, COSA_DML_DHCPV6_SERVER_IFNAME, globalIP);
+            ret = dhcpv6_assign_global_ip(v6pref, COSA_DML_DHCPV6_SERVER_IFNAME, globalIP);
 #else
-                        ret = dhcpv6_assign_global_ip(v6pref, "l2sd0", globalIP);
+            ret = dhcpv6_assign_global_ip(v6pref, "l2sd0", globalIP);
 #endif
-                        CcspTraceWarning(("%s: globalIP %s globalIP2 %s\n", __func__,
-                            globalIP, globalIP2));
-                        if ( _ansc_strcmp(globalIP, globalIP2 ) ){
-                            bRestartLan = TRUE;
+            CcspTraceWarning(("%s: globalIP %s globalIP2 %s\n", __func__,
+                globalIP, globalIP2));
+            if ( _ansc_strcmp(globalIP, globalIP2 ) ){
+                bRestartLan = TRUE;
 
-                            //PaM may restart. When this happen, we should not overwrite previous ipv6
-                            if ( globalIP2[0] )
-                               sysevent_set(sysevent_fd, sysevent_token,"lan_ipaddr_v6_prev", globalIP2, 0);
+                //PaM may restart. When this happen, we should not overwrite previous ipv6
+                if ( globalIP2[0] )
+                   sysevent_set(sysevent_fd, sysevent_token,"lan_ipaddr_v6_prev", globalIP2, 0);
 
-                            _ansc_strcpy(globalIP2, globalIP);
-                        }else{
+                _ansc_strcpy(globalIP2, globalIP);
+            }else{
                 char lanrestart[8] = {0};
-                    sysevent_get(sysevent_fd, sysevent_token,"lan_restarted",lanrestart, sizeof(lanrestart));
+                sysevent_get(sysevent_fd, sysevent_token,"lan_restarted",lanrestart, sizeof(lanrestart));
                 fprintf(stderr,"lan restart staus is %s \n",lanrestart);
-                   if (strcmp("true",lanrestart) == 0)
+                if (strcmp("true",lanrestart) == 0)
                     bRestartLan = TRUE;
-                    else
-                                bRestartLan = FALSE;
+                else
+                    bRestartLan = FALSE;
             }
-                        CcspTraceWarning(("%s: bRestartLan %d\n", __func__, bRestartLan));
+            CcspTraceWarning(("%s: bRestartLan %d\n", __func__, bRestartLan));
 
-                        fprintf(stderr, "%s -- %d !!! ret:%d bRestartLan:%d %s %s \n", __FUNCTION__, __LINE__,ret,  bRestartLan,  globalIP, globalIP2);
+            fprintf(stderr, "%s -- %d !!! ret:%d bRestartLan:%d %s %s \n", __FUNCTION__, __LINE__,ret,  bRestartLan,  globalIP, globalIP2);
 
-                        if ( ret != 0 )
-                        {
-                            AnscTrace("error, assign global ip error.\n");
-                        }else if ( bRestartLan == FALSE ){
-                            AnscTrace("Same global IP, Need not restart.\n");
-                        }else{
-                            /* This is for IP.Interface.1. use */
-                            sysevent_set(sysevent_fd, sysevent_token,COSA_DML_DHCPV6S_ADDR_SYSEVENT_NAME, globalIP, 0);
-
-                            /*This is for brlan0 interface */
-                            sysevent_set(sysevent_fd, sysevent_token,"lan_ipaddr_v6", globalIP, 0);
-                            _ansc_sprintf(cmd, "%d", pref_len);
-                            sysevent_set(sysevent_fd, sysevent_token,"lan_prefix_v6", cmd, 0);
-
-                            sysevent_set(sysevent_fd, sysevent_token,"lan-restart", "1", 0);
-                        }
+            if ( ret != 0 )
+            {
+                AnscTrace("error, assign global ip error.\n");
+            }else if ( bRestartLan == FALSE ){
+                AnscTrace("Same global IP, Need not restart.\n");
+            }else{
+                /* This is for IP.Interface.1. use */
+                sysevent_set(sysevent_fd, sysevent_token,COSA_DML_DHCPV6S_ADDR_SYSEVENT_NAME, globalIP, 0);
+
+                /*This is for brlan0 interface */
+                sysevent_set(sysevent_fd, sysevent_token,"lan_ipaddr_v6", globalIP, 0);
+                _ansc_sprintf(cmd, "%d", pLease->prefLen);
+                sysevent_set(sysevent_fd, sysevent_token,"lan_prefix_v6", cmd, 0);
+
+                sysevent_set(sysevent_fd, sysevent_token,"lan-restart", "1", 0);
+            }
 #endif
-                    }
-                }
-                else if (!strncmp(action, "del", 3))
+        }
+    }
+    else if (!strncmp(pLease->action, "del", 3))
+    {
+        /* the delegated prefix is gone, hand the LAN /64s back */
+        if (strncmp(pLease->v6pref, "::", 2) != 0)
+        {
+            char *token = NULL;
+            char *pt = NULL;
+
+            memset(out, 0, sizeof(out));
+            syscfg_get(NULL, "IPv6_Interface", out, sizeof(out));
+            pt = out;
+            while ((token = strtok_r(pt, ",", &pt)))
+            {
+                if (WanMgr_SubPrefix_Release(token) == ANSC_STATUS_SUCCESS)
                 {
-                    /*todo*/
+                    snprintf(objName, sizeof(objName), "%s_ipaddr_v6", token);
+                    sysevent_set(sysevent_fd, sysevent_token, objName, "", 0);
                 }
+            }
+        }
+    }
 #if defined(CISCO_CONFIG_DHCPV6_PREFIX_DELEGATION) && (defined(_CBR_PRODUCT_REQ_) || defined(_BCI_FEATURE_REQ))
 
 #else
-        system("sysevent set zebra-restart");
+    system("sysevent set zebra-restart");
 #endif
-            }
+}
 
+/* Processes one dibbler-client notification. Runs on the event loop worker. */
+static void dhcpv6c_process_msg(char *msg)
+{
+    WANMGR_DHCPV6C_LEASE lease;
+    char * p = NULL;
+
+    CcspTraceInfo(("%s: get message %s\n", __func__, msg));
+
+    if (!strncmp(msg, "dibbler-client", strlen("dibbler-client")))
+    {
+        /*the format is :
+         add 2000::ba7a:1ed4:99ea:cd9f :: 0 t1
+         action, address, prefix, pref_len 3600
+        now action only supports "add", "del"*/
+
+        p = msg+strlen("dibbler-client");
+        while(isblank(*p)) p++;
+
+        memset(&lease, 0, sizeof(lease));
+        if (sscanf(p, "%63s %63s %31s %31s %31s %31s %31s %63s %d %31s %31s %31s %31s %31s",
+                   lease.action, lease.v6addr, lease.ianaIaid, lease.ianaT1, lease.ianaT2, lease.ianaPretm, lease.ianaVldtm,
+                   lease.v6pref, &lease.prefLen, lease.iapdIaid, lease.iapdT1, lease.iapdT2, lease.iapdPretm, lease.iapdVldtm) == 14)
+        {
+            WanMgr_Dhcpv6c_ProcessLease(&lease);
         }
+    }
 #ifdef _DEBUG
-        else if (!strncmp(msg, "mem", 3))
+    else if (!strncmp(msg, "mem", 3))
+    {
+        /*add the test funcs in the run time.*/
+
+        AnscTraceMemoryTable();
+    }
+#endif
+}
+
+static void dhcpv6c_process_msg_work(void *arg)
+{
+    dhcpv6c_process_msg((char *) arg);
+    free(arg);
+}
+
+static void dhcpv6c_multinet_lan_status(const char *name, const char *val)
+{
+    WANMGR_DHCPV6C_LEASE lease;
+
+    if (strcmp(val, "ready") != 0 || gDhcpv6c_ctx.leasePending != TRUE)
+    {
+        return;
+    }
+
+    CcspTraceInfo(("%s: lan ready, replaying deferred DHCPv6 lease\n", __func__));
+    lease = gDhcpv6c_ctx.pendingLease;
+    WanMgr_Dhcpv6c_ProcessLease(&lease);
+}
+
+static void dhcpv6c_fifo_queue_record(const char *record)
+{
+    char *pWork = NULL;
+
+    if (record[0] == '\0')
+    {
+        return;
+    }
+
+    if ((pWork = strdup(record)) == NULL)
+    {
+        return;
+    }
+
+    if (WanMgr_EventLoop_QueueWork(dhcpv6c_process_msg_work, pWork) != ANSC_STATUS_SUCCESS)
+    {
+        free(pWork);
+    }
+}
+
+/* Hands every complete line in the ring to the worker, partial data stays */
+static void dhcpv6c_fifo_extract_records(dhcpv6c_fifo_ring_t *pRing)
+{
+    char record[DHCPV6C_FIFO_MSG_SIZE];
+    size_t len = 0;
+    size_t scanned = 0;
+    char c;
+
+    while (scanned < pRing->count)
+    {
+        c = pRing->data[(pRing->head + scanned) % DHCPV6C_FIFO_RING_SIZE];
+        scanned++;
+
+        if (c == '\n' || c == '\0')
         {
-            /*add the test funcs in the run time.*/
+            record[len] = '\0';
+            pRing->head = (pRing->head + scanned) % DHCPV6C_FIFO_RING_SIZE;
+            pRing->count -= scanned;
+            scanned = 0;
+            len = 0;
+            pRing->records++;
+            dhcpv6c_fifo_queue_record(record);
+            continue;
+        }
 
-            AnscTraceMemoryTable();
+        /* over-long lines are truncated, the rest is consumed up to the newline */
+        if (len < sizeof(record) - 1)
+        {
+            record[len++] = c;
         }
-#endif
     }
 
-EXIT:
-    if(fd>=0) {
-        close(fd);
+    if (pRing->count == DHCPV6C_FIFO_RING_SIZE)
+    {
+        /* a full ring without a terminator can't be framed, resync on the next line */
+        CcspTraceError(("%s: dibbler fifo overflow, dropping %zu bytes\n", __func__, pRing->count));
+        pRing->dropped += pRing->count;
+        pRing->head = 0;
+        pRing->count = 0;
     }
+}
+
+/* Event loop callback for the dibbler fifo, reads until the fifo is empty */
+static void dhcpv6c_fifo_readable(int fd, uint32_t events, void *arg)
+{
+    dhcpv6c_fifo_ring_t *pRing = &gDhcpv6c_ctx.ring;
+    size_t tail;
+    size_t room;
+    ssize_t len;
+
+    for (;;)
+    {
+        tail = (pRing->head + pRing->count) % DHCPV6C_FIFO_RING_SIZE;
+        room = DHCPV6C_FIFO_RING_SIZE - pRing->count;
+        if (tail + room > DHCPV6C_FIFO_RING_SIZE)
+        {
+            /* contiguous part up to the end of the ring */
+            room = DHCPV6C_FIFO_RING_SIZE - tail;
+        }
 
-    if(fd1>=0) {
-        close(fd1);
+        len = read(fd, pRing->data + tail, room);
+        if (len < 0 && errno == EINTR)
+        {
+            continue;
+        }
+        if (len <= 0)
+        {
+            /* EAGAIN, the fifo is drained */
+            break;
+        }
+
+        pRing->count += (size_t) len;
+        dhcpv6c_fifo_extract_records(pRing);
     }
+}
 
-    return NULL;
+static ANSC_STATUS dhcpv6c_fifo_init(void)
+{
+    sysevent_get(sysevent_fd, sysevent_token,"lan_ipaddr_v6", globalIP2, sizeof(globalIP2));
+    if ( globalIP2[0] )
+        CcspTraceWarning(("%s  It seems there is old value(%s)\n", __FUNCTION__, globalIP2));
+
+    /* O_RDWR keeps a writer open so the fifo never reports EOF */
+    gDhcpv6c_ctx.fifoFd = open(CCSP_COMMON_FIFO, O_RDWR | O_NONBLOCK | O_CLOEXEC);
+    if (gDhcpv6c_ctx.fifoFd < 0)
+    {
+        CcspTraceError(("%s open %s failed (%s)\n", __FUNCTION__, CCSP_COMMON_FIFO, strerror(errno)));
+        return ANSC_STATUS_FAILURE;
+    }
+
+    if (WanMgr_EventLoop_AddFd(gDhcpv6c_ctx.fifoFd, "dhcpv6c-fifo", dhcpv6c_fifo_readable, NULL) != ANSC_STATUS_SUCCESS)
+    {
+        close(gDhcpv6c_ctx.fifoFd);
+        gDhcpv6c_ctx.fifoFd = -1;
+        return ANSC_STATUS_FAILURE;
+    }
+
+    return ANSC_STATUS_SUCCESS;
 }
 
 
@@ -2325,7 +2444,8 @@ static ANSC_STATUS wanmgr_dchpv6_get_ipc_msg_info(WANMGR_IPV6_DATA* pDhcpv6Data,
     pDhcpv6Data->prefixVltime = pIpcIpv6Data->prefixVltime;
     memcpy(pDhcpv6Data->sitePrefixOld, pIpcIpv6Data->sitePrefixOld, BUFLEN_48);
 
-    return ANSC_STATUS_SUCCESS;
+    /* parse once here, consumers work on the binary copy */
+    return WanManager_Ipv6DataToBin(pDhcpv6Data);
 }
 
 ANSC_STATUS wanmgr_handle_dchpv6_event_data(DML_WAN_IFACE* pIfaceData)
@@ -2381,11 +2501,12 @@ ANSC_STATUS wanmgr_handle_dchpv6_event_data(DML_WAN_IFACE* pIfaceData)
 
 #ifdef FEATURE_MAPT
     Dhcp6cMAPTParametersMsgBody dhcp6cMAPTMsgBodyPrvs;
-    size_t expectedLength = sizeof(ipc_dhcpv6_data_t) + sizeof(Dhcp6cMAPTParametersMsgBody);
+    BOOL mapTUpdated = FALSE;
+    /* the lease buffer is WANMGR_IPV6_MSG_SIZE long, a sender without MAP-T parameters leaves them zeroed */
+    Dhcp6cMAPTParametersMsgBody *dhcp6cMAPTMsgBody = (Dhcp6cMAPTParametersMsgBody *)(pNewIpcMsg + 1);
     CcspTraceNotice(("FEATURE_MAPT: MAP-T Enable %d\n", pNewIpcMsg->maptAssigned));
-    if (pNewIpcMsg->maptAssigned && (msg->dataLength == expectedLength))
+    if (pNewIpcMsg->maptAssigned && (dhcp6cMAPTMsgBody->ruleIPv6Prefix[0] != '\0'))
     {
-        Dhcp6cMAPTParametersMsgBody *dhcp6cMAPTMsgBody = (Dhcp6cMAPTParametersMsgBody *)(pNewIpcMsg + 1);
 #ifdef FEATURE_MAPT_DEBUG
         LOG_PRINT_MAPT("Got an event in Wanmanager for MAPT - CONFIG");
 #endif
@@ -2394,15 +2515,29 @@ ANSC_STATUS wanmgr_handle_dchpv6_event_data(DML_WAN_IFACE* pIfaceData)
 
         if (memcmp(dhcp6cMAPTMsgBody, &dhcp6cMAPTMsgBodyPrvs, sizeof(Dhcp6cMAPTParametersMsgBody)) != 0)
         {
-            //WanManager_UpdateGlobalWanData(MAPT_CONFIG_CHANGED, TRUE);
-            pIfaceData->MAP.MaptChanged = TRUE;
+            /* While MAP-T is up, apply only the changed rules in place. A full
+             * tear down and rebuild is left to the state machine otherwise. */
+            if (pIfaceData->MAP.MaptStatus == WAN_IFACE_MAPT_STATE_UP &&
+                WanManager_UpdateMAPTConfiguration(&dhcp6cMAPTMsgBodyPrvs, dhcp6cMAPTMsgBody, pIfaceData->Wan.Name) == RETURN_OK)
+            {
+                memcpy(&(pIfaceData->MAP.dhcp6cMAPTparameters), dhcp6cMAPTMsgBody, sizeof(Dhcp6cMAPTParametersMsgBody));
+                mapTUpdated = TRUE;
+            }
+            else
+            {
+                //WanManager_UpdateGlobalWanData(MAPT_CONFIG_CHANGED, TRUE);
+                pIfaceData->MAP.MaptChanged = TRUE;
+            }
         }
 
-        // store MAP-T parameters locally
-        memcpy(&(pIfaceData->MAP.dhcp6cMAPTparameters), dhcp6cMAPTMsgBody, sizeof(Dhcp6cMAPTParametersMsgBody));
+        if (mapTUpdated == FALSE)
+        {
+            // store MAP-T parameters locally
+            memcpy(&(pIfaceData->MAP.dhcp6cMAPTparameters), dhcp6cMAPTMsgBody, sizeof(Dhcp6cMAPTParametersMsgBody));
 
-        // update MAP-T flags
-        WanManager_UpdateInterfaceStatus(pIfaceData, WANMGR_IFACE_MAPT_START);
+            // update MAP-T flags
+            WanManager_UpdateInterfaceStatus(pIfaceData, WANMGR_IFACE_MAPT_START);
+        }
     }
     else
     {
@@ -2580,11 +2715,7 @@ ANSC_STATUS wanmgr_handle_dchpv6_event_data(DML_WAN_IFACE* pIfaceData)
         WANMGR_IPV6_DATA Ipv6DataTemp;
         wanmgr_dchpv6_get_ipc_msg_info(&(Ipv6DataTemp), pNewIpcMsg);
 
-        if (strcmp(Ipv6DataTemp.address, pDhcp6cInfoCur->address) ||
-                strcmp(Ipv6DataTemp.pdIfAddress, pDhcp6cInfoCur->pdIfAddress) ||
-                strcmp(Ipv6DataTemp.nameserver, pDhcp6cInfoCur->nameserver) ||
-                strcmp(Ipv6DataTemp.nameserver1, pDhcp6cInfoCur->nameserver1) ||
-                strcmp(Ipv6DataTemp.sitePrefix, pDhcp6cInfoCur->sitePrefix))
+        if (memcmp(&Ipv6DataTemp.bin, &pDhcp6cInfoCur->bin, sizeof(WANMGR_IPV6_ADDR_BIN)) != 0)
         {
             CcspTraceInfo(("IPv6 configuration has been changed \n"));
             pIfaceData->IP.Ipv6Changed = TRUE;
@@ -2635,7 +2766,7 @@ void* IPV6CPStateChangeHandler (void *arg)
                 WanManager_StartDhcpv6Client(dhcpcInterface , TRUE);
                 break;
             case WAN_IFACE_IPV6CP_STATUS_DOWN:
-                WanManager_StopDhcpv6Client(TRUE);
+                WanManager_StopDhcpv6Client(dhcpcInterface, TRUE);
                 break;
         }
 
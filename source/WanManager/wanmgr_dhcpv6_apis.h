@@ -36,6 +36,10 @@
 
 #define CCSP_COMMON_FIFO "/tmp/ccsp_common_fifo"
 
+/* addrCmd and prefixCmd of ipc_dhcpv6_data_t */
+#define IFADDRCONF_ADD 0
+#define IFADDRCONF_REMOVE 1
+
 #define  DML_DHCP_MAX_ENTRIES                  4
 #define  DML_DHCP_MAX_RESERVED_ADDRESSES       8
 #define  DML_DHCP_MAX_OPT_ENTRIES              8
@@ -329,6 +333,34 @@ WanMgr_DmlStartDHCP6Client
 
 
 
+/* One lease notification of the DHCPv6 client, the fields of a dibbler-client
+ * notify record. Times are text the way the notify script prints them. */
+typedef struct _WANMGR_DHCPV6C_LEASE
+{
+    char    action[64];         /* "add" or "del" */
+    char    v6addr[64];         /* IA_NA address, "::" for none */
+    char    ianaIaid[32];
+    char    ianaT1[32];
+    char    ianaT2[32];
+    char    ianaPretm[32];
+    char    ianaVldtm[32];
+    char    v6pref[64];         /* IA_PD prefix without the length, "::" for none */
+    int     prefLen;
+    char    iapdIaid[32];
+    char    iapdT1[32];
+    char    iapdT2[32];
+    char    iapdPretm[32];
+    char    iapdVldtm[32];
+} WANMGR_DHCPV6C_LEASE;
+
+/**
+ * @brief Apply a DHCPv6 client lease to the LAN side (delegated prefix, brlan0
+ * address, DHCPv6 server) and to the Device.DHCPv6.Client sysevents. The lease is
+ * kept and applied later if the LAN bridge is not ready yet.
+ * @param pLease lease notification
+ */
+void WanMgr_Dhcpv6c_ProcessLease(const WANMGR_DHCPV6C_LEASE *pLease);
+
 /**
  * @brief API to process DHCP state change event message.
  * @param msg - Pointer to msg_payload_t structure contains Dhcpv6 configuration as part of ipc message
@@ -0,0 +1,1556 @@
+/*
+ * If not stated otherwise in this file or this component's Licenses.txt file the
+ * following copyright and licenses apply:
+ *
+ * Copyright 2020 RDK Management
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+*/
+
+#ifdef FEATURE_EMBEDDED_DHCPV6_CLIENT
+
+/* ---- Include Files ---------------------------------------- */
+#define _GNU_SOURCE     /* struct in6_pktinfo */
+#include <errno.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <sys/ioctl.h>
+#include <sys/socket.h>
+#include <sys/timerfd.h>
+#include <net/if.h>
+#include <netinet/in.h>
+#include <linux/if_ether.h>
+#include "syscfg.h"
+#include "wanmgr_dhcpv6_client.h"
+#include "wanmgr_dhcpv6_apis.h"
+#include "wanmgr_event_loop.h"
+#include "wanmgr_ipc.h"
+#include "wanmgr_netlink.h"
+
+#define DHCPV6C_CLIENT_PORT         546
+#define DHCPV6C_SERVER_PORT         547
+#define DHCPV6C_ALL_SERVERS         "ff02::1:2"     /* All_DHCP_Relay_Agents_and_Servers */
+#define DHCPV6C_PKT_MAX             1536
+#define DHCPV6C_MAX_DUID            130             /* type and up to 128 bytes (RFC 8415 11.1) */
+#define DHCPV6C_INFINITE            0xFFFFFFFF
+#define DHCPV6C_IAID                1               /* one IA_NA and one IA_PD, stable across reboots */
+#define DHCPV6C_MAX_RULES           4
+#define DHCPV6C_DEFAULT_PSID_OFFSET 6               /* RFC 7597 5.1 */
+#define DHCPV6C_MAX_PREFERENCE      255             /* an ADVERTISE to take at once (RFC 8415 18.2.1) */
+#define DHCPV6C_REPORT_RETRY_MS     100             /* a lease the state machine has not taken yet is offered again */
+
+#define DHCPV6C_SOLICIT             1
+#define DHCPV6C_ADVERTISE           2
+#define DHCPV6C_REQUEST             3
+#define DHCPV6C_RENEW               5
+#define DHCPV6C_REBIND              6
+#define DHCPV6C_REPLY               7
+#define DHCPV6C_RELEASE             8
+
+#define DHCPV6C_OPT_CLIENTID        1
+#define DHCPV6C_OPT_SERVERID        2
+#define DHCPV6C_OPT_IA_NA           3
+#define DHCPV6C_OPT_IAADDR          5
+#define DHCPV6C_OPT_ORO             6
+#define DHCPV6C_OPT_PREFERENCE      7
+#define DHCPV6C_OPT_ELAPSED_TIME    8
+#define DHCPV6C_OPT_STATUS_CODE     13
+#define DHCPV6C_OPT_RAPID_COMMIT    14
+#define DHCPV6C_OPT_DNS_SERVERS     23
+#define DHCPV6C_OPT_DOMAIN_LIST     24
+#define DHCPV6C_OPT_IA_PD           25
+#define DHCPV6C_OPT_IAPREFIX        26
+#define DHCPV6C_OPT_AFTR_NAME       64
+#define DHCPV6C_OPT_S46_RULE        89
+#define DHCPV6C_OPT_S46_DMR         91
+#define DHCPV6C_OPT_S46_PORTPARAMS  93
+#define DHCPV6C_OPT_S46_CONT_MAPT   95
+
+#define DHCPV6C_STATUS_SUCCESS      0
+#define DHCPV6C_STATUS_NOBINDING    3
+
+/* Device.DHCPv6.Client configuration as stored by the data model */
+#define DHCPV6C_SYSCFG_IANA         "tr_dhcpv6c_iana_enabled"
+#define DHCPV6C_SYSCFG_IAPD         "tr_dhcpv6c_iapd_enabled"
+#define DHCPV6C_SYSCFG_RAPID_COMMIT "tr_dhcpv6c_rapidcommit_enabled"
+
+typedef enum
+{
+    DHCPV6C_SOLICITING = 0,     /* ADVERTISEs are collected until the first RT, or a rapid commit REPLY taken */
+    DHCPV6C_REQUESTING,         /* ADVERTISE requested, waiting for the REPLY */
+    DHCPV6C_BOUND,
+    DHCPV6C_RENEWING,           /* to the server of the lease from T1 */
+    DHCPV6C_REBINDING           /* to any server from T2 */
+} Dhcpv6cState_t;
+
+/* The address of an IA_NA or the prefix of an IA_PD */
+typedef struct _Dhcpv6cIa_t
+{
+    BOOL            granted;
+    struct in6_addr addr;
+    uint8_t         prefixLen;      /* IA_PD only */
+    uint32_t        t1;
+    uint32_t        t2;
+    uint32_t        preferred;
+    uint32_t        valid;
+} Dhcpv6cIa_t;
+
+/* A mapping rule of the MAP-T container (RFC 7598 4.1) */
+typedef struct _Dhcpv6cMapRule_t
+{
+    uint8_t         flags;
+    uint8_t         eaLen;
+    uint8_t         v4Len;
+    struct in_addr  v4Prefix;
+    uint8_t         v6Len;
+    struct in6_addr v6Prefix;
+    uint8_t         psidOffset;
+    uint8_t         psidLen;
+    uint16_t        psid;
+} Dhcpv6cMapRule_t;
+
+/* Contents of a received ADVERTISE or REPLY */
+typedef struct _Dhcpv6cLease_t
+{
+    uint8_t          msgType;
+    uint8_t          serverId[DHCPV6C_MAX_DUID];
+    uint16_t         serverIdLen;
+    BOOL             clientIdMatch;
+    uint16_t         status;
+    uint8_t          preference;
+    BOOL             rapidCommit;
+    Dhcpv6cIa_t      na;
+    Dhcpv6cIa_t      pd;
+    uint16_t         naStatus;
+    uint16_t         pdStatus;
+    struct in6_addr  dns[2];
+    UINT             numDns;
+    char             domain[BUFLEN_64];
+    char             aftr[BUFLEN_256];
+    UINT             numRules;
+    Dhcpv6cMapRule_t rules[DHCPV6C_MAX_RULES];
+    BOOL             hasDmr;
+    uint8_t          dmrLen;
+    struct in6_addr  dmrPrefix;
+} Dhcpv6cLease_t;
+
+/* One lease for the workers: the DHCP6C_STATE_CHANGED data with the MAP-T
+ * parameters behind it, and the dibbler notification for the LAN side */
+typedef struct _Dhcpv6cReport_t
+{
+    uint32_t                seq;
+    union
+    {
+        ipc_dhcpv6_data_t   data;
+        uint8_t             raw[WANMGR_IPV6_MSG_SIZE];
+    } ipc;
+    WANMGR_DHCPV6C_LEASE    lanLease;
+} Dhcpv6cReport_t;
+
+typedef struct _Dhcpv6cSession_t
+{
+    BOOL                inUse;
+    char                ifName[IFNAMSIZ];
+    int                 ifIndex;
+    BOOL                wantNa;
+    BOOL                wantPd;
+    BOOL                rapidCommit;
+    uint8_t             duid[DHCPV6C_MAX_DUID];
+    uint16_t            duidLen;
+    Dhcpv6cState_t      state;
+    uint32_t            xid;
+    uint64_t            startMs;        /* of the current exchange, for the elapsed time */
+    uint64_t            nextMs;         /* next transmission or state change, 0 for none */
+    UINT                rtMs;           /* retransmission timeout, 0 before the first */
+    UINT                tries;
+    BOOL                advertised;     /* soliciting, the best ADVERTISE so far is held in lease */
+    BOOL                forced;         /* renewal asked for before T1 */
+    BOOL                leased;         /* a lease is reported up */
+    Dhcpv6cLease_t      lease;          /* advertised, then bound */
+    BOOL                addrSet;        /* the IA_NA address is configured on the interface */
+    struct in6_addr     addrSetAddr;
+    char                prevPrefix[BUFLEN_48];  /* sized as sitePrefixOld it is reported in */
+    uint64_t            t1Ms;           /* 0 for never */
+    uint64_t            t2Ms;
+    uint64_t            expiryMs;
+    uint32_t            reportSeq;      /* of the newest report */
+    Dhcpv6cReport_t    *pReport;        /* report not taken yet, offered again at reportMs */
+    uint64_t            reportMs;
+} Dhcpv6cSession_t;
+
+
+/* ---- Private Variables ------------------------------------ */
+static Dhcpv6cSession_t gSessions[WANMGR_DHCPV6C_MAX_IFACES];
+static int gTimerFd = -1;
+static int gSockFd = -1;
+static unsigned int gSeed = 0;
+static BOOL gDhcpv6cReady = FALSE;
+static pthread_mutex_t gDhcpv6cMutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_once_t gDhcpv6cOnce = PTHREAD_ONCE_INIT;
+
+static const uint16_t gOptionRequest[] =
+{
+    DHCPV6C_OPT_DNS_SERVERS, DHCPV6C_OPT_DOMAIN_LIST, DHCPV6C_OPT_AFTR_NAME, DHCPV6C_OPT_S46_CONT_MAPT
+};
+
+/* ---- Private Functions ------------------------------------ */
+
+static uint64_t Dhcpv6c_NowMs(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t) ts.tv_sec * 1000ULL + (uint64_t) ts.tv_nsec / 1000000ULL;
+}
+
+static uint16_t Dhcpv6c_Get16(const uint8_t *p)
+{
+    return (uint16_t)((p[0] << 8) | p[1]);
+}
+
+static uint32_t Dhcpv6c_Get32(const uint8_t *p)
+{
+    return ((uint32_t) p[0] << 24) | ((uint32_t) p[1] << 16) | ((uint32_t) p[2] << 8) | (uint32_t) p[3];
+}
+
+static void Dhcpv6c_Put16(uint8_t *p, uint16_t value)
+{
+    p[0] = (uint8_t)(value >> 8);
+    p[1] = (uint8_t) value;
+}
+
+static void Dhcpv6c_Put32(uint8_t *p, uint32_t value)
+{
+    Dhcpv6c_Put16(p, (uint16_t)(value >> 16));
+    Dhcpv6c_Put16(p + 2, (uint16_t) value);
+}
+
+static const char *Dhcpv6c_StateName(Dhcpv6cState_t state)
+{
+    switch (state)
+    {
+        case DHCPV6C_SOLICITING: return "SOLICITING";
+        case DHCPV6C_REQUESTING: return "REQUESTING";
+        case DHCPV6C_BOUND:      return "BOUND";
+        case DHCPV6C_RENEWING:   return "RENEWING";
+        case DHCPV6C_REBINDING:  return "REBINDING";
+    }
+    return "UNKNOWN";
+}
+
+/* Next retransmission timeout (RFC 8415 15): IRT then doubled up to MRT, each
+ * randomised by up to 10%. The first SOLICIT timeout is only ever longer. */
+static UINT Dhcpv6c_NextRt(Dhcpv6cSession_t *pSession, UINT irtMs, UINT mrtMs)
+{
+    int64_t rand = (int64_t)(rand_r(&gSeed) % 201) - 100;  /* per mille */
+    int64_t rt;
+
+    if (pSession->rtMs == 0)
+    {
+        if (pSession->state == DHCPV6C_SOLICITING && rand < 0)
+        {
+            rand = -rand;
+        }
+        rt = (int64_t) irtMs + (int64_t) irtMs * rand / 1000;
+    }
+    else
+    {
+        rt = 2 * (int64_t) pSession->rtMs + (int64_t) pSession->rtMs * rand / 1000;
+        if (rt > (int64_t) mrtMs)
+        {
+            rt = (int64_t) mrtMs + (int64_t) mrtMs * rand / 1000;
+        }
+    }
+
+    pSession->rtMs = (UINT) rt;
+    return pSession->rtMs;
+}
+
+static BOOL Dhcpv6c_SyscfgFlag(const char *name, BOOL defaultValue)
+{
+    char out[8] = {0};
+
+    if (syscfg_get(NULL, name, out, sizeof(out)) != 0 || out[0] == '\0')
+    {
+        return defaultValue;
+    }
+    return (out[0] == '1') ? TRUE : FALSE;
+}
+
+/* The DUID dibbler used, so that the server keeps the bindings of the CPE,
+ * else a DUID-LL of the interface (RFC 8415 11.4) */
+static void Dhcpv6c_LoadDuid(Dhcpv6cSession_t *pSession)
+{
+    char text[3 * DHCPV6C_MAX_DUID + 1] = {0};
+    const char *p = text;
+    unsigned int byte;
+    uint16_t len = 0;
+    struct ifreq ifr;
+    FILE *fp;
+    int n;
+
+    if ((fp = fopen(WANMGR_DHCPV6C_DUID_FILE, "r")) != NULL)
+    {
+        if (fgets(text, sizeof(text), fp) != NULL)
+        {
+            //colon separated hex, "00:03:00:01:xx:xx:xx:xx:xx:xx"
+            while (len < DHCPV6C_MAX_DUID && sscanf(p, "%2x%n", &byte, &n) == 1)
+            {
+                pSession->duid[len++] = (uint8_t) byte;
+                p += n;
+                if (*p++ != ':')
+                {
+                    break;
+                }
+            }
+        }
+        fclose(fp);
+
+        if (len > 2)
+        {
+            pSession->duidLen = len;
+            return;
+        }
+    }
+
+    memset(&ifr, 0, sizeof(ifr));
+    snprintf(ifr.ifr_name, sizeof(ifr.ifr_name), "%s", pSession->ifName);
+    if (ioctl(gSockFd, SIOCGIFHWADDR, &ifr) < 0)
+    {
+        CcspTraceWarning(("%s %d - %s: no link layer address for the DUID (%s)\n", __FUNCTION__, __LINE__, pSession->ifName, strerror(errno)));
+    }
+    Dhcpv6c_Put16(pSession->duid, 3);
+    Dhcpv6c_Put16(pSession->duid + 2, 1);
+    memcpy(pSession->duid + 4, ifr.ifr_hwaddr.sa_data, ETH_ALEN);
+    pSession->duidLen = 4 + ETH_ALEN;
+}
+
+/* ---- Reporting, run on the event loop urgent worker ---- */
+
+static int Dhcpv6c_FindSession(const char *ifName);
+static void Dhcpv6c_ArmTimer(void);
+
+/* The LAN side runs service restarts through system(), it is left to the
+ * event loop worker once the WAN side has the lease */
+static void Dhcpv6c_RunLanLease(void *arg)
+{
+    Dhcpv6cReport_t *pReport = (Dhcpv6cReport_t *) arg;
+
+    WanMgr_Dhcpv6c_ProcessLease(&pReport->lanLease);
+    free(pReport);
+}
+
+/* Hand the lease to the same code as a lease from dibbler: the WAN side as a
+ * DHCP6C_STATE_CHANGED message, then, once the WAN side took it, the LAN side
+ * as its notification. As for DHCPv4 the worker is never held up, a lease not
+ * taken yet is offered again from the session timer unless a newer one replaced it. */
+static void Dhcpv6c_RunReport(void *arg)
+{
+    Dhcpv6cReport_t *pReport = (Dhcpv6cReport_t *) arg;
+    int idx;
+
+    if (WanMgr_IpcTryNewIpv6Msg(&pReport->ipc.data, sizeof(pReport->ipc.raw)) == ANSC_STATUS_SUCCESS)
+    {
+        if (WanMgr_EventLoop_QueueWork(Dhcpv6c_RunLanLease, pReport) != ANSC_STATUS_SUCCESS)
+        {
+            CcspTraceError(("%s %d - LAN side of the %s lease dropped\n", __FUNCTION__, __LINE__, pReport->ipc.data.ifname));
+            free(pReport);
+        }
+        return;
+    }
+
+    pthread_mutex_lock(&gDhcpv6cMutex);
+    idx = Dhcpv6c_FindSession(pReport->ipc.data.ifname);
+    if (idx >= 0 && gSessions[idx].reportSeq == pReport->seq && gSessions[idx].pReport == NULL)
+    {
+        gSessions[idx].pReport = pReport;
+        gSessions[idx].reportMs = Dhcpv6c_NowMs() + DHCPV6C_REPORT_RETRY_MS;
+        Dhcpv6c_ArmTimer();
+        pReport = NULL;
+    }
+    pthread_mutex_unlock(&gDhcpv6cMutex);
+
+    free(pReport);
+}
+
+/* Queue a report to the urgent worker, called with gDhcpv6cMutex held */
+static void Dhcpv6c_QueueReport(Dhcpv6cSession_t *pSession, Dhcpv6cReport_t *pReport)
+{
+    if (WanMgr_EventLoop_QueueUrgentWork(Dhcpv6c_RunReport, pReport) != ANSC_STATUS_SUCCESS)
+    {
+        pSession->pReport = pReport;
+        pSession->reportMs = Dhcpv6c_NowMs() + DHCPV6C_REPORT_RETRY_MS;
+    }
+}
+
+#ifdef FEATURE_MAPT
+static BOOL Dhcpv6c_PrefixMatch(const struct in6_addr *pPrefix, const struct in6_addr *pAddr, uint8_t len)
+{
+    uint8_t bytes = len / 8;
+    uint8_t mask = (uint8_t)(0xFF << (8 - len % 8));
+
+    if (memcmp(pPrefix->s6_addr, pAddr->s6_addr, bytes) != 0)
+    {
+        return FALSE;
+    }
+    return (len % 8 == 0 || ((pPrefix->s6_addr[bytes] ^ pAddr->s6_addr[bytes]) & mask) == 0) ? TRUE : FALSE;
+}
+
+/* MAP-T parameters of the rule the delegated prefix falls in, its basic mapping rule */
+static BOOL Dhcpv6c_GetMapt(const Dhcpv6cLease_t *pLease, Dhcp6cMAPTParametersMsgBody *pMapt)
+{
+    const Dhcpv6cMapRule_t *pRule = NULL;
+    char addr[INET6_ADDRSTRLEN] = {0};
+    int ratioBits;
+    UINT idx;
+
+    if (pLease->hasDmr != TRUE || pLease->pd.granted != TRUE)
+    {
+        return FALSE;
+    }
+
+    for (idx = 0; idx < pLease->numRules; idx++)
+    {
+        if (pLease->rules[idx].v6Len <= pLease->pd.prefixLen &&
+            Dhcpv6c_PrefixMatch(&pLease->rules[idx].v6Prefix, &pLease->pd.addr, pLease->rules[idx].v6Len) == TRUE)
+        {
+            pRule = &pLease->rules[idx];
+            break;
+        }
+    }
+    if (pRule == NULL)
+    {
+        CcspTraceWarning(("%s %d - no MAP-T rule for the delegated prefix\n", __FUNCTION__, __LINE__));
+        return FALSE;
+    }
+
+    inet_ntop(AF_INET, &pRule->v4Prefix, addr, sizeof(addr));
+    snprintf(pMapt->ruleIPv4Prefix, sizeof(pMapt->ruleIPv4Prefix), "%s", addr);
+    inet_ntop(AF_INET6, &pRule->v6Prefix, addr, sizeof(addr));
+    snprintf(pMapt->ruleIPv6Prefix, sizeof(pMapt->ruleIPv6Prefix), "%s/%u", addr, pRule->v6Len);
+    inet_ntop(AF_INET6, &pLease->dmrPrefix, addr, sizeof(addr));
+    snprintf(pMapt->brIPv6Prefix, sizeof(pMapt->brIPv6Prefix), "%s/%u", addr, pLease->dmrLen);
+    inet_ntop(AF_INET6, &pLease->pd.addr, addr, sizeof(addr));
+    snprintf(pMapt->pdIPv6Prefix, sizeof(pMapt->pdIPv6Prefix), "%s", addr);
+
+    pMapt->v6Len = pRule->v6Len;
+    pMapt->iapdPrefixLen = pLease->pd.prefixLen;
+    pMapt->v4Len = pRule->v4Len;
+    pMapt->eaLen = pRule->eaLen;
+    pMapt->psidOffset = pRule->psidOffset;
+    pMapt->psidLen = pRule->psidLen;
+    pMapt->psid = pRule->psid;
+
+    //EA bits beyond the IPv4 suffix select the port set, a CE shares its address by that many
+    ratioBits = (int) pRule->eaLen - (32 - (int) pRule->v4Len);
+    pMapt->ratio = (ratioBits > 0) ? (1 << ratioBits) : 1;
+
+    return TRUE;
+}
+#endif
+
+/* Queue the lease of the session up, or expired, called with gDhcpv6cMutex held */
+static void Dhcpv6c_Report(Dhcpv6cSession_t *pSession, BOOL up)
+{
+    Dhcpv6cReport_t *pReport = (Dhcpv6cReport_t *) calloc(1, sizeof(Dhcpv6cReport_t));
+    const Dhcpv6cLease_t *pLease = &pSession->lease;
+    ipc_dhcpv6_data_t *pData;
+    WANMGR_DHCPV6C_LEASE *pLan;
+    char addr[INET6_ADDRSTRLEN] = {0};
+
+    if (pReport == NULL)
+    {
+        return;
+    }
+    pData = &pReport->ipc.data;
+    pLan = &pReport->lanLease;
+
+    //Only the newest report matters, one still waiting is dropped
+    pReport->seq = ++pSession->reportSeq;
+    free(pSession->pReport);
+    pSession->pReport = NULL;
+    pSession->reportMs = 0;
+
+    snprintf(pData->ifname, sizeof(pData->ifname), "%s", pSession->ifName);
+    snprintf(pLan->v6addr, sizeof(pLan->v6addr), "::");
+    snprintf(pLan->v6pref, sizeof(pLan->v6pref), "::");
+
+    if (up != TRUE)
+    {
+        pData->isExpired = TRUE;
+        snprintf(pLan->action, sizeof(pLan->action), "del");
+
+        //The LAN side hands back the /64s it took out of the lost prefix
+        if (pLease->pd.granted == TRUE)
+        {
+            inet_ntop(AF_INET6, &pLease->pd.addr, addr, sizeof(addr));
+            snprintf(pLan->v6pref, sizeof(pLan->v6pref), "%s", addr);
+            pLan->prefLen = pLease->pd.prefixLen;
+        }
+    }
+    else
+    {
+        snprintf(pLan->action, sizeof(pLan->action), "add");
+
+        if (pLease->na.granted == TRUE)
+        {
+            inet_ntop(AF_INET6, &pLease->na.addr, addr, sizeof(addr));
+            pData->addrAssigned = TRUE;
+            pData->addrCmd = IFADDRCONF_ADD;
+            snprintf(pData->address, sizeof(pData->address), "%s/128", addr);
+
+            //the notify script quotes the numbers
+            snprintf(pLan->v6addr, sizeof(pLan->v6addr), "%s", addr);
+            snprintf(pLan->ianaIaid, sizeof(pLan->ianaIaid), "'%u'", DHCPV6C_IAID);
+            snprintf(pLan->ianaT1, sizeof(pLan->ianaT1), "'%u'", pLease->na.t1);
+            snprintf(pLan->ianaT2, sizeof(pLan->ianaT2), "'%u'", pLease->na.t2);
+            snprintf(pLan->ianaPretm, sizeof(pLan->ianaPretm), "'%u'", pLease->na.preferred);
+            snprintf(pLan->ianaVldtm, sizeof(pLan->ianaVldtm), "'%u'", pLease->na.valid);
+        }
+
+        if (pLease->pd.granted == TRUE)
+        {
+            inet_ntop(AF_INET6, &pLease->pd.addr, addr, sizeof(addr));
+            pData->prefixAssigned = TRUE;
+            pData->prefixCmd = IFADDRCONF_ADD;
+            snprintf(pData->sitePrefix, sizeof(pData->sitePrefix), "%s/%u", addr, pLease->pd.prefixLen);
+            pData->prefixPltime = pLease->pd.preferred;
+            pData->prefixVltime = pLease->pd.valid;
+            if (pSession->prevPrefix[0] != '\0' && strcmp(pSession->prevPrefix, pData->sitePrefix) != 0)
+            {
+                snprintf(pData->sitePrefixOld, sizeof(pData->sitePrefixOld), "%s", pSession->prevPrefix);
+            }
+            snprintf(pSession->prevPrefix, sizeof(pSession->prevPrefix), "%s", pData->sitePrefix);
+
+            snprintf(pLan->v6pref, sizeof(pLan->v6pref), "%s", addr);
+            pLan->prefLen = pLease->pd.prefixLen;
+            snprintf(pLan->iapdIaid, sizeof(pLan->iapdIaid), "'%u'", DHCPV6C_IAID);
+            snprintf(pLan->iapdT1, sizeof(pLan->iapdT1), "'%u'", pLease->pd.t1);
+            snprintf(pLan->iapdT2, sizeof(pLan->iapdT2), "'%u'", pLease->pd.t2);
+            snprintf(pLan->iapdPretm, sizeof(pLan->iapdPretm), "'%u'", pLease->pd.preferred);
+            snprintf(pLan->iapdVldtm, sizeof(pLan->iapdVldtm), "'%u'", pLease->pd.valid);
+        }
+
+        if (pLease->numDns > 0)
+        {
+            pData->dnsAssigned = TRUE;
+            inet_ntop(AF_INET6, &pLease->dns[0], pData->nameserver, sizeof(pData->nameserver));
+            if (pLease->numDns > 1)
+            {
+                inet_ntop(AF_INET6, &pLease->dns[1], pData->nameserver1, sizeof(pData->nameserver1));
+            }
+        }
+        if (pLease->domain[0] != '\0')
+        {
+            pData->domainNameAssigned = TRUE;
+            snprintf(pData->domainName, sizeof(pData->domainName), "%s", pLease->domain);
+        }
+        if (pLease->aftr[0] != '\0')
+        {
+            pData->aftrAssigned = TRUE;
+            snprintf(pData->aftr, sizeof(pData->aftr), "%s", pLease->aftr);
+        }
+#ifdef FEATURE_MAPT
+        pData->maptAssigned = Dhcpv6c_GetMapt(pLease, (Dhcp6cMAPTParametersMsgBody *)(pData + 1));
+#endif
+    }
+
+    Dhcpv6c_QueueReport(pSession, pReport);
+}
+
+/* ---- Sending, called with gDhcpv6cMutex held ---- */
+
+static uint8_t *Dhcpv6c_AddOption(uint8_t *pOpt, uint16_t code, const void *data, uint16_t len)
+{
+    Dhcpv6c_Put16(pOpt, code);
+    Dhcpv6c_Put16(pOpt + 2, len);
+    if (len > 0)
+    {
+        memcpy(pOpt + 4, data, len);
+    }
+    return pOpt + 4 + len;
+}
+
+/* IA_NA or IA_PD, with the address or prefix held. Times are left to the server. */
+static uint8_t *Dhcpv6c_AddIa(uint8_t *pOpt, uint16_t code, const Dhcpv6cIa_t *pIa)
+{
+    uint8_t ia[12 + 4 + 25];
+    uint8_t sub[25];
+    uint16_t len = 12;
+
+    memset(ia, 0, sizeof(ia));
+    Dhcpv6c_Put32(ia, DHCPV6C_IAID);
+
+    if (pIa != NULL && pIa->granted == TRUE)
+    {
+        memset(sub, 0, sizeof(sub));
+        if (code == DHCPV6C_OPT_IA_NA)
+        {
+            memcpy(sub, &pIa->addr, sizeof(struct in6_addr));
+            Dhcpv6c_AddOption(ia + len, DHCPV6C_OPT_IAADDR, sub, 24);
+            len += 4 + 24;
+        }
+        else
+        {
+            sub[8] = pIa->prefixLen;
+            memcpy(sub + 9, &pIa->addr, sizeof(struct in6_addr));
+            Dhcpv6c_AddOption(ia + len, DHCPV6C_OPT_IAPREFIX, sub, 25);
+            len += 4 + 25;
+        }
+    }
+
+    return Dhcpv6c_AddOption(pOpt, code, ia, len);
+}
+
+static void Dhcpv6c_Send(Dhcpv6cSession_t *pSession, uint8_t type, uint64_t now)
+{
+    uint8_t pkt[512];
+    uint8_t oro[sizeof(gOptionRequest)];
+    uint8_t elapsed[2];
+    uint64_t elapsedCs = (now - pSession->startMs) / 10;
+    BOOL holding = (type != DHCPV6C_SOLICIT) ? TRUE : FALSE;
+    struct sockaddr_in6 dst;
+    uint8_t *pOpt;
+    size_t idx;
+
+    pkt[0] = type;
+    pkt[1] = (uint8_t)(pSession->xid >> 16);
+    pkt[2] = (uint8_t)(pSession->xid >> 8);
+    pkt[3] = (uint8_t) pSession->xid;
+
+    pOpt = Dhcpv6c_AddOption(pkt + 4, DHCPV6C_OPT_CLIENTID, pSession->duid, pSession->duidLen);
+    if (type == DHCPV6C_REQUEST || type == DHCPV6C_RENEW || type == DHCPV6C_RELEASE)
+    {
+        pOpt = Dhcpv6c_AddOption(pOpt, DHCPV6C_OPT_SERVERID, pSession->lease.serverId, pSession->lease.serverIdLen);
+    }
+
+    Dhcpv6c_Put16(elapsed, (elapsedCs > 0xFFFF) ? 0xFFFF : (uint16_t) elapsedCs);
+    pOpt = Dhcpv6c_AddOption(pOpt, DHCPV6C_OPT_ELAPSED_TIME, elapsed, sizeof(elapsed));
+
+    if (type != DHCPV6C_RELEASE)
+    {
+        for (idx = 0; idx < sizeof(gOptionRequest) / sizeof(gOptionRequest[0]); idx++)
+        {
+            Dhcpv6c_Put16(oro + 2 * idx, gOptionRequest[idx]);
+        }
+        pOpt = Dhcpv6c_AddOption(pOpt, DHCPV6C_OPT_ORO, oro, sizeof(oro));
+    }
+    if (type == DHCPV6C_SOLICIT && pSession->rapidCommit == TRUE)
+    {
+        pOpt = Dhcpv6c_AddOption(pOpt, DHCPV6C_OPT_RAPID_COMMIT, NULL, 0);
+    }
+
+    //A RELEASE names only what is held, the other messages every IA configured
+    if (pSession->wantNa == TRUE && (type != DHCPV6C_RELEASE || pSession->lease.na.granted == TRUE))
+    {
+        pOpt = Dhcpv6c_AddIa(pOpt, DHCPV6C_OPT_IA_NA, (holding == TRUE) ? &pSession->lease.na : NULL);
+    }
+    if (pSession->wantPd == TRUE && (type != DHCPV6C_RELEASE || pSession->lease.pd.granted == TRUE))
+    {
+        pOpt = Dhcpv6c_AddIa(pOpt, DHCPV6C_OPT_IA_PD, (holding == TRUE) ? &pSession->lease.pd : NULL);
+    }
+
+    memset(&dst, 0, sizeof(dst));
+    dst.sin6_family = AF_INET6;
+    dst.sin6_port = htons(DHCPV6C_SERVER_PORT);
+    dst.sin6_scope_id = pSession->ifIndex;
+    inet_pton(AF_INET6, DHCPV6C_ALL_SERVERS, &dst.sin6_addr);
+
+    //Fails until the link local address has passed DAD, the retransmission covers that
+    if (sendto(gSockFd, pkt, pOpt - pkt, 0, (struct sockaddr *) &dst, sizeof(dst)) < 0)
+    {
+        CcspTraceWarning(("%s %d - %s: send failed (%s)\n", __FUNCTION__, __LINE__, pSession->ifName, strerror(errno)));
+    }
+}
+
+/* ---- State machine, called with gDhcpv6cMutex held ---- */
+
+/* Remove the IA_NA address configured, if any */
+static void Dhcpv6c_ClearAddr(Dhcpv6cSession_t *pSession)
+{
+    if (pSession->addrSet == TRUE)
+    {
+        WanMgr_Netlink_SetAddr6(pSession->ifIndex, FALSE, &pSession->addrSetAddr, 128, 0, 0);
+        pSession->addrSet = FALSE;
+    }
+}
+
+static void Dhcpv6c_NewExchange(Dhcpv6cSession_t *pSession, Dhcpv6cState_t state, uint64_t now)
+{
+    pSession->state = state;
+    pSession->xid = (uint32_t) rand_r(&gSeed) & 0xFFFFFF;
+    pSession->startMs = now;
+    pSession->nextMs = now;
+    pSession->rtMs = 0;
+    pSession->tries = 0;
+    pSession->advertised = FALSE;
+}
+
+static void Dhcpv6c_OnDeadline(Dhcpv6cSession_t *pSession, uint64_t now);
+
+/* Request the ADVERTISE held in lease */
+static void Dhcpv6c_Request(Dhcpv6cSession_t *pSession, uint64_t now)
+{
+    CcspTraceInfo(("%s %d - %s: requesting from the server of preference %u\n", __FUNCTION__, __LINE__, pSession->ifName, pSession->lease.preference));
+    Dhcpv6c_NewExchange(pSession, DHCPV6C_REQUESTING, now);
+    Dhcpv6c_OnDeadline(pSession, now);
+}
+
+/* Back to solicitation, a lease held is reported expired */
+static void Dhcpv6c_Restart(Dhcpv6cSession_t *pSession, uint64_t now, BOOL expired)
+{
+    if (expired == TRUE && pSession->leased == TRUE)
+    {
+        CcspTraceInfo(("%s %d - %s: lease lost\n", __FUNCTION__, __LINE__, pSession->ifName));
+        Dhcpv6c_Report(pSession, FALSE);
+        pSession->leased = FALSE;
+    }
+    if (pSession->leased != TRUE)
+    {
+        Dhcpv6c_ClearAddr(pSession);
+    }
+
+    //The interface index can change across link flaps
+    pSession->ifIndex = if_nametoindex(pSession->ifName);
+    Dhcpv6c_LoadDuid(pSession);
+
+    Dhcpv6c_NewExchange(pSession, DHCPV6C_SOLICITING, now);
+    pSession->forced = FALSE;
+    memset(&pSession->lease, 0, sizeof(pSession->lease));
+}
+
+static void Dhcpv6c_OnDeadline(Dhcpv6cSession_t *pSession, uint64_t now)
+{
+    uint64_t limitMs;
+
+    switch (pSession->state)
+    {
+        case DHCPV6C_SOLICITING:
+            //The first RT is over, the best ADVERTISE collected is requested
+            if (pSession->advertised == TRUE)
+            {
+                Dhcpv6c_Request(pSession, now);
+                break;
+            }
+            Dhcpv6c_Send(pSession, DHCPV6C_SOLICIT, now);
+            pSession->tries++;
+            pSession->nextMs = now + Dhcpv6c_NextRt(pSession, WANMGR_DHCPV6C_SOL_TIMEOUT_MS, WANMGR_DHCPV6C_SOL_MAX_RT_MS);
+            break;
+
+        case DHCPV6C_REQUESTING:
+            if (pSession->tries >= WANMGR_DHCPV6C_REQ_MAX_RC)
+            {
+                CcspTraceWarning(("%s %d - %s: no REPLY from the server, soliciting again\n", __FUNCTION__, __LINE__, pSession->ifName));
+                Dhcpv6c_Restart(pSession, now, FALSE);
+                break;
+            }
+            Dhcpv6c_Send(pSession, DHCPV6C_REQUEST, now);
+            pSession->tries++;
+            pSession->nextMs = now + Dhcpv6c_NextRt(pSession, WANMGR_DHCPV6C_REQ_TIMEOUT_MS, WANMGR_DHCPV6C_REQ_MAX_RT_MS);
+            break;
+
+        case DHCPV6C_BOUND:
+        case DHCPV6C_RENEWING:
+        case DHCPV6C_REBINDING:
+            if (pSession->forced == TRUE)
+            {
+                if (pSession->tries >= WANMGR_DHCPV6C_RENEW_TRIES)
+                {
+                    CcspTraceWarning(("%s %d - %s: renewal not answered, soliciting again\n", __FUNCTION__, __LINE__, pSession->ifName));
+                    Dhcpv6c_Restart(pSession, now, TRUE);
+                    break;
+                }
+                Dhcpv6c_Send(pSession, DHCPV6C_RENEW, now);
+                pSession->tries++;
+                pSession->nextMs = now + WANMGR_DHCPV6C_RENEW_RETRY_MS;
+                break;
+            }
+
+            if (pSession->expiryMs != 0 && now >= pSession->expiryMs)
+            {
+                Dhcpv6c_Restart(pSession, now, TRUE);
+                break;
+            }
+            //Renewing and rebinding are separate exchanges, each with its own transaction
+            if (pSession->state == DHCPV6C_BOUND ||
+                (pSession->state == DHCPV6C_RENEWING && pSession->t2Ms != 0 && now >= pSession->t2Ms))
+            {
+                Dhcpv6c_NewExchange(pSession, (pSession->t2Ms != 0 && now >= pSession->t2Ms) ? DHCPV6C_REBINDING : DHCPV6C_RENEWING, now);
+                CcspTraceInfo(("%s %d - %s: %s\n", __FUNCTION__, __LINE__, pSession->ifName, Dhcpv6c_StateName(pSession->state)));
+            }
+
+            if (pSession->state == DHCPV6C_RENEWING)
+            {
+                Dhcpv6c_Send(pSession, DHCPV6C_RENEW, now);
+                pSession->nextMs = now + Dhcpv6c_NextRt(pSession, WANMGR_DHCPV6C_REN_TIMEOUT_MS, WANMGR_DHCPV6C_REN_MAX_RT_MS);
+                limitMs = pSession->t2Ms;
+            }
+            else
+            {
+                Dhcpv6c_Send(pSession, DHCPV6C_REBIND, now);
+                pSession->nextMs = now + Dhcpv6c_NextRt(pSession, WANMGR_DHCPV6C_REB_TIMEOUT_MS, WANMGR_DHCPV6C_REB_MAX_RT_MS);
+                limitMs = pSession->expiryMs;
+            }
+            pSession->tries++;
+            if (limitMs != 0 && pSession->nextMs > limitMs)
+            {
+                pSession->nextMs = limitMs;
+            }
+            break;
+    }
+}
+
+/* Earliest T1, T2 and valid lifetime of the IAs, a T1 or T2 of 0 is left
+ * to the client: half and four fifths of the preferred lifetime */
+static void Dhcpv6c_LeaseTimes(const Dhcpv6cIa_t *pIa, uint32_t *pT1, uint32_t *pT2, uint32_t *pValid)
+{
+    uint32_t t1 = pIa->t1;
+    uint32_t t2 = pIa->t2;
+
+    if (pIa->granted != TRUE)
+    {
+        return;
+    }
+
+    if (t2 == 0)
+    {
+        t2 = (pIa->preferred == DHCPV6C_INFINITE) ? DHCPV6C_INFINITE : (uint32_t)((uint64_t) pIa->preferred * 4 / 5);
+    }
+    if (t1 == 0)
+    {
+        t1 = (pIa->preferred == DHCPV6C_INFINITE) ? DHCPV6C_INFINITE : pIa->preferred / 2;
+    }
+    if (t1 > t2)
+    {
+        t1 = t2;
+    }
+
+    *pT1 = (t1 < *pT1) ? t1 : *pT1;
+    *pT2 = (t2 < *pT2) ? t2 : *pT2;
+    *pValid = (pIa->valid < *pValid) ? pIa->valid : *pValid;
+}
+
+static void Dhcpv6c_Bind(Dhcpv6cSession_t *pSession, const Dhcpv6cLease_t *pLease, uint64_t now)
+{
+    uint32_t t1 = DHCPV6C_INFINITE;
+    uint32_t t2 = DHCPV6C_INFINITE;
+    uint32_t valid = DHCPV6C_INFINITE;
+    char addr[INET6_ADDRSTRLEN] = {0};
+    char prefix[INET6_ADDRSTRLEN] = {0};
+
+    Dhcpv6c_LeaseTimes(&pLease->na, &t1, &t2, &valid);
+    Dhcpv6c_LeaseTimes(&pLease->pd, &t1, &t2, &valid);
+    pSession->t1Ms = (t1 == DHCPV6C_INFINITE) ? 0 : now + (uint64_t) t1 * 1000ULL;
+    pSession->t2Ms = (t2 == DHCPV6C_INFINITE) ? 0 : now + (uint64_t) t2 * 1000ULL;
+    pSession->expiryMs = (valid == DHCPV6C_INFINITE) ? 0 : now + (uint64_t) valid * 1000ULL;
+    pSession->lease = *pLease;
+
+    //The address is ours to configure, as dibbler did. On-link prefixes come from RAs.
+    if (pLease->na.granted == TRUE)
+    {
+        if (pSession->addrSet == TRUE && memcmp(&pSession->addrSetAddr, &pLease->na.addr, sizeof(struct in6_addr)) != 0)
+        {
+            Dhcpv6c_ClearAddr(pSession);
+        }
+        if (WanMgr_Netlink_SetAddr6(pSession->ifIndex, TRUE, &pLease->na.addr, 128, pLease->na.preferred, pLease->na.valid) == ANSC_STATUS_SUCCESS)
+        {
+            pSession->addrSet = TRUE;
+            pSession->addrSetAddr = pLease->na.addr;
+        }
+        inet_ntop(AF_INET6, &pLease->na.addr, addr, sizeof(addr));
+    }
+    else
+    {
+        Dhcpv6c_ClearAddr(pSession);
+    }
+    if (pLease->pd.granted == TRUE)
+    {
+        inet_ntop(AF_INET6, &pLease->pd.addr, prefix, sizeof(prefix));
+    }
+
+    pSession->state = DHCPV6C_BOUND;
+    pSession->nextMs = pSession->t1Ms;
+    pSession->rtMs = 0;
+    pSession->tries = 0;
+    pSession->forced = FALSE;
+    pSession->leased = TRUE;
+
+    CcspTraceInfo(("%s %d - %s: bound, address %s prefix %s/%u, T1 %u s\n", __FUNCTION__, __LINE__, pSession->ifName,
+                   (addr[0] != '\0') ? addr : "none", (prefix[0] != '\0') ? prefix : "none", pLease->pd.prefixLen, t1));
+    Dhcpv6c_Report(pSession, TRUE);
+}
+
+static void Dhcpv6c_OnReply(Dhcpv6cSession_t *pSession, const Dhcpv6cLease_t *pLease, uint64_t now)
+{
+    BOOL granted = (pLease->na.granted == TRUE || pLease->pd.granted == TRUE) ? TRUE : FALSE;
+
+    if (pLease->clientIdMatch != TRUE || pLease->serverIdLen == 0)
+    {
+        return;
+    }
+
+    switch (pSession->state)
+    {
+        case DHCPV6C_SOLICITING:
+            if (pLease->msgType == DHCPV6C_REPLY && pSession->rapidCommit == TRUE && pLease->rapidCommit == TRUE &&
+                pLease->status == DHCPV6C_STATUS_SUCCESS && granted == TRUE)
+            {
+                Dhcpv6c_Bind(pSession, pLease, now);
+                return;
+            }
+            //An ADVERTISE without anything to offer is of no use
+            if (pLease->msgType != DHCPV6C_ADVERTISE || pLease->status != DHCPV6C_STATUS_SUCCESS || granted != TRUE)
+            {
+                return;
+            }
+            //Collected until the first RT is over, the highest preference first (RFC 8415 18.2.1)
+            if (pSession->advertised != TRUE || pLease->preference > pSession->lease.preference)
+            {
+                pSession->lease = *pLease;
+                pSession->advertised = TRUE;
+            }
+            //The top preference, or an ADVERTISE past the first RT, is taken at once
+            if (pLease->preference == DHCPV6C_MAX_PREFERENCE || pSession->tries > 1)
+            {
+                Dhcpv6c_Request(pSession, now);
+            }
+            break;
+
+        case DHCPV6C_REQUESTING:
+        case DHCPV6C_RENEWING:
+            //The message named the server, answers of the others are for them
+            if (pLease->serverIdLen != pSession->lease.serverIdLen ||
+                memcmp(pLease->serverId, pSession->lease.serverId, pLease->serverIdLen) != 0)
+            {
+                return;
+            }
+            /* fall through */
+        case DHCPV6C_REBINDING:
+            if (pLease->msgType != DHCPV6C_REPLY)
+            {
+                return;
+            }
+            if (pLease->status != DHCPV6C_STATUS_SUCCESS)
+            {
+                CcspTraceWarning(("%s %d - %s: status %u in %s\n", __FUNCTION__, __LINE__, pSession->ifName, pLease->status, Dhcpv6c_StateName(pSession->state)));
+                if (pSession->state == DHCPV6C_REQUESTING)
+                {
+                    Dhcpv6c_Restart(pSession, now, FALSE);
+                }
+                return;
+            }
+            //The server no longer knows an IA held, start over rather than request it alone
+            if (granted != TRUE ||
+                (pSession->lease.na.granted == TRUE && pLease->naStatus == DHCPV6C_STATUS_NOBINDING) ||
+                (pSession->lease.pd.granted == TRUE && pLease->pdStatus == DHCPV6C_STATUS_NOBINDING))
+            {
+                CcspTraceWarning(("%s %d - %s: no binding in %s, soliciting again\n", __FUNCTION__, __LINE__, pSession->ifName, Dhcpv6c_StateName(pSession->state)));
+                Dhcpv6c_Restart(pSession, now, TRUE);
+                return;
+            }
+            Dhcpv6c_Bind(pSession, pLease, now);
+            break;
+
+        case DHCPV6C_BOUND:
+            break;
+    }
+}
+
+/* ---- Receiving ---- */
+
+/* First name of a list in DNS wire format (RFC 1035 3.1) as a dotted string */
+static void Dhcpv6c_GetDomain(const uint8_t *v, uint16_t len, char *pName, size_t nameLen)
+{
+    size_t pos = 0;
+    uint16_t off = 0;
+    uint8_t labelLen;
+
+    pName[0] = '\0';
+    while (off < len && v[off] != 0)
+    {
+        labelLen = v[off++];
+        if (labelLen > 63 || off + labelLen > len || pos + labelLen + 2 > nameLen)
+        {
+            pName[0] = '\0';
+            return;
+        }
+        if (pos > 0)
+        {
+            pName[pos++] = '.';
+        }
+        memcpy(pName + pos, v + off, labelLen);
+        pos += labelLen;
+        off += labelLen;
+    }
+    pName[pos] = '\0';
+}
+
+/* IA_NA or IA_PD of ours, the first address or prefix with a valid lifetime is taken */
+static void Dhcpv6c_ParseIa(uint16_t code, const uint8_t *v, uint16_t len, Dhcpv6cIa_t *pIa, uint16_t *pStatus)
+{
+    uint16_t off = 12;
+    uint16_t subCode;
+    uint16_t subLen;
+    const uint8_t *s;
+
+    if (len < 12 || Dhcpv6c_Get32(v) != DHCPV6C_IAID)
+    {
+        return;
+    }
+
+    memset(pIa, 0, sizeof(Dhcpv6cIa_t));
+    pIa->t1 = Dhcpv6c_Get32(v + 4);
+    pIa->t2 = Dhcpv6c_Get32(v + 8);
+
+    while (off + 4 <= len)
+    {
+        subCode = Dhcpv6c_Get16(v + off);
+        subLen = Dhcpv6c_Get16(v + off + 2);
+        s = v + off + 4;
+        if (off + 4 + subLen > len)
+        {
+            break;
+        }
+        off += 4 + subLen;
+
+        if (subCode == DHCPV6C_OPT_STATUS_CODE && subLen >= 2)
+        {
+            *pStatus = Dhcpv6c_Get16(s);
+        }
+        else if (pIa->granted != TRUE &&
+                 ((code == DHCPV6C_OPT_IA_NA && subCode == DHCPV6C_OPT_IAADDR && subLen >= 24) ||
+                  (code == DHCPV6C_OPT_IA_PD && subCode == DHCPV6C_OPT_IAPREFIX && subLen >= 25)))
+        {
+            if (code == DHCPV6C_OPT_IA_NA)
+            {
+                memcpy(&pIa->addr, s, sizeof(struct in6_addr));
+                pIa->preferred = Dhcpv6c_Get32(s + 16);
+                pIa->valid = Dhcpv6c_Get32(s + 20);
+                pIa->prefixLen = 128;
+            }
+            else
+            {
+                pIa->preferred = Dhcpv6c_Get32(s);
+                pIa->valid = Dhcpv6c_Get32(s + 4);
+                pIa->prefixLen = s[8];
+                memcpy(&pIa->addr, s + 9, sizeof(struct in6_addr));
+            }
+            //RFC 8415 21.6 and 21.22: ignored if the preferred lifetime exceeds the valid one
+            pIa->granted = (pIa->valid != 0 && pIa->preferred <= pIa->valid && pIa->prefixLen <= 128) ? TRUE : FALSE;
+        }
+    }
+
+    if (*pStatus != DHCPV6C_STATUS_SUCCESS)
+    {
+        pIa->granted = FALSE;
+    }
+}
+
+/* Rules of the MAP-T container (RFC 7598 4) */
+static void Dhcpv6c_ParseMapt(const uint8_t *v, uint16_t len, Dhcpv6cLease_t *pLease)
+{
+    uint16_t off = 0;
+    uint16_t code;
+    uint16_t optLen;
+    const uint8_t *o;
+
+    while (off + 4 <= len)
+    {
+        code = Dhcpv6c_Get16(v + off);
+        optLen = Dhcpv6c_Get16(v + off + 2);
+        o = v + off + 4;
+        if (off + 4 + optLen > len)
+        {
+            break;
+        }
+        off += 4 + optLen;
+
+        if (code == DHCPV6C_OPT_S46_RULE && optLen >= 8 && pLease->numRules < DHCPV6C_MAX_RULES)
+        {
+            Dhcpv6cMapRule_t *pRule = &pLease->rules[pLease->numRules];
+            uint16_t prefixBytes = (o[7] + 7) / 8;
+            uint16_t subOff = 8 + prefixBytes;
+
+            if (o[2] > 32 || o[7] > 128 || subOff > optLen)
+            {
+                continue;
+            }
+            memset(pRule, 0, sizeof(Dhcpv6cMapRule_t));
+            pRule->flags = o[0];
+            pRule->eaLen = o[1];
+            pRule->v4Len = o[2];
+            memcpy(&pRule->v4Prefix, o + 3, sizeof(struct in_addr));
+            pRule->v6Len = o[7];
+            memcpy(&pRule->v6Prefix, o + 8, prefixBytes);
+            pRule->psidOffset = DHCPV6C_DEFAULT_PSID_OFFSET;
+
+            while (subOff + 4 <= optLen)
+            {
+                uint16_t subCode = Dhcpv6c_Get16(o + subOff);
+                uint16_t subLen = Dhcpv6c_Get16(o + subOff + 2);
+
+                if (subOff + 4 + subLen > optLen)
+                {
+                    break;
+                }
+                if (subCode == DHCPV6C_OPT_S46_PORTPARAMS && subLen >= 4)
+                {
+                    pRule->psidOffset = o[subOff + 4];
+                    pRule->psidLen = o[subOff + 5];
+                    pRule->psid = Dhcpv6c_Get16(o + subOff + 6);
+                }
+                subOff += 4 + subLen;
+            }
+            pLease->numRules++;
+        }
+        else if (code == DHCPV6C_OPT_S46_DMR && optLen >= 1 && o[0] <= 128 && 1 + (o[0] + 7) / 8 <= optLen)
+        {
+            memset(&pLease->dmrPrefix, 0, sizeof(struct in6_addr));
+            pLease->dmrLen = o[0];
+            memcpy(&pLease->dmrPrefix, o + 1, (o[0] + 7) / 8);
+            pLease->hasDmr = TRUE;
+        }
+    }
+}
+
+/* Parse a received message, FALSE unless it is an ADVERTISE or REPLY to xid */
+static BOOL Dhcpv6c_Parse(const uint8_t *pkt, int len, const Dhcpv6cSession_t *pSession, Dhcpv6cLease_t *pLease)
+{
+    int off = 4;
+    uint16_t code;
+    uint16_t optLen;
+    const uint8_t *v;
+
+    if (len < 4 || (pkt[0] != DHCPV6C_ADVERTISE && pkt[0] != DHCPV6C_REPLY) ||
+        (((uint32_t) pkt[1] << 16) | ((uint32_t) pkt[2] << 8) | pkt[3]) != pSession->xid)
+    {
+        return FALSE;
+    }
+
+    memset(pLease, 0, sizeof(Dhcpv6cLease_t));
+    pLease->msgType = pkt[0];
+
+    while (off + 4 <= len)
+    {
+        code = Dhcpv6c_Get16(pkt + off);
+        optLen = Dhcpv6c_Get16(pkt + off + 2);
+        v = pkt + off + 4;
+        if (off + 4 + optLen > len)
+        {
+            return FALSE;
+        }
+        off += 4 + optLen;
+
+        switch (code)
+        {
+            case DHCPV6C_OPT_CLIENTID:
+                pLease->clientIdMatch = (optLen == pSession->duidLen && memcmp(v, pSession->duid, optLen) == 0) ? TRUE : FALSE;
+                break;
+            case DHCPV6C_OPT_SERVERID:
+                if (optLen > 0 && optLen <= DHCPV6C_MAX_DUID)
+                {
+                    memcpy(pLease->serverId, v, optLen);
+                    pLease->serverIdLen = optLen;
+                }
+                break;
+            case DHCPV6C_OPT_STATUS_CODE:
+                if (optLen >= 2)
+                {
+                    pLease->status = Dhcpv6c_Get16(v);
+                }
+                break;
+            case DHCPV6C_OPT_PREFERENCE:
+                if (optLen == 1)
+                {
+                    pLease->preference = v[0];
+                }
+                break;
+            case DHCPV6C_OPT_RAPID_COMMIT:
+                pLease->rapidCommit = TRUE;
+                break;
+            case DHCPV6C_OPT_IA_NA:
+                Dhcpv6c_ParseIa(code, v, optLen, &pLease->na, &pLease->naStatus);
+                break;
+            case DHCPV6C_OPT_IA_PD:
+                Dhcpv6c_ParseIa(code, v, optLen, &pLease->pd, &pLease->pdStatus);
+                break;
+            case DHCPV6C_OPT_DNS_SERVERS:
+                for (pLease->numDns = 0; pLease->numDns < 2 && (pLease->numDns + 1) * sizeof(struct in6_addr) <= optLen; pLease->numDns++)
+                {
+                    memcpy(&pLease->dns[pLease->numDns], v + pLease->numDns * sizeof(struct in6_addr), sizeof(struct in6_addr));
+                }
+                break;
+            case DHCPV6C_OPT_DOMAIN_LIST:
+                Dhcpv6c_GetDomain(v, optLen, pLease->domain, sizeof(pLease->domain));
+                break;
+            case DHCPV6C_OPT_AFTR_NAME:
+                Dhcpv6c_GetDomain(v, optLen, pLease->aftr, sizeof(pLease->aftr));
+                break;
+            case DHCPV6C_OPT_S46_CONT_MAPT:
+                Dhcpv6c_ParseMapt(v, optLen, pLease);
+                break;
+        }
+    }
+
+    return TRUE;
+}
+
+/* Arm the timer for the earliest session, called with gDhcpv6cMutex held */
+static void Dhcpv6c_ArmTimer(void)
+{
+    struct itimerspec its;
+    uint64_t next = 0;
+    int idx;
+
+    for (idx = 0; idx < WANMGR_DHCPV6C_MAX_IFACES; idx++)
+    {
+        if (gSessions[idx].inUse == TRUE && gSessions[idx].nextMs != 0 && (next == 0 || gSessions[idx].nextMs < next))
+        {
+            next = gSessions[idx].nextMs;
+        }
+        if (gSessions[idx].inUse == TRUE && gSessions[idx].pReport != NULL && (next == 0 || gSessions[idx].reportMs < next))
+        {
+            next = gSessions[idx].reportMs;
+        }
+    }
+
+    memset(&its, 0, sizeof(its));
+    if (next != 0)
+    {
+        its.it_value.tv_sec = next / 1000;
+        its.it_value.tv_nsec = (long)(next % 1000) * 1000000L;
+    }
+    timerfd_settime(gTimerFd, TFD_TIMER_ABSTIME, &its, NULL);
+}
+
+static void Dhcpv6c_OnPacket(int fd, uint32_t events, void *arg)
+{
+    uint8_t pkt[DHCPV6C_PKT_MAX];
+    uint8_t control[CMSG_SPACE(sizeof(struct in6_pktinfo))];
+    static Dhcpv6cLease_t lease;    /* event loop thread only */
+    struct sockaddr_in6 from;
+    struct cmsghdr *pCmsg;
+    struct msghdr msg;
+    struct iovec iov;
+    int ifIndex;
+    int len;
+    int idx;
+
+    for (;;)
+    {
+        iov.iov_base = pkt;
+        iov.iov_len = sizeof(pkt);
+        memset(&msg, 0, sizeof(msg));
+        msg.msg_name = &from;
+        msg.msg_namelen = sizeof(from);
+        msg.msg_iov = &iov;
+        msg.msg_iovlen = 1;
+        msg.msg_control = control;
+        msg.msg_controllen = sizeof(control);
+
+        if ((len = recvmsg(fd, &msg, 0)) < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            break;
+        }
+
+        ifIndex = 0;
+        for (pCmsg = CMSG_FIRSTHDR(&msg); pCmsg != NULL; pCmsg = CMSG_NXTHDR(&msg, pCmsg))
+        {
+            if (pCmsg->cmsg_level == IPPROTO_IPV6 && pCmsg->cmsg_type == IPV6_PKTINFO)
+            {
+                ifIndex = ((struct in6_pktinfo *) CMSG_DATA(pCmsg))->ipi6_ifindex;
+            }
+        }
+
+        pthread_mutex_lock(&gDhcpv6cMutex);
+        for (idx = 0; idx < WANMGR_DHCPV6C_MAX_IFACES; idx++)
+        {
+            Dhcpv6cSession_t *pSession = &gSessions[idx];
+
+            if (pSession->inUse == TRUE && pSession->ifIndex == ifIndex && Dhcpv6c_Parse(pkt, len, pSession, &lease) == TRUE)
+            {
+                Dhcpv6c_OnReply(pSession, &lease, Dhcpv6c_NowMs());
+                break;
+            }
+        }
+        Dhcpv6c_ArmTimer();
+        pthread_mutex_unlock(&gDhcpv6cMutex);
+    }
+}
+
+static void Dhcpv6c_OnTimer(int fd, uint32_t events, void *arg)
+{
+    uint64_t expirations;
+    uint64_t now;
+    int idx;
+
+    if (read(fd, &expirations, sizeof(expirations)) != sizeof(expirations))
+    {
+        return;
+    }
+
+    pthread_mutex_lock(&gDhcpv6cMutex);
+    now = Dhcpv6c_NowMs();
+    for (idx = 0; idx < WANMGR_DHCPV6C_MAX_IFACES; idx++)
+    {
+        Dhcpv6cSession_t *pSession = &gSessions[idx];
+
+        if (pSession->inUse == TRUE && pSession->nextMs != 0 && pSession->nextMs <= now)
+        {
+            Dhcpv6c_OnDeadline(pSession, now);
+        }
+        if (pSession->inUse == TRUE && pSession->pReport != NULL && pSession->reportMs <= now)
+        {
+            Dhcpv6cReport_t *pReport = pSession->pReport;
+
+            pSession->pReport = NULL;
+            pSession->reportMs = 0;
+            Dhcpv6c_QueueReport(pSession, pReport);
+        }
+    }
+    Dhcpv6c_ArmTimer();
+    pthread_mutex_unlock(&gDhcpv6cMutex);
+}
+
+/* ---- Setup ---- */
+
+static void Dhcpv6c_Init(void)
+{
+    struct sockaddr_in6 sin6;
+    int on = 1;
+
+    gSeed = (unsigned int)(Dhcpv6c_NowMs() ^ (uint64_t) getpid());
+
+    if ((gTimerFd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC)) < 0 ||
+        (gSockFd = socket(AF_INET6, SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0)) < 0)
+    {
+        CcspTraceError(("%s %d - DHCPv6 client sockets failed (%s)\n", __FUNCTION__, __LINE__, strerror(errno)));
+        return;
+    }
+
+    //One socket for every interface, the arrival interface picks the session
+    memset(&sin6, 0, sizeof(sin6));
+    sin6.sin6_family = AF_INET6;
+    sin6.sin6_port = htons(DHCPV6C_CLIENT_PORT);
+    sin6.sin6_addr = in6addr_any;
+    if (setsockopt(gSockFd, IPPROTO_IPV6, IPV6_V6ONLY, &on, sizeof(on)) < 0 ||
+        setsockopt(gSockFd, IPPROTO_IPV6, IPV6_RECVPKTINFO, &on, sizeof(on)) < 0 ||
+        bind(gSockFd, (struct sockaddr *) &sin6, sizeof(sin6)) < 0)
+    {
+        CcspTraceError(("%s %d - DHCPv6 client port not bound (%s)\n", __FUNCTION__, __LINE__, strerror(errno)));
+        return;
+    }
+
+    if (WanMgr_EventLoop_AddFd(gTimerFd, "dhcpv6c-timer", Dhcpv6c_OnTimer, NULL) != ANSC_STATUS_SUCCESS ||
+        WanMgr_EventLoop_AddFd(gSockFd, "dhcpv6c-sock", Dhcpv6c_OnPacket, NULL) != ANSC_STATUS_SUCCESS)
+    {
+        return;
+    }
+
+    gDhcpv6cReady = TRUE;
+}
+
+/* Session of ifName, called with gDhcpv6cMutex held */
+static int Dhcpv6c_FindSession(const char *ifName)
+{
+    int idx;
+
+    for (idx = 0; idx < WANMGR_DHCPV6C_MAX_IFACES; idx++)
+    {
+        if (gSessions[idx].inUse == TRUE && strcmp(gSessions[idx].ifName, ifName) == 0)
+        {
+            return idx;
+        }
+    }
+    return -1;
+}
+
+/* ---- Public Functions ------------------------------------- */
+
+ANSC_STATUS WanMgr_Dhcpv6c_Start(const char *ifName)
+{
+    Dhcpv6cSession_t *pSession;
+    BOOL wantNa;
+    BOOL wantPd;
+    BOOL rapidCommit;
+    int idx;
+
+    if (ifName == NULL || ifName[0] == '\0')
+    {
+        return ANSC_STATUS_BAD_PARAMETER;
+    }
+
+    pthread_once(&gDhcpv6cOnce, Dhcpv6c_Init);
+    if (gDhcpv6cReady != TRUE)
+    {
+        CcspTraceError(("%s %d - embedded DHCPv6 client unavailable\n", __FUNCTION__, __LINE__));
+        return ANSC_STATUS_FAILURE;
+    }
+
+    wantNa = Dhcpv6c_SyscfgFlag(DHCPV6C_SYSCFG_IANA, TRUE);
+    wantPd = Dhcpv6c_SyscfgFlag(DHCPV6C_SYSCFG_IAPD, TRUE);
+    rapidCommit = Dhcpv6c_SyscfgFlag(DHCPV6C_SYSCFG_RAPID_COMMIT, FALSE);
+    if (wantNa != TRUE && wantPd != TRUE)
+    {
+        CcspTraceError(("%s %d - neither IA_NA nor IA_PD requested for %s\n", __FUNCTION__, __LINE__, ifName));
+        return ANSC_STATUS_FAILURE;
+    }
+
+    pthread_mutex_lock(&gDhcpv6cMutex);
+    if (Dhcpv6c_FindSession(ifName) >= 0)
+    {
+        pthread_mutex_unlock(&gDhcpv6cMutex);
+        CcspTraceInfo(("%s %d - DHCPv6 client of %s already running\n", __FUNCTION__, __LINE__, ifName));
+        return ANSC_STATUS_SUCCESS;
+    }
+
+    for (idx = 0; idx < WANMGR_DHCPV6C_MAX_IFACES; idx++)
+    {
+        if (gSessions[idx].inUse != TRUE)
+        {
+            break;
+        }
+    }
+
+    if (idx >= WANMGR_DHCPV6C_MAX_IFACES)
+    {
+        pthread_mutex_unlock(&gDhcpv6cMutex);
+        CcspTraceError(("%s %d - no free DHCPv6 client for %s\n", __FUNCTION__, __LINE__, ifName));
+        return ANSC_STATUS_RESOURCES;
+    }
+
+    pSession = &gSessions[idx];
+    memset(pSession, 0, sizeof(Dhcpv6cSession_t));
+    snprintf(pSession->ifName, sizeof(pSession->ifName), "%s", ifName);
+    pSession->wantNa = wantNa;
+    pSession->wantPd = wantPd;
+    pSession->rapidCommit = rapidCommit;
+    pSession->inUse = TRUE;
+    Dhcpv6c_Restart(pSession, Dhcpv6c_NowMs(), FALSE);
+    Dhcpv6c_ArmTimer();
+    pthread_mutex_unlock(&gDhcpv6cMutex);
+
+    CcspTraceInfo(("%s %d - DHCPv6 client started on %s (IA_NA %d IA_PD %d rapid commit %d)\n", __FUNCTION__, __LINE__,
+                   ifName, wantNa, wantPd, rapidCommit));
+    return ANSC_STATUS_SUCCESS;
+}
+
+ANSC_STATUS WanMgr_Dhcpv6c_Renew(const char *ifName)
+{
+    ANSC_STATUS ret = ANSC_STATUS_FAILURE;
+    uint64_t now;
+    int idx;
+
+    pthread_mutex_lock(&gDhcpv6cMutex);
+    now = Dhcpv6c_NowMs();
+    for (idx = 0; idx < WANMGR_DHCPV6C_MAX_IFACES; idx++)
+    {
+        Dhcpv6cSession_t *pSession = &gSessions[idx];
+
+        if (pSession->inUse != TRUE || (ifName != NULL && strcmp(pSession->ifName, ifName) != 0))
+        {
+            continue;
+        }
+
+        CcspTraceInfo(("%s %d - renewing the DHCPv6 lease of %s in %s\n", __FUNCTION__, __LINE__, pSession->ifName, Dhcpv6c_StateName(pSession->state)));
+        if (pSession->leased == TRUE)
+        {
+            //RENEW to the server of the lease, a few quick tries then solicitation
+            Dhcpv6c_NewExchange(pSession, DHCPV6C_RENEWING, now);
+            pSession->forced = TRUE;
+        }
+        else
+        {
+            Dhcpv6c_Restart(pSession, now, FALSE);
+        }
+        ret = ANSC_STATUS_SUCCESS;
+    }
+
+    if (gDhcpv6cReady == TRUE)
+    {
+        Dhcpv6c_ArmTimer();
+    }
+    pthread_mutex_unlock(&gDhcpv6cMutex);
+
+    return ret;
+}
+
+ANSC_STATUS WanMgr_Dhcpv6c_Stop(const char *ifName, BOOL release)
+{
+    uint64_t now;
+    int idx;
+
+    pthread_mutex_lock(&gDhcpv6cMutex);
+    now = Dhcpv6c_NowMs();
+    for (idx = 0; idx < WANMGR_DHCPV6C_MAX_IFACES; idx++)
+    {
+        Dhcpv6cSession_t *pSession = &gSessions[idx];
+
+        if (pSession->inUse != TRUE || (ifName != NULL && strcmp(pSession->ifName, ifName) != 0))
+        {
+            continue;
+        }
+
+        //Sent once, the session is gone before a retransmission would be due
+        if (release == TRUE && pSession->leased == TRUE)
+        {
+            CcspTraceInfo(("%s %d - releasing the DHCPv6 lease of %s\n", __FUNCTION__, __LINE__, pSession->ifName));
+            Dhcpv6c_NewExchange(pSession, pSession->state, now);
+            Dhcpv6c_Send(pSession, DHCPV6C_RELEASE, now);
+        }
+        Dhcpv6c_ClearAddr(pSession);
+        CcspTraceInfo(("%s %d - DHCPv6 client stopped on %s\n", __FUNCTION__, __LINE__, pSession->ifName));
+        free(pSession->pReport);
+        pSession->pReport = NULL;
+        pSession->inUse = FALSE;
+    }
+
+    if (gDhcpv6cReady == TRUE)
+    {
+        Dhcpv6c_ArmTimer();
+    }
+    pthread_mutex_unlock(&gDhcpv6cMutex);
+
+    return ANSC_STATUS_SUCCESS;
+}
+
+BOOL WanMgr_Dhcpv6c_IsRunning(const char *ifName)
+{
+    BOOL running = FALSE;
+    int idx;
+
+    pthread_mutex_lock(&gDhcpv6cMutex);
+    for (idx = 0; idx < WANMGR_DHCPV6C_MAX_IFACES; idx++)
+    {
+        if (gSessions[idx].inUse == TRUE && (ifName == NULL || strcmp(gSessions[idx].ifName, ifName) == 0))
+        {
+            running = TRUE;
+            break;
+        }
+    }
+    pthread_mutex_unlock(&gDhcpv6cMutex);
+
+    return running;
+}
+
+#endif /* FEATURE_EMBEDDED_DHCPV6_CLIENT */
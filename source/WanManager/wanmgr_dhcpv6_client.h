@@ -0,0 +1,84 @@
+/*
+ * If not stated otherwise in this file or this component's Licenses.txt file the
+ * following copyright and licenses apply:
+ *
+ * Copyright 2020 RDK Management
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+*/
+
+#ifndef _WANMGR_DHCPV6_CLIENT_H_
+#define _WANMGR_DHCPV6_CLIENT_H_
+
+/* Embedded DHCPv6 client (FEATURE_EMBEDDED_DHCPV6_CLIENT). Runs the RFC 8415
+ * client state machine for one IA_NA and one IA_PD on the event loop, instead
+ * of dibbler-client, its notify script and the ccsp_common_fifo. A lease is
+ * handed to the code a DHCP6C_STATE_CHANGED message goes to, with the MAP-T
+ * parameters of option 95 behind it, and to the LAN side code the dibbler
+ * notification went to. The IA_NA address is configured by the client, as
+ * dibbler did. */
+
+/* ---- Include Files ---------------------------------------- */
+#include "ansc_platform.h"
+
+/* ---- Global Constants -------------------------------------- */
+#define WANMGR_DHCPV6C_MAX_IFACES           8
+#define WANMGR_DHCPV6C_SOL_TIMEOUT_MS       1000        /* RFC 8415 7.6 transmission parameters */
+#define WANMGR_DHCPV6C_SOL_MAX_RT_MS        3600000
+#define WANMGR_DHCPV6C_REQ_TIMEOUT_MS       1000
+#define WANMGR_DHCPV6C_REQ_MAX_RT_MS        30000
+#define WANMGR_DHCPV6C_REQ_MAX_RC           10
+#define WANMGR_DHCPV6C_REN_TIMEOUT_MS       10000
+#define WANMGR_DHCPV6C_REN_MAX_RT_MS        600000
+#define WANMGR_DHCPV6C_REB_TIMEOUT_MS       10000
+#define WANMGR_DHCPV6C_REB_MAX_RT_MS        600000
+#define WANMGR_DHCPV6C_RENEW_TRIES          3           /* unanswered forced renewals before soliciting again */
+#define WANMGR_DHCPV6C_RENEW_RETRY_MS       4000
+#define WANMGR_DHCPV6C_DUID_FILE            "/tmp/dibbler/client-duid"  /* kept so the server sees the same client */
+
+/* ---- Global Prototypes -------------------------------------- */
+
+/***************************************************************************
+ * @brief Start the DHCPv6 client of an interface. Solicitation starts right
+ * away, nothing is done if the client is already running. IA_NA, IA_PD and
+ * rapid commit follow the Device.DHCPv6.Client configuration in syscfg.
+ * @param ifName WAN interface name
+ * @return ANSC_STATUS_SUCCESS upon success else returned error code.
+ ****************************************************************************/
+ANSC_STATUS WanMgr_Dhcpv6c_Start(const char *ifName);
+
+/***************************************************************************
+ * @brief Renew the lease now. Without a lease solicitation is restarted.
+ * @param ifName WAN interface name, NULL for every interface
+ * @return ANSC_STATUS_SUCCESS if a client was renewed else ANSC_STATUS_FAILURE.
+ ****************************************************************************/
+ANSC_STATUS WanMgr_Dhcpv6c_Renew(const char *ifName);
+
+/***************************************************************************
+ * @brief Stop the DHCPv6 client of an interface and remove its IA_NA
+ * address. The lease is not reported down, the caller tears the connection
+ * down itself.
+ * @param ifName WAN interface name, NULL for every interface
+ * @param release TRUE to send a RELEASE for the lease held
+ * @return ANSC_STATUS_SUCCESS upon success else returned error code.
+ ****************************************************************************/
+ANSC_STATUS WanMgr_Dhcpv6c_Stop(const char *ifName, BOOL release);
+
+/***************************************************************************
+ * @brief Check whether the DHCPv6 client of an interface is running.
+ * @param ifName WAN interface name, NULL for any interface
+ * @return TRUE if running else FALSE.
+ ****************************************************************************/
+BOOL WanMgr_Dhcpv6c_IsRunning(const char *ifName);
+
+#endif /* _WANMGR_DHCPV6_CLIENT_H_ */
@@ -280,7 +280,9 @@ WanMgr_Dhcpv6Remove
         }
 
         AnscFreeMemory( pCxtDhcpcLink->pServerEntry );
+        AnscFreeMemory( pCxtDhcpcLink->pServerInsNum );
         AnscFreeMemory( pCxtDhcpcLink->pRecvEntry );
+        AnscFreeMemory( pCxtDhcpcLink->pRecvInsNum );
         AnscFreeMemory(pCxtDhcpcLink->hContext);
         AnscFreeMemory(pCxtDhcpcLink);
     }
@@ -452,8 +454,25 @@ WanMgr_Dhcpv6BackendGetDhcpv6Info
                         );
         if ( returnStatus == ANSC_STATUS_SUCCESS )
         {
-            pClientCxtLink->pServerEntry    = pDhcpcServer;
-            pClientCxtLink->NumberOfServer  = count;
+            /* numbers the rows, later syncs keep them */
+            WanMgr_DmlSyncTable
+                (
+                    (PVOID*)&pClientCxtLink->pServerEntry,
+                    &pClientCxtLink->NumberOfServer,
+                    &pClientCxtLink->CapacityOfServer,
+                    &pClientCxtLink->pServerInsNum,
+                    &pClientCxtLink->maxInstanceOfServer,
+                    pDhcpcServer,
+                    count,
+                    sizeof(DML_DHCPCV6_SVR),
+                    WanMgr_DmlDhcpv6cServerKeyMatch,
+                    WanMgr_DmlDhcpv6cServerRowEqual
+                );
+            if ( pDhcpcServer )
+            {
+                AnscFreeMemory(pDhcpcServer);
+                pDhcpcServer = NULL;
+            }
         }
         else
         {
@@ -580,8 +599,24 @@ WanMgr_Dhcpv6BackendGetDhcpv6Info
                         );
         if ( returnStatus == ANSC_STATUS_SUCCESS )
         {
-            pClientCxtLink->pRecvEntry    = pDhcpcRecv;
-            pClientCxtLink->NumberOfRecv  = count;
+            WanMgr_DmlSyncTable
+                (
+                    (PVOID*)&pClientCxtLink->pRecvEntry,
+                    &pClientCxtLink->NumberOfRecv,
+                    &pClientCxtLink->CapacityOfRecv,
+                    &pClientCxtLink->pRecvInsNum,
+                    &pClientCxtLink->maxInstanceOfRecv,
+                    pDhcpcRecv,
+                    count,
+                    sizeof(DML_DHCPCV6_RECV),
+                    WanMgr_DmlDhcpv6cRecvKeyMatch,
+                    WanMgr_DmlDhcpv6cRecvRowEqual
+                );
+            if ( pDhcpcRecv )
+            {
+                AnscFreeMemory(pDhcpcRecv);
+                pDhcpcRecv = NULL;
+            }
         }
         else
         {
@@ -1483,3 +1518,249 @@ WanMgr_Dhcpv6ClientHasDelayAddedChild
     }
     return FALSE;
 }
+
+/* A server is identified by its DUID, its address may change */
+BOOL
+WanMgr_DmlDhcpv6cServerKeyMatch
+    (
+        const void*                 pOld,
+        const void*                 pNew
+    )
+{
+    const DML_DHCPCV6_SVR*      pOldSvr = (const DML_DHCPCV6_SVR*)pOld;
+    const DML_DHCPCV6_SVR*      pNewSvr = (const DML_DHCPCV6_SVR*)pNew;
+
+    return (strcmp((const char*)pOldSvr->DUID, (const char*)pNewSvr->DUID) == 0) ? TRUE : FALSE;
+}
+
+BOOL
+WanMgr_DmlDhcpv6cServerRowEqual
+    (
+        const void*                 pOld,
+        const void*                 pNew
+    )
+{
+    const DML_DHCPCV6_SVR*      pOldSvr = (const DML_DHCPCV6_SVR*)pOld;
+    const DML_DHCPCV6_SVR*      pNewSvr = (const DML_DHCPCV6_SVR*)pNew;
+
+    return ( strcmp((const char*)pOldSvr->SourceAddress, (const char*)pNewSvr->SourceAddress) == 0 &&
+             strcmp((const char*)pOldSvr->InformationRefreshTime, (const char*)pNewSvr->InformationRefreshTime) == 0 ) ? TRUE : FALSE;
+}
+
+/* A received option is identified by its tag and the server that sent it */
+BOOL
+WanMgr_DmlDhcpv6cRecvKeyMatch
+    (
+        const void*                 pOld,
+        const void*                 pNew
+    )
+{
+    const DML_DHCPCV6_RECV*     pOldRecv = (const DML_DHCPCV6_RECV*)pOld;
+    const DML_DHCPCV6_RECV*     pNewRecv = (const DML_DHCPCV6_RECV*)pNew;
+
+    return ( pOldRecv->Tag == pNewRecv->Tag &&
+             strcmp((const char*)pOldRecv->Server, (const char*)pNewRecv->Server) == 0 ) ? TRUE : FALSE;
+}
+
+/* The list linkage is not compared, the table is a plain array */
+BOOL
+WanMgr_DmlDhcpv6cRecvRowEqual
+    (
+        const void*                 pOld,
+        const void*                 pNew
+    )
+{
+    const DML_DHCPCV6_RECV*     pOldRecv = (const DML_DHCPCV6_RECV*)pOld;
+    const DML_DHCPCV6_RECV*     pNewRecv = (const DML_DHCPCV6_RECV*)pNew;
+
+    return (strcmp((const char*)pOldRecv->Value, (const char*)pNewRecv->Value) == 0) ? TRUE : FALSE;
+}
+
+/**********************************************************************
+
+    caller:     owner of this object
+
+    prototype:
+
+        ULONG
+        WanMgr_DmlSyncTable
+            (
+                PVOID*                      ppRows,
+                PULONG                      pNumRows,
+                PULONG                      pCapacity,
+                PULONG*                     ppInsNums,
+                PULONG                      pMaxInsNum,
+                const VOID*                 pNewRows,
+                ULONG                       numNewRows,
+                ULONG                       rowSize,
+                WANMGR_DML_ROW_CMP          KeyMatch,
+                WANMGR_DML_ROW_CMP          RowEqual
+            );
+
+    description:
+
+        This function is called to bring a table of fixed size rows in
+        line with a fresh copy from the backend. Rows are matched by key,
+        rows that still exist keep their relative order and are only
+        overwritten when their content changed, new rows are appended.
+        The row buffer is reused and only grows, so handles returned by
+        GetEntry stay valid as long as no row before them went away.
+        Each row keeps the instance number it was given when it was
+        added, new rows take the next one.
+
+    argument:   PVOID*                      ppRows,
+                The table rows, allocated with AnscAllocateMemory;
+
+                PULONG                      pNumRows,
+                The number of rows in use;
+
+                PULONG                      pCapacity,
+                The number of rows allocated;
+
+                PULONG*                     ppInsNums,
+                The instance number of each row, same capacity as the rows;
+
+                PULONG                      pMaxInsNum,
+                The last instance number handed out;
+
+                const VOID*                 pNewRows,
+                ULONG                       numNewRows,
+                The rows as reported by the backend;
+
+                ULONG                       rowSize,
+                The size of one row;
+
+                WANMGR_DML_ROW_CMP          KeyMatch,
+                WANMGR_DML_ROW_CMP          RowEqual
+                The row callbacks.
+
+    return:     The number of rows added, removed or updated.
+
+**********************************************************************/
+ULONG
+WanMgr_DmlSyncTable
+    (
+        PVOID*                      ppRows,
+        PULONG                      pNumRows,
+        PULONG                      pCapacity,
+        PULONG*                     ppInsNums,
+        PULONG                      pMaxInsNum,
+        const VOID*                 pNewRows,
+        ULONG                       numNewRows,
+        ULONG                       rowSize,
+        WANMGR_DML_ROW_CMP          KeyMatch,
+        WANMGR_DML_ROW_CMP          RowEqual
+    )
+{
+    PUCHAR                          pRows        = (PUCHAR)*ppRows;
+    PULONG                          pInsNums     = *ppInsNums;
+    const UCHAR*                    pNew         = (const UCHAR*)pNewRows;
+    PUCHAR                          pGrown       = NULL;
+    PULONG                          pGrownIns    = NULL;
+    PUCHAR                          pUsed        = NULL;
+    ULONG                           numKept      = 0;
+    ULONG                           changed      = 0;
+    ULONG                           i            = 0;
+    ULONG                           j            = 0;
+
+    if ( numNewRows > 0 )
+    {
+        pUsed = (PUCHAR)AnscAllocateMemory(numNewRows);
+        if ( !pUsed )
+        {
+            return 0;
+        }
+        AnscZeroMemory(pUsed, numNewRows);
+    }
+
+    /* keep the rows that still exist, in their order, and compact them */
+    for ( i = 0; i < *pNumRows; i++ )
+    {
+        for ( j = 0; j < numNewRows; j++ )
+        {
+            if ( !pUsed[j] && KeyMatch(pRows + i * rowSize, pNew + j * rowSize) )
+            {
+                break;
+            }
+        }
+
+        if ( j == numNewRows )
+        {
+            changed++;
+            continue;
+        }
+
+        pUsed[j] = 1;
+        if ( numKept != i )
+        {
+            AnscCopyMemory(pRows + numKept * rowSize, pRows + i * rowSize, rowSize);
+            pInsNums[numKept] = pInsNums[i];
+        }
+        if ( !RowEqual(pRows + numKept * rowSize, pNew + j * rowSize) )
+        {
+            AnscCopyMemory(pRows + numKept * rowSize, (PVOID)(pNew + j * rowSize), rowSize);
+            changed++;
+        }
+        numKept++;
+    }
+
+    /* grow once to the new size if the new rows do not fit */
+    if ( numNewRows > *pCapacity )
+    {
+        pGrown    = (PUCHAR)AnscAllocateMemory(numNewRows * rowSize);
+        pGrownIns = (PULONG)AnscAllocateMemory(numNewRows * sizeof(ULONG));
+        if ( !pGrown || !pGrownIns )
+        {
+            if ( pGrown )
+            {
+                AnscFreeMemory(pGrown);
+            }
+            if ( pGrownIns )
+            {
+                AnscFreeMemory(pGrownIns);
+            }
+            *pNumRows = numKept;
+            AnscFreeMemory(pUsed);
+            return changed;
+        }
+        if ( pRows )
+        {
+            AnscCopyMemory(pGrown, pRows, numKept * rowSize);
+            AnscFreeMemory(pRows);
+        }
+        if ( pInsNums )
+        {
+            AnscCopyMemory(pGrownIns, pInsNums, numKept * sizeof(ULONG));
+            AnscFreeMemory(pInsNums);
+        }
+        pRows      = pGrown;
+        pInsNums   = pGrownIns;
+        *ppRows    = pRows;
+        *ppInsNums = pInsNums;
+        *pCapacity = numNewRows;
+    }
+
+    for ( j = 0; j < numNewRows; j++ )
+    {
+        if ( !pUsed[j] )
+        {
+            AnscCopyMemory(pRows + numKept * rowSize, (PVOID)(pNew + j * rowSize), rowSize);
+            if ( !++*pMaxInsNum )
+            {
+                *pMaxInsNum = 1;
+            }
+            pInsNums[numKept] = *pMaxInsNum;
+            numKept++;
+            changed++;
+        }
+    }
+
+    *pNumRows = numKept;
+
+    if ( pUsed )
+    {
+        AnscFreeMemory(pUsed);
+    }
+
+    return changed;
+}
@@ -72,9 +72,15 @@
         ULONG                             maxInstanceOfSent;                                \
         PDML_DHCPCV6_SVR             pServerEntry;                                       \
         ULONG                             NumberOfServer;                                     \
+        ULONG                             CapacityOfServer;                                     \
+        PULONG                            pServerInsNum;                                     \
+        ULONG                             maxInstanceOfServer;                                \
         ULONG                             PreviousVisitTimeOfServer;                                      \
         PDML_DHCPCV6_RECV            pRecvEntry;                                    \
         ULONG                             NumberOfRecv;                                     \
+        ULONG                             CapacityOfRecv;                                     \
+        PULONG                            pRecvInsNum;                                     \
+        ULONG                             maxInstanceOfRecv;                                \
         ULONG                             PreviousVisitTimeOfRecv;                                      \
         CHAR                              AliasOfSent[COSA_DML_DHCPV6_ALIAS];                \
 
@@ -135,9 +141,15 @@ WAN_DHCPV6_DATA,  *PWAN_DHCPV6_DATA;
     (pDhcpc)->maxInstanceOfSent               = 0;                 \
     (pDhcpc)->pServerEntry                    = NULL;                 \
     (pDhcpc)->NumberOfServer                  = 0;                 \
+    (pDhcpc)->CapacityOfServer                = 0;                 \
+    (pDhcpc)->pServerInsNum                   = NULL;                 \
+    (pDhcpc)->maxInstanceOfServer             = 0;                 \
     (pDhcpc)->PreviousVisitTimeOfServer       = 0;                 \
     (pDhcpc)->pRecvEntry                      = NULL;                 \
     (pDhcpc)->NumberOfRecv                    = 0;                 \
+    (pDhcpc)->CapacityOfRecv                  = 0;                 \
+    (pDhcpc)->pRecvInsNum                     = NULL;                 \
+    (pDhcpc)->maxInstanceOfRecv               = 0;                 \
     (pDhcpc)->PreviousVisitTimeOfRecv         = 0;                 \
     AnscZeroMemory((pDhcpc)->AliasOfSent, sizeof((pDhcpc)->AliasOfSent) ); \
 
@@ -151,6 +163,12 @@ WAN_DHCPV6_DATA,  *PWAN_DHCPV6_DATA;
     (pSentOption)->Tag                        = 0;                                    \
     AnscZeroMemory( (pSentOption)->Value, sizeof( (pSentOption)->Value ) );           \
     
+/*
+    Row callbacks for WanMgr_DmlSyncTable, KeyMatch tells whether two rows
+    describe the same entry, RowEqual whether an entry needs updating.
+*/
+typedef BOOL (*WANMGR_DML_ROW_CMP)(const void *pOld, const void *pNew);
+
 /*
     Function declaration 
 */ 
@@ -205,6 +223,49 @@ WanMgr_DmlSetIpaddr
         ULONG MaxNumber 
     );
 
+ULONG
+WanMgr_DmlSyncTable
+    (
+        PVOID*                      ppRows,
+        PULONG                      pNumRows,
+        PULONG                      pCapacity,
+        PULONG*                     ppInsNums,
+        PULONG                      pMaxInsNum,
+        const VOID*                 pNewRows,
+        ULONG                       numNewRows,
+        ULONG                       rowSize,
+        WANMGR_DML_ROW_CMP          KeyMatch,
+        WANMGR_DML_ROW_CMP          RowEqual
+    );
+
+BOOL
+WanMgr_DmlDhcpv6cServerKeyMatch
+    (
+        const void*                 pOld,
+        const void*                 pNew
+    );
+
+BOOL
+WanMgr_DmlDhcpv6cServerRowEqual
+    (
+        const void*                 pOld,
+        const void*                 pNew
+    );
+
+BOOL
+WanMgr_DmlDhcpv6cRecvKeyMatch
+    (
+        const void*                 pOld,
+        const void*                 pNew
+    );
+
+BOOL
+WanMgr_DmlDhcpv6cRecvRowEqual
+    (
+        const void*                 pOld,
+        const void*                 pNew
+    );
+
 BOOL 
 WanMgr_DmlGetIpaddrString
     (
@@ -0,0 +1,386 @@
+/*
+ * If not stated otherwise in this file or this component's Licenses.txt file the
+ * following copyright and licenses apply:
+ *
+ * Copyright 2020 RDK Management
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+*/
+
+/* ---- Include Files ---------------------------------------- */
+#include <errno.h>
+#include <pthread.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/epoll.h>
+#include "wanmgr_event_loop.h"
+
+#define EVTLOOP_MAX_EVENTS  WANMGR_EVTLOOP_MAX_SOURCES
+
+typedef struct _WanMgr_EvtSource_t
+{
+    BOOL                    inUse;
+    int                     fd;
+    char                    name[BUFLEN_32];
+    WanMgr_EventLoopCb_t    cb;
+    void*                   arg;
+    WanMgr_EventLoopStats_t stats;
+} WanMgr_EvtSource_t;
+
+typedef struct _WanMgr_EvtWork_t
+{
+    WanMgr_EventLoopWork_t      fn;
+    void*                       arg;
+    struct _WanMgr_EvtWork_t*   next;
+} WanMgr_EvtWork_t;
+
+/* One worker thread drains each queue */
+typedef struct _WanMgr_EvtWorkQueue_t
+{
+    const char*                 name;
+    WanMgr_EvtWork_t*           head;
+    WanMgr_EvtWork_t*           tail;
+    pthread_mutex_t             mutex;
+    pthread_cond_t              cond;
+} WanMgr_EvtWorkQueue_t;
+
+/* ---- Private Variables ------------------------------------ */
+static int gEpollFd = -1;
+static WanMgr_EvtSource_t gSources[WANMGR_EVTLOOP_MAX_SOURCES];
+static pthread_mutex_t gSourcesMutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_once_t gEvtLoopOnce = PTHREAD_ONCE_INIT;
+static BOOL gEvtLoopStarted = FALSE;
+
+/* sysevent jobs, firewall and service restarts, D-Bus sets */
+static WanMgr_EvtWorkQueue_t gWorkQueue = { "worker", NULL, NULL, PTHREAD_MUTEX_INITIALIZER, PTHREAD_COND_INITIALIZER };
+/* failover and lease hand-off, never queued behind a system() call */
+static WanMgr_EvtWorkQueue_t gUrgentQueue = { "urgent", NULL, NULL, PTHREAD_MUTEX_INITIALIZER, PTHREAD_COND_INITIALIZER };
+
+/* ---- Private Functions ------------------------------------ */
+
+static void EvtLoop_Create(void)
+{
+    if ((gEpollFd = epoll_create1(EPOLL_CLOEXEC)) < 0)
+    {
+        CcspTraceError(("%s %d - epoll_create1 failed (%s)\n", __FUNCTION__, __LINE__, strerror(errno)));
+    }
+}
+
+static uint64_t EvtLoop_NowUs(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t) ts.tv_sec * 1000000ULL + (uint64_t) ts.tv_nsec / 1000ULL;
+}
+
+static void EvtLoop_Dispatch(uint32_t slot, uint32_t events)
+{
+    WanMgr_EventLoopCb_t cb = NULL;
+    void *arg = NULL;
+    int fd = -1;
+    uint64_t start;
+    uint64_t elapsed;
+
+    pthread_mutex_lock(&gSourcesMutex);
+    if (slot < WANMGR_EVTLOOP_MAX_SOURCES && gSources[slot].inUse == TRUE)
+    {
+        cb = gSources[slot].cb;
+        arg = gSources[slot].arg;
+        fd = gSources[slot].fd;
+    }
+    pthread_mutex_unlock(&gSourcesMutex);
+
+    if (cb == NULL)
+    {
+        return;
+    }
+
+    start = EvtLoop_NowUs();
+    cb(fd, events, arg);
+    elapsed = EvtLoop_NowUs() - start;
+
+    pthread_mutex_lock(&gSourcesMutex);
+    if (gSources[slot].inUse == TRUE && gSources[slot].fd == fd)
+    {
+        gSources[slot].stats.dispatched++;
+        gSources[slot].stats.totalUs += elapsed;
+        if (elapsed > gSources[slot].stats.maxUs)
+        {
+            gSources[slot].stats.maxUs = elapsed;
+        }
+        if (elapsed > (uint64_t) WANMGR_EVTLOOP_SLOW_CB_MS * 1000ULL)
+        {
+            CcspTraceWarning(("%s %d - %s callback took %llu ms\n", __FUNCTION__, __LINE__,
+                              gSources[slot].name, (unsigned long long)(elapsed / 1000ULL)));
+        }
+    }
+    pthread_mutex_unlock(&gSourcesMutex);
+}
+
+static void* EvtLoop_Thread(void *arg)
+{
+    struct epoll_event events[EVTLOOP_MAX_EVENTS];
+    int n;
+    int i;
+
+    pthread_detach(pthread_self());
+
+    for (;;)
+    {
+        n = epoll_wait(gEpollFd, events, EVTLOOP_MAX_EVENTS, -1);
+        if (n < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            CcspTraceError(("%s %d - epoll_wait failed (%s), event loop exiting\n", __FUNCTION__, __LINE__, strerror(errno)));
+            break;
+        }
+
+        for (i = 0; i < n; i++)
+        {
+            EvtLoop_Dispatch(events[i].data.u32, events[i].events);
+        }
+    }
+
+    return NULL;
+}
+
+static void* EvtLoop_WorkerThread(void *arg)
+{
+    WanMgr_EvtWorkQueue_t *pQueue = (WanMgr_EvtWorkQueue_t *) arg;
+    WanMgr_EvtWork_t *pWork = NULL;
+
+    pthread_detach(pthread_self());
+
+    for (;;)
+    {
+        pthread_mutex_lock(&pQueue->mutex);
+        while (pQueue->head == NULL)
+        {
+            pthread_cond_wait(&pQueue->cond, &pQueue->mutex);
+        }
+        pWork = pQueue->head;
+        pQueue->head = pWork->next;
+        if (pQueue->head == NULL)
+        {
+            pQueue->tail = NULL;
+        }
+        pthread_mutex_unlock(&pQueue->mutex);
+
+        pWork->fn(pWork->arg);
+        free(pWork);
+    }
+
+    return NULL;
+}
+
+static ANSC_STATUS EvtLoop_Queue(WanMgr_EvtWorkQueue_t *pQueue, WanMgr_EventLoopWork_t fn, void *arg)
+{
+    WanMgr_EvtWork_t *pWork = NULL;
+
+    if (fn == NULL)
+    {
+        return ANSC_STATUS_FAILURE;
+    }
+
+    if (gEvtLoopStarted != TRUE)
+    {
+        /* no worker yet, run in the caller's context */
+        fn(arg);
+        return ANSC_STATUS_SUCCESS;
+    }
+
+    if ((pWork = (WanMgr_EvtWork_t *) malloc(sizeof(WanMgr_EvtWork_t))) == NULL)
+    {
+        return ANSC_STATUS_FAILURE;
+    }
+
+    pWork->fn = fn;
+    pWork->arg = arg;
+    pWork->next = NULL;
+
+    pthread_mutex_lock(&pQueue->mutex);
+    if (pQueue->tail == NULL)
+    {
+        pQueue->head = pWork;
+    }
+    else
+    {
+        pQueue->tail->next = pWork;
+    }
+    pQueue->tail = pWork;
+    pthread_cond_signal(&pQueue->cond);
+    pthread_mutex_unlock(&pQueue->mutex);
+
+    return ANSC_STATUS_SUCCESS;
+}
+
+static ANSC_STATUS EvtLoop_StartWorker(WanMgr_EvtWorkQueue_t *pQueue)
+{
+    pthread_t workerThreadId;
+
+    if (pthread_create(&workerThreadId, NULL, &EvtLoop_WorkerThread, pQueue) != 0)
+    {
+        CcspTraceError(("%s %d - failed to start event loop %s thread\n", __FUNCTION__, __LINE__, pQueue->name));
+        return ANSC_STATUS_FAILURE;
+    }
+
+    return ANSC_STATUS_SUCCESS;
+}
+
+/* ---- Public Functions ------------------------------------- */
+
+ANSC_STATUS WanMgr_EventLoop_AddFd(int fd, const char *name, WanMgr_EventLoopCb_t cb, void *arg)
+{
+    struct epoll_event ev;
+    uint32_t slot;
+
+    if (fd < 0 || cb == NULL)
+    {
+        return ANSC_STATUS_FAILURE;
+    }
+
+    pthread_once(&gEvtLoopOnce, EvtLoop_Create);
+    if (gEpollFd < 0)
+    {
+        return ANSC_STATUS_FAILURE;
+    }
+
+    pthread_mutex_lock(&gSourcesMutex);
+    for (slot = 0; slot < WANMGR_EVTLOOP_MAX_SOURCES; slot++)
+    {
+        if (gSources[slot].inUse != TRUE)
+        {
+            break;
+        }
+    }
+
+    if (slot >= WANMGR_EVTLOOP_MAX_SOURCES)
+    {
+        pthread_mutex_unlock(&gSourcesMutex);
+        CcspTraceError(("%s %d - no free event source for %s\n", __FUNCTION__, __LINE__, name));
+        return ANSC_STATUS_FAILURE;
+    }
+
+    memset(&gSources[slot], 0, sizeof(WanMgr_EvtSource_t));
+    gSources[slot].fd = fd;
+    strncpy(gSources[slot].name, (name != NULL) ? name : "", sizeof(gSources[slot].name) - 1);
+    gSources[slot].cb = cb;
+    gSources[slot].arg = arg;
+    gSources[slot].inUse = TRUE;
+
+    memset(&ev, 0, sizeof(ev));
+    ev.events = EPOLLIN;
+    ev.data.u32 = slot;
+    if (epoll_ctl(gEpollFd, EPOLL_CTL_ADD, fd, &ev) < 0)
+    {
+        gSources[slot].inUse = FALSE;
+        pthread_mutex_unlock(&gSourcesMutex);
+        CcspTraceError(("%s %d - epoll_ctl add %s failed (%s)\n", __FUNCTION__, __LINE__, name, strerror(errno)));
+        return ANSC_STATUS_FAILURE;
+    }
+    pthread_mutex_unlock(&gSourcesMutex);
+
+    CcspTraceInfo(("%s %d - %s (fd %d) added to event loop\n", __FUNCTION__, __LINE__, name, fd));
+    return ANSC_STATUS_SUCCESS;
+}
+
+ANSC_STATUS WanMgr_EventLoop_RemoveFd(int fd)
+{
+    uint32_t slot;
+
+    if (gEpollFd < 0)
+    {
+        return ANSC_STATUS_FAILURE;
+    }
+
+    pthread_mutex_lock(&gSourcesMutex);
+    for (slot = 0; slot < WANMGR_EVTLOOP_MAX_SOURCES; slot++)
+    {
+        if (gSources[slot].inUse == TRUE && gSources[slot].fd == fd)
+        {
+            epoll_ctl(gEpollFd, EPOLL_CTL_DEL, fd, NULL);
+            gSources[slot].inUse = FALSE;
+            pthread_mutex_unlock(&gSourcesMutex);
+            return ANSC_STATUS_SUCCESS;
+        }
+    }
+    pthread_mutex_unlock(&gSourcesMutex);
+
+    return ANSC_STATUS_FAILURE;
+}
+
+ANSC_STATUS WanMgr_EventLoop_QueueWork(WanMgr_EventLoopWork_t fn, void *arg)
+{
+    return EvtLoop_Queue(&gWorkQueue, fn, arg);
+}
+
+ANSC_STATUS WanMgr_EventLoop_QueueUrgentWork(WanMgr_EventLoopWork_t fn, void *arg)
+{
+    return EvtLoop_Queue(&gUrgentQueue, fn, arg);
+}
+
+ANSC_STATUS WanMgr_EventLoop_GetStats(const char *name, WanMgr_EventLoopStats_t *pStats)
+{
+    uint32_t slot;
+
+    if (name == NULL || pStats == NULL)
+    {
+        return ANSC_STATUS_FAILURE;
+    }
+
+    pthread_mutex_lock(&gSourcesMutex);
+    for (slot = 0; slot < WANMGR_EVTLOOP_MAX_SOURCES; slot++)
+    {
+        if (gSources[slot].inUse == TRUE && strcmp(gSources[slot].name, name) == 0)
+        {
+            memcpy(pStats, &gSources[slot].stats, sizeof(WanMgr_EventLoopStats_t));
+            pthread_mutex_unlock(&gSourcesMutex);
+            return ANSC_STATUS_SUCCESS;
+        }
+    }
+    pthread_mutex_unlock(&gSourcesMutex);
+
+    return ANSC_STATUS_FAILURE;
+}
+
+ANSC_STATUS WanMgr_EventLoop_Start(void)
+{
+    pthread_t loopThreadId;
+
+    pthread_once(&gEvtLoopOnce, EvtLoop_Create);
+    if (gEpollFd < 0)
+    {
+        return ANSC_STATUS_FAILURE;
+    }
+
+    if (EvtLoop_StartWorker(&gWorkQueue) != ANSC_STATUS_SUCCESS ||
+        EvtLoop_StartWorker(&gUrgentQueue) != ANSC_STATUS_SUCCESS)
+    {
+        return ANSC_STATUS_FAILURE;
+    }
+    gEvtLoopStarted = TRUE;
+
+    if (pthread_create(&loopThreadId, NULL, &EvtLoop_Thread, NULL) != 0)
+    {
+        CcspTraceError(("%s %d - failed to start event loop\n", __FUNCTION__, __LINE__));
+        return ANSC_STATUS_FAILURE;
+    }
+
+    CcspTraceInfo(("%s %d - event loop started\n", __FUNCTION__, __LINE__));
+    return ANSC_STATUS_SUCCESS;
+}
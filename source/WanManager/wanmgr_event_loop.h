@@ -0,0 +1,99 @@
+/*
+ * If not stated otherwise in this file or this component's Licenses.txt file the
+ * following copyright and licenses apply:
+ *
+ * Copyright 2020 RDK Management
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+*/
+
+#ifndef _WANMGR_EVENT_LOOP_H_
+#define _WANMGR_EVENT_LOOP_H_
+
+/* ---- Include Files ---------------------------------------- */
+#include <stdint.h>
+#include "ansc_platform.h"
+
+/* ---- Global Constants -------------------------------------- */
+#define WANMGR_EVTLOOP_MAX_SOURCES      32
+#define WANMGR_EVTLOOP_SLOW_CB_MS       100     /* callbacks slower than this are logged */
+
+/* ---- Global Types -------------------------------------------- */
+
+/* Called on the event loop thread when fd is readable. Must not block. */
+typedef void (*WanMgr_EventLoopCb_t)(int fd, uint32_t events, void *arg);
+
+/* Deferred work, run in order on an event loop worker thread. */
+typedef void (*WanMgr_EventLoopWork_t)(void *arg);
+
+typedef struct _WanMgr_EventLoopStats_t
+{
+    UINT        dispatched;     /* number of callback invocations */
+    uint64_t    totalUs;        /* time spent in the callback */
+    uint64_t    maxUs;
+} WanMgr_EventLoopStats_t;
+
+/* ---- Global Prototypes -------------------------------------- */
+
+/***************************************************************************
+ * @brief Register a readable fd with the event loop. Sources can be added
+ * before or after the loop is started.
+ * @param fd file descriptor to watch
+ * @param name short name used in logs and statistics
+ * @param cb callback invoked when fd is readable
+ * @param arg opaque pointer passed to cb
+ * @return ANSC_STATUS_SUCCESS upon success else returned error code.
+ ****************************************************************************/
+ANSC_STATUS WanMgr_EventLoop_AddFd(int fd, const char *name, WanMgr_EventLoopCb_t cb, void *arg);
+
+/***************************************************************************
+ * @brief Stop watching a previously registered fd. The fd is not closed.
+ * @param fd file descriptor to remove
+ * @return ANSC_STATUS_SUCCESS upon success else returned error code.
+ ****************************************************************************/
+ANSC_STATUS WanMgr_EventLoop_RemoveFd(int fd);
+
+/***************************************************************************
+ * @brief Queue blocking work (system(), D-Bus, long waits) so it does not
+ * hold up the event loop. Work items run one at a time in queue order.
+ * @param fn function to run
+ * @param arg opaque pointer passed to fn, owned by fn
+ * @return ANSC_STATUS_SUCCESS upon success else returned error code.
+ ****************************************************************************/
+ANSC_STATUS WanMgr_EventLoop_QueueWork(WanMgr_EventLoopWork_t fn, void *arg);
+
+/***************************************************************************
+ * @brief Queue latency critical work (failover, lease hand-off) on its own
+ * worker thread, so it never waits behind QueueWork items. Keep the work
+ * short, anything that runs system() belongs on QueueWork.
+ * @param fn function to run
+ * @param arg opaque pointer passed to fn, owned by fn
+ * @return ANSC_STATUS_SUCCESS upon success else returned error code.
+ ****************************************************************************/
+ANSC_STATUS WanMgr_EventLoop_QueueUrgentWork(WanMgr_EventLoopWork_t fn, void *arg);
+
+/***************************************************************************
+ * @brief Read the dispatch statistics of a registered source.
+ * @param name name given at registration
+ * @param pStats output statistics
+ * @return ANSC_STATUS_SUCCESS if the source exists else ANSC_STATUS_FAILURE.
+ ****************************************************************************/
+ANSC_STATUS WanMgr_EventLoop_GetStats(const char *name, WanMgr_EventLoopStats_t *pStats);
+
+/***************************************************************************
+ * @brief Start the event loop and worker threads.
+ * @return ANSC_STATUS_SUCCESS upon success else returned error code.
+ ****************************************************************************/
+ANSC_STATUS WanMgr_EventLoop_Start(void);
+
+#endif /* _WANMGR_EVENT_LOOP_H_ */
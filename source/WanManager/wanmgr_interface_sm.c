@@ -19,7 +19,11 @@
 
 #include <unistd.h>
 #include <pthread.h>
-#include <ifaddrs.h>
+#include <arpa/inet.h>
+#include <sys/eventfd.h>
+#include <sys/select.h>
+#include <linux/if_addr.h>
+#include <linux/rtnetlink.h>
 #include "wanmgr_interface_sm.h"
 #include "wanmgr_utils.h"
 #include "platform_hal.h"
@@ -30,8 +34,14 @@
 #include "wanmgr_interface_sm.h"
 #include "wanmgr_platform_events.h"
 #include "wanmgr_net_utils.h"
+#include "wanmgr_netlink.h"
 #include "wanmgr_dhcpv4_apis.h"
 #include "wanmgr_dhcpv6_apis.h"
+#ifdef FEATURE_IPOE_HEALTH_CHECK
+#include "wanmgr_ipoe_hc.h"
+#endif
+#include "wanmgr_probe.h"
+#include "wanmgr_validation.h"
 
 typedef enum
 {
@@ -82,18 +92,21 @@ static eWanState_t wan_transition_exit(WanMgr_IfaceSM_Controller_t* pWanIfaceCtr
  * This API calls the HAL routine to configure ipv4.
  * @param ifname Wan interface name
  * @param wanData pointer to WanData_t holds the wan data
+ * @param wanPolicy current WAN policy, in MULTIWAN_MODE the policy owns the default route
  * @return RETURN_OK upon success else returned error code.
  *********************************************************************************/
-static int wan_setUpIPv4(DML_WAN_IFACE* pInterface);
+static int wan_setUpIPv4(DML_WAN_IFACE* pInterface, DML_WAN_POLICY wanPolicy);
 
 /********************************************************************************
  * @brief Unconfig IPV4 configuration on the interface.
  * This API calls the HAL routine to unconfig ipv4.
  * @param ifname Wan interface name
  * @param wanData pointer to WanData_t holds the wan data
+ * @param wanPolicy current WAN policy, in MULTIWAN_MODE the global WAN state
+ *        is only reset when no other WAN still has IPv4 up
  * @return RETURN_OK upon success else returned error code.
  *********************************************************************************/
-static int wan_tearDownIPv4(DML_WAN_IFACE* pInterface);
+static int wan_tearDownIPv4(DML_WAN_IFACE* pInterface, DML_WAN_POLICY wanPolicy);
 
 /*************************************************************************************
  * @brief Configure IPV6 configuration on the interface.
@@ -102,7 +115,7 @@ static int wan_tearDownIPv4(DML_WAN_IFACE* pInterface);
  * @param wanData pointer to WanData_t holds the wan data
  * @return  RETURN_OK upon success else returned error code.
  **************************************************************************************/
-static int wan_setUpIPv6(DML_WAN_IFACE* pInterface);
+static int wan_setUpIPv6(DML_WAN_IFACE* pInterface, DML_WAN_POLICY wanPolicy);
 
 /*************************************************************************************
  * @brief Unconfig IPV6 configuration on the interface.
@@ -111,16 +124,18 @@ static int wan_setUpIPv6(DML_WAN_IFACE* pInterface);
  * @param wanData pointer to WanData_t holds the wan data
  * @return RETURN_OK upon success else returned error code.
  **************************************************************************************/
-static int wan_tearDownIPv6(DML_WAN_IFACE* pInterface);
+static int wan_tearDownIPv6(DML_WAN_IFACE* pInterface, DML_WAN_POLICY wanPolicy);
 
 /**************************************************************************************
  * @brief Update DNS configuration into /etc/resolv.conf
  * @param wanIfname wan interface name
  * @param addIPv4 boolean flag indicates whether IPv4 DNS data needs to be update
  * @param addIPv6 boolean flag indicates whether IPv6 DNS data needs to be update
+ * @param wanPolicy current WAN policy, in MULTIWAN_MODE the servers of the
+ *        other active WANs are kept as well
  * @return RETURN_OK upon success else ERROR code returned
  **************************************************************************************/
-static int wan_updateDNS(DML_WAN_IFACE* pInterface, BOOL addIPv4, BOOL addIPv6);
+static int wan_updateDNS(DML_WAN_IFACE* pInterface, BOOL addIPv4, BOOL addIPv6, DML_WAN_POLICY wanPolicy);
 
 /**************************************************************************************
  * @brief Clear the DHCP client data stored.
@@ -173,6 +188,54 @@ static int validate_v6_gateway_address(void);
  ************************************************************************************/
 static int setUpLanPrefixIPv6(DML_WAN_IFACE* pIfaceData);
 
+#ifdef FEATURE_IPOE_HEALTH_CHECK
+/************************************************************************************
+ * @brief Start IPoE health check echoes over IPv4 with the leased address
+ * @param pInterface pointer to the interface data
+ * @return RETURN_OK on success else RETURN_ERR
+ ************************************************************************************/
+static int wan_startIpoeHealthCheckIPv4(DML_WAN_IFACE* pInterface);
+
+/************************************************************************************
+ * @brief Start IPoE health check echoes over IPv6 with the WAN address, or the
+ * first address of the delegated prefix when no address was assigned
+ * @param pInterface pointer to the interface data
+ * @return RETURN_OK on success else RETURN_ERR
+ ************************************************************************************/
+static int wan_startIpoeHealthCheckIPv6(DML_WAN_IFACE* pInterface);
+#endif /* FEATURE_IPOE_HEALTH_CHECK */
+
+/************************************************************************************
+ * @brief Start the liveness probes of an IPoE interface, if a probe interval is configured
+ * @param pInterface pointer to the interface data
+ * @return TRUE if the probes were started else FALSE
+ ************************************************************************************/
+static BOOL wan_startProbes(DML_WAN_IFACE* pInterface);
+
+/************************************************************************************
+ * @brief Start IPv4 liveness probes with the leased address, gateway and DNS server
+ * @param pInterface pointer to the interface data
+ * @return RETURN_OK on success else RETURN_ERR
+ ************************************************************************************/
+static int wan_startProbesIPv4(DML_WAN_IFACE* pInterface);
+
+/************************************************************************************
+ * @brief Start IPv6 liveness probes with the WAN address, or the first address
+ * of the delegated prefix when no address was assigned
+ * @param pInterface pointer to the interface data
+ * @return RETURN_OK on success else RETURN_ERR
+ ************************************************************************************/
+static int wan_startProbesIPv6(DML_WAN_IFACE* pInterface);
+
+/************************************************************************************
+ * @brief Start the Discover-Offer and Solicit-Advertise checks enabled by the
+ * Wan.Validation flags of an IPoE interface
+ * @param pInterface pointer to the interface data
+ * @param wakeFd eventfd of the state machine, written once the result is known
+ * @return TRUE if validation was started else FALSE
+ ************************************************************************************/
+static BOOL wan_startValidation(DML_WAN_IFACE* pInterface, int wakeFd);
+
 
 
 #ifdef FEATURE_MAPT
@@ -320,6 +383,7 @@ void WanManager_UpdateInterfaceStatus(DML_WAN_IFACE* pIfaceData, wanmgr_iface_st
             pIfaceData->IP.Ipv4Status = WAN_IFACE_IPV4_STATE_DOWN;
             pIfaceData->IP.Ipv4Changed = FALSE;
             strncpy(pIfaceData->IP.Ipv4Data.ip, "", sizeof(pIfaceData->IP.Ipv4Data.ip));
+            memset(&pIfaceData->IP.Ipv4Data.bin.ip, 0, sizeof(pIfaceData->IP.Ipv4Data.bin.ip));
             wanmgr_sysevents_ipv4Info_init(pIfaceData->Wan.Name); // reset the sysvent/syscfg fields
             break;
         }
@@ -339,6 +403,7 @@ void WanManager_UpdateInterfaceStatus(DML_WAN_IFACE* pIfaceData, wanmgr_iface_st
 	    strncpy(pIfaceData->IP.Ipv6Data.sitePrefix, "", sizeof(pIfaceData->IP.Ipv6Data.sitePrefix));
             strncpy(pIfaceData->IP.Ipv6Data.nameserver, "", sizeof(pIfaceData->IP.Ipv6Data.nameserver));
             strncpy(pIfaceData->IP.Ipv6Data.nameserver1, "", sizeof(pIfaceData->IP.Ipv6Data.nameserver1));
+            WanManager_Ipv6DataToBin(&pIfaceData->IP.Ipv6Data);
             wanmgr_sysevents_ipv6Info_init(); // reset the sysvent/syscfg fields
             break;
         }
@@ -363,6 +428,148 @@ void WanManager_UpdateInterfaceStatus(DML_WAN_IFACE* pIfaceData, wanmgr_iface_st
     return;
 }
 
+/* TRUE if pAddr is configured on ifName and past DAD, so it can source probes */
+static BOOL wan_isIpv6AddressUsable(const char *ifName, const struct in6_addr *pAddr)
+{
+    WanMgr_NlAddr6_t addr6;
+    uint32_t idx;
+
+    for (idx = 0; WanMgr_Netlink_GetIfAddr6(ifName, idx, &addr6) == ANSC_STATUS_SUCCESS; idx++)
+    {
+        if (IN6_ARE_ADDR_EQUAL(&addr6.addr, pAddr))
+        {
+            return (addr6.ifaFlags & (IFA_F_TENTATIVE | IFA_F_DADFAILED)) ? FALSE : TRUE;
+        }
+    }
+
+    return FALSE;
+}
+
+/* Source address for echoes and probes: the IA_NA address, else the ::1 of the
+ * delegated prefix on the LAN bridge (routed to us as well), whichever the
+ * kernel has configured and finished DAD on. */
+static BOOL wan_getIpv6SourceAddress(DML_WAN_IFACE* pInterface, struct in6_addr *pAddr)
+{
+    WANMGR_IPV6_ADDR_BIN *pBin = &pInterface->IP.Ipv6Data.bin;
+
+    if (!IN6_IS_ADDR_UNSPECIFIED(&pBin->address) && wan_isIpv6AddressUsable(pInterface->Wan.Name, &pBin->address) == TRUE)
+    {
+        *pAddr = pBin->address;
+        return TRUE;
+    }
+
+    if (!IN6_IS_ADDR_UNSPECIFIED(&pBin->sitePrefix))
+    {
+        *pAddr = pBin->sitePrefix;
+        pAddr->s6_addr[15] |= 1;
+        if (wan_isIpv6AddressUsable(ETH_BRIDGE_NAME, pAddr) == TRUE)
+        {
+            return TRUE;
+        }
+    }
+
+    CcspTraceError(("%s %d - no usable IPv6 address on %s \n", __FUNCTION__, __LINE__, pInterface->Wan.Name));
+    return FALSE;
+}
+
+#ifdef FEATURE_IPOE_HEALTH_CHECK
+static int wan_startIpoeHealthCheckIPv4(DML_WAN_IFACE* pInterface)
+{
+    WANMGR_IPV4_ADDR_BIN *pBin = &pInterface->IP.Ipv4Data.bin;
+
+    if ((pBin->ip.s_addr == INADDR_ANY) || (pBin->gateway.s_addr == INADDR_ANY))
+    {
+        CcspTraceError(("%s %d - bad address %s gw %s \n", __FUNCTION__, __LINE__, pInterface->IP.Ipv4Data.ip, pInterface->IP.Ipv4Data.gateway));
+        return RETURN_ERR;
+    }
+
+    return (WanMgr_IpoeHc_SetIpv4(pInterface->Wan.Name, TRUE, &pBin->ip, &pBin->gateway) == ANSC_STATUS_SUCCESS) ? RETURN_OK : RETURN_ERR;
+}
+
+static int wan_startIpoeHealthCheckIPv6(DML_WAN_IFACE* pInterface)
+{
+    struct in6_addr addr;
+
+    if (wan_getIpv6SourceAddress(pInterface, &addr) != TRUE)
+    {
+        return RETURN_ERR;
+    }
+
+    return (WanMgr_IpoeHc_SetIpv6(pInterface->Wan.Name, TRUE, &addr) == ANSC_STATUS_SUCCESS) ? RETURN_OK : RETURN_ERR;
+}
+#endif /* FEATURE_IPOE_HEALTH_CHECK */
+
+static BOOL wan_startProbes(DML_WAN_IFACE* pInterface)
+{
+    WanMgr_ProbeConfig_t config;
+
+    if (pInterface->Wan.Probe.Interval == 0)
+    {
+        return FALSE;
+    }
+
+    memset(&config, 0, sizeof(config));
+    config.intervalMs = pInterface->Wan.Probe.Interval;
+    config.failureCount = pInterface->Wan.Probe.FailureCount;
+    config.methods = WanMgr_Probe_ParseMethods(pInterface->Wan.Probe.Methods);
+    snprintf(config.host, sizeof(config.host), "%s", pInterface->Wan.Probe.Host);
+
+    if (WanMgr_Probe_Start(pInterface->Wan.Name, &config) != ANSC_STATUS_SUCCESS)
+    {
+        CcspTraceError(("%s %d - Failed to start probes on interface %s \n", __FUNCTION__, __LINE__, pInterface->Wan.Name));
+        return FALSE;
+    }
+
+    return TRUE;
+}
+
+static int wan_startProbesIPv4(DML_WAN_IFACE* pInterface)
+{
+    WANMGR_IPV4_ADDR_BIN *pBin = &pInterface->IP.Ipv4Data.bin;
+
+    if ((pBin->ip.s_addr == INADDR_ANY) || (pBin->gateway.s_addr == INADDR_ANY))
+    {
+        CcspTraceError(("%s %d - bad address %s gw %s \n", __FUNCTION__, __LINE__, pInterface->IP.Ipv4Data.ip, pInterface->IP.Ipv4Data.gateway));
+        return RETURN_ERR;
+    }
+
+    return (WanMgr_Probe_SetIpv4(pInterface->Wan.Name, TRUE, &pBin->ip, &pBin->gateway, &pBin->dnsServer) == ANSC_STATUS_SUCCESS) ? RETURN_OK : RETURN_ERR;
+}
+
+static int wan_startProbesIPv6(DML_WAN_IFACE* pInterface)
+{
+    WANMGR_IPV6_ADDR_BIN *pBin = &pInterface->IP.Ipv6Data.bin;
+    struct in6_addr addr;
+
+    //Probes sourced from an address the kernel does not use would never be answered
+    if (wan_getIpv6SourceAddress(pInterface, &addr) != TRUE)
+    {
+        return RETURN_ERR;
+    }
+
+    return (WanMgr_Probe_SetIpv6(pInterface->Wan.Name, TRUE, &addr, &pBin->nameserver) == ANSC_STATUS_SUCCESS) ? RETURN_OK : RETURN_ERR;
+}
+
+static BOOL wan_startValidation(DML_WAN_IFACE* pInterface, int wakeFd)
+{
+    BOOL discoverOffer = pInterface->Wan.Validation.DiscoverOffer;
+    BOOL solicitAdvertise = pInterface->Wan.Validation.SolicitAdvertise;
+
+    //A PPP session is not validated over DHCP
+    if (pInterface->PPP.Enable == TRUE || (discoverOffer == FALSE && solicitAdvertise == FALSE))
+    {
+        return FALSE;
+    }
+
+    if (WanMgr_Validation_Start(pInterface->Wan.Name, discoverOffer, solicitAdvertise, wakeFd) != ANSC_STATUS_SUCCESS)
+    {
+        CcspTraceError(("%s %d - Failed to start validation on interface %s \n", __FUNCTION__, __LINE__, pInterface->Wan.Name));
+        return FALSE;
+    }
+
+    return TRUE;
+}
+
 static ANSC_STATUS WanMgr_Send_InterfaceRefresh(DML_WAN_IFACE* pInterface)
 {
     DML_WAN_IFACE*      pWanIface4Thread = NULL;
@@ -401,10 +608,71 @@ static ANSC_STATUS WanMgr_Send_InterfaceRefresh(DML_WAN_IFACE* pInterface)
     return ANSC_STATUS_SUCCESS;
 }
 
-static int wan_updateDNS(DML_WAN_IFACE* pInterface, BOOL addIPv4, BOOL addIPv6)
+/* Takes the first free slot, a server already listed is not added twice */
+static void wan_addDnsServer(char *pDns1, char *pDns2, size_t len, const char *pServer)
+{
+    if (pServer[0] == '\0' || strcmp(pDns1, pServer) == 0 || strcmp(pDns2, pServer) == 0)
+    {
+        return;
+    }
+
+    if (pDns1[0] == '\0')
+    {
+        snprintf(pDns1, len, "%s", pServer);
+    }
+    else if (pDns2[0] == '\0')
+    {
+        snprintf(pDns2, len, "%s", pServer);
+    }
+}
+
+/* Adds the servers of the other WANs that are still up. The caller holds the
+ * interface data lock, the lock is recursive. */
+static void wan_mergeActiveWanDNS(DML_WAN_IFACE* pInterface, DnsData_t *pDnsData)
+{
+    WanMgr_IfaceCtrl_Data_t* pWanIfaceCtrl = WanMgr_GetIfaceCtrl_locked();
+    UINT uiIndex;
+    int pass;
+
+    if (pWanIfaceCtrl == NULL)
+    {
+        return;
+    }
+
+    /* the first server of every WAN before any second one */
+    for (pass = 0; pass < 2; pass++)
+    {
+        for (uiIndex = 0; uiIndex < pWanIfaceCtrl->ulTotalNumbWanInterfaces; uiIndex++)
+        {
+            DML_WAN_IFACE* pOther = &(pWanIfaceCtrl->pIface[uiIndex].data);
+
+            if (pOther->uiIfaceIdx == pInterface->uiIfaceIdx || pOther->Wan.ActiveLink != TRUE)
+            {
+                continue;
+            }
+
+            if (pOther->IP.Ipv4Status == WAN_IFACE_IPV4_STATE_UP)
+            {
+                wan_addDnsServer(pDnsData->dns_ipv4_1, pDnsData->dns_ipv4_2, sizeof(pDnsData->dns_ipv4_1),
+                                 (pass == 0) ? pOther->IP.Ipv4Data.dnsServer : pOther->IP.Ipv4Data.dnsServer1);
+            }
+
+            if (pOther->IP.Ipv6Status == WAN_IFACE_IPV6_STATE_UP)
+            {
+                wan_addDnsServer(pDnsData->dns_ipv6_1, pDnsData->dns_ipv6_2, sizeof(pDnsData->dns_ipv6_1),
+                                 (pass == 0) ? pOther->IP.Ipv6Data.nameserver : pOther->IP.Ipv6Data.nameserver1);
+            }
+        }
+    }
+
+    WanMgrDml_GetIfaceCtrl_release(pWanIfaceCtrl);
+}
+
+static int wan_updateDNS(DML_WAN_IFACE* pInterface, BOOL addIPv4, BOOL addIPv6, DML_WAN_POLICY wanPolicy)
 {
     int ret = RETURN_OK;
     DnsData_t dnsData;
+    BOOL dnsChanged = FALSE;
 
     if (NULL == pInterface)
     {
@@ -426,141 +694,79 @@ static int wan_updateDNS(DML_WAN_IFACE* pInterface, BOOL addIPv4, BOOL addIPv6)
         strncpy(dnsData.dns_ipv6_2, pInterface->IP.Ipv6Data.nameserver1, sizeof(dnsData.dns_ipv6_2));
     }
 
-    if ((ret = WanManager_CreateResolvCfg(&dnsData)) != RETURN_OK)
+    if (wanPolicy == MULTIWAN_MODE)
+    {
+        wan_mergeActiveWanDNS(pInterface, &dnsData);
+    }
+
+    if ((ret = WanManager_CreateResolvCfg(&dnsData, &dnsChanged)) != RETURN_OK)
     {
         CcspTraceError(("%s %d - Failed to set up DNS servers \n", __FUNCTION__, __LINE__));
     }
-    else
+    else if (dnsChanged)
     {
-        sysevent_set(sysevent_fd, sysevent_token, SYSEVENT_DHCP_SERVER_RESTART, NULL, 0);
+        /* dnsmasq only needs a restart when the nameserver set really changed */
+        wanmgr_sysevents_scheduleRestart(WANMGR_RESTART_DHCP_SERVER);
     }
 
     return ret;
 }
 
+/* Any IPv6 default route will do: through a router, ECMP or over a point to point link */
 static int validate_v6_gateway_address(void)
 {
-    char command[BUFLEN_64] = {0};
-    char line[BUFLEN_128] = {0};
-    char defaultGateway[BUFLEN_64] = {0};
-    int defaultGatewayLen = 64;
-    FILE *fp;
-    int ret = RETURN_OK;
-
-    snprintf(command, sizeof(command), "ip -6 route show default | grep default | awk '{print $3}'");
+    struct in6_addr gateway;
+    char defaultGateway[INET6_ADDRSTRLEN] = {0};
 
-    fp = popen(command, "r");
+    if (WanMgr_Netlink_FindDefaultRoute6(0) != ANSC_STATUS_SUCCESS)
+    {
+        return RETURN_ERR;
+    }
 
-    if (fp)
+    if (WanMgr_Netlink_GetDefaultGateway6(0, &gateway) == ANSC_STATUS_SUCCESS)
     {
-        if (fgets(line, sizeof(line), fp) != NULL)
-        {
-            char *token = strtok(line, "\n"); // get string up until newline character
-            if (token)
-            {
-                strncpy(defaultGateway, token, defaultGatewayLen);
-                CcspTraceInfo(("IPv6 Default Gateway Address  = %s \n", defaultGateway));
-            }
-            else
-            {
-                CcspTraceError(("Could not parse IPv6 Gateway Address \n"));
-                ret = RETURN_ERR;
-            }
-        }
-        else
-        {
-            ret = RETURN_ERR;
-        }
-        pclose(fp);
+        inet_ntop(AF_INET6, &gateway, defaultGateway, sizeof(defaultGateway));
+        CcspTraceInfo(("IPv6 Default Gateway Address  = %s \n", defaultGateway));
     }
     else
     {
-        CcspTraceError(("Failed to get the default Gateway Address \n"));
-        ret = RETURN_ERR;
+        CcspTraceInfo(("IPv6 Default route without a gateway address\n"));
     }
 
-    return ret;
+    return RETURN_OK;
 }
 
+/* One look at the LAN bridge, the state machine asks again on its next pass
+ * rather than waiting here with the interface data locked. */
 static int checkIpv6LanAddressIsReadyToUse()
 {
-    char buffer[BUFLEN_256] = {0};
-    FILE *fp_dad   = NULL;
-    FILE *fp_route = NULL;
-    int address_flag   = 0;
-    int dad_flag       = 0;
-    int route_flag     = 0;
-    struct ifaddrs *ifap = NULL;
-    struct ifaddrs *ifa  = NULL;
+    WanMgr_NlAddr6_t addr6;
     char addr[INET6_ADDRSTRLEN] = {0};
-    int i;
+    int address_flag = 0;
+    uint32_t idx;
 
     /* We need to check the interface has got an IPV6-prefix , beacuse P-and-M can send
     the same event when interface is down, so we ensure send the UP event only
     when interface has an IPV6-prefix.
+    Duplicate Address Detection (DAD) takes around 3 to 4 seconds after an
+    address is added, none of the bridge addresses may still be tentative.
+    The default route is checked by validate_v6_gateway_address().
     */
-    if (!getifaddrs(&ifap)) {
-        for (ifa = ifap; ifa; ifa = ifa->ifa_next) {
-            if(strncmp(ifa->ifa_name,ETH_BRIDGE_NAME, strlen(ETH_BRIDGE_NAME)))
-                continue;
-            if (ifa->ifa_addr->sa_family != AF_INET6)
-                continue;
-            getnameinfo(ifa->ifa_addr, sizeof(struct sockaddr_in6), addr,
-                    sizeof(addr), NULL, 0, NI_NUMERICHOST);
-            if((strncmp(addr + (strlen(addr) - 3), "::1", 3) == 0)){
-                address_flag = 1;
-                break;
-            }
-        }//for loop
-        freeifaddrs(ifap);
-    }//getifaddr close
-
-    if(address_flag == 0) {
-        return -1;
-    }
-    /* Check Duplicate Address Detection (DAD) status. The way it works is that
-       after an address is added to an interface, the operating system uses the
-       Neighbor Discovery Protocol to check if any other host on the network
-       has the same address. The whole process will take around 3 to 4 seconds
-       to complete. Also we need to check and ensure that the gateway has
-       a valid default route entry.
-    */
-    for(i=0; i<15; i++) {
-        buffer[0] = '\0';
-        if(dad_flag == 0) {
-            if ((fp_dad = popen("ip address show dev brlan0 tentative", "r"))) {
-                if(fp_dad != NULL) {
-                    fgets(buffer, BUFLEN_256, fp_dad);
-                    if(strlen(buffer) == 0 ) {
-                        dad_flag = 1;
-                    }
-                    pclose(fp_dad);
-                }
-            }
-        }
-
-        if(route_flag == 0) {
-            buffer[0] = '\0';
-            if ((fp_route = popen("ip -6 ro | grep default", "r"))) {
-                if(fp_route != NULL) {
-                    fgets(buffer, BUFLEN_256, fp_route);
-                    if(strlen(buffer) > 0 ) {
-                        route_flag = 1;
-                    }
-                    pclose(fp_route);
-                }
-            }
+    for (idx = 0; WanMgr_Netlink_GetIfAddr6(ETH_BRIDGE_NAME, idx, &addr6) == ANSC_STATUS_SUCCESS; idx++)
+    {
+        if (addr6.ifaFlags & IFA_F_TENTATIVE)
+        {
+            return -1;
         }
 
-        if(dad_flag == 0 || route_flag == 0) {
-            sleep(1);
+        inet_ntop(AF_INET6, &addr6.addr, addr, sizeof(addr));
+        if (addr6.scope == RT_SCOPE_UNIVERSE && strlen(addr) > 3 && strcmp(addr + strlen(addr) - 3, "::1") == 0)
+        {
+            address_flag = 1;
         }
-        else {
-            break;
-       }
     }
 
-    if(dad_flag == 0 || route_flag == 0) {
+    if(address_flag == 0) {
         return -1;
     }
 
@@ -628,7 +834,7 @@ static int setUpLanPrefixIPv6(DML_WAN_IFACE* pIfaceData)
 }
 
 
-static int wan_setUpIPv4(DML_WAN_IFACE* pInterface)
+static int wan_setUpIPv4(DML_WAN_IFACE* pInterface, DML_WAN_POLICY wanPolicy)
 {
     int ret = RETURN_OK;
     char cmdStr[BUFLEN_128 + IP_ADDR_LENGTH] = {0};
@@ -642,11 +848,9 @@ static int wan_setUpIPv4(DML_WAN_IFACE* pInterface)
         CcspTraceError(("%s %d - Invalid memory \n", __FUNCTION__, __LINE__));
         return RETURN_ERR;
     }
-    if (RETURN_OK == wan_updateDNS(pInterface, TRUE, (pInterface->IP.Ipv6Status == WAN_IFACE_IPV6_STATE_UP)))
+    if (RETURN_OK == wan_updateDNS(pInterface, TRUE, (pInterface->IP.Ipv6Status == WAN_IFACE_IPV6_STATE_UP), wanPolicy))
     {
         CcspTraceInfo(("%s %d -  IPv4 DNS servers configures successfully \n", __FUNCTION__, __LINE__));
-        /* DHCP restart triggered. */
-        sysevent_set(sysevent_fd, sysevent_token, SYSEVENT_DHCP_SERVER_RESTART, NULL, 0);
     }
     else
     {
@@ -656,7 +860,7 @@ static int wan_setUpIPv4(DML_WAN_IFACE* pInterface)
     /** Setup IPv4: such as
      * "ifconfig eth0 10.6.33.165 netmask 255.255.255.192 broadcast 10.6.33.191 up"
      */
-    if (WanManager_GetBCastFromIpSubnetMask(pInterface->IP.Ipv4Data.ip, pInterface->IP.Ipv4Data.mask, bCastStr) != RETURN_OK)
+    if (WanManager_GetBCastFromIpv4Data(&pInterface->IP.Ipv4Data, bCastStr, sizeof(bCastStr)) != RETURN_OK)
     {
         CcspTraceError((" %s %d - bad address %s/%s \n",__FUNCTION__,__LINE__, pInterface->IP.Ipv4Data.ip, pInterface->IP.Ipv4Data.mask));
         return RETURN_ERR;
@@ -679,8 +883,9 @@ static int wan_setUpIPv4(DML_WAN_IFACE* pInterface)
         }
     }
 
-    /** Set default gatway. */
-    if (WanManager_AddDefaultGatewayRoute(&pInterface->IP.Ipv4Data) != RETURN_OK)
+    /** Set default gatway. In MULTIWAN_MODE the policy owns the default route. */
+    if (wanPolicy != MULTIWAN_MODE &&
+        WanManager_AddDefaultGatewayRoute(&pInterface->IP.Ipv4Data) != RETURN_OK)
     {
         CcspTraceError(("%s %d - Failed to set up default system gateway", __FUNCTION__, __LINE__));
     }
@@ -723,15 +928,47 @@ static int wan_setUpIPv4(DML_WAN_IFACE* pInterface)
     }
 
     /* Firewall restart. */
-    sysevent_set(sysevent_fd, sysevent_token, SYSEVENT_FIREWALL_RESTART, NULL, 0);
+    wanmgr_sysevents_scheduleRestart(WANMGR_RESTART_FIREWALL);
     return ret;
 }
 
 
-static int wan_tearDownIPv4(DML_WAN_IFACE* pInterface)
+/* Another WAN that still has IPv4 up, the caller holds the interface data lock */
+static BOOL wan_findOtherIPv4Wan(DML_WAN_IFACE* pInterface, char *pIpAddr, char *pMask, size_t len)
+{
+    WanMgr_IfaceCtrl_Data_t* pWanIfaceCtrl = WanMgr_GetIfaceCtrl_locked();
+    BOOL bFound = FALSE;
+    UINT uiIndex;
+
+    if (pWanIfaceCtrl == NULL)
+    {
+        return FALSE;
+    }
+
+    for (uiIndex = 0; uiIndex < pWanIfaceCtrl->ulTotalNumbWanInterfaces; uiIndex++)
+    {
+        DML_WAN_IFACE* pOther = &(pWanIfaceCtrl->pIface[uiIndex].data);
+
+        if (pOther->uiIfaceIdx != pInterface->uiIfaceIdx && pOther->Wan.ActiveLink == TRUE &&
+            pOther->IP.Ipv4Status == WAN_IFACE_IPV4_STATE_UP)
+        {
+            snprintf(pIpAddr, len, "%s", pOther->IP.Ipv4Data.ip);
+            snprintf(pMask, len, "%s", pOther->IP.Ipv4Data.mask);
+            bFound = TRUE;
+            break;
+        }
+    }
+
+    WanMgrDml_GetIfaceCtrl_release(pWanIfaceCtrl);
+    return bFound;
+}
+
+static int wan_tearDownIPv4(DML_WAN_IFACE* pInterface, DML_WAN_POLICY wanPolicy)
 {
     int ret = RETURN_OK;
     char cmdStr[BUFLEN_64] = {0};
+    char otherIpAddr[IP_ADDR_LENGTH] = {0};
+    char otherMask[IP_ADDR_LENGTH] = {0};
 
     if (pInterface == NULL)
     {
@@ -740,11 +977,9 @@ static int wan_tearDownIPv4(DML_WAN_IFACE* pInterface)
     }
 
     /** Reset IPv4 DNS configuration. */
-    if (RETURN_OK == wan_updateDNS(pInterface, FALSE, (pInterface->IP.Ipv6Status == WAN_IFACE_IPV6_STATE_UP)))
+    if (RETURN_OK == wan_updateDNS(pInterface, FALSE, (pInterface->IP.Ipv6Status == WAN_IFACE_IPV6_STATE_UP), wanPolicy))
     {
         CcspTraceInfo(("%s %d -  IPv4 DNS servers unconfig successfully \n", __FUNCTION__, __LINE__));
-        /* DHCP restart trigger. */
-        sysevent_set(sysevent_fd, sysevent_token, SYSEVENT_DHCP_SERVER_RESTART, NULL, 0);
     }
     else
     {
@@ -763,6 +998,17 @@ static int wan_tearDownIPv4(DML_WAN_IFACE* pInterface)
         ret = RETURN_ERR;
     }
 
+    /* In MULTIWAN_MODE the global WAN state follows a WAN that is still up */
+    if (wanPolicy == MULTIWAN_MODE &&
+        wan_findOtherIPv4Wan(pInterface, otherIpAddr, otherMask, sizeof(otherIpAddr)) == TRUE)
+    {
+        CcspTraceInfo(("%s %d - %s down, WAN address moves to %s \n", __FUNCTION__, __LINE__, pInterface->Wan.Name, otherIpAddr));
+        sysevent_set(sysevent_fd, sysevent_token, SYSEVENT_CURRENT_WAN_IPADDR, otherIpAddr, 0);
+        sysevent_set(sysevent_fd, sysevent_token, SYSEVENT_CURRENT_WAN_SUBNET, otherMask, 0);
+        wanmgr_sysevents_scheduleRestart(WANMGR_RESTART_FIREWALL);
+        return ret;
+    }
+
     /* ReSet the required sysevents. */
     sysevent_set(sysevent_fd, sysevent_token, SYSEVENT_IPV4_CONNECTION_STATE, WAN_STATUS_DOWN, 0);
     sysevent_set(sysevent_fd, sysevent_token, SYSEVENT_CURRENT_IPV4_LINK_STATE, WAN_STATUS_DOWN, 0);
@@ -770,7 +1016,7 @@ static int wan_tearDownIPv4(DML_WAN_IFACE* pInterface)
     sysevent_set(sysevent_fd, sysevent_token, SYSEVENT_WAN_START_TIME, "0", 0);
     sysevent_set(sysevent_fd, sysevent_token, SYSEVENT_CURRENT_WAN_IPADDR, "0.0.0.0", 0);
     sysevent_set(sysevent_fd, sysevent_token, SYSEVENT_CURRENT_WAN_SUBNET, "255.255.255.0", 0);
-    sysevent_set(sysevent_fd, sysevent_token, SYSEVENT_FIREWALL_RESTART, NULL, 0);
+    wanmgr_sysevents_scheduleRestart(WANMGR_RESTART_FIREWALL);
     if (strstr(pInterface->Phy.Path, "Ethernet"))
     {
         sysevent_set(sysevent_fd, sysevent_token, SYSEVENT_ETHWAN_INITIALIZED, "0", 0);
@@ -786,7 +1032,7 @@ static int wan_tearDownIPv4(DML_WAN_IFACE* pInterface)
 }
 
 
-static int wan_setUpIPv6(DML_WAN_IFACE* pInterface)
+static int wan_setUpIPv6(DML_WAN_IFACE* pInterface, DML_WAN_POLICY wanPolicy)
 {
     int ret = RETURN_OK;
 
@@ -797,11 +1043,9 @@ static int wan_setUpIPv6(DML_WAN_IFACE* pInterface)
     }
 
     /** Reset IPv6 DNS configuration. */
-    if (RETURN_OK == wan_updateDNS(pInterface, (pInterface->IP.Ipv4Status == WAN_IFACE_IPV4_STATE_UP), TRUE))
+    if (RETURN_OK == wan_updateDNS(pInterface, (pInterface->IP.Ipv4Status == WAN_IFACE_IPV4_STATE_UP), TRUE, wanPolicy))
     {
         CcspTraceInfo(("%s %d -  IPv6 DNS servers configured successfully \n", __FUNCTION__, __LINE__));
-        /* DHCP restart trigger. */
-        sysevent_set(sysevent_fd, sysevent_token, SYSEVENT_DHCP_SERVER_RESTART, NULL, 0);
     }
     else
     {
@@ -811,8 +1055,8 @@ static int wan_setUpIPv6(DML_WAN_IFACE* pInterface)
 
     sysevent_set(sysevent_fd, sysevent_token, SYSEVENT_IPV6_CONNECTION_STATE, WAN_STATUS_UP, 0);
     sysevent_set(sysevent_fd, sysevent_token, SYSEVENT_RADVD_RESTART, NULL, 0);
-    sysevent_set(sysevent_fd, sysevent_token, SYSEVENT_DHCP_SERVER_RESTART, NULL, 0);
-    sysevent_set(sysevent_fd, sysevent_token, SYSEVENT_FIREWALL_RESTART, NULL, 0);
+    wanmgr_sysevents_scheduleRestart(WANMGR_RESTART_DHCP_SERVER);
+    wanmgr_sysevents_scheduleRestart(WANMGR_RESTART_FIREWALL);
 
     if (pInterface->IP.Ipv4Status == WAN_IFACE_IPV4_STATE_DOWN)
     {
@@ -823,7 +1067,7 @@ static int wan_setUpIPv6(DML_WAN_IFACE* pInterface)
     return ret;
 }
 
-static int wan_tearDownIPv6(DML_WAN_IFACE* pInterface)
+static int wan_tearDownIPv6(DML_WAN_IFACE* pInterface, DML_WAN_POLICY wanPolicy)
 {
     int ret = RETURN_OK;
 
@@ -834,11 +1078,9 @@ static int wan_tearDownIPv6(DML_WAN_IFACE* pInterface)
     }
 
     /** Reset IPv6 DNS configuration. */
-    if (RETURN_OK == wan_updateDNS(pInterface, (pInterface->IP.Ipv4Status == WAN_IFACE_IPV4_STATE_UP), FALSE))
+    if (RETURN_OK == wan_updateDNS(pInterface, (pInterface->IP.Ipv4Status == WAN_IFACE_IPV4_STATE_UP), FALSE, wanPolicy))
     {
         CcspTraceInfo(("%s %d -  IPv6 DNS servers unconfig successfully \n", __FUNCTION__, __LINE__));
-        /* DHCP restart trigger. */
-        sysevent_set(sysevent_fd, sysevent_token, SYSEVENT_DHCP_SERVER_RESTART, NULL, 0);
     }
     else
     {
@@ -868,7 +1110,7 @@ static int wan_tearDownIPv6(DML_WAN_IFACE* pInterface)
     sysevent_set(sysevent_fd, sysevent_token, SYSEVENT_FIELD_IPV6_PREFIX, "", 0);
     sysevent_set(sysevent_fd, sysevent_token, SYSEVENT_FIELD_TR_EROUTER_DHCPV6_CLIENT_PREFIX, "", 0);
     sysevent_set(sysevent_fd, sysevent_token, SYSEVENT_IPV6_CONNECTION_STATE, WAN_STATUS_DOWN, 0);
-    sysevent_set(sysevent_fd, sysevent_token, SYSEVENT_FIREWALL_RESTART, NULL, 0);
+    wanmgr_sysevents_scheduleRestart(WANMGR_RESTART_FIREWALL);
 
     if (pInterface->IP.Ipv4Status == WAN_IFACE_IPV4_STATE_DOWN)
     {
@@ -965,29 +1207,40 @@ static eWanState_t wan_transition_physical_interface_down(WanMgr_IfaceSM_Control
 
     DML_WAN_IFACE* pInterface = pWanIfaceCtrl->pIfaceData;
 
+    if (pWanIfaceCtrl->ValidationActive == TRUE)
+    {
+        WanMgr_Validation_Stop(pInterface->Wan.Name);
+        pWanIfaceCtrl->ValidationActive = FALSE;
+    }
+
     if(pInterface->PPP.Enable == FALSE)
     {
         /* Stops DHCPv4 client */
-        WanManager_StopDhcpv4Client(TRUE); // release dhcp lease
+        WanManager_StopDhcpv4Client(pInterface->Wan.Name, TRUE); // release dhcp lease
 
         /* Stops DHCPv6 client */
-        WanManager_StopDhcpv6Client(TRUE); // release dhcp lease
+        WanManager_StopDhcpv6Client(pInterface->Wan.Name, TRUE); // release dhcp lease
 
 #ifdef FEATURE_IPOE_HEALTH_CHECK
-        if (pWanIfaceCtrl->IhcPid > 0)
+        if (pWanIfaceCtrl->IhcActive == TRUE)
         {
-            if (WanManager_StopIpoeHealthCheckService(pWanIfaceCtrl->IhcPid) == ANSC_STATUS_FAILURE)
+            if (WanMgr_IpoeHc_Stop(pInterface->Wan.Name) != ANSC_STATUS_SUCCESS)
             {
-                CcspTraceError(("%s %d - Failed to kill IHC process interface %s \n", __FUNCTION__, __LINE__, pInterface->Wan.Name));
+                CcspTraceError(("%s %d - Failed to stop IPoE Health Check on interface %s \n", __FUNCTION__, __LINE__, pInterface->Wan.Name));
             }
-            pWanIfaceCtrl->IhcPid = 0;
+            pWanIfaceCtrl->IhcActive = FALSE;
         }
 #endif  // FEATURE_IPOE_HEALTH_CHECK
+        if (pWanIfaceCtrl->ProbeActive == TRUE)
+        {
+            WanMgr_Probe_Stop(pInterface->Wan.Name);
+            pWanIfaceCtrl->ProbeActive = FALSE;
+        }
     }
     else
     {
         /* Stops DHCPv6 client */
-        WanManager_StopDhcpv6Client(TRUE); // release dhcp lease
+        WanManager_StopDhcpv6Client(pInterface->Wan.Name, TRUE); // release dhcp lease
 
         /* Delete PPP session */
         WanManager_DeletePPPSession(pInterface);
@@ -1011,13 +1264,12 @@ static eWanState_t wan_transition_wan_up(WanMgr_IfaceSM_Controller_t* pWanIfaceC
 
 
     pInterface->Wan.Status = WAN_IFACE_STATUS_VALIDATING;
+    pInterface->Wan.ValidationFailed = FALSE;
 
+    /* Runs the validation checks set in the Wan.Validation flags on the event loop,
+    the state machine is woken when a result is known */
+    pWanIfaceCtrl->ValidationActive = wan_startValidation(pInterface, pWanIfaceCtrl->WakeFd);
 
-    /* TODO: Runs WAN Validation processes based on the Wan.Validation flags,
-    e.g. if Wan.Validation.Discovery-Offer is set to TRUE, a threaded
-    process will be started to run the DHCPv4 Discovery-Offer validation.
-    The results of each validation process will be stored internally
-    to the state machine (i.e. not expressed in the data model */
     if(pInterface->Wan.ActiveLink == TRUE)
     {
         WanMgr_UpdatePlatformStatus(WANMGR_CONNECTING);
@@ -1048,12 +1300,10 @@ static eWanState_t wan_transition_wan_validated(WanMgr_IfaceSM_Controller_t* pWa
 #ifdef FEATURE_IPOE_HEALTH_CHECK
         if (pInterface->Wan.ActiveLink == TRUE)
         {
-            UINT IhcPid = 0;
-            IhcPid = WanManager_StartIpoeHealthCheckService(pInterface->Wan.Name);
-            if (IhcPid > 0)
+            if (WanMgr_IpoeHc_Start(pInterface->Wan.Name) == ANSC_STATUS_SUCCESS)
             {
-                pWanIfaceCtrl->IhcPid = IhcPid;
-                CcspTraceError(("%s %d - Starting IPoE Health Check pid - %u for interface %s \n", __FUNCTION__, __LINE__, pWanIfaceCtrl->IhcPid, pInterface->Wan.Name));
+                pWanIfaceCtrl->IhcActive = TRUE;
+                CcspTraceInfo(("%s %d - Starting IPoE Health Check for interface %s \n", __FUNCTION__, __LINE__, pInterface->Wan.Name));
             }
             else
             {
@@ -1061,9 +1311,14 @@ static eWanState_t wan_transition_wan_validated(WanMgr_IfaceSM_Controller_t* pWa
             }
         }
 #endif // FEATURE_IPOE_HEALTH_CHECK
+        if (pInterface->Wan.ActiveLink == TRUE)
+        {
+            pWanIfaceCtrl->ProbeActive = wan_startProbes(pInterface);
+        }
+
         /* Start DHCPv4 client */
         CcspTraceInfo(("%s %d - Staring udhcpc on interface %s \n", __FUNCTION__, __LINE__, pInterface->Wan.Name));
-        uint32_t pid = WanManager_StartDhcpv4Client(pInterface->Wan.Name, FALSE);
+        pInterface->IP.Dhcp4cPid = WanManager_StartDhcpv4Client(pInterface->Wan.Name, FALSE);
 
         /* Start DHCPv6 Client */
         CcspTraceInfo(("%s %d - Staring dibbler-client on interface %s \n", __FUNCTION__, __LINE__, pInterface->Wan.Name));
@@ -1095,15 +1350,15 @@ static eWanState_t wan_transition_refreshing_wan(WanMgr_IfaceSM_Controller_t* pW
     if(pInterface->PPP.Enable == FALSE)
     {
         /* Stops DHCPv4 client */
-        WanManager_StopDhcpv4Client(TRUE); // release dhcp lease
+        WanManager_StopDhcpv4Client(pInterface->Wan.Name, TRUE); // release dhcp lease
 
         /* Stops DHCPv6 client */
-        WanManager_StopDhcpv6Client(TRUE); // release dhcp lease
+        WanManager_StopDhcpv6Client(pInterface->Wan.Name, TRUE); // release dhcp lease
     }
     else
     {
         /* Stops DHCPv6 client */
-        WanManager_StopDhcpv6Client(TRUE); // release dhcp lease
+        WanManager_StopDhcpv6Client(pInterface->Wan.Name, TRUE); // release dhcp lease
 
         /* Delete PPP session */
         WanManager_DeletePPPSession(pInterface);
@@ -1141,8 +1396,8 @@ static eWanState_t wan_transition_wan_refreshed(WanMgr_IfaceSM_Controller_t* pWa
         /* Start dhcp clients */
         /* DHCPv4 client */
         CcspTraceInfo(("%s %d - Staring dhcpc on interface %s \n", __FUNCTION__, __LINE__, pInterface->Wan.Name));
-        uint32_t pid = WanManager_StartDhcpv4Client(pInterface->Wan.Name, FALSE);
-        CcspTraceInfo(("%s %d - Started dhcpc on interface %s, pid %d \n", __FUNCTION__, __LINE__, pInterface->Wan.Name, pid));
+        pInterface->IP.Dhcp4cPid = WanManager_StartDhcpv4Client(pInterface->Wan.Name, FALSE);
+        CcspTraceInfo(("%s %d - Started dhcpc on interface %s, pid %d \n", __FUNCTION__, __LINE__, pInterface->Wan.Name, pInterface->IP.Dhcp4cPid));
 
         /* DHCPv6 Client */
         if (RETURN_OK != WanManager_StartDhcpv6Client(pInterface->Wan.Name, FALSE))
@@ -1175,18 +1430,22 @@ static eWanState_t wan_transition_ipv4_up(WanMgr_IfaceSM_Controller_t* pWanIface
     if(pInterface->Wan.ActiveLink == TRUE )
     {
         /* Configure IPv4. */
-        ret = wan_setUpIPv4(pInterface);
+        ret = wan_setUpIPv4(pInterface, pWanIfaceCtrl->WanPolicy);
         if (ret != RETURN_OK)
         {
             CcspTraceError(("%s %d - Failed to configure IPv4 successfully \n", __FUNCTION__, __LINE__));
         }
 
 #ifdef FEATURE_IPOE_HEALTH_CHECK
-        if ((pInterface->PPP.Enable == FALSE) && (pWanIfaceCtrl->IhcPid > 0))
+        if ((pInterface->PPP.Enable == FALSE) && (pWanIfaceCtrl->IhcActive == TRUE))
         {
-            WanMgr_SendMsgToIHC(IPOE_MSG_WAN_CONNECTION_UP, pInterface->Wan.Name);
+            wan_startIpoeHealthCheckIPv4(pInterface);
         }
 #endif
+        if ((pInterface->PPP.Enable == FALSE) && (pWanIfaceCtrl->ProbeActive == TRUE))
+        {
+            wan_startProbesIPv4(pInterface);
+        }
     }
 
     /* Force reset ipv4 state global flag. */
@@ -1199,7 +1458,7 @@ static eWanState_t wan_transition_ipv4_up(WanMgr_IfaceSM_Controller_t* pWanIface
     if (strcmp(buf, WAN_STATUS_STARTED))
     {
         sysevent_set(sysevent_fd, sysevent_token, SYSEVENT_WAN_SERVICE_STATUS, WAN_STATUS_STARTED, 0);
-        sysevent_set(sysevent_fd, sysevent_token, SYSEVENT_FIREWALL_RESTART, NULL, 0);
+        wanmgr_sysevents_scheduleRestart(WANMGR_RESTART_FIREWALL);
     }
 
     memset(buf, 0, BUFLEN_128);
@@ -1237,18 +1496,22 @@ static eWanState_t wan_transition_ipv4_down(WanMgr_IfaceSM_Controller_t* pWanIfa
 
     DML_WAN_IFACE* pInterface = pWanIfaceCtrl->pIfaceData;
 
-    if (wan_tearDownIPv4(pInterface) != RETURN_OK)
+    if (wan_tearDownIPv4(pInterface, pWanIfaceCtrl->WanPolicy) != RETURN_OK)
     {
         CcspTraceError(("%s %d - Failed to tear down IPv4 for %s \n", __FUNCTION__, __LINE__, pInterface->Wan.Name));
     }
 
     WanManager_UpdateInterfaceStatus(pInterface, WANMGR_IFACE_CONNECTION_DOWN);
 #ifdef FEATURE_IPOE_HEALTH_CHECK
-    if((pInterface->Wan.ActiveLink == TRUE) && (pInterface->PPP.Enable == FALSE) && (pWanIfaceCtrl->IhcPid > 0))
+    if((pInterface->Wan.ActiveLink == TRUE) && (pInterface->PPP.Enable == FALSE) && (pWanIfaceCtrl->IhcActive == TRUE))
     {
-        WanMgr_SendMsgToIHC(IPOE_MSG_WAN_CONNECTION_DOWN, pInterface->Wan.Name);
+        WanMgr_IpoeHc_SetIpv4(pInterface->Wan.Name, FALSE, NULL, NULL);
     }
 #endif
+    if ((pInterface->PPP.Enable == FALSE) && (pWanIfaceCtrl->ProbeActive == TRUE))
+    {
+        WanMgr_Probe_SetIpv4(pInterface->Wan.Name, FALSE, NULL, NULL, NULL);
+    }
 
     sysevent_get(sysevent_fd, sysevent_token, SYSEVENT_IPV6_CONNECTION_STATE, buf, sizeof(buf));
 
@@ -1287,17 +1550,21 @@ static eWanState_t wan_transition_ipv6_up(WanMgr_IfaceSM_Controller_t* pWanIface
     if(pInterface->Wan.ActiveLink == TRUE )
     {
         /* Configure IPv6. */
-        ret = wan_setUpIPv6(pInterface);
+        ret = wan_setUpIPv6(pInterface, pWanIfaceCtrl->WanPolicy);
         if (ret != RETURN_OK)
         {
             CcspTraceError(("%s %d - Failed to configure IPv6 successfully \n", __FUNCTION__, __LINE__));
         }
 #ifdef FEATURE_IPOE_HEALTH_CHECK
-        if ((pInterface->PPP.Enable == FALSE) && (pWanIfaceCtrl->IhcPid > 0))
+        if ((pInterface->PPP.Enable == FALSE) && (pWanIfaceCtrl->IhcActive == TRUE))
         {
-            WanMgr_SendMsgToIHC(IPOE_MSG_WAN_CONNECTION_IPV6_UP, pInterface->Wan.Name);
+            wan_startIpoeHealthCheckIPv6(pInterface);
         }
 #endif
+        if ((pInterface->PPP.Enable == FALSE) && (pWanIfaceCtrl->ProbeActive == TRUE))
+        {
+            wan_startProbesIPv6(pInterface);
+        }
     }
 
     pInterface->IP.Ipv6Changed = FALSE;
@@ -1307,7 +1574,7 @@ static eWanState_t wan_transition_ipv6_up(WanMgr_IfaceSM_Controller_t* pWanIface
     if (strcmp(buf, WAN_STATUS_STARTED))
     {
         sysevent_set(sysevent_fd, sysevent_token, SYSEVENT_WAN_SERVICE_STATUS, WAN_STATUS_STARTED, 0);
-        sysevent_set(sysevent_fd, sysevent_token, SYSEVENT_FIREWALL_RESTART, NULL, 0);
+        wanmgr_sysevents_scheduleRestart(WANMGR_RESTART_FIREWALL);
     }
 
     memset(buf, 0, BUFLEN_128);
@@ -1344,7 +1611,7 @@ static eWanState_t wan_transition_ipv6_down(WanMgr_IfaceSM_Controller_t* pWanIfa
 
     DML_WAN_IFACE* pInterface = pWanIfaceCtrl->pIfaceData;
 
-    if (wan_tearDownIPv6(pInterface) != RETURN_OK)
+    if (wan_tearDownIPv6(pInterface, pWanIfaceCtrl->WanPolicy) != RETURN_OK)
     {
         CcspTraceError(("%s %d - Failed to tear down IPv6 for %s \n", __FUNCTION__, __LINE__, pInterface->Wan.Name));
     }
@@ -1352,11 +1619,15 @@ static eWanState_t wan_transition_ipv6_down(WanMgr_IfaceSM_Controller_t* pWanIfa
     WanManager_UpdateInterfaceStatus(pInterface, WANMGR_IFACE_CONNECTION_IPV6_DOWN);
 
 #ifdef FEATURE_IPOE_HEALTH_CHECK
-    if ((pInterface->Wan.ActiveLink == TRUE) && (pInterface->PPP.Enable == FALSE) && (pWanIfaceCtrl->IhcPid > 0))
+    if ((pInterface->Wan.ActiveLink == TRUE) && (pInterface->PPP.Enable == FALSE) && (pWanIfaceCtrl->IhcActive == TRUE))
     {
-        WanMgr_SendMsgToIHC(IPOE_MSG_WAN_CONNECTION_IPV6_DOWN, pInterface->Wan.Name);
+        WanMgr_IpoeHc_SetIpv6(pInterface->Wan.Name, FALSE, NULL);
     }
 #endif
+    if ((pInterface->PPP.Enable == FALSE) && (pWanIfaceCtrl->ProbeActive == TRUE))
+    {
+        WanMgr_Probe_SetIpv6(pInterface->Wan.Name, FALSE, NULL, NULL);
+    }
 
     sysevent_get(sysevent_fd, sysevent_token, SYSEVENT_IPV4_CONNECTION_STATE, buf, sizeof(buf));
 
@@ -1476,12 +1747,42 @@ static eWanState_t wan_state_validating_wan(WanMgr_IfaceSM_Controller_t* pWanIfa
 
     if (pInterface->Wan.LinkStatus ==  WAN_IFACE_LINKSTATUS_CONFIGURING )
     {
-        /* TODO: We'll need to call a transition that stops any running validation
-        processes before returning to the CONFIGURING WAN state */
+        /* Validation is run again once the link is back up */
+        if (pWanIfaceCtrl->ValidationActive == TRUE)
+        {
+            WanMgr_Validation_Stop(pInterface->Wan.Name);
+            pWanIfaceCtrl->ValidationActive = FALSE;
+        }
         return WAN_STATE_CONFIGURING_WAN;
     }
 
-    /* TODO: Waits for every running validation process to complete, then checks the results */
+    if (pWanIfaceCtrl->ValidationActive == TRUE)
+    {
+        switch (WanMgr_Validation_GetResult(pInterface->Wan.Name))
+        {
+            case WANMGR_VALIDATION_PENDING:
+                return WAN_STATE_VALIDATING_WAN;
+
+            case WANMGR_VALIDATION_FAILED:
+                /* No DHCP server on the link yet. The policy is told so it can
+                fail over, this interface keeps validating until it is deselected */
+                CcspTraceWarning(("%s %d - Interface '%s' - validation failed, retrying\n", __FUNCTION__, __LINE__, pInterface->Name));
+                pInterface->Wan.ValidationFailed = TRUE;
+                WanMgr_Validation_Stop(pInterface->Wan.Name);
+                pWanIfaceCtrl->ValidationActive = wan_startValidation(pInterface, pWanIfaceCtrl->WakeFd);
+                if (pWanIfaceCtrl->ValidationActive == TRUE)
+                {
+                    return WAN_STATE_VALIDATING_WAN;
+                }
+                break;
+
+            case WANMGR_VALIDATION_PASSED:
+                WanMgr_Validation_Stop(pInterface->Wan.Name);
+                pWanIfaceCtrl->ValidationActive = FALSE;
+                pInterface->Wan.ValidationFailed = FALSE;
+                break;
+        }
+    }
 
     return wan_transition_wan_validated(pWanIfaceCtrl);
 }
@@ -1511,7 +1812,9 @@ static eWanState_t wan_state_obtaining_ip_addresses(WanMgr_IfaceSM_Controller_t*
 
     if (pInterface->IP.Ipv4Status == WAN_IFACE_IPV4_STATE_UP)
     {
-        return wan_transition_ipv4_up(pWanIfaceCtrl);
+        /* IPv6 carries on in the same pass, it does not wait a loop behind IPv4 */
+        eWanState_t state = wan_transition_ipv4_up(pWanIfaceCtrl);
+        return (state == WAN_STATE_IPV4_LEASED) ? wan_state_ipv4_leased(pWanIfaceCtrl) : state;
     }
     else if (pInterface->IP.Ipv6Status == WAN_IFACE_IPV6_STATE_UP)
     {
@@ -1743,6 +2046,13 @@ static eWanState_t wan_state_exit(WanMgr_IfaceSM_Controller_t* pWanIfaceCtrl)
         return ANSC_STATUS_FAILURE;
     }
 
+    //Stop validation while the name is still known
+    if (pWanIfaceCtrl->ValidationActive == TRUE)
+    {
+        WanMgr_Validation_Stop(pWanIfaceCtrl->pIfaceData->Wan.Name);
+        pWanIfaceCtrl->ValidationActive = FALSE;
+    }
+
     //Clear WAN Name
     memset(pWanIfaceCtrl->pIfaceData->Wan.Name, 0, sizeof(pWanIfaceCtrl->pIfaceData->Wan.Name));
 
@@ -1777,6 +2087,18 @@ ANSC_STATUS WanMgr_InterfaceSMThread_Finalise(void)
 }
 
 
+/* Marks whether a state machine thread runs on the interface, the policies
+check this to know when a WAN they released has been torn down */
+static void WanMgr_InterfaceSMThread_SetRunning(INT iface_idx, BOOL bRunning)
+{
+    WanMgr_Iface_Data_t* pWanDmlIfaceData = WanMgr_GetIfaceData_locked(iface_idx);
+    if(pWanDmlIfaceData != NULL)
+    {
+        pWanDmlIfaceData->SMRunning = bRunning;
+        WanMgrDml_GetIfaceData_release(pWanDmlIfaceData);
+    }
+}
+
 static ANSC_STATUS WanMgr_IfaceIpcMsg_handle(WanMgr_IfaceSM_Controller_t* pWanIfaceCtrl)
 {
     if((pWanIfaceCtrl == NULL) || (pWanIfaceCtrl->pIfaceData == NULL))
@@ -1821,6 +2143,8 @@ static void* WanMgr_InterfaceSMThread( void *arg )
     // event handler
     int n = 0;
     struct timeval tv;
+    fd_set rfds;
+    uint64_t wakeups;
 
 
     //detach thread from caller stack
@@ -1834,9 +2158,17 @@ static void* WanMgr_InterfaceSMThread( void *arg )
     if(WanMgr_InterfaceSMThread_Init(pWanIfaceCtrl) != ANSC_STATUS_SUCCESS)
     {
         CcspTraceError(("%s %d Policy Controller Error \n", __FUNCTION__, __LINE__));
+        WanMgr_InterfaceSMThread_SetRunning(pWanIfaceCtrl->interfaceIdx, FALSE);
         return ANSC_STATUS_FAILURE;
     }
 
+    //Woken before the loop timeout by the validation checks
+    pWanIfaceCtrl->WakeFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (pWanIfaceCtrl->WakeFd < 0)
+    {
+        CcspTraceWarning(("%s %d - eventfd failed, polling only\n", __FUNCTION__, __LINE__));
+    }
+
     //Transition Start
     pWanDmlIfaceData = WanMgr_GetIfaceData_locked(pWanIfaceCtrl->interfaceIdx);
     if(pWanDmlIfaceData != NULL)
@@ -1854,16 +2186,26 @@ static void* WanMgr_InterfaceSMThread( void *arg )
     {
         pWanIfaceCtrl->pIfaceData = NULL;
 
-        /* Wait up to 500 milliseconds */
+        /* Wait up to 500 milliseconds, or until woken */
         tv.tv_sec = 0;
         tv.tv_usec = LOOP_TIMEOUT;
 
-        n = select(0, NULL, NULL, NULL, &tv);
+        FD_ZERO(&rfds);
+        if (pWanIfaceCtrl->WakeFd >= 0)
+        {
+            FD_SET(pWanIfaceCtrl->WakeFd, &rfds);
+        }
+
+        n = select(pWanIfaceCtrl->WakeFd + 1, &rfds, NULL, NULL, &tv);
         if (n < 0)
         {
             /* interrupted by signal or something, continue */
             continue;
         }
+        if (n > 0 && read(pWanIfaceCtrl->WakeFd, &wakeups, sizeof(wakeups)) < 0)
+        {
+            CcspTraceWarning(("%s %d - wake read failed\n", __FUNCTION__, __LINE__));
+        }
 
 
         //Update Wan config
@@ -1871,6 +2213,7 @@ static void* WanMgr_InterfaceSMThread( void *arg )
         if(pWanConfigData != NULL)
         {
             pWanIfaceCtrl->WanEnable = pWanConfigData->data.Enable;
+            pWanIfaceCtrl->WanPolicy = pWanConfigData->data.Policy;
 
             WanMgrDml_GetConfigData_release(pWanConfigData);
         }
@@ -1952,9 +2295,22 @@ static void* WanMgr_InterfaceSMThread( void *arg )
 
     WanMgr_InterfaceSMThread_Finalise();
 
+    //wan_state_exit() stopped validation, nothing writes to it any more.
+    //Should it still run, the fd is left open rather than reused under it
+    if (pWanIfaceCtrl->ValidationActive == TRUE)
+    {
+        CcspTraceWarning(("%s %d - validation still active, wake fd left open\n", __FUNCTION__, __LINE__));
+    }
+    else if (pWanIfaceCtrl->WakeFd >= 0)
+    {
+        close(pWanIfaceCtrl->WakeFd);
+    }
+
 
     CcspTraceInfo(("%s %d - Interface state machine (TID %lu) exiting for iface idx %d\n", __FUNCTION__, __LINE__, pthread_self(), pWanIfaceCtrl->interfaceIdx));
-    
+
+    WanMgr_InterfaceSMThread_SetRunning(pWanIfaceCtrl->interfaceIdx, FALSE);
+
     //Free current private resource before exit
     if(NULL != pWanIfaceCtrl)
     {
@@ -1986,12 +2342,17 @@ int WanMgr_StartInterfaceStateMachine(WanMgr_IfaceSM_Controller_t *wanIf)
 
     CcspTraceInfo (("%s %d - WAN interface data received in the state machine (iface idx %d) \n", __FUNCTION__, __LINE__, wanIfLocal->interfaceIdx));
 
+    //Marked before the thread starts, so it is never seen stopped while starting
+    WanMgr_InterfaceSMThread_SetRunning(wanIfLocal->interfaceIdx, TRUE);
+
     //Wanmanager state machine thread
     iErrorCode = pthread_create( &wanSmThreadId, NULL, &WanMgr_InterfaceSMThread, (void*)wanIfLocal );
 
     if( 0 != iErrorCode )
     {
         CcspTraceInfo(("%s %d - Failed to start WanManager State Machine Thread EC:%d\n", __FUNCTION__, __LINE__, iErrorCode ));
+        WanMgr_InterfaceSMThread_SetRunning(wanIfLocal->interfaceIdx, FALSE);
+        free(wanIfLocal);
     }
     else
     {
@@ -2006,10 +2367,14 @@ void WanMgr_IfaceSM_Init(WanMgr_IfaceSM_Controller_t* pWanIfaceSMCtrl, INT iface
     if(pWanIfaceSMCtrl != NULL)
     {
        pWanIfaceSMCtrl->WanEnable = FALSE;
+       pWanIfaceSMCtrl->WanPolicy = FIXED_MODE;
        pWanIfaceSMCtrl->interfaceIdx = iface_idx;
 #ifdef FEATURE_IPOE_HEALTH_CHECK
-       pWanIfaceSMCtrl->IhcPid = 0;
+       pWanIfaceSMCtrl->IhcActive = FALSE;
 #endif
+       pWanIfaceSMCtrl->ProbeActive = FALSE;
+       pWanIfaceSMCtrl->ValidationActive = FALSE;
+       pWanIfaceSMCtrl->WakeFd = -1;
        pWanIfaceSMCtrl->pIfaceData = NULL;
     }
 }
@@ -57,10 +57,14 @@ typedef enum
 typedef struct WanMgr_IfaceSM_Ctrl_st
 {
     BOOL                    WanEnable;
+    DML_WAN_POLICY          WanPolicy;
     INT                     interfaceIdx;
 #ifdef FEATURE_IPOE_HEALTH_CHECK
-    UINT                    IhcPid;
+    BOOL                    IhcActive;
 #endif
+    BOOL                    ProbeActive;
+    BOOL                    ValidationActive;
+    int                     WakeFd;         /* eventfd the state machine waits on between passes */
     DML_WAN_IFACE*          pIfaceData;
 } WanMgr_IfaceSM_Controller_t;
 
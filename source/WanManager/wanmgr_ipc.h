@@ -24,14 +24,35 @@
 #include "ansc_platform.h"
 #include "ipc_msg.h"
 
-
-#ifdef FEATURE_IPOE_HEALTH_CHECK
-ANSC_STATUS WanMgr_SendMsgToIHC (ipoe_msg_type_t msgType, char *ifName);
-#endif
+/* A stored IPv6 lease is followed by its MAP-T parameters, zeroed if none */
+#ifdef FEATURE_MAPT
+#define WANMGR_IPV6_MSG_SIZE    (sizeof(ipc_dhcpv6_data_t) + sizeof(Dhcp6cMAPTParametersMsgBody))
+#else
+#define WANMGR_IPV6_MSG_SIZE    sizeof(ipc_dhcpv6_data_t)
+#endif
 
 
 ANSC_STATUS WanMgr_StartIpcServer(); /*IPC server to handle WAN Manager clients*/
 ANSC_STATUS WanMgr_CloseIpcServer(void);
 
+/***************************************************************************
+ * @brief Process a DHCPv4 lease as received from a client over IPC, for
+ * clients running inside WAN Manager. Does not wait: while the interface
+ * state machine has not taken the previous lease the caller retries later.
+ * @param pNewIpv4Msg lease data, copied
+ * @return ANSC_STATUS_SUCCESS if handed over else ANSC_STATUS_FAILURE.
+ ****************************************************************************/
+ANSC_STATUS WanMgr_IpcTryNewIpv4Msg(ipc_dhcpv4_data_t* pNewIpv4Msg);
+
+/***************************************************************************
+ * @brief Process a DHCPv6 lease as received from a client over IPC, for
+ * clients running inside WAN Manager. Does not wait, as for IPv4.
+ * @param pNewIpv6Msg lease data, copied. With FEATURE_MAPT the MAP-T
+ * parameters may follow it in the same buffer.
+ * @param msgLen bytes at pNewIpv6Msg, up to WANMGR_IPV6_MSG_SIZE
+ * @return ANSC_STATUS_SUCCESS if handed over else returned error code.
+ ****************************************************************************/
+ANSC_STATUS WanMgr_IpcTryNewIpv6Msg(ipc_dhcpv6_data_t* pNewIpv6Msg, size_t msgLen);
+
 
 #endif /*_WANMGR_IPC_H_*/
@@ -0,0 +1,1027 @@
+/*
+ * If not stated otherwise in this file or this component's Licenses.txt file the
+ * following copyright and licenses apply:
+ *
+ * Copyright 2020 RDK Management
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+*/
+
+#ifdef FEATURE_IPOE_HEALTH_CHECK
+
+/* ---- Include Files ---------------------------------------- */
+#include <errno.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/timerfd.h>
+#include <net/if.h>
+#include <netinet/ip.h>
+#include <netinet/ip6.h>
+#include <netinet/udp.h>
+#include <linux/if_packet.h>
+#include <linux/if_ether.h>
+#include <linux/filter.h>
+#include <linux/rtnetlink.h>
+#include <sysevent/sysevent.h>
+#include "wanmgr_ipoe_hc.h"
+#include "wanmgr_event_loop.h"
+#include "wanmgr_netlink.h"
+#include "wanmgr_link_metrics.h"
+#include "wanmgr_data.h"
+#include "wanmgr_interface_sm.h"
+#include "wanmgr_net_utils.h"
+#include "wanmgr_dhcp_client.h"
+#include "wanmgr_sysevents.h"
+#include "wanmgr_utils.h"
+
+#define IHC_TICK_MS             50
+#define IHC_WHEEL_SLOTS         64      /* power of two */
+#define IHC_INTERVAL_TICKS      (WANMGR_IHC_TX_INTERVAL_MS / IHC_TICK_MS)
+#define IHC_ECHO_MAGIC          0x57484345  /* "WHCE" */
+#define IHC_SRC_PORT_BASE       49152       /* RFC 5881: echo source ports are in the dynamic range */
+#define IHC_PKT_MAX             128
+
+#define IHC_FAMILY_V4           0
+#define IHC_FAMILY_V6           1
+#define IHC_NUM_FAMILIES        2
+
+typedef enum
+{
+    IHC_ACTION_UP = 0,      /* first echo answered */
+    IHC_ACTION_RENEW,       /* echoes lost, ask the DHCP client to renew */
+    IHC_ACTION_FAIL         /* still lost after renewing, restart the DHCP client */
+} IhcAction_t;
+
+/* Echo payload, only ever read back by us */
+typedef struct _IhcEcho_t
+{
+    uint32_t magic;
+    uint32_t discr;
+    uint32_t seq;
+    uint32_t reserved;
+    uint64_t txUs;
+} __attribute__((packed)) IhcEcho_t;
+
+/* One address family of a health checked interface */
+typedef struct _IhcPath_t
+{
+    BOOL            armed;
+    BOOL            macValid;
+    BOOL            resolveDue;     /* gateway to be looked up again, set by route and neighbour changes */
+    BOOL            answered;       /* an echo came back since the path was armed */
+    struct in6_addr local;          /* IPv4 addresses use the first 4 bytes */
+    struct in6_addr gateway;
+    uint8_t         gwMac[ETH_ALEN];
+    uint32_t        txSeq;
+    uint32_t        rxSeq;          /* newest echo that came back */
+    UINT            renews;         /* failures since an echo last came back */
+} IhcPath_t;
+
+typedef struct _IhcSession_t
+{
+    BOOL        inUse;
+    char        ifName[IFNAMSIZ];
+    int         ifIndex;
+    uint32_t    discr;
+    IhcPath_t   path[IHC_NUM_FAMILIES];
+    BOOL        onWheel;
+    uint64_t    expiryTick;
+    int         wheelNext;
+} IhcSession_t;
+
+typedef struct _IhcWork_t
+{
+    char        ifName[IFNAMSIZ];
+    int         family;
+    IhcAction_t action;
+} IhcWork_t;
+
+extern token_t sysevent_token;
+
+/* ---- Private Variables ------------------------------------ */
+static IhcSession_t gSessions[WANMGR_IHC_MAX_IFACES];
+static int gWheel[IHC_WHEEL_SLOTS];
+static uint64_t gTick = 0;
+static UINT gNumOnWheel = 0;
+static int gTimerFd = -1;
+static int gPktFd[IHC_NUM_FAMILIES] = { -1, -1 };
+static int gSinkFd = -1;
+static int gNlFd = -1;
+static BOOL gIhcReady = FALSE;
+static pthread_mutex_t gIhcMutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_once_t gIhcOnce = PTHREAD_ONCE_INIT;
+
+/* ---- Private Functions ------------------------------------ */
+
+static uint64_t Ihc_NowUs(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t) ts.tv_sec * 1000000ULL + (uint64_t) ts.tv_nsec / 1000ULL;
+}
+
+static uint16_t Ihc_Checksum(uint32_t sum, const void *data, size_t len)
+{
+    const uint8_t *p = (const uint8_t *) data;
+
+    while (len > 1)
+    {
+        sum += (uint32_t)((p[0] << 8) | p[1]);
+        p += 2;
+        len -= 2;
+    }
+    if (len > 0)
+    {
+        sum += (uint32_t)(p[0] << 8);
+    }
+    while (sum >> 16)
+    {
+        sum = (sum & 0xFFFF) + (sum >> 16);
+    }
+
+    return htons((uint16_t) ~sum);
+}
+
+/* ---- Timer wheel, called with gIhcMutex held ---- */
+
+static void Ihc_WheelSchedule(int idx, uint64_t ticks)
+{
+    IhcSession_t *pSession = &gSessions[idx];
+    int slot;
+
+    pSession->expiryTick = gTick + ticks;
+    slot = (int)(pSession->expiryTick & (IHC_WHEEL_SLOTS - 1));
+    pSession->wheelNext = gWheel[slot];
+    gWheel[slot] = idx;
+
+    if (pSession->onWheel != TRUE)
+    {
+        pSession->onWheel = TRUE;
+        if (gNumOnWheel++ == 0)
+        {
+            struct itimerspec its;
+
+            memset(&its, 0, sizeof(its));
+            its.it_interval.tv_nsec = IHC_TICK_MS * 1000000L;
+            its.it_value.tv_nsec = IHC_TICK_MS * 1000000L;
+            timerfd_settime(gTimerFd, 0, &its, NULL);
+        }
+    }
+}
+
+static void Ihc_WheelCancel(int idx)
+{
+    IhcSession_t *pSession = &gSessions[idx];
+    int slot = (int)(pSession->expiryTick & (IHC_WHEEL_SLOTS - 1));
+    int *pLink = &gWheel[slot];
+
+    if (pSession->onWheel != TRUE)
+    {
+        return;
+    }
+
+    while (*pLink != -1)
+    {
+        if (*pLink == idx)
+        {
+            *pLink = pSession->wheelNext;
+            break;
+        }
+        pLink = &gSessions[*pLink].wheelNext;
+    }
+
+    pSession->onWheel = FALSE;
+    if (--gNumOnWheel == 0)
+    {
+        //Nothing to probe, stop waking up
+        struct itimerspec its;
+
+        memset(&its, 0, sizeof(its));
+        timerfd_settime(gTimerFd, 0, &its, NULL);
+    }
+}
+
+/* ---- Echoes ---- */
+
+static void Ihc_QueueAction(const IhcSession_t *pSession, int family, IhcAction_t action);
+
+static void Ihc_SendEcho(IhcSession_t *pSession, int family)
+{
+    IhcPath_t *pPath = &pSession->path[family];
+    uint8_t pkt[IHC_PKT_MAX];
+    struct sockaddr_ll sll;
+    struct udphdr udp;
+    IhcEcho_t echo;
+    size_t ipLen = (family == IHC_FAMILY_V4) ? sizeof(struct iphdr) : sizeof(struct ip6_hdr);
+    size_t len = ipLen + sizeof(udp) + sizeof(echo);
+
+    memset(&echo, 0, sizeof(echo));
+    echo.magic = htonl(IHC_ECHO_MAGIC);
+    echo.discr = htonl(pSession->discr);
+    echo.seq = htonl(pPath->txSeq);
+    echo.txUs = Ihc_NowUs();
+
+    memset(&udp, 0, sizeof(udp));
+    udp.source = htons(IHC_SRC_PORT_BASE + (pSession - gSessions) * IHC_NUM_FAMILIES + family);
+    udp.dest = htons(WANMGR_IHC_ECHO_PORT);
+    udp.len = htons(sizeof(udp) + sizeof(echo));
+
+    memset(pkt, 0, sizeof(pkt));
+    if (family == IHC_FAMILY_V4)
+    {
+        struct iphdr ip;
+
+        //Sent to ourselves, the gateway forwards it straight back
+        memset(&ip, 0, sizeof(ip));
+        ip.version = 4;
+        ip.ihl = sizeof(ip) / 4;
+        ip.tos = 0xC0;
+        ip.tot_len = htons(len);
+        ip.id = htons((uint16_t) pPath->txSeq);
+        ip.frag_off = htons(IP_DF);
+        ip.ttl = 255;
+        ip.protocol = IPPROTO_UDP;
+        memcpy(&ip.saddr, &pPath->local, sizeof(struct in_addr));
+        memcpy(&ip.daddr, &pPath->local, sizeof(struct in_addr));
+        ip.check = Ihc_Checksum(0, &ip, sizeof(ip));
+        memcpy(pkt, &ip, sizeof(ip));
+    }
+    else
+    {
+        struct ip6_hdr ip6;
+        uint32_t sum = 0;
+        int i;
+
+        memset(&ip6, 0, sizeof(ip6));
+        ip6.ip6_flow = htonl((6 << 28) | (0xC0 << 20));
+        ip6.ip6_plen = udp.len;
+        ip6.ip6_nxt = IPPROTO_UDP;
+        ip6.ip6_hlim = 255;
+        ip6.ip6_src = pPath->local;
+        ip6.ip6_dst = pPath->local;
+        memcpy(pkt, &ip6, sizeof(ip6));
+
+        //UDP checksum is mandatory over IPv6, pseudo header first
+        for (i = 0; i < 16; i += 2)
+        {
+            sum += 2 * (uint32_t)((pPath->local.s6_addr[i] << 8) | pPath->local.s6_addr[i + 1]);
+        }
+        sum += ntohs(udp.len) + IPPROTO_UDP;
+        memcpy(pkt + ipLen, &udp, sizeof(udp));
+        memcpy(pkt + ipLen + sizeof(udp), &echo, sizeof(echo));
+        udp.check = Ihc_Checksum(sum, pkt + ipLen, sizeof(udp) + sizeof(echo));
+        if (udp.check == 0)
+        {
+            udp.check = 0xFFFF;
+        }
+    }
+    memcpy(pkt + ipLen, &udp, sizeof(udp));
+    memcpy(pkt + ipLen + sizeof(udp), &echo, sizeof(echo));
+
+    memset(&sll, 0, sizeof(sll));
+    sll.sll_family = AF_PACKET;
+    sll.sll_protocol = htons((family == IHC_FAMILY_V4) ? ETH_P_IP : ETH_P_IPV6);
+    sll.sll_ifindex = pSession->ifIndex;
+    sll.sll_halen = ETH_ALEN;
+    memcpy(sll.sll_addr, pPath->gwMac, ETH_ALEN);
+
+    if (sendto(gPktFd[family], pkt, len, 0, (struct sockaddr *) &sll, sizeof(sll)) < 0)
+    {
+        CcspTraceWarning(("%s %d - %s echo send failed (%s)\n", __FUNCTION__, __LINE__, pSession->ifName, strerror(errno)));
+    }
+}
+
+/* Look the gateway and its link layer address up again. The result is kept
+   until a route or neighbour change, or lost echoes, ask for a new lookup. */
+static void Ihc_ResolveGateway(IhcSession_t *pSession, int family)
+{
+    IhcPath_t *pPath = &pSession->path[family];
+    int af = (family == IHC_FAMILY_V4) ? AF_INET : AF_INET6;
+
+    pPath->resolveDue = FALSE;
+
+    //The IPv4 gateway comes with the lease, the IPv6 one is the router of the default route
+    if (family == IHC_FAMILY_V6)
+    {
+        struct in6_addr gateway;
+
+        if (WanMgr_Netlink_GetDefaultGateway6(pSession->ifIndex, &gateway) != ANSC_STATUS_SUCCESS)
+        {
+            pPath->macValid = FALSE;
+            return;
+        }
+        if (memcmp(&gateway, &pPath->gateway, sizeof(gateway)) != 0)
+        {
+            pPath->gateway = gateway;
+            pPath->macValid = FALSE;
+        }
+    }
+    else if (pPath->gateway.s6_addr32[0] == 0)
+    {
+        return;
+    }
+
+    if (pPath->macValid == TRUE)
+    {
+        return;
+    }
+
+    if (WanMgr_Netlink_GetNeighbour(pSession->ifIndex, af, &pPath->gateway, pPath->gwMac) == ANSC_STATUS_SUCCESS)
+    {
+        pPath->macValid = TRUE;
+        return;
+    }
+
+    //The neighbour change brings the address once resolved
+    WanMgr_Netlink_ResolveNeighbour(pSession->ifIndex, af, &pPath->gateway);
+}
+
+/* Timer of a session: judge the last echo and send the next one */
+static void Ihc_SessionTimer(int idx, UINT lost[IHC_NUM_FAMILIES])
+{
+    IhcSession_t *pSession = &gSessions[idx];
+    BOOL bArmed = FALSE;
+    int family;
+
+    for (family = 0; family < IHC_NUM_FAMILIES; family++)
+    {
+        IhcPath_t *pPath = &pSession->path[family];
+
+        if (pPath->armed != TRUE)
+        {
+            continue;
+        }
+
+        if (pPath->txSeq != pPath->rxSeq)
+        {
+            lost[family]++;
+        }
+
+        if (pPath->txSeq - pPath->rxSeq >= WANMGR_IHC_DETECT_MULT)
+        {
+            IhcAction_t action = (pPath->renews < WANMGR_IHC_MAX_RENEWS) ? IHC_ACTION_RENEW : IHC_ACTION_FAIL;
+
+            CcspTraceWarning(("%s %d - %s IPv%c gateway stopped echoing, %s\n", __FUNCTION__, __LINE__, pSession->ifName,
+                              (family == IHC_FAMILY_V4) ? '4' : '6', (action == IHC_ACTION_RENEW) ? "renewing" : "restarting DHCP client"));
+
+            Ihc_QueueAction(pSession, family, action);
+            if (action == IHC_ACTION_FAIL)
+            {
+                //Probing resumes once the restarted client configures a lease
+                pPath->renews = 0;
+                pPath->armed = FALSE;
+                continue;
+            }
+
+            //Keep probing through the renew with a fresh window, the gateway may have moved
+            pPath->renews++;
+            pPath->rxSeq = pPath->txSeq;
+            pPath->answered = FALSE;
+            pPath->macValid = FALSE;
+            pPath->resolveDue = TRUE;
+        }
+
+        pPath->txSeq++;
+        if (pPath->resolveDue == TRUE)
+        {
+            Ihc_ResolveGateway(pSession, family);
+        }
+        if (pPath->macValid == TRUE)
+        {
+            Ihc_SendEcho(pSession, family);
+        }
+        bArmed = TRUE;
+    }
+
+    if (bArmed == TRUE)
+    {
+        Ihc_WheelSchedule(idx, IHC_INTERVAL_TICKS);
+    }
+    else
+    {
+        pSession->onWheel = FALSE;
+        if (--gNumOnWheel == 0)
+        {
+            struct itimerspec its;
+
+            memset(&its, 0, sizeof(its));
+            timerfd_settime(gTimerFd, 0, &its, NULL);
+        }
+    }
+}
+
+static void Ihc_OnTimer(int fd, uint32_t events, void *arg)
+{
+    char lostIfName[WANMGR_IHC_MAX_IFACES][IFNAMSIZ];
+    UINT lost[WANMGR_IHC_MAX_IFACES][IHC_NUM_FAMILIES];
+    uint64_t expirations = 0;
+    uint64_t target;
+    uint64_t tick;
+    int idx;
+
+    if (read(fd, &expirations, sizeof(expirations)) != sizeof(expirations) || expirations == 0)
+    {
+        return;
+    }
+
+    memset(lost, 0, sizeof(lost));
+
+    pthread_mutex_lock(&gIhcMutex);
+    target = gTick + expirations;
+    //Late by a full turn or more: every slot is due
+    tick = (expirations >= IHC_WHEEL_SLOTS) ? target - IHC_WHEEL_SLOTS + 1 : gTick + 1;
+    gTick = target;
+
+    for (; tick <= target; tick++)
+    {
+        int slot = (int)(tick & (IHC_WHEEL_SLOTS - 1));
+        int due = -1;
+
+        //Unlink what is due first, the timers put sessions back on the wheel
+        int *pLink = &gWheel[slot];
+        while (*pLink != -1)
+        {
+            IhcSession_t *pSession = &gSessions[*pLink];
+            if (pSession->expiryTick <= target)
+            {
+                int next = pSession->wheelNext;
+                pSession->wheelNext = due;
+                due = *pLink;
+                *pLink = next;
+            }
+            else
+            {
+                pLink = &pSession->wheelNext;
+            }
+        }
+
+        while (due != -1)
+        {
+            int next = gSessions[due].wheelNext;
+            Ihc_SessionTimer(due, lost[due]);
+            due = next;
+        }
+    }
+
+    for (idx = 0; idx < WANMGR_IHC_MAX_IFACES; idx++)
+    {
+        snprintf(lostIfName[idx], IFNAMSIZ, "%s", gSessions[idx].ifName);
+    }
+    pthread_mutex_unlock(&gIhcMutex);
+
+    for (idx = 0; idx < WANMGR_IHC_MAX_IFACES; idx++)
+    {
+        UINT i;
+        for (i = 0; i < lost[idx][IHC_FAMILY_V4] + lost[idx][IHC_FAMILY_V6]; i++)
+        {
+            WanMgr_LinkMetrics_AddEcho(lostIfName[idx], FALSE, 0);
+        }
+    }
+}
+
+static void Ihc_OnEcho(int fd, uint32_t events, void *arg)
+{
+    int family = (int)(intptr_t) arg;
+    uint8_t pkt[IHC_PKT_MAX];
+    struct sockaddr_ll sll;
+    socklen_t sllLen;
+    int len;
+
+    for (;;)
+    {
+        char ifName[IFNAMSIZ] = {0};
+        UINT rttUs = 0;
+        BOOL bFirst = FALSE;
+        BOOL bOnTime = FALSE;
+        size_t off;
+        IhcEcho_t echo;
+        uint32_t seq;
+        int idx;
+
+        sllLen = sizeof(sll);
+        len = recvfrom(fd, pkt, sizeof(pkt), 0, (struct sockaddr *) &sll, &sllLen);
+        if (len < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            break;
+        }
+
+        if (sll.sll_pkttype == PACKET_OUTGOING)
+        {
+            continue;
+        }
+
+        off = (family == IHC_FAMILY_V4) ? (size_t)(pkt[0] & 0x0F) * 4 : sizeof(struct ip6_hdr);
+        off += sizeof(struct udphdr);
+        if ((size_t) len < off + sizeof(echo))
+        {
+            continue;
+        }
+
+        memcpy(&echo, pkt + off, sizeof(echo));
+        if (ntohl(echo.magic) != IHC_ECHO_MAGIC)
+        {
+            continue;
+        }
+        seq = ntohl(echo.seq);
+
+        pthread_mutex_lock(&gIhcMutex);
+        for (idx = 0; idx < WANMGR_IHC_MAX_IFACES; idx++)
+        {
+            IhcSession_t *pSession = &gSessions[idx];
+            IhcPath_t *pPath = &pSession->path[family];
+
+            if (pSession->inUse != TRUE || pSession->ifIndex != sll.sll_ifindex ||
+                pSession->discr != ntohl(echo.discr) || pPath->armed != TRUE)
+            {
+                continue;
+            }
+
+            //Only newer echoes count, a late one is already counted lost
+            if (seq > pPath->rxSeq && seq <= pPath->txSeq)
+            {
+                pPath->rxSeq = seq;
+                rttUs = (UINT)(Ihc_NowUs() - echo.txUs);
+                //Older echoes were counted lost by the timer already, they only show the path is alive
+                bOnTime = (seq == pPath->txSeq) ? TRUE : FALSE;
+                snprintf(ifName, sizeof(ifName), "%s", pSession->ifName);
+
+                if (pPath->answered != TRUE)
+                {
+                    pPath->answered = TRUE;
+                    pPath->renews = 0;
+                    bFirst = TRUE;
+                    Ihc_QueueAction(pSession, family, IHC_ACTION_UP);
+                }
+            }
+            break;
+        }
+        pthread_mutex_unlock(&gIhcMutex);
+
+        if (ifName[0] != '\0')
+        {
+            if (bOnTime == TRUE)
+            {
+                WanMgr_LinkMetrics_AddEcho(ifName, TRUE, rttUs);
+            }
+            if (bFirst == TRUE)
+            {
+                CcspTraceInfo(("%s %d - %s IPv%c gateway echoing, rtt %u us\n", __FUNCTION__, __LINE__, ifName,
+                               (family == IHC_FAMILY_V4) ? '4' : '6', rttUs));
+            }
+        }
+    }
+}
+
+/* Route or neighbour change, called with gIhcMutex held */
+static void Ihc_OnRouteEvent(const WanMgr_NlRouteEvent_t *pEvent, void *arg)
+{
+    int family = (pEvent->family == AF_INET) ? IHC_FAMILY_V4 : IHC_FAMILY_V6;
+    size_t addrLen = (family == IHC_FAMILY_V4) ? sizeof(struct in_addr) : sizeof(struct in6_addr);
+    int idx;
+
+    (void) arg;
+
+    for (idx = 0; idx < WANMGR_IHC_MAX_IFACES; idx++)
+    {
+        IhcSession_t *pSession = &gSessions[idx];
+        IhcPath_t *pPath = &pSession->path[family];
+
+        if (pSession->inUse != TRUE || pPath->armed != TRUE)
+        {
+            continue;
+        }
+
+        if (pEvent->type == RTM_NEWROUTE || pEvent->type == RTM_DELROUTE)
+        {
+            //The IPv6 gateway may have moved
+            if (family == IHC_FAMILY_V6 && pEvent->isDefault == TRUE &&
+                (pEvent->ifIndex == 0 || pEvent->ifIndex == pSession->ifIndex))
+            {
+                pPath->resolveDue = TRUE;
+            }
+            continue;
+        }
+
+        if (pEvent->ifIndex != pSession->ifIndex || memcmp(&pEvent->addr, &pPath->gateway, addrLen) != 0)
+        {
+            continue;
+        }
+
+        if (pEvent->resolved == TRUE)
+        {
+            memcpy(pPath->gwMac, pEvent->mac, ETH_ALEN);
+            pPath->macValid = TRUE;
+        }
+        else if (pPath->macValid == TRUE)
+        {
+            //Gone or failed, resolve it again. A lookup in progress is left alone, the lost echoes retry it.
+            pPath->macValid = FALSE;
+            pPath->resolveDue = TRUE;
+        }
+    }
+}
+
+static void Ihc_OnNetlink(int fd, uint32_t events, void *arg)
+{
+    int idx;
+    int family;
+
+    pthread_mutex_lock(&gIhcMutex);
+    if (WanMgr_Netlink_ReadRouteEvents(fd, Ihc_OnRouteEvent, NULL) != ANSC_STATUS_SUCCESS)
+    {
+        //Changes were dropped, look every gateway up again
+        for (idx = 0; idx < WANMGR_IHC_MAX_IFACES; idx++)
+        {
+            for (family = 0; family < IHC_NUM_FAMILIES; family++)
+            {
+                gSessions[idx].path[family].resolveDue = TRUE;
+            }
+        }
+    }
+    pthread_mutex_unlock(&gIhcMutex);
+}
+
+/* Echoes also reach the stack, swallow them there instead of answering port unreachable */
+static void Ihc_OnSink(int fd, uint32_t events, void *arg)
+{
+    char buf[IHC_PKT_MAX];
+
+    while (recv(fd, buf, sizeof(buf), 0) >= 0 || errno == EINTR);
+}
+
+/* ---- Actions, run on the event loop urgent worker ---- */
+
+static ANSC_STATUS Ihc_SetWanIfData(char *ifName, wanmgr_iface_status_t state)
+{
+    WanMgr_Iface_Data_t* pWanDmlIfaceData = WanMgr_GetIfaceDataByName_locked(ifName);
+
+    if(pWanDmlIfaceData != NULL)
+    {
+        WanManager_UpdateInterfaceStatus(&(pWanDmlIfaceData->data), state);
+        WanMgrDml_GetIfaceData_release(pWanDmlIfaceData);
+        return ANSC_STATUS_SUCCESS;
+    }
+    return ANSC_STATUS_FAILURE;
+}
+
+static void Ihc_RunAction(void *arg)
+{
+    IhcWork_t *pWork = (IhcWork_t *) arg;
+    BOOL bV4 = (pWork->family == IHC_FAMILY_V4) ? TRUE : FALSE;
+    char conn_status[BUFLEN_16] = {0};
+    const char *state = bV4 ? SYSEVENT_IPV4_CONNECTION_STATE : SYSEVENT_IPV6_CONNECTION_STATE;
+
+    switch (pWork->action)
+    {
+        case IHC_ACTION_UP:
+            /* Connection state may have been set DOWN on the previous failure */
+            sysevent_get(sysevent_fd, sysevent_token, state, conn_status, sizeof(conn_status));
+            if (strcmp(conn_status, WAN_STATUS_DOWN) == 0)
+            {
+                CcspTraceInfo(("Setting IPv%c Connection state to UP \n", bV4 ? '4' : '6'));
+                sysevent_set(sysevent_fd, sysevent_token, state, WAN_STATUS_UP, 0);
+            }
+            break;
+
+        case IHC_ACTION_RENEW:
+            /* send triggered renew request to the DHCP client */
+            WanMgr_DhcpClient_Renew(pWork->ifName, bV4 ? WANMGR_DHCPC_V4 : WANMGR_DHCPC_V6);
+            Ihc_SetWanIfData(pWork->ifName, bV4 ? WANMGR_IFACE_CONNECTION_DOWN : WANMGR_IFACE_CONNECTION_IPV6_DOWN);
+            break;
+
+        case IHC_ACTION_FAIL:
+            if (bV4 == TRUE && WanManager_StopDhcpv4Client(pWork->ifName, TRUE) != ANSC_STATUS_SUCCESS)
+            {
+                CcspTraceInfo(("Failed to kill DHCPv4 Client \n"));
+            }
+            else if (bV4 != TRUE && WanManager_StopDhcpv6Client(pWork->ifName, TRUE) != ANSC_STATUS_SUCCESS)
+            {
+                CcspTraceInfo(("Failed to kill DHCPv6 Client \n"));
+            }
+            Ihc_SetWanIfData(pWork->ifName, bV4 ? WANMGR_IFACE_CONNECTION_DOWN : WANMGR_IFACE_CONNECTION_IPV6_DOWN);
+            break;
+    }
+
+    free(pWork);
+}
+
+static void Ihc_QueueAction(const IhcSession_t *pSession, int family, IhcAction_t action)
+{
+    IhcWork_t *pWork = (IhcWork_t *) malloc(sizeof(IhcWork_t));
+
+    if (pWork == NULL)
+    {
+        return;
+    }
+
+    snprintf(pWork->ifName, sizeof(pWork->ifName), "%s", pSession->ifName);
+    pWork->family = family;
+    pWork->action = action;
+
+    if (WanMgr_EventLoop_QueueUrgentWork(Ihc_RunAction, pWork) != ANSC_STATUS_SUCCESS)
+    {
+        free(pWork);
+    }
+}
+
+/* ---- Setup ---- */
+
+static int Ihc_OpenPacketSocket(int family)
+{
+    /* Runs on the packet from the IP header: UDP, not a fragment, to the echo port, not our own */
+    struct sock_filter filter4[] =
+    {
+        BPF_STMT(BPF_LD | BPF_W | BPF_ABS, SKF_AD_OFF + SKF_AD_PKTTYPE),
+        BPF_JUMP(BPF_JMP | BPF_JEQ | BPF_K, PACKET_OUTGOING, 8, 0),
+        BPF_STMT(BPF_LD | BPF_B | BPF_ABS, 9),
+        BPF_JUMP(BPF_JMP | BPF_JEQ | BPF_K, IPPROTO_UDP, 0, 6),
+        BPF_STMT(BPF_LD | BPF_H | BPF_ABS, 6),
+        BPF_JUMP(BPF_JMP | BPF_JSET | BPF_K, 0x1FFF, 4, 0),
+        BPF_STMT(BPF_LDX | BPF_B | BPF_MSH, 0),
+        BPF_STMT(BPF_LD | BPF_H | BPF_IND, 2),
+        BPF_JUMP(BPF_JMP | BPF_JEQ | BPF_K, WANMGR_IHC_ECHO_PORT, 0, 1),
+        BPF_STMT(BPF_RET | BPF_K, 0xFFFF),
+        BPF_STMT(BPF_RET | BPF_K, 0),
+    };
+    struct sock_filter filter6[] =
+    {
+        BPF_STMT(BPF_LD | BPF_W | BPF_ABS, SKF_AD_OFF + SKF_AD_PKTTYPE),
+        BPF_JUMP(BPF_JMP | BPF_JEQ | BPF_K, PACKET_OUTGOING, 4, 0),
+        BPF_STMT(BPF_LD | BPF_B | BPF_ABS, 6),
+        BPF_JUMP(BPF_JMP | BPF_JEQ | BPF_K, IPPROTO_UDP, 0, 2),
+        BPF_STMT(BPF_LD | BPF_H | BPF_ABS, sizeof(struct ip6_hdr) + 2),
+        BPF_JUMP(BPF_JMP | BPF_JEQ | BPF_K, WANMGR_IHC_ECHO_PORT, 1, 0),
+        BPF_STMT(BPF_RET | BPF_K, 0),
+        BPF_STMT(BPF_RET | BPF_K, 0xFFFF),
+    };
+    struct sock_fprog prog;
+    int fd;
+
+    fd = socket(AF_PACKET, SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC, htons((family == IHC_FAMILY_V4) ? ETH_P_IP : ETH_P_IPV6));
+    if (fd < 0)
+    {
+        CcspTraceError(("%s %d - packet socket failed (%s)\n", __FUNCTION__, __LINE__, strerror(errno)));
+        return -1;
+    }
+
+    if (family == IHC_FAMILY_V4)
+    {
+        prog.len = sizeof(filter4) / sizeof(filter4[0]);
+        prog.filter = filter4;
+    }
+    else
+    {
+        prog.len = sizeof(filter6) / sizeof(filter6[0]);
+        prog.filter = filter6;
+    }
+
+    if (setsockopt(fd, SOL_SOCKET, SO_ATTACH_FILTER, &prog, sizeof(prog)) < 0)
+    {
+        CcspTraceError(("%s %d - attaching echo filter failed (%s)\n", __FUNCTION__, __LINE__, strerror(errno)));
+        close(fd);
+        return -1;
+    }
+
+    return fd;
+}
+
+static int Ihc_OpenSinkSocket(void)
+{
+    struct sockaddr_in6 addr;
+    int off = 0;
+    int fd = socket(AF_INET6, SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+
+    if (fd < 0)
+    {
+        return -1;
+    }
+
+    setsockopt(fd, IPPROTO_IPV6, IPV6_V6ONLY, &off, sizeof(off));
+
+    memset(&addr, 0, sizeof(addr));
+    addr.sin6_family = AF_INET6;
+    addr.sin6_addr = in6addr_any;
+    addr.sin6_port = htons(WANMGR_IHC_ECHO_PORT);
+    if (bind(fd, (struct sockaddr *) &addr, sizeof(addr)) < 0)
+    {
+        CcspTraceWarning(("%s %d - echo port busy (%s)\n", __FUNCTION__, __LINE__, strerror(errno)));
+        close(fd);
+        return -1;
+    }
+
+    return fd;
+}
+
+static void Ihc_Init(void)
+{
+    int i;
+
+    for (i = 0; i < IHC_WHEEL_SLOTS; i++)
+    {
+        gWheel[i] = -1;
+    }
+
+    if ((gTimerFd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC)) < 0)
+    {
+        CcspTraceError(("%s %d - timerfd_create failed (%s)\n", __FUNCTION__, __LINE__, strerror(errno)));
+        return;
+    }
+
+    gPktFd[IHC_FAMILY_V4] = Ihc_OpenPacketSocket(IHC_FAMILY_V4);
+    gPktFd[IHC_FAMILY_V6] = Ihc_OpenPacketSocket(IHC_FAMILY_V6);
+    gNlFd = WanMgr_Netlink_OpenRouteEvents();
+    if (gPktFd[IHC_FAMILY_V4] < 0 || gPktFd[IHC_FAMILY_V6] < 0 || gNlFd < 0)
+    {
+        return;
+    }
+
+    if (WanMgr_EventLoop_AddFd(gTimerFd, "ihc-timer", Ihc_OnTimer, NULL) != ANSC_STATUS_SUCCESS ||
+        WanMgr_EventLoop_AddFd(gPktFd[IHC_FAMILY_V4], "ihc-echo4", Ihc_OnEcho, (void *)(intptr_t) IHC_FAMILY_V4) != ANSC_STATUS_SUCCESS ||
+        WanMgr_EventLoop_AddFd(gPktFd[IHC_FAMILY_V6], "ihc-echo6", Ihc_OnEcho, (void *)(intptr_t) IHC_FAMILY_V6) != ANSC_STATUS_SUCCESS ||
+        WanMgr_EventLoop_AddFd(gNlFd, "ihc-netlink", Ihc_OnNetlink, NULL) != ANSC_STATUS_SUCCESS)
+    {
+        return;
+    }
+
+    if ((gSinkFd = Ihc_OpenSinkSocket()) >= 0)
+    {
+        WanMgr_EventLoop_AddFd(gSinkFd, "ihc-sink", Ihc_OnSink, NULL);
+    }
+
+    gIhcReady = TRUE;
+}
+
+/* Session of ifName, called with gIhcMutex held */
+static int Ihc_FindSession(const char *ifName)
+{
+    int idx;
+
+    for (idx = 0; idx < WANMGR_IHC_MAX_IFACES; idx++)
+    {
+        if (gSessions[idx].inUse == TRUE && strcmp(gSessions[idx].ifName, ifName) == 0)
+        {
+            return idx;
+        }
+    }
+    return -1;
+}
+
+static ANSC_STATUS Ihc_SetPath(const char *ifName, int family, BOOL up, const void *pAddr, const void *pGateway)
+{
+    IhcSession_t *pSession;
+    IhcPath_t *pPath;
+    size_t addrLen = (family == IHC_FAMILY_V4) ? sizeof(struct in_addr) : sizeof(struct in6_addr);
+    UINT renews;
+    int idx;
+
+    if (ifName == NULL || (up == TRUE && pAddr == NULL))
+    {
+        return ANSC_STATUS_BAD_PARAMETER;
+    }
+
+    pthread_mutex_lock(&gIhcMutex);
+    if ((idx = Ihc_FindSession(ifName)) < 0)
+    {
+        pthread_mutex_unlock(&gIhcMutex);
+        return ANSC_STATUS_FAILURE;
+    }
+
+    pSession = &gSessions[idx];
+    pPath = &pSession->path[family];
+
+    //The failure history outlives the lease, it decides between renew and restart
+    renews = pPath->renews;
+    memset(pPath, 0, sizeof(IhcPath_t));
+    pPath->renews = renews;
+
+    if (up == TRUE)
+    {
+        pSession->ifIndex = if_nametoindex(ifName);
+        memcpy(&pPath->local, pAddr, addrLen);
+        if (pGateway != NULL)
+        {
+            memcpy(&pPath->gateway, pGateway, addrLen);
+        }
+        pPath->armed = TRUE;
+
+        //Start resolving the gateway now, the first echo goes on the next tick
+        Ihc_ResolveGateway(pSession, family);
+        if (pSession->onWheel != TRUE)
+        {
+            Ihc_WheelSchedule(idx, 1);
+        }
+    }
+    pthread_mutex_unlock(&gIhcMutex);
+
+    CcspTraceInfo(("%s %d - %s IPv%c echoes %s\n", __FUNCTION__, __LINE__, ifName,
+                   (family == IHC_FAMILY_V4) ? '4' : '6', (up == TRUE) ? "started" : "stopped"));
+    return ANSC_STATUS_SUCCESS;
+}
+
+/* ---- Public Functions ------------------------------------- */
+
+ANSC_STATUS WanMgr_IpoeHc_Start(const char *ifName)
+{
+    int idx;
+
+    if (ifName == NULL || ifName[0] == '\0')
+    {
+        return ANSC_STATUS_BAD_PARAMETER;
+    }
+
+    pthread_once(&gIhcOnce, Ihc_Init);
+    if (gIhcReady != TRUE)
+    {
+        CcspTraceError(("%s %d - IPoE health check unavailable\n", __FUNCTION__, __LINE__));
+        return ANSC_STATUS_FAILURE;
+    }
+
+    pthread_mutex_lock(&gIhcMutex);
+    if (Ihc_FindSession(ifName) >= 0)
+    {
+        pthread_mutex_unlock(&gIhcMutex);
+        return ANSC_STATUS_SUCCESS;
+    }
+
+    for (idx = 0; idx < WANMGR_IHC_MAX_IFACES; idx++)
+    {
+        if (gSessions[idx].inUse != TRUE)
+        {
+            break;
+        }
+    }
+
+    if (idx >= WANMGR_IHC_MAX_IFACES)
+    {
+        pthread_mutex_unlock(&gIhcMutex);
+        CcspTraceError(("%s %d - no free health check session for %s\n", __FUNCTION__, __LINE__, ifName));
+        return ANSC_STATUS_FAILURE;
+    }
+
+    memset(&gSessions[idx], 0, sizeof(IhcSession_t));
+    snprintf(gSessions[idx].ifName, sizeof(gSessions[idx].ifName), "%s", ifName);
+    gSessions[idx].discr = (uint32_t)(Ihc_NowUs() ^ ((uint64_t) idx << 24) ^ (uint64_t) getpid());
+    gSessions[idx].wheelNext = -1;
+    gSessions[idx].inUse = TRUE;
+    pthread_mutex_unlock(&gIhcMutex);
+
+    CcspTraceInfo(("%s %d - IPoE health check started on %s\n", __FUNCTION__, __LINE__, ifName));
+    return ANSC_STATUS_SUCCESS;
+}
+
+ANSC_STATUS WanMgr_IpoeHc_Stop(const char *ifName)
+{
+    int idx;
+
+    if (ifName == NULL)
+    {
+        return ANSC_STATUS_BAD_PARAMETER;
+    }
+
+    pthread_mutex_lock(&gIhcMutex);
+    if ((idx = Ihc_FindSession(ifName)) < 0)
+    {
+        pthread_mutex_unlock(&gIhcMutex);
+        return ANSC_STATUS_FAILURE;
+    }
+
+    Ihc_WheelCancel(idx);
+    gSessions[idx].inUse = FALSE;
+    pthread_mutex_unlock(&gIhcMutex);
+
+    CcspTraceInfo(("%s %d - IPoE health check stopped on %s\n", __FUNCTION__, __LINE__, ifName));
+    return ANSC_STATUS_SUCCESS;
+}
+
+ANSC_STATUS WanMgr_IpoeHc_SetIpv4(const char *ifName, BOOL up, const struct in_addr *pAddr, const struct in_addr *pGateway)
+{
+    return Ihc_SetPath(ifName, IHC_FAMILY_V4, up, pAddr, pGateway);
+}
+
+ANSC_STATUS WanMgr_IpoeHc_SetIpv6(const char *ifName, BOOL up, const struct in6_addr *pAddr)
+{
+    return Ihc_SetPath(ifName, IHC_FAMILY_V6, up, pAddr, NULL);
+}
+
+#endif /* FEATURE_IPOE_HEALTH_CHECK */
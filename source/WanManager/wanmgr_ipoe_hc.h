@@ -0,0 +1,76 @@
+/*
+ * If not stated otherwise in this file or this component's Licenses.txt file the
+ * following copyright and licenses apply:
+ *
+ * Copyright 2020 RDK Management
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+*/
+
+#ifndef _WANMGR_IPOE_HC_H_
+#define _WANMGR_IPOE_HC_H_
+
+/* IPoE health check: BFD echo (RFC 5880/5881 echo function) towards the
+ * gateway of every IPoE WAN. An echo is sent to our own address through the
+ * gateway MAC, the gateway forwards it straight back. All interfaces share
+ * one timer wheel and one packet socket per address family on the event loop. */
+
+/* ---- Include Files ---------------------------------------- */
+#include <netinet/in.h>
+#include "ansc_platform.h"
+
+/* ---- Global Constants -------------------------------------- */
+#define WANMGR_IHC_MAX_IFACES       8
+#define WANMGR_IHC_TX_INTERVAL_MS   250     /* one echo per interval and address family */
+#define WANMGR_IHC_DETECT_MULT      3       /* echoes lost in a row before the path is declared down */
+#define WANMGR_IHC_MAX_RENEWS       3       /* failures answered with a DHCP renew before the client is restarted */
+#define WANMGR_IHC_ECHO_PORT        3785
+
+/* ---- Global Prototypes -------------------------------------- */
+
+/***************************************************************************
+ * @brief Start health checking an interface. Probing starts per address
+ * family once its address is set with WanMgr_IpoeHc_SetIpv4/6.
+ * @param ifName WAN interface name
+ * @return ANSC_STATUS_SUCCESS upon success else returned error code.
+ ****************************************************************************/
+ANSC_STATUS WanMgr_IpoeHc_Start(const char *ifName);
+
+/***************************************************************************
+ * @brief Stop health checking an interface and forget its failure history.
+ * @param ifName WAN interface name
+ * @return ANSC_STATUS_SUCCESS upon success else returned error code.
+ ****************************************************************************/
+ANSC_STATUS WanMgr_IpoeHc_Stop(const char *ifName);
+
+/***************************************************************************
+ * @brief Start or stop IPv4 echoes on an interface.
+ * @param ifName WAN interface name
+ * @param up TRUE when the IPv4 lease is configured, FALSE when it is gone
+ * @param pAddr WAN address, the echoes are sent to and from it
+ * @param pGateway gateway the echoes are looped through
+ * @return ANSC_STATUS_SUCCESS upon success else returned error code.
+ ****************************************************************************/
+ANSC_STATUS WanMgr_IpoeHc_SetIpv4(const char *ifName, BOOL up, const struct in_addr *pAddr, const struct in_addr *pGateway);
+
+/***************************************************************************
+ * @brief Start or stop IPv6 echoes on an interface. The gateway is the
+ * router of the IPv6 default route through the interface.
+ * @param ifName WAN interface name
+ * @param up TRUE when IPv6 is configured, FALSE when it is gone
+ * @param pAddr global address routed to us, the echoes are sent to and from it
+ * @return ANSC_STATUS_SUCCESS upon success else returned error code.
+ ****************************************************************************/
+ANSC_STATUS WanMgr_IpoeHc_SetIpv6(const char *ifName, BOOL up, const struct in6_addr *pAddr);
+
+#endif /* _WANMGR_IPOE_HC_H_ */
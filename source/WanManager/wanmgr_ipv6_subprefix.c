@@ -0,0 +1,330 @@
+/*
+ * If not stated otherwise in this file or this component's Licenses.txt file the
+ * following copyright and licenses apply:
+ *
+ * Copyright 2020 RDK Management
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+*/
+
+/* ---- Include Files ---------------------------------------- */
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <pthread.h>
+#include <arpa/inet.h>
+#include <net/if.h>
+#include "syscfg.h"
+#include "wanmgr_sysevents.h"
+#include "wanmgr_ipv6_subprefix.h"
+
+#define SUBPREFIX_MAX_SLOTS     (1U << (64 - WANMGR_SUBPREFIX_MIN_PD_LEN))
+#define SUBPREFIX_BITMAP_WORDS  (SUBPREFIX_MAX_SLOTS / 64)
+#define SUBPREFIX_MAP_LEN       (WANMGR_SUBPREFIX_MAX_IFACES * (IFNAMSIZ + 5))
+
+typedef struct _WanMgr_SubPrefixEntry_t
+{
+    char        ifName[IFNAMSIZ];
+    UINT        index;
+} WanMgr_SubPrefixEntry_t;
+
+/* ---- Private Variables ------------------------------------ */
+static pthread_mutex_t gSubPrefixMutex = PTHREAD_MUTEX_INITIALIZER;
+static BOOL gSubPrefixLoaded = FALSE;
+static uint64_t gSubPrefixBitmap[SUBPREFIX_BITMAP_WORDS];
+static WanMgr_SubPrefixEntry_t gSubPrefixEntries[WANMGR_SUBPREFIX_MAX_IFACES];
+static UINT gSubPrefixCount = 0;
+
+/* ---- Private Functions ------------------------------------ */
+
+static void SubPrefix_SetBit(UINT index)
+{
+    gSubPrefixBitmap[index / 64] |= (1ULL << (index % 64));
+}
+
+static void SubPrefix_ClearBit(UINT index)
+{
+    gSubPrefixBitmap[index / 64] &= ~(1ULL << (index % 64));
+}
+
+static int SubPrefix_Find(const char *ifName)
+{
+    UINT i;
+
+    for (i = 0; i < gSubPrefixCount; i++)
+    {
+        if (strcmp(gSubPrefixEntries[i].ifName, ifName) == 0)
+        {
+            return (int) i;
+        }
+    }
+
+    return -1;
+}
+
+static void SubPrefix_Remove(UINT entry)
+{
+    SubPrefix_ClearBit(gSubPrefixEntries[entry].index);
+    gSubPrefixCount--;
+    if (entry != gSubPrefixCount)
+    {
+        gSubPrefixEntries[entry] = gSubPrefixEntries[gSubPrefixCount];
+    }
+}
+
+/* Lowest free index in [first, slots), the bitmap is at most 4 words */
+static int SubPrefix_AllocIndex(UINT first, UINT slots)
+{
+    uint64_t avail;
+    UINT word;
+    UINT bit;
+
+    for (word = first / 64; word * 64 < slots; word++)
+    {
+        avail = ~gSubPrefixBitmap[word];
+        if (word == first / 64 && (first % 64) != 0)
+        {
+            avail &= ~((1ULL << (first % 64)) - 1);
+        }
+        if (avail == 0)
+        {
+            continue;
+        }
+
+        bit = word * 64 + (UINT) __builtin_ctzll(avail);
+        if (bit >= slots)
+        {
+            break;
+        }
+        SubPrefix_SetBit(bit);
+        return (int) bit;
+    }
+
+    return -1;
+}
+
+/* Persisted as "ifname:index,ifname:index" */
+static void SubPrefix_Load(void)
+{
+    char map[SUBPREFIX_MAP_LEN] = {0};
+    char *tok = NULL;
+    char *save = NULL;
+    char *sep = NULL;
+    long index;
+
+    gSubPrefixLoaded = TRUE;
+    if (syscfg_get(NULL, SYSCFG_SUBPREFIX_MAP, map, sizeof(map)) != 0)
+    {
+        return;
+    }
+
+    for (tok = strtok_r(map, ",", &save); tok != NULL; tok = strtok_r(NULL, ",", &save))
+    {
+        if ((sep = strchr(tok, ':')) == NULL || gSubPrefixCount >= WANMGR_SUBPREFIX_MAX_IFACES)
+        {
+            continue;
+        }
+        *sep = '\0';
+        index = strtol(sep + 1, NULL, 10);
+        if (tok[0] == '\0' || index < 0 || index >= (long) SUBPREFIX_MAX_SLOTS || SubPrefix_Find(tok) >= 0)
+        {
+            continue;
+        }
+        if (gSubPrefixBitmap[index / 64] & (1ULL << (index % 64)))
+        {
+            continue;
+        }
+
+        strncpy(gSubPrefixEntries[gSubPrefixCount].ifName, tok, IFNAMSIZ - 1);
+        gSubPrefixEntries[gSubPrefixCount].index = (UINT) index;
+        SubPrefix_SetBit((UINT) index);
+        gSubPrefixCount++;
+    }
+
+    CcspTraceInfo(("%s %d - restored %u sub-prefix assignments\n", __FUNCTION__, __LINE__, gSubPrefixCount));
+}
+
+/* Only called when an assignment changes, not on every prefix event */
+static void SubPrefix_Store(void)
+{
+    char map[SUBPREFIX_MAP_LEN] = {0};
+    size_t len = 0;
+    UINT i;
+
+    for (i = 0; i < gSubPrefixCount && len < sizeof(map); i++)
+    {
+        len += snprintf(map + len, sizeof(map) - len, "%s%s:%u", (i > 0) ? "," : "",
+                        gSubPrefixEntries[i].ifName, gSubPrefixEntries[i].index);
+    }
+
+    syscfg_set_string(SYSCFG_SUBPREFIX_MAP, map);
+}
+
+/* ---- Public Functions ------------------------------------- */
+
+ANSC_STATUS WanMgr_SubPrefix_Get(const char *ifName, const char *pdPrefix, int pdLen, char *out, size_t outLen)
+{
+    struct in6_addr addr;
+    char str[INET6_ADDRSTRLEN] = {0};
+    uint64_t upper = 0;
+    UINT slots;
+    UINT reserved;
+    int entry;
+    int index;
+    int i;
+
+    if (ifName == NULL || ifName[0] == '\0' || pdPrefix == NULL || out == NULL || pdLen <= 0 || pdLen > 64)
+    {
+        return ANSC_STATUS_FAILURE;
+    }
+
+    if (inet_pton(AF_INET6, pdPrefix, &addr) != 1)
+    {
+        CcspTraceError(("%s %d - invalid prefix %s\n", __FUNCTION__, __LINE__, pdPrefix));
+        return ANSC_STATUS_FAILURE;
+    }
+
+    /* a shorter delegation is only carved up to its first /56 */
+    if (pdLen < WANMGR_SUBPREFIX_MIN_PD_LEN)
+    {
+        pdLen = WANMGR_SUBPREFIX_MIN_PD_LEN;
+    }
+    /* a delegated /64 is handed out whole, nothing is reserved out of it */
+    slots = 1U << (64 - pdLen);
+    reserved = (slots / 2 < WANMGR_SUBPREFIX_RESERVED) ? slots / 2 : WANMGR_SUBPREFIX_RESERVED;
+
+    pthread_mutex_lock(&gSubPrefixMutex);
+    if (gSubPrefixLoaded != TRUE)
+    {
+        SubPrefix_Load();
+    }
+
+    entry = SubPrefix_Find(ifName);
+    if (entry >= 0 && (gSubPrefixEntries[entry].index < reserved || gSubPrefixEntries[entry].index >= slots))
+    {
+        /* the delegation got smaller, the old index is out of range now */
+        SubPrefix_Remove((UINT) entry);
+        entry = -1;
+    }
+
+    if (entry < 0)
+    {
+        if (gSubPrefixCount >= WANMGR_SUBPREFIX_MAX_IFACES || (index = SubPrefix_AllocIndex(reserved, slots)) < 0)
+        {
+            pthread_mutex_unlock(&gSubPrefixMutex);
+            CcspTraceError(("%s %d - no free /64 for %s in /%d\n", __FUNCTION__, __LINE__, ifName, pdLen));
+            return ANSC_STATUS_FAILURE;
+        }
+
+        entry = (int) gSubPrefixCount++;
+        memset(&gSubPrefixEntries[entry], 0, sizeof(WanMgr_SubPrefixEntry_t));
+        strncpy(gSubPrefixEntries[entry].ifName, ifName, IFNAMSIZ - 1);
+        gSubPrefixEntries[entry].index = (UINT) index;
+        SubPrefix_Store();
+        CcspTraceInfo(("%s %d - %s assigned sub-prefix %d\n", __FUNCTION__, __LINE__, ifName, index));
+    }
+    index = (int) gSubPrefixEntries[entry].index;
+    pthread_mutex_unlock(&gSubPrefixMutex);
+
+    /* index goes in bits pdLen..63, the interface id half stays zero */
+    for (i = 0; i < 8; i++)
+    {
+        upper = (upper << 8) | addr.s6_addr[i];
+    }
+    upper = (upper & ~((1ULL << (64 - pdLen)) - 1)) | (uint64_t) index;
+    for (i = 7; i >= 0; i--)
+    {
+        addr.s6_addr[i] = (uint8_t) (upper & 0xff);
+        upper >>= 8;
+    }
+    memset(&addr.s6_addr[8], 0, 8);
+
+    if (inet_ntop(AF_INET6, &addr, str, sizeof(str)) == NULL)
+    {
+        return ANSC_STATUS_FAILURE;
+    }
+    snprintf(out, outLen, "%s/64", str);
+
+    return ANSC_STATUS_SUCCESS;
+}
+
+ANSC_STATUS WanMgr_SubPrefix_Release(const char *ifName)
+{
+    int entry;
+
+    if (ifName == NULL)
+    {
+        return ANSC_STATUS_FAILURE;
+    }
+
+    pthread_mutex_lock(&gSubPrefixMutex);
+    if (gSubPrefixLoaded != TRUE)
+    {
+        SubPrefix_Load();
+    }
+
+    if ((entry = SubPrefix_Find(ifName)) < 0)
+    {
+        pthread_mutex_unlock(&gSubPrefixMutex);
+        return ANSC_STATUS_FAILURE;
+    }
+
+    SubPrefix_Remove((UINT) entry);
+    SubPrefix_Store();
+    pthread_mutex_unlock(&gSubPrefixMutex);
+
+    CcspTraceInfo(("%s %d - %s released its sub-prefix\n", __FUNCTION__, __LINE__, ifName));
+    return ANSC_STATUS_SUCCESS;
+}
+
+void WanMgr_SubPrefix_Retain(const char *ifList)
+{
+    char list[SUBPREFIX_MAP_LEN] = {0};
+    char token[IFNAMSIZ + 2];
+    BOOL changed = FALSE;
+    UINT i = 0;
+
+    if (ifList == NULL)
+    {
+        return;
+    }
+
+    /* ",brlan0,brlan1," so each name can be matched as ",name," */
+    snprintf(list, sizeof(list), ",%s,", ifList);
+
+    pthread_mutex_lock(&gSubPrefixMutex);
+    if (gSubPrefixLoaded != TRUE)
+    {
+        SubPrefix_Load();
+    }
+
+    while (i < gSubPrefixCount)
+    {
+        snprintf(token, sizeof(token), ",%s,", gSubPrefixEntries[i].ifName);
+        if (strstr(list, token) == NULL)
+        {
+            CcspTraceInfo(("%s %d - %s no longer needs a sub-prefix\n", __FUNCTION__, __LINE__, gSubPrefixEntries[i].ifName));
+            SubPrefix_Remove(i);
+            changed = TRUE;
+            continue;
+        }
+        i++;
+    }
+
+    if (changed == TRUE)
+    {
+        SubPrefix_Store();
+    }
+    pthread_mutex_unlock(&gSubPrefixMutex);
+}
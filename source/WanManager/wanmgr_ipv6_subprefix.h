@@ -0,0 +1,65 @@
+/*
+ * If not stated otherwise in this file or this component's Licenses.txt file the
+ * following copyright and licenses apply:
+ *
+ * Copyright 2020 RDK Management
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+*/
+
+#ifndef _WANMGR_IPV6_SUBPREFIX_H_
+#define _WANMGR_IPV6_SUBPREFIX_H_
+
+/* ---- Include Files ---------------------------------------- */
+#include <stddef.h>
+#include "ansc_platform.h"
+
+/* ---- Global Constants -------------------------------------- */
+#define WANMGR_SUBPREFIX_MIN_PD_LEN     56      /* largest delegation carved up, 256 /64s */
+#define WANMGR_SUBPREFIX_MAX_IFACES     16
+#define WANMGR_SUBPREFIX_RESERVED       4       /* first /64s are kept for the dhcp configuration */
+#define SYSCFG_SUBPREFIX_MAP            "wanmanager_ipv6_subprefix_map"
+
+/* ---- Global Prototypes -------------------------------------- */
+
+/***************************************************************************
+ * @brief Get the /64 assigned to a LAN interface out of the delegated
+ * prefix, allocating one on first use. An interface keeps the same index
+ * across prefix changes and restarts, the assignment is stored in syscfg.
+ * Delegations longer than /56 are supported, anything shorter is treated
+ * as a /56. A delegated /64 is a single sub-prefix, given to the first
+ * interface asking for it.
+ * @param ifName LAN interface name
+ * @param pdPrefix delegated prefix address, without length
+ * @param pdLen delegated prefix length, up to 64
+ * @param out output buffer, receives "<prefix>/64"
+ * @param outLen size of out
+ * @return ANSC_STATUS_SUCCESS upon success else ANSC_STATUS_FAILURE.
+ ****************************************************************************/
+ANSC_STATUS WanMgr_SubPrefix_Get(const char *ifName, const char *pdPrefix, int pdLen, char *out, size_t outLen);
+
+/***************************************************************************
+ * @brief Return the /64 held by an interface to the pool, e.g. when the
+ * delegated prefix is lost.
+ * @param ifName LAN interface name
+ * @return ANSC_STATUS_SUCCESS if the interface had an assignment.
+ ****************************************************************************/
+ANSC_STATUS WanMgr_SubPrefix_Release(const char *ifName);
+
+/***************************************************************************
+ * @brief Release every assignment whose interface is not in ifList.
+ * @param ifList comma separated list of interfaces still in use
+ ****************************************************************************/
+void WanMgr_SubPrefix_Retain(const char *ifList);
+
+#endif /* _WANMGR_IPV6_SUBPREFIX_H_ */
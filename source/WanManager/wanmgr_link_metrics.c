@@ -0,0 +1,383 @@
+/*
+ * If not stated otherwise in this file or this component's Licenses.txt file the
+ * following copyright and licenses apply:
+ *
+ * Copyright 2020 RDK Management
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+*/
+
+/* ---- Include Files ---------------------------------------- */
+#include <stdio.h>
+#include <string.h>
+#include <pthread.h>
+#include <time.h>
+#include <net/if.h>
+#include "wanmgr_link_metrics.h"
+
+#define METRICS_RATE_ALPHA      0.25    /* weight of a new throughput sample */
+#define METRICS_LOSS_ALPHA      0.25    /* weight of the loss of a new sample */
+#define METRICS_RTT_ALPHA       0.125   /* weight of a new round trip time */
+#define METRICS_UTIL_KNEE       0.8     /* utilisation of the link speed penalised above this */
+
+typedef struct _WanMgr_LinkEntry_t
+{
+    BOOL        inUse;
+    char        ifName[IFNAMSIZ];
+    uint64_t    lastSampleMs;
+    uint64_t    lastActivityMs;
+    uint64_t    rxBytes;        /* counters at the last sample */
+    uint64_t    txBytes;
+    uint64_t    errors;         /* rx/tx errors and tx drops at the last sample */
+    BOOL        countersValid;
+    double      rateBps;
+    uint64_t    speedBps;
+    UINT        echoAnswered;   /* echoes since the last sample */
+    UINT        echoLost;
+    double      lossPct;
+    double      rttUs;
+    UINT        minRttUs;
+    BOOL        newErrors;
+    UINT        score;
+    BOOL        degraded;
+    UINT        streak;         /* consecutive samples on the other side of the hysteresis */
+} WanMgr_LinkEntry_t;
+
+/* ---- Private Variables ------------------------------------ */
+static WanMgr_LinkEntry_t gLinks[WANMGR_METRICS_MAX_LINKS];
+static pthread_mutex_t gLinksMutex = PTHREAD_MUTEX_INITIALIZER;
+
+/* ---- Private Functions ------------------------------------ */
+
+static uint64_t Metrics_NowMs(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t) ts.tv_sec * 1000ULL + (uint64_t) ts.tv_nsec / 1000000ULL;
+}
+
+static void Metrics_Reset(WanMgr_LinkEntry_t *pLink, const char *ifName)
+{
+    memset(pLink, 0, sizeof(WanMgr_LinkEntry_t));
+    snprintf(pLink->ifName, sizeof(pLink->ifName), "%s", ifName);
+    pLink->score = WANMGR_METRICS_SCORE_MAX;
+    pLink->inUse = TRUE;
+}
+
+/* Entry of ifName, created (or recycled from the stalest link) if needed. Called with gLinksMutex held. */
+static WanMgr_LinkEntry_t* Metrics_GetLink(const char *ifName, BOOL create)
+{
+    WanMgr_LinkEntry_t *pFree = NULL;
+    WanMgr_LinkEntry_t *pOldest = NULL;
+    uint64_t now = Metrics_NowMs();
+    int i;
+
+    for (i = 0; i < WANMGR_METRICS_MAX_LINKS; i++)
+    {
+        WanMgr_LinkEntry_t *pLink = &gLinks[i];
+
+        if (pLink->inUse != TRUE)
+        {
+            pFree = (pFree == NULL) ? pLink : pFree;
+            continue;
+        }
+
+        if (strcmp(pLink->ifName, ifName) == 0)
+        {
+            if (now - pLink->lastActivityMs > WANMGR_METRICS_STALE_MS)
+            {
+                //Not measured for a while, what we knew no longer holds
+                Metrics_Reset(pLink, ifName);
+                pLink->lastActivityMs = now;
+            }
+            return pLink;
+        }
+
+        if (pOldest == NULL || pLink->lastActivityMs < pOldest->lastActivityMs)
+        {
+            pOldest = pLink;
+        }
+    }
+
+    if (create != TRUE)
+    {
+        return NULL;
+    }
+
+    pFree = (pFree != NULL) ? pFree : pOldest;
+    Metrics_Reset(pFree, ifName);
+    pFree->lastActivityMs = now;
+    return pFree;
+}
+
+static BOOL Metrics_ReadCounter(const char *ifName, const char *counter, uint64_t *pValue)
+{
+    char path[BUFLEN_128];
+    unsigned long long value = 0;
+    FILE *fp;
+    BOOL ok;
+
+    snprintf(path, sizeof(path), "/sys/class/net/%s/statistics/%s", ifName, counter);
+    if ((fp = fopen(path, "r")) == NULL)
+    {
+        return FALSE;
+    }
+    ok = (fscanf(fp, "%llu", &value) == 1) ? TRUE : FALSE;
+    fclose(fp);
+
+    *pValue = (uint64_t) value;
+    return ok;
+}
+
+/* Link speed in bits per second as the driver reports it, 0 if it reports none (PPP, most DSL) */
+static uint64_t Metrics_ReadSpeed(const char *ifName)
+{
+    char path[BUFLEN_128];
+    long long mbps = 0;
+    FILE *fp;
+
+    snprintf(path, sizeof(path), "/sys/class/net/%s/speed", ifName);
+    if ((fp = fopen(path, "r")) == NULL)
+    {
+        return 0;
+    }
+    //Reading fails while the link is down, -1 means unknown
+    if (fscanf(fp, "%lld", &mbps) != 1 || mbps <= 0)
+    {
+        mbps = 0;
+    }
+    fclose(fp);
+
+    return (uint64_t) mbps * 1000000ULL;
+}
+
+static void Metrics_Score(WanMgr_LinkEntry_t *pLink)
+{
+    double penalty = 0;
+    UINT score;
+
+    //Lost echoes: 50% loss makes the link unusable
+    penalty += pLink->lossPct * 2;
+
+    //Queueing delay over the best round trip seen, 5 ms per point
+    if (pLink->minRttUs > 0 && pLink->rttUs > pLink->minRttUs)
+    {
+        double queueMs = (pLink->rttUs - pLink->minRttUs) / 1000.0;
+        penalty += (queueMs / 5 > 40) ? 40 : queueMs / 5;
+    }
+
+    //Busier direction running at the link speed, full duplex so each direction has all of it
+    if (pLink->speedBps > 0 && pLink->rateBps > pLink->speedBps * METRICS_UTIL_KNEE)
+    {
+        double util = (pLink->rateBps > pLink->speedBps) ? 1 : pLink->rateBps / pLink->speedBps;
+        penalty += (util - METRICS_UTIL_KNEE) * 250;
+    }
+
+    if (pLink->newErrors == TRUE)
+    {
+        penalty += 10;
+    }
+
+    score = (penalty >= WANMGR_METRICS_SCORE_MAX) ? 0 : (UINT)(WANMGR_METRICS_SCORE_MAX - penalty);
+    pLink->score = score;
+
+    /* Hysteresis: a link has to stay bad to be degraded and good for longer to recover,
+       so routing does not flap on a single noisy sample */
+    if (pLink->degraded == FALSE)
+    {
+        pLink->streak = (score < WANMGR_METRICS_DEGRADE_SCORE) ? pLink->streak + 1 : 0;
+        if (pLink->streak >= WANMGR_METRICS_DEGRADE_COUNT)
+        {
+            pLink->degraded = TRUE;
+            pLink->streak = 0;
+            CcspTraceWarning(("%s %d - %s degraded, score %u loss %u%% rtt %u us rate %llu/%llu bps\n", __FUNCTION__, __LINE__,
+                              pLink->ifName, score, (UINT) pLink->lossPct, (UINT) pLink->rttUs,
+                              (unsigned long long) pLink->rateBps, (unsigned long long) pLink->speedBps));
+        }
+    }
+    else
+    {
+        pLink->streak = (score >= WANMGR_METRICS_RECOVER_SCORE) ? pLink->streak + 1 : 0;
+        if (pLink->streak >= WANMGR_METRICS_RECOVER_COUNT)
+        {
+            pLink->degraded = FALSE;
+            pLink->streak = 0;
+            CcspTraceInfo(("%s %d - %s recovered, score %u\n", __FUNCTION__, __LINE__, pLink->ifName, score));
+        }
+    }
+}
+
+/* ---- Public Functions ------------------------------------- */
+
+ANSC_STATUS WanMgr_LinkMetrics_AddEcho(const char *ifName, BOOL success, UINT rttUs)
+{
+    WanMgr_LinkEntry_t *pLink;
+
+    if (ifName == NULL || ifName[0] == '\0')
+    {
+        return ANSC_STATUS_FAILURE;
+    }
+
+    pthread_mutex_lock(&gLinksMutex);
+    if ((pLink = Metrics_GetLink(ifName, TRUE)) == NULL)
+    {
+        pthread_mutex_unlock(&gLinksMutex);
+        return ANSC_STATUS_FAILURE;
+    }
+
+    //Loss is judged per sample, from what was sent in between
+    if (success == TRUE)
+    {
+        pLink->echoAnswered++;
+    }
+    else
+    {
+        pLink->echoLost++;
+    }
+
+    if (success == TRUE && rttUs > 0)
+    {
+        pLink->rttUs = (pLink->rttUs == 0) ? rttUs : pLink->rttUs + METRICS_RTT_ALPHA * (rttUs - pLink->rttUs);
+        if (pLink->minRttUs == 0 || rttUs < pLink->minRttUs)
+        {
+            pLink->minRttUs = rttUs;
+        }
+    }
+
+    pLink->lastActivityMs = Metrics_NowMs();
+    pthread_mutex_unlock(&gLinksMutex);
+
+    return ANSC_STATUS_SUCCESS;
+}
+
+ANSC_STATUS WanMgr_LinkMetrics_Update(const char *ifName)
+{
+    WanMgr_LinkEntry_t *pLink;
+    uint64_t now = Metrics_NowMs();
+    uint64_t rxBytes = 0, txBytes = 0;
+    uint64_t rxErrors = 0, txErrors = 0, txDropped = 0;
+    uint64_t speedBps;
+    uint64_t errors;
+
+    if (ifName == NULL || ifName[0] == '\0')
+    {
+        return ANSC_STATUS_FAILURE;
+    }
+
+    pthread_mutex_lock(&gLinksMutex);
+    if ((pLink = Metrics_GetLink(ifName, TRUE)) == NULL)
+    {
+        pthread_mutex_unlock(&gLinksMutex);
+        return ANSC_STATUS_FAILURE;
+    }
+
+    if (pLink->countersValid == TRUE && now - pLink->lastSampleMs < WANMGR_METRICS_SAMPLE_MS)
+    {
+        pthread_mutex_unlock(&gLinksMutex);
+        return ANSC_STATUS_SUCCESS;
+    }
+    pthread_mutex_unlock(&gLinksMutex);
+
+    //sysfs reads are done unlocked
+    if (Metrics_ReadCounter(ifName, "rx_bytes", &rxBytes) != TRUE ||
+        Metrics_ReadCounter(ifName, "tx_bytes", &txBytes) != TRUE)
+    {
+        return ANSC_STATUS_FAILURE;
+    }
+    Metrics_ReadCounter(ifName, "rx_errors", &rxErrors);
+    Metrics_ReadCounter(ifName, "tx_errors", &txErrors);
+    Metrics_ReadCounter(ifName, "tx_dropped", &txDropped);
+    speedBps = Metrics_ReadSpeed(ifName);
+
+    errors = rxErrors + txErrors + txDropped;
+
+    pthread_mutex_lock(&gLinksMutex);
+    if ((pLink = Metrics_GetLink(ifName, TRUE)) == NULL)
+    {
+        pthread_mutex_unlock(&gLinksMutex);
+        return ANSC_STATUS_FAILURE;
+    }
+
+    //Counters going backwards mean the interface was recreated, start over from here
+    if (pLink->countersValid == TRUE && rxBytes >= pLink->rxBytes && txBytes >= pLink->txBytes &&
+        errors >= pLink->errors && now > pLink->lastSampleMs)
+    {
+        uint64_t delta = (rxBytes - pLink->rxBytes > txBytes - pLink->txBytes) ? rxBytes - pLink->rxBytes : txBytes - pLink->txBytes;
+        double rate = (double) delta * 8 * 1000 / (double)(now - pLink->lastSampleMs);
+        UINT echoes = pLink->echoAnswered + pLink->echoLost;
+
+        pLink->rateBps += METRICS_RATE_ALPHA * (rate - pLink->rateBps);
+        pLink->speedBps = speedBps;
+        pLink->newErrors = (errors > pLink->errors) ? TRUE : FALSE;
+
+        //No echo in the interval (no health check on the link) leaves the loss as it was
+        if (echoes > 0)
+        {
+            pLink->lossPct += METRICS_LOSS_ALPHA * (100.0 * pLink->echoLost / echoes - pLink->lossPct);
+        }
+
+        Metrics_Score(pLink);
+    }
+
+    pLink->echoAnswered = 0;
+    pLink->echoLost = 0;
+    pLink->rxBytes = rxBytes;
+    pLink->txBytes = txBytes;
+    pLink->errors = errors;
+    pLink->countersValid = TRUE;
+    pLink->lastSampleMs = now;
+    pLink->lastActivityMs = now;
+    pthread_mutex_unlock(&gLinksMutex);
+
+    return ANSC_STATUS_SUCCESS;
+}
+
+ANSC_STATUS WanMgr_LinkMetrics_Get(const char *ifName, WanMgr_LinkMetrics_t *pMetrics)
+{
+    WanMgr_LinkEntry_t *pLink;
+
+    if (ifName == NULL || pMetrics == NULL)
+    {
+        return ANSC_STATUS_FAILURE;
+    }
+
+    memset(pMetrics, 0, sizeof(WanMgr_LinkMetrics_t));
+    pMetrics->score = WANMGR_METRICS_SCORE_MAX;
+
+    pthread_mutex_lock(&gLinksMutex);
+    if ((pLink = Metrics_GetLink(ifName, FALSE)) == NULL)
+    {
+        pthread_mutex_unlock(&gLinksMutex);
+        return ANSC_STATUS_FAILURE;
+    }
+
+    pMetrics->score = pLink->score;
+    pMetrics->degraded = pLink->degraded;
+    pMetrics->lossPct = (UINT) pLink->lossPct;
+    pMetrics->rttUs = (UINT) pLink->rttUs;
+    pMetrics->minRttUs = pLink->minRttUs;
+    pMetrics->rateBps = (uint64_t) pLink->rateBps;
+    pMetrics->speedBps = pLink->speedBps;
+    pthread_mutex_unlock(&gLinksMutex);
+
+    return ANSC_STATUS_SUCCESS;
+}
+
+BOOL WanMgr_LinkMetrics_IsDegraded(const char *ifName)
+{
+    WanMgr_LinkMetrics_t metrics;
+
+    WanMgr_LinkMetrics_Get(ifName, &metrics);
+    return metrics.degraded;
+}
@@ -0,0 +1,88 @@
+/*
+ * If not stated otherwise in this file or this component's Licenses.txt file the
+ * following copyright and licenses apply:
+ *
+ * Copyright 2020 RDK Management
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+*/
+
+#ifndef _WANMGR_LINK_METRICS_H_
+#define _WANMGR_LINK_METRICS_H_
+
+/* ---- Include Files ---------------------------------------- */
+#include <stdint.h>
+#include "ansc_platform.h"
+
+/* ---- Global Constants -------------------------------------- */
+#define WANMGR_METRICS_MAX_LINKS        8
+#define WANMGR_METRICS_SAMPLE_MS        5000    /* interface counters are sampled at most this often */
+#define WANMGR_METRICS_SCORE_MAX        100
+#define WANMGR_METRICS_DEGRADE_SCORE    50      /* a link scoring below this ... */
+#define WANMGR_METRICS_DEGRADE_COUNT    3       /* ... for this many samples is degraded */
+#define WANMGR_METRICS_RECOVER_SCORE    75      /* a degraded link scoring at least this ... */
+#define WANMGR_METRICS_RECOVER_COUNT    6       /* ... for this many samples has recovered */
+#define WANMGR_METRICS_STALE_MS         300000  /* links not measured for this long are forgotten */
+
+/* ---- Global Types -------------------------------------------- */
+typedef struct _WanMgr_LinkMetrics_t
+{
+    UINT        score;          /* 0 (unusable) .. WANMGR_METRICS_SCORE_MAX (healthy) */
+    BOOL        degraded;       /* score state after hysteresis */
+    UINT        lossPct;        /* smoothed share of echoes lost per sample */
+    UINT        rttUs;          /* smoothed echo round trip time, 0 if unknown */
+    UINT        minRttUs;       /* lowest round trip time seen, 0 if unknown */
+    uint64_t    rateBps;        /* smoothed throughput of the busier direction */
+    uint64_t    speedBps;       /* link speed reported by the driver, 0 if unknown */
+} WanMgr_LinkMetrics_t;
+
+/* ---- Global Prototypes -------------------------------------- */
+
+/***************************************************************************
+ * @brief Record the result of a health check echo on a link. Each echo
+ * sent is to be recorded once, answered or lost; the loss of the echoes
+ * recorded between two samples is folded in by WanMgr_LinkMetrics_Update().
+ * @param ifName WAN interface name
+ * @param success TRUE if the echo was answered
+ * @param rttUs round trip time of the echo in microseconds, 0 if unknown
+ * @return ANSC_STATUS_SUCCESS upon success else returned error code.
+ ****************************************************************************/
+ANSC_STATUS WanMgr_LinkMetrics_AddEcho(const char *ifName, BOOL success, UINT rttUs);
+
+/***************************************************************************
+ * @brief Sample the interface counters of a link and rescore it. Cheap to
+ * call from a policy loop, sampling is rate limited to WANMGR_METRICS_SAMPLE_MS.
+ * Utilisation is measured against the link speed, links whose driver
+ * reports none are not scored on it.
+ * @param ifName WAN interface name
+ * @return ANSC_STATUS_SUCCESS upon success else returned error code.
+ ****************************************************************************/
+ANSC_STATUS WanMgr_LinkMetrics_Update(const char *ifName);
+
+/***************************************************************************
+ * @brief Read the current metrics of a link. Links never measured, or not
+ * measured for WANMGR_METRICS_STALE_MS, read as healthy.
+ * @param ifName WAN interface name
+ * @param pMetrics output metrics
+ * @return ANSC_STATUS_SUCCESS if the link has metrics else ANSC_STATUS_FAILURE.
+ ****************************************************************************/
+ANSC_STATUS WanMgr_LinkMetrics_Get(const char *ifName, WanMgr_LinkMetrics_t *pMetrics);
+
+/***************************************************************************
+ * @brief Check whether a link is degraded, after hysteresis.
+ * @param ifName WAN interface name
+ * @return TRUE if degraded else FALSE.
+ ****************************************************************************/
+BOOL WanMgr_LinkMetrics_IsDegraded(const char *ifName);
+
+#endif /* _WANMGR_LINK_METRICS_H_ */
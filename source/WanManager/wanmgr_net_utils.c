@@ -22,7 +22,19 @@
 #include <sys/sysinfo.h>
 #include <sys/time.h>
 #include <time.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <errno.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/ioctl.h>
+#include <sys/wait.h>
+#include <net/if.h>
+#include <linux/rtnetlink.h>
 #include "wanmgr_net_utils.h"
+#include "wanmgr_netlink.h"
+#include "wanmgr_dhcp_client.h"
+#include "wanmgr_sysevents.h"
 #include "wanmgr_rdkbus_utils.h"
 #include "wanmgr_dhcpv4_apis.h"
 #include "wanmgr_rdkbus_apis.h"
@@ -35,6 +47,9 @@
 #include <sys/sysinfo.h>
 
 #define RESOLV_CONF_FILE "/etc/resolv.conf"
+#define RESOLV_CONF_TMP_SUFFIX ".tmp"
+#define RESOLV_CONF_MAX_LINKS 8
+#define RESOLV_CONF_MAX_LEN 1024
 #define LOOPBACK "127.0.0.1"
 #define BROADCAST_IP "255.255.255.255"
 /* To ignore link local addresses configured as DNS servers,
@@ -286,13 +301,15 @@ int WanManager_Ipv6AddrUtil(char *ifname, Ipv6OperType opr, int preflft, int val
 
 ANSC_STATUS WanManager_StartDhcpv6Client(const char *pcInterfaceName, BOOL isPPP)
 {
-    char cmdLine[BUFLEN_128];
-    bool enableClient = TRUE;
+    static BOOL enableClient = TRUE;
 
     CcspTraceInfo(("Enter WanManager_StartDhcpv6Client for  %s \n", DHCPV6_CLIENT_NAME));
-    sprintf(cmdLine, "%s start", DHCPV6_CLIENT_NAME);
-    system(cmdLine);
-    CcspTraceInfo(("Started %s \n", cmdLine ));
+    /* run in the foreground, so the PID we track is the client itself */
+    if (WanMgr_DhcpClient_Start(pcInterfaceName, WANMGR_DHCPC_V6, DHCPV6_CLIENT_NAME, "run") != ANSC_STATUS_SUCCESS)
+    {
+        CcspTraceError(("Failed to start %s on %s \n", DHCPV6_CLIENT_NAME, pcInterfaceName));
+        return ANSC_STATUS_FAILURE;
+    }
     if(setDibblerClientEnable(&enableClient) == ANSC_STATUS_SUCCESS)
     {
         CcspTraceInfo(("setDibblerClientEnable is successful \n"));
@@ -308,28 +325,26 @@ ANSC_STATUS WanManager_StartDhcpv6Client(const char *pcInterfaceName, BOOL isPPP
 /**
  * @brief This function will stop the DHCPV6 client(WAN side) in router
  *
+ * @param pcInterfaceName : Interface the client was started on.
  * @param boolDisconnect : This indicates whether this function called from disconnect context or not.
  *              TRUE (disconnect context) / FALSE (Non disconnect context)
  */
-ANSC_STATUS WanManager_StopDhcpv6Client(BOOL boolDisconnect)
+ANSC_STATUS WanManager_StopDhcpv6Client(const char *pcInterfaceName, BOOL boolDisconnect)
 {
-    ANSC_STATUS ret = ANSC_STATUS_SUCCESS;
-    char cmdLine[BUFLEN_128];
-
     CcspTraceInfo(("Enter WanManager_StopDhcpv6Client for  %s \n", DHCPV6_CLIENT_NAME));
-    sprintf(cmdLine, "killall %s", DHCPV6_CLIENT_NAME);
-    system(cmdLine);
-
-    CcspTraceInfo(("Exit WanManager_StopDhcpv6Client\n"));
-    return ret;
+    return WanMgr_DhcpClient_Stop(pcInterfaceName, WANMGR_DHCPC_V6, boolDisconnect);
 }
 
 uint32_t WanManager_StartDhcpv4Client(const char *intf, BOOL discover)
 {
-    uint32_t pid = 0;
     char cmdLine[BUFLEN_128];
     char exeBuff[1024] = {0};
 
+    if (intf == NULL)
+    {
+        return 0;
+    }
+
     /**
      * In case of udhcpc, we are passing action handler program which will be invoked
      * and fill the required dhcpv4 configuration. This handler will pass the data back
@@ -338,60 +353,34 @@ uint32_t WanManager_StartDhcpv4Client(const char *intf, BOOL discover)
     if (ANSC_STATUS_SUCCESS != GetPathToApp(DHCPV4_ACTION_HANDLER, exeBuff, sizeof(exeBuff) - 1))
     {
         CcspTraceError(("Could not find requested app [%s] in CPE , not passing -s option to udhcpc \n", DHCPV4_ACTION_HANDLER));
-        snprintf(cmdLine, sizeof(cmdLine), "-f -i %s -p %s", (intf != NULL ? intf : ""),DHCPV4C_PID_FILE);
+        snprintf(cmdLine, sizeof(cmdLine), "-f -i %s -p %s", intf, DHCPV4C_PID_FILE);
     }
     else
     {
-        snprintf(cmdLine, sizeof(cmdLine), "-f -i %s -p %s -s %s", (intf != NULL ? intf : ""),DHCPV4C_PID_FILE, exeBuff);
+        snprintf(cmdLine, sizeof(cmdLine), "-f -i %s -p %s -s %s", intf, DHCPV4C_PID_FILE, exeBuff);
     }
 
-    pid = WanManager_DoStartApp(DHCPV4_CLIENT_NAME, cmdLine);
+    if (WanMgr_DhcpClient_Start(intf, WANMGR_DHCPC_V4, DHCPV4_CLIENT_NAME, cmdLine) != ANSC_STATUS_SUCCESS)
+    {
+        CcspTraceError(("Failed to start %s on %s \n", DHCPV4_CLIENT_NAME, intf));
+        return 0;
+    }
 
-    return pid;
+    return WanMgr_DhcpClient_GetPid(intf, WANMGR_DHCPC_V4);
 }
 
-ANSC_STATUS WanManager_StopDhcpv4Client(BOOL sendReleaseAndExit)
+ANSC_STATUS WanManager_StopDhcpv4Client(const char *intf, BOOL sendReleaseAndExit)
 {
     CcspTraceInfo(("Enter WanManager_StopDhcpv4Client for  %s \n", DHCPV4_CLIENT_NAME));
-    ANSC_STATUS ret = ANSC_STATUS_SUCCESS;
-
-    if (!sendReleaseAndExit)
-    {
-        WanManager_DoStopApp(DHCPV4_CLIENT_NAME);
-    }
-    else
-    {
-        CcspTraceInfo(("Sending release and exit  msg to %s \n", DHCPV4_CLIENT_NAME));
-        if (WanManager_IsApplicationRunning(DHCPV4_CLIENT_NAME) == TRUE)
-        {
-            int pid = util_getPidByName(DHCPV4_CLIENT_NAME);
-            CcspTraceInfo(("sending SIGUSR2 to [%s][pid=%d], this will let the %s to send release packet out and exit \n", DHCPV4_CLIENT_NAME));
-            if (util_signalProcess(pid, SIGUSR2) != RETURN_OK)
-            {
-                WanManager_DoStopApp(DHCPV4_CLIENT_NAME);
-            }
-            else
-            {
-                /* Collect if any zombie process. */
-                WanManager_DoCollectApp(DHCPV4_CLIENT_NAME);
-            }
-        }
-    }
-
-    return ret;
+    return WanMgr_DhcpClient_Stop(intf, WANMGR_DHCPC_V4, sendReleaseAndExit);
 }
 
 void WanUpdateDhcp6cProcessId(char *currentBaseIfName)
 {
     INT           wanIndex = -1;
-    int processId = 0;
-    char cmdLine[BUFLEN_128];
-    char out[BUFLEN_128] = {0};
+    int processId = WanMgr_DhcpClient_GetPid(currentBaseIfName, WANMGR_DHCPC_V6);
 
-    sprintf(cmdLine, "pidof %s", DHCPV6_CLIENT_NAME);
-    _get_shell_output(cmdLine, out, sizeof(out));
-    CcspTraceError(("%s Updating dibbler client pid %s\n", __func__, out));
-    processId = atoi(out);
+    CcspTraceInfo(("%s Updating dibbler client pid %d\n", __func__, processId));
 
     WanMgr_Iface_Data_t* pWanDmlIfaceData = WanMgr_GetIfaceDataByName_locked(currentBaseIfName);
     if (pWanDmlIfaceData != NULL)
@@ -408,12 +397,11 @@ void WanUpdateDhcp6cProcessId(char *currentBaseIfName)
 
 #ifdef FEATURE_MAPT
 const char *nat44PostRoutingTable = "OUTBOUND_POSTROUTING";
-char ipv6AddressString[BUFLEN_256] = " ";
 #ifdef FEATURE_MAPT_DEBUG
-void WanManager_UpdateMaptLogFile(Dhcp6cMAPTParametersMsgBody *dhcp6cMAPTMsgBody);
+void WanManager_UpdateMaptLogFile(const Dhcp6cMAPTParametersMsgBody *dhcp6cMAPTMsgBody);
 #endif // FEATURE_MAPT_DEBUG
-static int WanManager_CalculateMAPTPsid(char *pdIPv6Prefix, int v6PrefixLen, int iapdPrefixLen, int v4PrefixLen, int *psidValue, int *ipv4IndexValue, int *psidLen);
-static int WanManager_ConfigureIpv6Sysevents(char *pdIPv6Prefix, char *ipAddressString, int psidValue);
+static int WanManager_CalculateMAPTPsid(const char *pdIPv6Prefix, int v6PrefixLen, int iapdPrefixLen, int v4PrefixLen, int *psidValue, int *ipv4IndexValue, int *psidLen);
+static int WanManager_BuildMaptIpv6Address(const char *pdIPv6Prefix, const char *ipAddressString, int psidValue, char *ipv6AddressString, size_t len);
 
 static unsigned WanManager_GetMAPTbits(unsigned value, int pos, int num)
 {
@@ -456,80 +444,269 @@ static ANSC_STATUS WanManager_GetLANIPAddress(char *ipAddress, size_t length)
     return ANSC_STATUS_SUCCESS;
 }
 
-int WanManager_ProcessMAPTConfiguration(Dhcp6cMAPTParametersMsgBody *dhcp6cMAPTMsgBody, const char *baseIf, const char *vlanIf)
+/* Kernel state touched by a MAP-T apply, used to roll back a partial apply */
+typedef struct _WanMgr_MaptApplyState_t
+{
+    char baseIf[BUFLEN_64];
+    char vlanIf[BUFLEN_64];
+    int  baseIfMtu;             /* previous MTU, 0 if untouched */
+    int  vlanIfMtu;             /* previous MTU, 0 if untouched */
+    char rpFilter[BUFLEN_16];   /* previous rp_filter value, empty if untouched */
+    BOOL iviConfigured;         /* ivictl ran, rules or the translator may be in place */
+    BOOL maptInfoSet;
+} WanMgr_MaptApplyState_t;
+
+static int WanManager_GetIfMtu(const char *ifName, int *pMtu)
 {
+    struct ifreq ifr;
+    int fd;
     int ret = RETURN_OK;
-    char cmdDMRConfig[BUFLEN_128 + BUFLEN_64];
-    char cmdBMRConfig[BUFLEN_256];
-    char cmdStartMAPT[BUFLEN_256];
-    char cmdDisableMapFiltering[BUFLEN_64];
-    int psidValue = 0;
-    int ipv4IndexValue = 0;
-    char ipAddressString[BUFLEN_32] = "";
-    char ipLANAddressString[BUFLEN_32] = "";
-    struct in_addr result;
-    unsigned char ipAddressBytes[BUFLEN_4];
-    unsigned int ipValue = 0;
-    int psidLen = 0;
-    char cmdConfigureMTUSize[BUFLEN_64] = "";
-    char cmdEnableIpv4Traffic[BUFLEN_64] = "";
-    MaptData_t maptInfo;
 
-    /* RM16042: Since erouter0 is vlan interface on top of eth3, we need
-       to first set the MTU size of eth3 to 1520 and then change MTU of erouter0.
-       Otherwise we can't configure MTU as we are getting `Numerical result out of range` error.
-       Configure eth3 MTU size to 1520.
-    */
-    snprintf(cmdConfigureMTUSize, sizeof(cmdConfigureMTUSize), "ip link set dev %s mtu %d ", baseIf, MTU_SIZE);
+    if ((fd = socket(AF_INET, SOCK_DGRAM | SOCK_CLOEXEC, 0)) < 0)
+    {
+        return RETURN_ERR;
+    }
+
+    memset(&ifr, 0, sizeof(ifr));
+    strncpy(ifr.ifr_name, ifName, sizeof(ifr.ifr_name) - 1);
+    if (ioctl(fd, SIOCGIFMTU, &ifr) < 0)
+    {
+        CcspTraceError(("%s %d - SIOCGIFMTU %s failed (%s)\n", __FUNCTION__, __LINE__, ifName, strerror(errno)));
+        ret = RETURN_ERR;
+    }
+    else
+    {
+        *pMtu = ifr.ifr_mtu;
+    }
+
+    close(fd);
+    return ret;
+}
+
+static int WanManager_SetIfMtu(const char *ifName, int mtu)
+{
+    struct ifreq ifr;
+    int fd;
+    int ret = RETURN_OK;
 
 #ifdef FEATURE_MAPT_DEBUG
-    LOG_PRINT_MAPT("ivictl:cmdConfigureMTUSize:%s", cmdConfigureMTUSize);
+    LOG_PRINT_MAPT("ivictl:set mtu %d on %s", mtu, ifName);
 #endif
 
-    if ((ret = WanManager_DoSystemActionWithStatus("ivictl", cmdConfigureMTUSize)) < RETURN_OK)
+    if ((fd = socket(AF_INET, SOCK_DGRAM | SOCK_CLOEXEC, 0)) < 0)
     {
-        CcspTraceError(("Failed to run: %s:%d", cmdConfigureMTUSize, ret));
-        return ret;
+        return RETURN_ERR;
     }
 
-    /*  Configure erouter0 MTU size. */
-    snprintf(cmdConfigureMTUSize, sizeof(cmdConfigureMTUSize), "ip link set dev %s mtu %d ", vlanIf, MTU_SIZE);
+    memset(&ifr, 0, sizeof(ifr));
+    strncpy(ifr.ifr_name, ifName, sizeof(ifr.ifr_name) - 1);
+    ifr.ifr_mtu = mtu;
+    if (ioctl(fd, SIOCSIFMTU, &ifr) < 0)
+    {
+        CcspTraceError(("%s %d - SIOCSIFMTU %s %d failed (%s)\n", __FUNCTION__, __LINE__, ifName, mtu, strerror(errno)));
+        ret = RETURN_ERR;
+    }
 
-#ifdef FEATURE_MAPT_DEBUG
-    LOG_PRINT_MAPT("ivictl:cmdConfigureMTUSize:%s", cmdConfigureMTUSize);
-#endif
+    close(fd);
+    return ret;
+}
+
+int WanManager_SetProcSysValue(const char *path, const char *value, char *oldValue, size_t oldLen)
+{
+    int fd;
+    ssize_t len;
 
-    if ((ret = WanManager_DoSystemActionWithStatus("ivictl", cmdConfigureMTUSize)) < RETURN_OK)
+    if (oldValue != NULL && oldLen > 0)
     {
-        CcspTraceError(("Failed to run: %s:%d", cmdConfigureMTUSize, ret));
-        return ret;
+        oldValue[0] = '\0';
+        if ((fd = open(path, O_RDONLY | O_CLOEXEC)) >= 0)
+        {
+            if ((len = read(fd, oldValue, oldLen - 1)) > 0)
+            {
+                oldValue[len] = '\0';
+                oldValue[strcspn(oldValue, "\n")] = '\0';
+            }
+            close(fd);
+        }
     }
 
-    snprintf(cmdDMRConfig, sizeof(cmdDMRConfig), "ivictl -r -d -P %s -T", dhcp6cMAPTMsgBody->brIPv6Prefix);
-#ifdef FEATURE_MAPT_DEBUG
-    WanManager_UpdateMaptLogFile(dhcp6cMAPTMsgBody);
-    LOG_PRINT_MAPT("### ivictl commands - START ###");
-    LOG_PRINT_MAPT("ivictl:DMR config:%s", cmdDMRConfig);
-#endif
+    if ((fd = open(path, O_WRONLY | O_CLOEXEC)) < 0)
+    {
+        CcspTraceError(("%s %d - open %s failed (%s)\n", __FUNCTION__, __LINE__, path, strerror(errno)));
+        return RETURN_ERR;
+    }
 
-    if ((ret = WanManager_DoSystemActionWithStatus("ivictl", cmdDMRConfig)) < RETURN_OK)
+    len = write(fd, value, strlen(value));
+    close(fd);
+
+    if (len != (ssize_t) strlen(value))
     {
-        CcspTraceError(("Failed to run: %s:%d", cmdDMRConfig, ret));
-        return ret;
+        CcspTraceError(("%s %d - write %s to %s failed\n", __FUNCTION__, __LINE__, value, path));
+        return RETURN_ERR;
     }
-    snprintf(cmdBMRConfig, sizeof(cmdBMRConfig), "ivictl -r -p %s -P %s -z %d -R %d -T", dhcp6cMAPTMsgBody->ruleIPv4Prefix,
-             dhcp6cMAPTMsgBody->ruleIPv6Prefix, dhcp6cMAPTMsgBody->psidOffset, dhcp6cMAPTMsgBody->ratio);
+
+    return RETURN_OK;
+}
+
+/* Runs ivictl directly (no shell). Its exit codes are not reliable, only
+IVICTL_COMMAND_ERROR is taken as a failure */
+static int WanManager_RunIvictl(const char *args)
+{
+    char exeBuf[MAX_FULLPATH_LENGTH] = {0};
+    int pid = 0;
+    int status = 0;
+    int rc;
 
 #ifdef FEATURE_MAPT_DEBUG
-    LOG_PRINT_MAPT("ivictl:BMR config:%s", cmdBMRConfig);
+    LOG_PRINT_MAPT("ivictl %s", args);
 #endif
 
-    if ((ret = WanManager_DoSystemActionWithStatus("ivictl", cmdBMRConfig)) < RETURN_OK)
+    if (GetPathToApp("ivictl", exeBuf, sizeof(exeBuf) - 1) != ANSC_STATUS_SUCCESS)
     {
-        CcspTraceError(("Failed to run: %s:%d", cmdBMRConfig, ret));
-        return ret;
+        CcspTraceError(("%s %d - ivictl not found\n", __FUNCTION__, __LINE__));
+        return RETURN_ERR;
+    }
+
+    if (util_spawnProcess(exeBuf, args, &pid) != RETURN_OK || pid < 0)
+    {
+        CcspTraceError(("%s %d - failed to spawn ivictl %s\n", __FUNCTION__, __LINE__, args));
+        return RETURN_ERR;
+    }
+
+    while ((rc = waitpid(pid, &status, 0)) < 0 && errno == EINTR);
+
+    if (rc < 0)
+    {
+        CcspTraceError(("%s %d - could not collect ivictl %s, errno %d\n", __FUNCTION__, __LINE__, args, errno));
+        return RETURN_ERR;
+    }
+
+    if (!WIFEXITED(status))
+    {
+        CcspTraceError(("%s %d - ivictl %s did not exit, status %d\n", __FUNCTION__, __LINE__, args, status));
+        return RETURN_ERR;
+    }
+
+    if (WEXITSTATUS(status) == IVICTL_COMMAND_ERROR)
+    {
+        CcspTraceError(("%s %d - ivictl %s failed, exit %d\n", __FUNCTION__, __LINE__, args, WEXITSTATUS(status)));
+        return RETURN_ERR;
+    }
+
+    if (WEXITSTATUS(status) != 0)
+    {
+        CcspTraceInfo(("%s %d - ivictl %s exited %d, ignored\n", __FUNCTION__, __LINE__, args, WEXITSTATUS(status)));
+    }
+
+    return RETURN_OK;
+}
+
+static void WanManager_RollbackMAPTConfiguration(WanMgr_MaptApplyState_t *pState)
+{
+    char path[BUFLEN_128] = {0};
+
+    CcspTraceWarning(("%s %d - rolling back partial MAP-T configuration\n", __FUNCTION__, __LINE__));
+
+    if (pState->maptInfoSet)
+    {
+        maptInfo_reset();
+        wanmgr_sysevents_scheduleRestart(WANMGR_RESTART_FIREWALL);
     }
 
+    if (pState->iviConfigured)
+    {
+        WanManager_RunIvictl("-q");
+    }
+
+    if (pState->rpFilter[0] != '\0')
+    {
+        snprintf(path, sizeof(path), "/proc/sys/net/ipv4/conf/%s/rp_filter", pState->vlanIf);
+        WanManager_SetProcSysValue(path, pState->rpFilter, NULL, 0);
+    }
+
+    /* vlan interface first, its MTU can't exceed the base interface MTU */
+    if (pState->vlanIfMtu > 0)
+    {
+        WanManager_SetIfMtu(pState->vlanIf, pState->vlanIfMtu);
+    }
+
+    if (pState->baseIfMtu > 0)
+    {
+        WanManager_SetIfMtu(pState->baseIf, pState->baseIfMtu);
+    }
+}
+
+/* ivictl arguments and firewall data derived from one MAP-T option set */
+typedef struct _WanMgr_MaptConfig_t
+{
+    Dhcp6cMAPTParametersMsgBody msg;    /* option set, with the sharing ratio defaulted */
+    char lanAddress[BUFLEN_32];         /* LAN address/length the translator serves */
+    char ipAddress[BUFLEN_32];          /* mapped IPv4 address */
+    int  psidValue;
+    int  psidLen;
+    char dmrArgs[BUFLEN_128 + BUFLEN_64];
+    char bmrArgs[BUFLEN_256];
+    char startArgs[BUFLEN_256];
+    MaptData_t maptInfo;
+} WanMgr_MaptConfig_t;
+
+/* Compare two "address[/length]" strings by value, so a different spelling of
+ * the same prefix is not taken for a change. Unparsable strings compare as text. */
+static BOOL WanManager_SameMaptPrefix(int family, const char *pA, const char *pB)
+{
+    char buf[2][BUFLEN_128];
+    unsigned char addr[2][sizeof(struct in6_addr)];
+    const char *pIn[2] = { pA, pB };
+    char *pLen[2];
+    int i;
+
+    for (i = 0; i < 2; i++)
+    {
+        snprintf(buf[i], sizeof(buf[i]), "%s", pIn[i]);
+        if ((pLen[i] = strchr(buf[i], '/')) != NULL)
+        {
+            *pLen[i]++ = '\0';
+        }
+        if (inet_pton(family, buf[i], addr[i]) != 1)
+        {
+            return (strcmp(pA, pB) == 0) ? TRUE : FALSE;
+        }
+    }
+
+    if (memcmp(addr[0], addr[1], (family == AF_INET) ? sizeof(struct in_addr) : sizeof(struct in6_addr)) != 0)
+    {
+        return FALSE;
+    }
+
+    if (pLen[0] == NULL || pLen[1] == NULL)
+    {
+        return (pLen[0] == pLen[1]) ? TRUE : FALSE;
+    }
+
+    return (atoi(pLen[0]) == atoi(pLen[1])) ? TRUE : FALSE;
+}
+
+/* Works out everything that can fail before touching the kernel,
+ * so an invalid option set leaves the current configuration alone.
+ * Nothing is written here, the sysevents are only set from pCfg->maptInfo
+ * of the configuration that gets applied. */
+static int WanManager_PrepareMAPTConfiguration(const Dhcp6cMAPTParametersMsgBody *pMsg, const char *vlanIf, WanMgr_MaptConfig_t *pCfg)
+{
+    Dhcp6cMAPTParametersMsgBody *dhcp6cMAPTMsgBody = &pCfg->msg;
+    int ret = RETURN_OK;
+    int psidValue = 0;
+    int ipv4IndexValue = 0;
+    char *ipAddressString = pCfg->ipAddress;
+    char *ipLANAddressString = pCfg->lanAddress;
+    char ipv6AddressString[BUFLEN_256] = "";
+    struct in_addr result;
+    unsigned char ipAddressBytes[BUFLEN_4];
+    unsigned int ipValue = 0;
+    int psidLen = 0;
+
+    memset(pCfg, 0, sizeof(WanMgr_MaptConfig_t));
+    memcpy(dhcp6cMAPTMsgBody, pMsg, sizeof(Dhcp6cMAPTParametersMsgBody));
+
     ret = WanManager_CalculateMAPTPsid(dhcp6cMAPTMsgBody->pdIPv6Prefix, dhcp6cMAPTMsgBody->v6Len, dhcp6cMAPTMsgBody->iapdPrefixLen,
                                           dhcp6cMAPTMsgBody->v4Len, &psidValue, &ipv4IndexValue, &psidLen);
 
@@ -539,7 +716,6 @@ int WanManager_ProcessMAPTConfiguration(Dhcp6cMAPTParametersMsgBody *dhcp6cMAPTM
 #ifdef FEATURE_MAPT_DEBUG
         LOG_PRINT_MAPT("Exiting MAPT configuration, MAPT will not be configured, as invalid dhcpc6c options found");
 #endif
-        CcspTraceNotice(("FEATURE_MAPT: MAP-T configuration failed\n"));
         return ret;
     }
 
@@ -562,15 +738,14 @@ int WanManager_ProcessMAPTConfiguration(Dhcp6cMAPTParametersMsgBody *dhcp6cMAPTM
         ipAddressBytes[0] = (ipAddressBytes[0] + ipv4IndexValue) - 255;
 
     //store new ipv4 address
-    //dhcp6cMAPTMsgBody->ipv4Address = ( ((ipAddressBytes[3] & 0xFF) << 24) | ((ipAddressBytes[2] & 0xFF) << 16) | ((ipAddressBytes[1] & 0xFF) << 8) | (ipAddressBytes[0] & 0xFF) );
-    snprintf(ipAddressString, sizeof(ipAddressString), "%d.%d.%d.%d", ipAddressBytes[3], ipAddressBytes[2], ipAddressBytes[1], ipAddressBytes[0]);
+    snprintf(ipAddressString, sizeof(pCfg->ipAddress), "%d.%d.%d.%d", ipAddressBytes[3], ipAddressBytes[2], ipAddressBytes[1], ipAddressBytes[0]);
 
 #ifdef FEATURE_MAPT_DEBUG
     LOG_PRINT_MAPT("ipAddressString:%s", ipAddressString);
 #endif
 
     //get LAN IP Address
-    if ((ret = WanManager_GetLANIPAddress(ipLANAddressString, sizeof(ipLANAddressString))) != RETURN_OK)
+    if ((ret = WanManager_GetLANIPAddress(ipLANAddressString, sizeof(pCfg->lanAddress))) != RETURN_OK)
     {
         CcspTraceError(("Could not get LAN IP Address"));
         return ret;
@@ -579,94 +754,268 @@ int WanManager_ProcessMAPTConfiguration(Dhcp6cMAPTParametersMsgBody *dhcp6cMAPTM
     if (dhcp6cMAPTMsgBody->ratio == 0)
         dhcp6cMAPTMsgBody->ratio = 1;
 
-    if ((ret = WanManager_ConfigureIpv6Sysevents(dhcp6cMAPTMsgBody->pdIPv6Prefix, ipAddressString, psidValue)) != RETURN_OK)
+    if ((ret = WanManager_BuildMaptIpv6Address(dhcp6cMAPTMsgBody->pdIPv6Prefix, ipAddressString, psidValue,
+                                               ipv6AddressString, sizeof(ipv6AddressString))) != RETURN_OK)
     {
-        CcspTraceError(("Failed to configure ipv6Tablerules"));
+        CcspTraceError(("Failed to build the MAP-T IPv6 address"));
         return ret;
     }
-    // create MAP-T command string
-    snprintf(cmdStartMAPT, sizeof(cmdStartMAPT), "ivictl -s -i %s -I %s -H -a %s -A %s/%d -P %s -z %d -R %d -T -o %d", ETH_BRIDGE_NAME, vlanIf,
+
+    pCfg->psidValue = psidValue;
+    pCfg->psidLen = psidLen;
+
+    snprintf(pCfg->dmrArgs, sizeof(pCfg->dmrArgs), "-r -d -P %s -T", dhcp6cMAPTMsgBody->brIPv6Prefix);
+    snprintf(pCfg->bmrArgs, sizeof(pCfg->bmrArgs), "-r -p %s -P %s -z %d -R %d -T", dhcp6cMAPTMsgBody->ruleIPv4Prefix,
+             dhcp6cMAPTMsgBody->ruleIPv6Prefix, dhcp6cMAPTMsgBody->psidOffset, dhcp6cMAPTMsgBody->ratio);
+    snprintf(pCfg->startArgs, sizeof(pCfg->startArgs), "-s -i %s -I %s -H -a %s -A %s/%d -P %s -z %d -R %d -T -o %d", ETH_BRIDGE_NAME, vlanIf,
              ipLANAddressString, ipAddressString, dhcp6cMAPTMsgBody->v4Len, dhcp6cMAPTMsgBody->ruleIPv6Prefix, dhcp6cMAPTMsgBody->psidOffset,
              dhcp6cMAPTMsgBody->ratio, psidValue);
 
-#ifdef FEATURE_MAPT_DEBUG
-    LOG_PRINT_MAPT("ivictl:startMapt Command:%s", cmdStartMAPT);
-#endif
-    ret = WanManager_DoSystemActionWithStatus("ivictl", cmdStartMAPT);
+    strncpy(pCfg->maptInfo.maptConfigFlag, SET, sizeof(pCfg->maptInfo.maptConfigFlag));
+    strncpy(pCfg->maptInfo.ruleIpAddressString, dhcp6cMAPTMsgBody->ruleIPv4Prefix, sizeof(pCfg->maptInfo.ruleIpAddressString));
+    strncpy(pCfg->maptInfo.ruleIpv6AddressString, dhcp6cMAPTMsgBody->ruleIPv6Prefix, sizeof(pCfg->maptInfo.ruleIpv6AddressString));
+    strncpy(pCfg->maptInfo.brIpv6PrefixString, dhcp6cMAPTMsgBody->brIPv6Prefix, sizeof(pCfg->maptInfo.brIpv6PrefixString));
+    strncpy(pCfg->maptInfo.ipAddressString, ipAddressString, sizeof(pCfg->maptInfo.ipAddressString));
+    strncpy(pCfg->maptInfo.ipv6AddressString, ipv6AddressString, sizeof(pCfg->maptInfo.ipv6AddressString));
+    pCfg->maptInfo.psidValue = psidValue;
+    pCfg->maptInfo.psidLen = psidLen;
+    pCfg->maptInfo.ratio = dhcp6cMAPTMsgBody->ratio;
+    pCfg->maptInfo.psidOffset = dhcp6cMAPTMsgBody->psidOffset;
+    pCfg->maptInfo.eaLen = dhcp6cMAPTMsgBody->eaLen;
+    pthread_mutex_lock(&gmWanDataMutex);
+    pCfg->maptInfo.maptAssigned = gWanData.ipv6Data.maptAssigned;
+    pCfg->maptInfo.mapeAssigned = gWanData.ipv6Data.mapeAssigned;
+    pCfg->maptInfo.isFMR = gWanData.ipv6Data.isFMR;
+    pthread_mutex_unlock(&gmWanDataMutex);
+
+    return RETURN_OK;
+}
+
+int WanManager_ProcessMAPTConfiguration(const Dhcp6cMAPTParametersMsgBody *dhcp6cMAPTMsgBody, const char *baseIf, const char *vlanIf)
+{
+    int ret = RETURN_OK;
+    char rpFilterPath[BUFLEN_128];
+    WanMgr_MaptConfig_t maptCfg;
+    WanMgr_MaptApplyState_t applyState;
 
-    //Added check since the 'system' command is not returning the expected value
-    if (ret == IVICTL_COMMAND_ERROR)
+    if ((ret = WanManager_PrepareMAPTConfiguration(dhcp6cMAPTMsgBody, vlanIf, &maptCfg)) != RETURN_OK)
     {
-        CcspTraceError(("Failed to run: %s:%d", cmdStartMAPT, ret));
+        CcspTraceNotice(("FEATURE_MAPT: MAP-T configuration failed\n"));
         return ret;
     }
 
-    snprintf(cmdDisableMapFiltering, sizeof(cmdDisableMapFiltering), "echo 0 > /proc/sys/net/ipv4/conf/%s/rp_filter", vlanIf);
+    snprintf(rpFilterPath, sizeof(rpFilterPath), "/proc/sys/net/ipv4/conf/%s/rp_filter", vlanIf);
 
 #ifdef FEATURE_MAPT_DEBUG
-    LOG_PRINT_MAPT("ivictl:Disable RP Filtering:%s", cmdDisableMapFiltering);
+    WanManager_UpdateMaptLogFile(dhcp6cMAPTMsgBody);
+    LOG_PRINT_MAPT("### ivictl commands - START ###");
 #endif
 
-    if ((ret = WanManager_DoSystemActionWithStatus("ivictl", cmdDisableMapFiltering)) < RETURN_OK)
+    /* Apply. Any failure from here on undoes the steps already taken. */
+    memset(&applyState, 0, sizeof(applyState));
+    strncpy(applyState.baseIf, baseIf, sizeof(applyState.baseIf) - 1);
+    strncpy(applyState.vlanIf, vlanIf, sizeof(applyState.vlanIf) - 1);
+
+    /* RM16042: Since erouter0 is vlan interface on top of eth3, we need
+       to first set the MTU size of eth3 to 1520 and then change MTU of erouter0.
+       Otherwise we can't configure MTU as we are getting `Numerical result out of range` error. */
+    if ((ret = WanManager_GetIfMtu(baseIf, &applyState.baseIfMtu)) != RETURN_OK ||
+        (ret = WanManager_SetIfMtu(baseIf, MTU_SIZE)) != RETURN_OK)
     {
-        CcspTraceError(("Failed to run: %s:%d", cmdDisableMapFiltering, ret));
-        return ret;
+        applyState.baseIfMtu = 0;
+        goto ROLLBACK;
     }
 
-#ifdef FEATURE_MAPT_DEBUG
-    LOG_PRINT_MAPT("ivictl:Calling configureDefaultIpTableRules()... ");
-#endif
+    if ((ret = WanManager_GetIfMtu(vlanIf, &applyState.vlanIfMtu)) != RETURN_OK ||
+        (ret = WanManager_SetIfMtu(vlanIf, MTU_SIZE)) != RETURN_OK)
+    {
+        applyState.vlanIfMtu = 0;
+        goto ROLLBACK;
+    }
+
+    /* a failing ivictl may still have installed part of its rules */
+    applyState.iviConfigured = TRUE;
+    if ((ret = WanManager_RunIvictl(maptCfg.dmrArgs)) != RETURN_OK ||
+        (ret = WanManager_RunIvictl(maptCfg.bmrArgs)) != RETURN_OK ||
+        (ret = WanManager_RunIvictl(maptCfg.startArgs)) != RETURN_OK)
+    {
+        goto ROLLBACK;
+    }
+
+    if ((ret = WanManager_SetProcSysValue(rpFilterPath, "0", applyState.rpFilter, sizeof(applyState.rpFilter))) != RETURN_OK)
+    {
+        goto ROLLBACK;
+    }
 
     /**
      * Firewall rules are changed to utopia firewall
      * To update the firewall rules, required the MAPT specific values, so
      * updated sysvents and restart firewall.
      * First set MAPT_CONFIG_FLAG to set, so firewall can add rules for the MAPT configuration. */
-    memset(&maptInfo, 0, sizeof(maptInfo));
-    strncpy(maptInfo.maptConfigFlag, SET, sizeof(maptInfo.maptConfigFlag));
-    strncpy(maptInfo.ruleIpAddressString, dhcp6cMAPTMsgBody->ruleIPv4Prefix, sizeof(maptInfo.ruleIpAddressString));
-    strncpy(maptInfo.ruleIpv6AddressString, dhcp6cMAPTMsgBody->ruleIPv6Prefix, sizeof(maptInfo.ruleIpv6AddressString));
-    strncpy(maptInfo.brIpv6PrefixString, dhcp6cMAPTMsgBody->brIPv6Prefix, sizeof(maptInfo.brIpv6PrefixString));
-    strncpy(maptInfo.ipAddressString, ipAddressString, sizeof(maptInfo.ipAddressString));
-    strncpy(maptInfo.ipv6AddressString, ipv6AddressString, sizeof(maptInfo.ipv6AddressString));
-    maptInfo.psidValue = psidValue;
-    maptInfo.psidLen = psidLen;
-    maptInfo.ratio = dhcp6cMAPTMsgBody->ratio;
-    maptInfo.psidOffset = dhcp6cMAPTMsgBody->psidOffset;
-    maptInfo.eaLen = dhcp6cMAPTMsgBody->eaLen;
-    pthread_mutex_lock(&gmWanDataMutex);
-    maptInfo.maptAssigned = gWanData.ipv6Data.maptAssigned;
-    maptInfo.mapeAssigned = gWanData.ipv6Data.mapeAssigned;
-    maptInfo.isFMR = gWanData.ipv6Data.isFMR;
-    pthread_mutex_unlock(&gmWanDataMutex);
-
-    if ((ret = maptInfo_set(&maptInfo)) != RETURN_OK)
+    if ((ret = maptInfo_set(&maptCfg.maptInfo)) != RETURN_OK)
     {
         CcspTraceError(("Failed to set sysevents for MAPT feature to set firewall rules \n"));
-        return ret;
+        goto ROLLBACK;
+    }
+    applyState.maptInfoSet = TRUE;
+
+    if (WanMgr_Netlink_ReplaceDefaultRoute(vlanIf) != ANSC_STATUS_SUCCESS)
+    {
+        ret = RETURN_ERR;
+        goto ROLLBACK;
     }
 
     /* Restart firewall to reflect the changes. Do a sysevent to notify firewall to
      * restart and update rules. */
-    sysevent_set(sysevent_fd, sysevent_token, SYSEVENT_FIREWALL_RESTART, NULL, 0);
-    snprintf(cmdEnableIpv4Traffic, sizeof(cmdEnableIpv4Traffic), "ip ro rep default dev %s", vlanIf);
+    wanmgr_sysevents_scheduleRestart(WANMGR_RESTART_FIREWALL);
+
 #ifdef FEATURE_MAPT_DEBUG
-    LOG_PRINT_MAPT("ivictl:cmdEnableIpv4Traffic:%s", cmdEnableIpv4Traffic);
+    LOG_PRINT_MAPT("### ivictl commands - ENDS  ###");
 #endif
-    if ((ret = WanManager_DoSystemActionWithStatus("ivictl", cmdEnableIpv4Traffic)) < RETURN_OK)
+    CcspTraceNotice(("FEATURE_MAPT: MAP-T configuration done\n"));
+    return RETURN_OK;
+
+ROLLBACK:
+    WanManager_RollbackMAPTConfiguration(&applyState);
+    CcspTraceNotice(("FEATURE_MAPT: MAP-T configuration failed\n"));
+    return (ret != RETURN_OK) ? ret : RETURN_ERR;
+}
+
+UINT32 WanManager_DiffMAPTConfiguration(const Dhcp6cMAPTParametersMsgBody *pOld, const Dhcp6cMAPTParametersMsgBody *pNew)
+{
+    UINT32 diff = 0;
+
+    if (!WanManager_SameMaptPrefix(AF_INET6, pOld->brIPv6Prefix, pNew->brIPv6Prefix))
     {
-        CcspTraceError(("Failed to run: %s:%d", cmdEnableIpv4Traffic, ret));
-        return ret;
+        diff |= WANMGR_MAPT_DIFF_DMR;
+    }
+
+    /* a sharing ratio of 0 means 1 */
+    if (!WanManager_SameMaptPrefix(AF_INET, pOld->ruleIPv4Prefix, pNew->ruleIPv4Prefix) ||
+        !WanManager_SameMaptPrefix(AF_INET6, pOld->ruleIPv6Prefix, pNew->ruleIPv6Prefix) ||
+        pOld->psidOffset != pNew->psidOffset ||
+        ((pOld->ratio == 0) ? 1 : pOld->ratio) != ((pNew->ratio == 0) ? 1 : pNew->ratio) ||
+        pOld->eaLen != pNew->eaLen)
+    {
+        diff |= WANMGR_MAPT_DIFF_BMR;
+    }
+
+    if (!WanManager_SameMaptPrefix(AF_INET6, pOld->pdIPv6Prefix, pNew->pdIPv6Prefix) ||
+        pOld->v6Len != pNew->v6Len ||
+        pOld->iapdPrefixLen != pNew->iapdPrefixLen ||
+        pOld->v4Len != pNew->v4Len)
+    {
+        diff |= WANMGR_MAPT_DIFF_PSID;
+    }
+
+    return diff;
+}
+
+int WanManager_UpdateMAPTConfiguration(const Dhcp6cMAPTParametersMsgBody *pOld, const Dhcp6cMAPTParametersMsgBody *pNew, const char *vlanIf)
+{
+    WanMgr_MaptConfig_t oldCfg;
+    WanMgr_MaptConfig_t newCfg;
+    UINT32 diff;
+    int mtu = 0;
+    BOOL restartIvi;
+    BOOL dmrChanged;
+    BOOL bmrChanged;
+
+    diff = WanManager_DiffMAPTConfiguration(pOld, pNew);
+
+    if (WanManager_PrepareMAPTConfiguration(pOld, vlanIf, &oldCfg) != RETURN_OK ||
+        WanManager_PrepareMAPTConfiguration(pNew, vlanIf, &newCfg) != RETURN_OK)
+    {
+        return RETURN_ERR;
+    }
+
+    /* The MTU is not part of the option set, only re-assert it if it drifted */
+    if (WanManager_GetIfMtu(vlanIf, &mtu) != RETURN_OK || mtu != MTU_SIZE)
+    {
+        diff |= WANMGR_MAPT_DIFF_MTU;
     }
 
+    CcspTraceNotice(("FEATURE_MAPT: MAP-T update%s%s%s%s\n",
+                     (diff & WANMGR_MAPT_DIFF_DMR) ? " DMR" : "", (diff & WANMGR_MAPT_DIFF_BMR) ? " BMR" : "",
+                     (diff & WANMGR_MAPT_DIFF_PSID) ? " PSID" : "", (diff & WANMGR_MAPT_DIFF_MTU) ? " MTU" : ""));
+
 #ifdef FEATURE_MAPT_DEBUG
-    LOG_PRINT_MAPT("### ivictl commands - ENDS  ###");
+    WanManager_UpdateMaptLogFile(pNew);
+    LOG_PRINT_MAPT("### ivictl update commands - START ###");
 #endif
-    CcspTraceNotice(("FEATURE_MAPT: MAP-T configuration done\n"));
+
+    if ((diff & WANMGR_MAPT_DIFF_MTU) && WanManager_SetIfMtu(vlanIf, MTU_SIZE) != RETURN_OK)
+    {
+        return RETURN_ERR;
+    }
+
+    /* Only a new local address/PSID or translator parameter needs the
+     * translator restarted. Rule changes are replaced in the running table. */
+    restartIvi = (!WanManager_SameMaptPrefix(AF_INET, oldCfg.ipAddress, newCfg.ipAddress) ||
+                  !WanManager_SameMaptPrefix(AF_INET, oldCfg.lanAddress, newCfg.lanAddress) ||
+                  !WanManager_SameMaptPrefix(AF_INET6, oldCfg.msg.ruleIPv6Prefix, newCfg.msg.ruleIPv6Prefix) ||
+                  oldCfg.msg.v4Len != newCfg.msg.v4Len ||
+                  oldCfg.msg.psidOffset != newCfg.msg.psidOffset ||
+                  oldCfg.msg.ratio != newCfg.msg.ratio ||
+                  oldCfg.psidValue != newCfg.psidValue) ? TRUE : FALSE;
+
+    dmrChanged = (diff & WANMGR_MAPT_DIFF_DMR) ? TRUE : FALSE;
+    bmrChanged = (!WanManager_SameMaptPrefix(AF_INET, oldCfg.msg.ruleIPv4Prefix, newCfg.msg.ruleIPv4Prefix) ||
+                  !WanManager_SameMaptPrefix(AF_INET6, oldCfg.msg.ruleIPv6Prefix, newCfg.msg.ruleIPv6Prefix) ||
+                  oldCfg.msg.psidOffset != newCfg.msg.psidOffset ||
+                  oldCfg.msg.ratio != newCfg.msg.ratio) ? TRUE : FALSE;
+
+    if (restartIvi == TRUE)
+    {
+        if (WanManager_RunIvictl("-q") != RETURN_OK ||
+            WanManager_RunIvictl(newCfg.dmrArgs) != RETURN_OK ||
+            WanManager_RunIvictl(newCfg.bmrArgs) != RETURN_OK ||
+            WanManager_RunIvictl(newCfg.startArgs) != RETURN_OK)
+        {
+            goto ROLLBACK;
+        }
+    }
+    else
+    {
+        if (dmrChanged == TRUE && WanManager_RunIvictl(newCfg.dmrArgs) != RETURN_OK)
+        {
+            goto ROLLBACK;
+        }
+
+        if (bmrChanged == TRUE && WanManager_RunIvictl(newCfg.bmrArgs) != RETURN_OK)
+        {
+            goto ROLLBACK;
+        }
+    }
+
+    if (memcmp(&oldCfg.maptInfo, &newCfg.maptInfo, sizeof(MaptData_t)) != 0)
+    {
+        if (maptInfo_set(&newCfg.maptInfo) != RETURN_OK)
+        {
+            CcspTraceError(("Failed to set sysevents for MAPT feature to set firewall rules \n"));
+            goto ROLLBACK;
+        }
+        wanmgr_sysevents_scheduleRestart(WANMGR_RESTART_FIREWALL);
+    }
+
+#ifdef FEATURE_MAPT_DEBUG
+    LOG_PRINT_MAPT("### ivictl update commands - ENDS  ###");
+#endif
+    CcspTraceNotice(("FEATURE_MAPT: MAP-T configuration updated%s\n", (restartIvi == TRUE) ? ", translator restarted" : ""));
     return RETURN_OK;
+
+ROLLBACK:
+    /* Neither the old nor the new rule set is fully in place, stop the translator
+     * and drop the firewall rules. The caller rebuilds from scratch. */
+    CcspTraceWarning(("%s %d - rolling back partial MAP-T update\n", __FUNCTION__, __LINE__));
+    WanManager_RunIvictl("-q");
+    maptInfo_reset();
+    wanmgr_sysevents_scheduleRestart(WANMGR_RESTART_FIREWALL);
+    CcspTraceNotice(("FEATURE_MAPT: MAP-T update failed\n"));
+    return RETURN_ERR;
 }
 
-static int WanManager_CalculateMAPTPsid(char *pdIPv6Prefix, int v6PrefixLen, int iapdPrefixLen, int v4PrefixLen, int *psidValue, int *ipv4IndexValue, int *psidLen)
+static int WanManager_CalculateMAPTPsid(const char *pdIPv6Prefix, int v6PrefixLen, int iapdPrefixLen, int v4PrefixLen, int *psidValue, int *ipv4IndexValue, int *psidLen)
 {
     int ret = RETURN_OK;
     int len, startPdOffset, endPdOffset;
@@ -716,7 +1065,8 @@ static int WanManager_CalculateMAPTPsid(char *pdIPv6Prefix, int v6PrefixLen, int
     return ret;
 }
 
-static int WanManager_ConfigureIpv6Sysevents(char *pdIPv6Prefix, char *ipAddressString, int psidValue)
+/* Formats the MAP-T IPv6 address from the PD prefix, mapped IPv4 address and PSID */
+static int WanManager_BuildMaptIpv6Address(const char *pdIPv6Prefix, const char *ipAddressString, int psidValue, char *ipv6AddressString, size_t len)
 {
     int ret = RETURN_OK;
     struct in6_addr in6Addr;
@@ -740,41 +1090,25 @@ static int WanManager_ConfigureIpv6Sysevents(char *pdIPv6Prefix, char *ipAddress
         return ret;
     }
 
-    snprintf(ipv6AddressString, sizeof(ipv6AddressString), "%02x%02x:%02x%02x:%02x%02x:%02x%02x:%02x%02x:%02x%02x:%02x%02x:%02x%02x", in6Addr.s6_addr[0], in6Addr.s6_addr[1], in6Addr.s6_addr[2], in6Addr.s6_addr[3], in6Addr.s6_addr[4], in6Addr.s6_addr[5], in6Addr.s6_addr[6], in6Addr.s6_addr[7], 0x0, 0x0, ipAddressBytes[3], ipAddressBytes[2], ipAddressBytes[1], ipAddressBytes[0], 0x0, psidValue);
+    snprintf(ipv6AddressString, len, "%02x%02x:%02x%02x:%02x%02x:%02x%02x:%02x%02x:%02x%02x:%02x%02x:%02x%02x", in6Addr.s6_addr[0], in6Addr.s6_addr[1], in6Addr.s6_addr[2], in6Addr.s6_addr[3], in6Addr.s6_addr[4], in6Addr.s6_addr[5], in6Addr.s6_addr[6], in6Addr.s6_addr[7], 0x0, 0x0, ipAddressBytes[3], ipAddressBytes[2], ipAddressBytes[1], ipAddressBytes[0], 0x0, psidValue);
 
     return ret;
 }
 
 int WanManager_ResetMAPTConfiguration(const char *baseIf, const char *vlanIf)
 {
-    char cmdConfigureMTUSize[BUFLEN_64] = "";
     int ret = RETURN_OK;
 
     /* RM16042: Since we have configures MTU size to 1520 for the MAPT functionality,
      * we need to reconfigure it back to 1500 when we reset from MAPT configuration.
-     * Reconfigure eth3 mtu size to 1500. */
-    snprintf(cmdConfigureMTUSize, sizeof(cmdConfigureMTUSize), "ip link set dev %s mtu %d ", baseIf, MTU_DEFAULT_SIZE);
-
-#ifdef FEATURE_MAPT_DEBUG
-    LOG_PRINT_MAPT("ivictl:cmdConfigureMTUSize:%s", cmdConfigureMTUSize);
-#endif
-
-    if ((ret = WanManager_DoSystemActionWithStatus("ivictl", cmdConfigureMTUSize)) < RETURN_OK)
+     * The vlan interface goes first, its MTU can't exceed the one of eth3. */
+    if ((ret = WanManager_SetIfMtu(vlanIf, MTU_DEFAULT_SIZE)) != RETURN_OK)
     {
-        CcspTraceError(("Failed to run: %s:%d", cmdConfigureMTUSize, ret));
         return ret;
     }
 
-    /*  ReConfigure erouter0 MTU size to 1500 */
-    snprintf(cmdConfigureMTUSize, sizeof(cmdConfigureMTUSize), "ip link set dev %s mtu %d ", vlanIf, MTU_DEFAULT_SIZE);
-
-#ifdef FEATURE_MAPT_DEBUG
-    LOG_PRINT_MAPT("ivictl:cmdConfigureMTUSize:%s", cmdConfigureMTUSize);
-#endif
-
-    if ((ret = WanManager_DoSystemActionWithStatus("ivictl", cmdConfigureMTUSize)) < RETURN_OK)
+    if ((ret = WanManager_SetIfMtu(baseIf, MTU_DEFAULT_SIZE)) != RETURN_OK)
     {
-        CcspTraceError(("Failed to run: %s:%d", cmdConfigureMTUSize, ret));
         return ret;
     }
 
@@ -784,7 +1118,7 @@ int WanManager_ResetMAPTConfiguration(const char *baseIf, const char *vlanIf)
      * `mapt_configure_flag` and restart the firewall. */
     //Reset MAP sysevent parameters
     maptInfo_reset();
-    sysevent_set(sysevent_fd, sysevent_token, SYSEVENT_FIREWALL_RESTART, NULL, 0);
+    wanmgr_sysevents_scheduleRestart(WANMGR_RESTART_FIREWALL);
     CcspTraceNotice(("FEATURE_MAPT: MAP-T configuration cleared\n"));
     return RETURN_OK;
 }
@@ -847,7 +1181,7 @@ void logPrintMapt(char *fmt,...)
     fclose(fpMaptLogFile);
 }
 
-void WanManager_UpdateMaptLogFile(Dhcp6cMAPTParametersMsgBody *dhcp6cMAPTMsgBody)
+void WanManager_UpdateMaptLogFile(const Dhcp6cMAPTParametersMsgBody *dhcp6cMAPTMsgBody)
 {
 
     LOG_PRINT_MAPT("############MAP-T Options DHCP - START#######################");
@@ -935,56 +1269,300 @@ static int IsValidDnsServer(int32_t af, const char *nameServer)
     return RETURN_OK;
 }
 
-int WanManager_CreateResolvCfg(const DnsData_t *dnsInfo)
+/* Content last written to RESOLV_CONF_FILE, shared by all interface state machines */
+static char gResolvConfContent[RESOLV_CONF_MAX_LEN];
+static BOOL gResolvConfLoaded = FALSE;
+static pthread_mutex_t gResolvConfMutex = PTHREAD_MUTEX_INITIALIZER;
+
+static int ResolvCfgAppend(char *buf, size_t size, size_t *len, const char *fmt, const char *server)
+{
+   int n = snprintf(buf + *len, size - *len, fmt, server);
+
+   if (n < 0 || (size_t)n >= size - *len)
+   {
+      return RETURN_ERR;
+   }
+
+   *len += n;
+   return RETURN_OK;
+}
+
+/* Follow RESOLV_CONF_FILE to the file actually holding the content, e.g. a link into /tmp on a
+ * read-only rootfs. Renaming over the link itself would replace it with a regular file. */
+static int ResolvCfgGetTarget(char *path, size_t size)
+{
+   char link[PATH_MAX];
+   char *pSlash = NULL;
+   ssize_t n = 0;
+   int hops = 0;
+
+   snprintf(path, size, "%s", RESOLV_CONF_FILE);
+
+   for (hops = 0; hops < RESOLV_CONF_MAX_LINKS; hops++)
+   {
+      if ((n = readlink(path, link, sizeof(link) - 1)) < 0)
+      {
+         //Not a link, or nothing there yet: the path itself is written
+         return (errno == EINVAL || errno == ENOENT) ? RETURN_OK : RETURN_ERR;
+      }
+      link[n] = '\0';
+
+      if (link[0] == '/')
+      {
+         if ((size_t) n >= size)
+         {
+            return RETURN_ERR;
+         }
+         snprintf(path, size, "%s", link);
+      }
+      else
+      {
+         //Relative to the directory of the link
+         pSlash = strrchr(path, '/');
+         if (pSlash == NULL || (size_t)(pSlash + 1 - path) + n >= size)
+         {
+            return RETURN_ERR;
+         }
+         snprintf(pSlash + 1, size - (pSlash + 1 - path), "%s", link);
+      }
+   }
+
+   CcspTraceError(("%s %d - too many links from %s\n", __FUNCTION__, __LINE__, RESOLV_CONF_FILE));
+   return RETURN_ERR;
+}
+
+static int ResolvCfgWriteAtomic(const char *content, size_t len)
+{
+   char target[PATH_MAX];
+   char tmpFile[PATH_MAX + sizeof(RESOLV_CONF_TMP_SUFFIX)];
+   int fd = -1;
+   ssize_t written = 0;
+
+   //The temporary file goes next to the target, rename() does not cross filesystems
+   if (ResolvCfgGetTarget(target, sizeof(target)) != RETURN_OK)
+   {
+      CcspTraceError(("%s %d - cannot resolve %s\n", __FUNCTION__, __LINE__, RESOLV_CONF_FILE));
+      return RETURN_ERR;
+   }
+   snprintf(tmpFile, sizeof(tmpFile), "%s%s", target, RESOLV_CONF_TMP_SUFFIX);
+
+   if ((fd = open(tmpFile, O_WRONLY | O_CREAT | O_TRUNC, 0644)) < 0)
+   {
+      CcspTraceError(("%s %d - Open %s error!\n", __FUNCTION__, __LINE__, tmpFile));
+      return RETURN_ERR;
+   }
+
+   while (len > 0)
+   {
+      written = write(fd, content, len);
+      if (written < 0)
+      {
+         if (errno == EINTR)
+         {
+            continue;
+         }
+         CcspTraceError(("%s %d - write %s failed (%s)\n", __FUNCTION__, __LINE__, tmpFile, strerror(errno)));
+         close(fd);
+         unlink(tmpFile);
+         return RETURN_ERR;
+      }
+      content += written;
+      len -= written;
+   }
+
+   close(fd);
+
+   if (rename(tmpFile, target) != 0)
+   {
+      CcspTraceError(("%s %d - rename to %s failed (%s)\n", __FUNCTION__, __LINE__, target, strerror(errno)));
+      unlink(tmpFile);
+      return RETURN_ERR;
+   }
+
+   return RETURN_OK;
+}
+
+int WanManager_CreateResolvCfg(const DnsData_t *dnsInfo, BOOL *pChanged)
 {
    FILE *fp = NULL;
-   char cmd[BUFLEN_128]={0};
+   char content[RESOLV_CONF_MAX_LEN] = {0};
+   size_t len = 0;
    int ret = RETURN_OK;
    bool valid_dns = FALSE;
    if(NULL == dnsInfo)
    {
         return ANSC_STATUS_FAILURE;
    }
+   if (pChanged != NULL)
+   {
+        *pChanged = FALSE;
+   }
    CcspTraceInfo(("%s %d -adding nameservers: %s %s %s %s\n", __FUNCTION__,__LINE__,dnsInfo->dns_ipv4_1, dnsInfo->dns_ipv4_2, dnsInfo->dns_ipv6_1, dnsInfo->dns_ipv6_2));
-   /* sets nameserver entries to resolv.conf file */
-   if((fp = fopen(RESOLV_CONF_FILE, "w+")) == NULL)
+
+   /* build the nameserver entries in memory first */
+   if(RETURN_OK == IsValidDnsServer(AF_INET, dnsInfo->dns_ipv4_1))
    {
-        CcspTraceInfo(("%s %d - Open %s error!\n", __FUNCTION__, __LINE__, RESOLV_CONF_FILE));
-        ret = RETURN_ERR;
+        ret |= ResolvCfgAppend(content, sizeof(content), &len, "nameserver %s\n", dnsInfo->dns_ipv4_1);
+        valid_dns = TRUE;
    }
-   else
+   if(RETURN_OK == IsValidDnsServer(AF_INET, dnsInfo->dns_ipv4_2))
    {
-        if(RETURN_OK == IsValidDnsServer(AF_INET, dnsInfo->dns_ipv4_1))
-        {
-            fprintf(fp, "nameserver %s\n", dnsInfo->dns_ipv4_1);
-            valid_dns = TRUE;
-        }
-        if(RETURN_OK == IsValidDnsServer(AF_INET, dnsInfo->dns_ipv4_2))
-        {
-            fprintf(fp, "nameserver %s\n", dnsInfo->dns_ipv4_2);
-            valid_dns = TRUE;
-        }
-        if(RETURN_OK == IsValidDnsServer(AF_INET6, dnsInfo->dns_ipv6_1))
-        {
-            fprintf(fp, "nameserver %s\n", dnsInfo->dns_ipv6_1);
-            valid_dns = TRUE;
-        }
-        if(RETURN_OK == IsValidDnsServer(AF_INET6, dnsInfo->dns_ipv6_2))
+        ret |= ResolvCfgAppend(content, sizeof(content), &len, "nameserver %s\n", dnsInfo->dns_ipv4_2);
+        valid_dns = TRUE;
+   }
+   if(RETURN_OK == IsValidDnsServer(AF_INET6, dnsInfo->dns_ipv6_1))
+   {
+        ret |= ResolvCfgAppend(content, sizeof(content), &len, "nameserver %s\n", dnsInfo->dns_ipv6_1);
+        valid_dns = TRUE;
+   }
+   if(RETURN_OK == IsValidDnsServer(AF_INET6, dnsInfo->dns_ipv6_2))
+   {
+        ret |= ResolvCfgAppend(content, sizeof(content), &len, "nameserver %s\n", dnsInfo->dns_ipv6_2);
+        valid_dns = TRUE;
+   }
+   if (valid_dns == FALSE)
+   {
+        CcspTraceInfo(("%s %d - No valid nameserver is available, adding loopback address for nameserver\n", __FUNCTION__,__LINE__));
+        ret |= ResolvCfgAppend(content, sizeof(content), &len, "nameserver %s \n", LOOPBACK);
+   }
+   if (ret != RETURN_OK)
+   {
+        CcspTraceError(("%s %d - resolv.conf content too long\n", __FUNCTION__, __LINE__));
+        return RETURN_ERR;
+   }
+
+   pthread_mutex_lock(&gResolvConfMutex);
+
+   /* after a restart compare against what is already on disk */
+   if (!gResolvConfLoaded)
+   {
+        if ((fp = fopen(RESOLV_CONF_FILE, "r")) != NULL)
         {
-            fprintf(fp, "nameserver %s\n", dnsInfo->dns_ipv6_2);
-            valid_dns = TRUE;
+            size_t n = fread(gResolvConfContent, 1, sizeof(gResolvConfContent) - 1, fp);
+            gResolvConfContent[n] = '\0';
+            fclose(fp);
         }
-        if (valid_dns == FALSE)
+        gResolvConfLoaded = TRUE;
+   }
+
+   if (strcmp(gResolvConfContent, content) == 0)
+   {
+        CcspTraceInfo(("%s %d - nameservers unchanged, %s not rewritten\n", __FUNCTION__, __LINE__, RESOLV_CONF_FILE));
+   }
+   else if ((ret = ResolvCfgWriteAtomic(content, len)) == RETURN_OK)
+   {
+        snprintf(gResolvConfContent, sizeof(gResolvConfContent), "%s", content);
+        if (pChanged != NULL)
         {
-            CcspTraceInfo(("%s %d - No valid nameserver is available, adding loopback address for nameserver\n", __FUNCTION__,__LINE__));
-            fprintf(fp, "nameserver %s \n", LOOPBACK);
+            *pChanged = TRUE;
         }
-        fclose(fp);
         CcspTraceInfo(("%s %d - Active domainname servers set!\n", __FUNCTION__,__LINE__));
    }
+
+   pthread_mutex_unlock(&gResolvConfMutex);
+
    return ret;
 }
 
+static void Ipv6StrToBin(const char *input, struct in6_addr *addr, uint32_t *plen)
+{
+   char buf[BUFLEN_128] = {0};
+   char *separator = NULL;
+
+   memset(addr, 0, sizeof(struct in6_addr));
+   *plen = 0;
+
+   if (IS_EMPTY_STR(input))
+   {
+      return;
+   }
+
+   snprintf(buf, sizeof(buf), "%s", input);
+   if ((separator = strchr(buf, '/')) != NULL)
+   {
+      *separator++ = '\0';
+      *plen = strtoul(separator, NULL, 10);
+   }
+
+   if (inet_pton(AF_INET6, buf, addr) <= 0)
+   {
+      memset(addr, 0, sizeof(struct in6_addr));
+      *plen = 0;
+   }
+   else if (separator == NULL)
+   {
+      *plen = 128;
+   }
+}
+
+ANSC_STATUS WanManager_Ipv4DataToBin(WANMGR_IPV4_DATA *pIpv4Data)
+{
+   WANMGR_IPV4_ADDR_BIN *pBin = NULL;
+
+   if (pIpv4Data == NULL)
+   {
+      return ANSC_STATUS_BAD_PARAMETER;
+   }
+
+   pBin = &pIpv4Data->bin;
+   memset(pBin, 0, sizeof(WANMGR_IPV4_ADDR_BIN));
+
+   /* inet_pton() leaves the output untouched on failure, so invalid strings stay 0.0.0.0 */
+   inet_pton(AF_INET, pIpv4Data->ip, &pBin->ip);
+   inet_pton(AF_INET, pIpv4Data->mask, &pBin->mask);
+   inet_pton(AF_INET, pIpv4Data->gateway, &pBin->gateway);
+   inet_pton(AF_INET, pIpv4Data->dnsServer, &pBin->dnsServer);
+   inet_pton(AF_INET, pIpv4Data->dnsServer1, &pBin->dnsServer1);
+   pBin->prefixLen = __builtin_popcount(pBin->mask.s_addr);
+
+   return ANSC_STATUS_SUCCESS;
+}
+
+ANSC_STATUS WanManager_Ipv6DataToBin(WANMGR_IPV6_DATA *pIpv6Data)
+{
+   WANMGR_IPV6_ADDR_BIN *pBin = NULL;
+   uint32_t plen = 0;
+
+   if (pIpv6Data == NULL)
+   {
+      return ANSC_STATUS_BAD_PARAMETER;
+   }
+
+   pBin = &pIpv6Data->bin;
+   memset(pBin, 0, sizeof(WANMGR_IPV6_ADDR_BIN));
+
+   Ipv6StrToBin(pIpv6Data->address, &pBin->address, &pBin->addressLen);
+   Ipv6StrToBin(pIpv6Data->pdIfAddress, &pBin->pdIfAddress, &pBin->pdIfAddressLen);
+   Ipv6StrToBin(pIpv6Data->nameserver, &pBin->nameserver, &plen);
+   Ipv6StrToBin(pIpv6Data->nameserver1, &pBin->nameserver1, &plen);
+   Ipv6StrToBin(pIpv6Data->sitePrefix, &pBin->sitePrefix, &pBin->sitePrefixLen);
+
+   return ANSC_STATUS_SUCCESS;
+}
+
+int WanManager_GetBCastFromIpv4Data(const WANMGR_IPV4_DATA *pIpv4Info, char *outBcastStr, size_t len)
+{
+   struct in_addr bCast;
+
+   if (pIpv4Info == NULL || outBcastStr == NULL)
+   {
+      return RETURN_ERR;
+   }
+
+   if (pIpv4Info->bin.ip.s_addr == 0 || pIpv4Info->bin.mask.s_addr == 0)
+   {
+      return RETURN_ERR;
+   }
+
+   bCast.s_addr = pIpv4Info->bin.ip.s_addr | ~pIpv4Info->bin.mask.s_addr;
+   if (inet_ntop(AF_INET, &bCast, outBcastStr, len) == NULL)
+   {
+      return RETURN_ERR;
+   }
+
+   return RETURN_OK;
+}
+
 int WanManager_GetBCastFromIpSubnetMask(const char* inIpStr, const char* inSubnetMaskStr, char *outBcastStr)
 {
    struct in_addr ip;
@@ -1017,7 +1595,7 @@ int WanManager_AddDefaultGatewayRoute(const WANMGR_IPV4_DATA* pIpv4Info)
 
    /* Sets default gateway route entry */
    /* For IPoE, always use gw IP address. */
-   if (IsValidIpv4Address(pIpv4Info->gateway) && !(IsZeroIpvxAddress(AF_SELECT_IPV4, pIpv4Info->gateway)))
+   if (pIpv4Info->bin.gateway.s_addr != 0)
    {
        snprintf(cmd, sizeof(cmd), "route add default gw %s dev %s", pIpv4Info->gateway, pIpv4Info->ifname);
        WanManager_DoSystemAction("SetUpDefaultSystemGateway:", cmd);
@@ -1184,139 +1762,30 @@ static int ParsePrefixAddress(const char *prefixAddr, char *address, uint32_t *p
 
 }
 
-static ANSC_STATUS getIfAddr6(const char *ifname , uint32_t addrIdx,
-                      char *ipAddr, uint32_t *ifIndex, uint32_t *prefixLen, uint32_t *scope, uint32_t *ifaFlags)
-{
-    int   ret = ANSC_STATUS_FAILURE;
-    FILE     *fp;
-    uint32_t   count = 0;
-    char     line[BUFLEN_64];
-
-    *ipAddr = '\0';
-
-    if ((fp = fopen("/proc/net/if_inet6", "r")) == NULL)
-    {
-        CcspTraceInfo(("failed to open /proc/net/if_inet6"));
-        return ANSC_STATUS_FAILURE;
-    }
-
-    while (fgets(line, sizeof(line), fp) != NULL)
-    {
-        /* remove the carriage return char */
-        line[strlen(line)-1] = '\0';
-
-        if (strstr(line, ifname) != NULL)
-        {
-            char *addr, *ifidx, *plen, *scp, *flags, *devname;
-            char *nextToken = NULL;
-
-            /* the first token in the line is the ip address */
-            addr = strtok_r(line, " ", &nextToken);
-
-            /* the second token is the Netlink device number (interface index) in hexadecimal */
-            ifidx = strtok_r(NULL, " ", &nextToken);
-            if (ifidx == NULL)
-            {
-                CcspTraceInfo(("Invalid /proc/net/if_inet6 line"));
-                ret = ANSC_STATUS_FAILURE;
-                break;
-            }
-
-            /* the third token is the Prefix length in hexadecimal */
-            plen = strtok_r(NULL, " ", &nextToken);
-            if (plen == NULL)
-            {
-                CcspTraceInfo(("Invalid /proc/net/if_inet6 line"));
-                ret = ANSC_STATUS_FAILURE;
-                break;
-            }
-
-            /* the forth token is the Scope value */
-            scp = strtok_r(NULL, " ", &nextToken);
-            if (scp == NULL)
-            {
-                CcspTraceInfo(("Invalid /proc/net/if_inet6 line"));
-                ret = ANSC_STATUS_FAILURE;
-                break;
-            }
-
-            /* the fifth token is the ifa flags */
-            flags = strtok_r(NULL, " ", &nextToken);
-            if (flags == NULL)
-            {
-                CcspTraceInfo(("Invalid /proc/net/if_inet6 line"));
-                ret = ANSC_STATUS_FAILURE;
-                break;
-            }
-
-            /* the sixth token is the device name */
-            devname = strtok_r(NULL, " ", &nextToken);
-            if (devname == NULL)
-            {
-                CcspTraceInfo(("Invalid /proc/net/if_inet6 line"));
-                ret = ANSC_STATUS_FAILURE;
-                break;
-            }
-            else
-            {
-                if (strcmp(devname, ifname) != 0)
-                {
-                    continue;
-                }
-                else if (count == addrIdx)
-                {
-                    int32_t   i;
-                    char     *p1, *p2;
-
-                    *ifIndex   = strtoul(ifidx, NULL, 16);
-                    *prefixLen = strtoul(plen, NULL, 16);
-                    *scope     = strtoul(scp, NULL, 16);
-                    *ifaFlags  = strtoul(flags, NULL, 16);
-
-                    /* insert a colon every 4 digits in the address string */
-                    p2 = ipAddr;
-                    for (i = 0, p1 = addr; *p1 != '\0'; i++)
-                    {
-                        if (i == 4)
-                        {
-                            i = 0;
-                            *p2++ = ':';
-                        }
-                        *p2++ = *p1++;
-                    }
-                    *p2 = '\0';
-
-                    ret = ANSC_STATUS_SUCCESS;
-                    break;   /* done */
-                }
-                else
-                {
-                    count++;
-                }
-            }
-        }
-    }  /* while */
-
-    fclose(fp);
-
-    return ret;
-
-}  /* End of getIfAddr6() */
-
 ANSC_STATUS WanManager_getGloballyUniqueIfAddr6(const char *ifname, char *ipAddr, uint32_t *prefixLen)
 {
+   WanMgr_NlAddr6_t addr6;
    uint32_t addrIdx=0;
-   uint32_t netlinkIndex=0;
-   uint32_t scope=0;
-   uint32_t ifaflags=0;
-   int ret= ANSC_STATUS_SUCCESS;
 
-   while (ANSC_STATUS_SUCCESS == ret)
+   if (ifname == NULL || ipAddr == NULL || prefixLen == NULL)
+   {
+      return ANSC_STATUS_FAILURE;
+   }
+
+   *ipAddr = '\0';
+
+   /* addresses come from the netlink cache kept by the address monitor */
+   while (ANSC_STATUS_SUCCESS == WanMgr_Netlink_GetIfAddr6(ifname, addrIdx, &addr6))
    {
-      ret = getIfAddr6(ifname, addrIdx, ipAddr, &netlinkIndex,
-                              prefixLen, &scope, &ifaflags);
-      if ((ANSC_STATUS_SUCCESS == ret) && (0 == scope))  // found it
+      if (RT_SCOPE_UNIVERSE == addr6.scope)  // found it
+      {
+         if (inet_ntop(AF_INET6, &addr6.addr, ipAddr, IP_ADDR_LENGTH) == NULL)
+         {
+            return ANSC_STATUS_FAILURE;
+         }
+         *prefixLen = addr6.prefixLen;
          return ANSC_STATUS_SUCCESS;
+      }
 
       addrIdx++;
    }
@@ -1629,7 +2098,7 @@ int WanManager_AddGatewayRoute(const WANMGR_IPV4_DATA* pIpv4Info)
     WanManager_DoSystemAction("SetUpSystemGateway:", cmd);
 
     /* Sets gateway route entry */
-    if (IsValidIpv4Address(pIpv4Info->gateway) && !(IsZeroIpvxAddress(AF_SELECT_IPV4, pIpv4Info->gateway)))
+    if (pIpv4Info->bin.gateway.s_addr != 0)
     {
         snprintf(cmd, sizeof(cmd), "ip route add %s dev %s", pIpv4Info->gateway, pIpv4Info->ifname);
         WanManager_DoSystemAction("SetUpSystemGateway:", cmd);
@@ -63,6 +63,14 @@ void logPrintMapt(char *fmt,...);
 #define LOG_PRINT_MAPT(...) logPrintMapt(__VA_ARGS__ )
 #endif /*FEATURE_MAPT_DEBUG*/
 
+#ifdef FEATURE_MAPT
+/* What changed between two MAP-T option sets */
+#define WANMGR_MAPT_DIFF_DMR    (1 << 0)    /* default mapping rule (BR prefix) */
+#define WANMGR_MAPT_DIFF_BMR    (1 << 1)    /* basic mapping rule prefixes, offset, ratio, EA length */
+#define WANMGR_MAPT_DIFF_PSID   (1 << 2)    /* delegated prefix and lengths the PSID is derived from */
+#define WANMGR_MAPT_DIFF_MTU    (1 << 3)    /* interface MTU drifted from the MAP-T MTU */
+#endif /* FEATURE_MAPT */
+
 typedef struct
 {
    char dns_ipv4_1[BUFLEN_64];
@@ -100,27 +108,29 @@ ANSC_STATUS WanManager_StartDhcpv6Client(const char *pcInterfaceName, BOOL isPPP
 
 /***************************************************************************
  * @brief API used to stop Dhcpv6 client application.
+ * @param pcInterfaceName Interface name the dhcpv6 client was started on
  * @param boolDisconnect This indicates whether this function called from
  * disconnect context or not
  * @return ANSC_STATUS_SUCCESS upon success else returned error code.
  ***************************************************************************/
-ANSC_STATUS WanManager_StopDhcpv6Client(BOOL boolDisconnect);
+ANSC_STATUS WanManager_StopDhcpv6Client(const char *pcInterfaceName, BOOL boolDisconnect);
 
 /***************************************************************************
  * @brief API used to start Dhcpv4 client application.
  * @param intf Interface name on which the dhcpv4 needs to start
  * @param discover flag indicates discover on interface forced.
- * @return ANSC_STATUS_SUCCESS upon success else returned error code.
+ * @return PID of the client, 0 on failure or while a previous client is stopping.
  ***************************************************************************/
 uint32_t WanManager_StartDhcpv4Client(const char* intf, BOOL discover);
 
 /***************************************************************************
  * @brief API used to stop Dhcpv4 client application.
+ * @param intf Interface name the dhcpv4 client was started on
  * @param sendReleaseAndExit flag indicates needs to send release packet before
  *                           exit.
  * @return ANSC_STATUS_SUCCESS upon success else returned error code.
  ***************************************************************************/
-ANSC_STATUS WanManager_StopDhcpv4Client(BOOL sendReleaseAndExit);
+ANSC_STATUS WanManager_StopDhcpv4Client(const char *intf, BOOL sendReleaseAndExit);
 
 /***************************************************************************
  * @brief API used to restart Dhcpv6 client application.
@@ -153,6 +163,16 @@ BOOL WanManager_IsApplicationRunning(const char* appName);
  ***************************************************************************/
 int WanManager_Ipv6AddrUtil(char *ifname,Ipv6OperType opr,int preflft,int vallft);
 
+/***************************************************************************
+ * @brief Write a value to a /proc/sys file, the native form of "sysctl -w".
+ * @param path full /proc/sys path
+ * @param value value to write
+ * @param oldValue optional output for the previous value, NULL if not needed
+ * @param oldLen size of oldValue
+ * @return RETURN_OK upon success else RETURN_ERR.
+ ***************************************************************************/
+int WanManager_SetProcSysValue(const char *path, const char *value, char *oldValue, size_t oldLen);
+
 #ifdef FEATURE_MAPT
 /***********************************************************************************
  * @brief This API used to process mapt configuration data.
@@ -161,7 +181,28 @@ int WanManager_Ipv6AddrUtil(char *ifname,Ipv6OperType opr,int preflft,int vallft
  * @param vlanIf Vlan interface name
  * @return RETURN_OK in case of success else error code returned.
  ************************************************************************************/
-int WanManager_ProcessMAPTConfiguration(Dhcp6cMAPTParametersMsgBody *dhcp6cMAPTMsgBody, const char *baseIf, const char *vlanIf);
+int WanManager_ProcessMAPTConfiguration(const Dhcp6cMAPTParametersMsgBody *dhcp6cMAPTMsgBody, const char *baseIf, const char *vlanIf);
+
+/***********************************************************************************
+ * @brief Compare two MAP-T option sets and classify what changed.
+ * @param pOld option set currently applied
+ * @param pNew option set received from the dhcp6 server
+ * @return bitmask of WANMGR_MAPT_DIFF_DMR/BMR/PSID, 0 if nothing relevant changed.
+ ************************************************************************************/
+UINT32 WanManager_DiffMAPTConfiguration(const Dhcp6cMAPTParametersMsgBody *pOld, const Dhcp6cMAPTParametersMsgBody *pNew);
+
+/***********************************************************************************
+ * @brief Move a running MAP-T configuration from one option set to another,
+ * applying only the parts that changed. DMR and BMR updates replace the rules
+ * in place, the translator is only restarted when the mapped address or PSID
+ * changes. On failure the translator is stopped and the MAP-T firewall data
+ * cleared, the caller falls back to a full reset/process.
+ * @param pOld option set currently applied
+ * @param pNew option set received from the dhcp6 server
+ * @param vlanIf Vlan interface name
+ * @return RETURN_OK in case of success else error code returned.
+ ************************************************************************************/
+int WanManager_UpdateMAPTConfiguration(const Dhcp6cMAPTParametersMsgBody *pOld, const Dhcp6cMAPTParametersMsgBody *pNew, const char *vlanIf);
 #endif
 
 /***********************************************************************************
@@ -173,11 +214,13 @@ int WanManager_ProcessMAPTConfiguration(Dhcp6cMAPTParametersMsgBody *dhcp6cMAPTM
 int WanManager_ResetMAPTConfiguration(const char *baseIf, const char *vlanIf);
 
 /***************************************************************************
- * @brief API used to update /etc/resolv.conf file with dns configuration
+ * @brief API used to update /etc/resolv.conf file with dns configuration.
+ * The file is replaced atomically and only when its content changes.
  * @param dnsInfo pointer to DnsData_t contains the dns info
+ * @param pChanged set to TRUE if the file was rewritten (may be NULL)
  * @return RETURN_OK upon success else returned error code.
  ****************************************************************************/
-int WanManager_CreateResolvCfg(const DnsData_t *dnsInfo);
+int WanManager_CreateResolvCfg(const DnsData_t *dnsInfo, BOOL *pChanged);
 
 /***************************************************************************
  * @brief API used to update default ipv4 gateway
@@ -195,6 +238,31 @@ int WanManager_AddDefaultGatewayRoute(const WANMGR_IPV4_DATA* ipv4Info);
  ****************************************************************************/
 int WanManager_GetBCastFromIpSubnetMask(const char *inIpStr, const char *inSubnetMaskStr, char *outBcastStr);
 
+/***************************************************************************
+ * @brief API used to get broadcast IP from the binary IPv4 lease data
+ * @param pIpv4Info pointer to WANMGR_IPV4_DATA with the bin block filled
+ * @param outBcastStr Stores the broadcast address
+ * @param len size of outBcastStr
+ * @return RETURN_OK upon success else returned error code.
+ ****************************************************************************/
+int WanManager_GetBCastFromIpv4Data(const WANMGR_IPV4_DATA *pIpv4Info, char *outBcastStr, size_t len);
+
+/***************************************************************************
+ * @brief API used to fill the binary address block of the IPv4 data from
+ * its string fields. Unparsable addresses are stored as 0.0.0.0.
+ * @param pIpv4Data pointer to WANMGR_IPV4_DATA
+ * @return ANSC_STATUS_SUCCESS upon success else returned error code.
+ ****************************************************************************/
+ANSC_STATUS WanManager_Ipv4DataToBin(WANMGR_IPV4_DATA *pIpv4Data);
+
+/***************************************************************************
+ * @brief API used to fill the binary address block of the IPv6 data from
+ * its string fields. Unparsable addresses are stored as ::.
+ * @param pIpv6Data pointer to WANMGR_IPV6_DATA
+ * @return ANSC_STATUS_SUCCESS upon success else returned error code.
+ ****************************************************************************/
+ANSC_STATUS WanManager_Ipv6DataToBin(WANMGR_IPV6_DATA *pIpv6Data);
+
 /***************************************************************************
  * @brief API used to update ipv4 gateway
  * @param ipv4Info pointer to dhcpv4_data_t holds the IPv4 configuration
@@ -218,7 +286,13 @@ ANSC_STATUS WanManager_CreatePPPSession(DML_WAN_IFACE* pInterface);
  ***************************************************************************/
 ANSC_STATUS WanManager_DeletePPPSession(DML_WAN_IFACE* pInterface);
 
-
+/***************************************************************************
+ * @brief API used to get the first globally scoped IPv6 address of an interface
+ * @param ifname interface name (exact match)
+ * @param ipAddr output buffer of IP_ADDR_LENGTH bytes
+ * @param prefixLen output prefix length of the address
+ * @return ANSC_STATUS_SUCCESS if an address was found else ANSC_STATUS_FAILURE.
+ ****************************************************************************/
 ANSC_STATUS WanManager_getGloballyUniqueIfAddr6(const char *ifname, char *ipAddr, uint32_t *prefixLen);
 
 #ifdef FEATURE_802_1P_COS_MARKING
@@ -0,0 +1,1136 @@
+/*
+ * If not stated otherwise in this file or this component's Licenses.txt file the
+ * following copyright and licenses apply:
+ *
+ * Copyright 2020 RDK Management
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+*/
+
+/* ---- Include Files ---------------------------------------- */
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <linux/netlink.h>
+#include <linux/rtnetlink.h>
+#include <linux/fib_rules.h>
+#include <linux/neighbour.h>
+#include <linux/if_ether.h>
+#include "wanmgr_netlink.h"
+
+#define NL_RECV_BUF_SIZE 8192
+
+typedef struct _WanMgr_NlIface6_t
+{
+    int              ifIndex;
+    uint32_t         numAddr;
+    WanMgr_NlAddr6_t addr[WANMGR_NL_MAX_ADDR6_PER_IFACE];
+} WanMgr_NlIface6_t;
+
+typedef struct _WanMgr_NlCache6_t
+{
+    uint32_t          numIface;
+    BOOL              overflow;     /* an interface did not fit, its addresses are dumped on lookup */
+    WanMgr_NlIface6_t iface[WANMGR_NL_MAX_IFACES];
+} WanMgr_NlCache6_t;
+
+/* ---- Private Variables ------------------------------------ */
+static WanMgr_NlCache6_t gAddr6Cache;
+/* TRUE while the monitor is running and no notification has been lost */
+static BOOL gAddr6CacheValid = FALSE;
+static pthread_mutex_t gAddr6CacheMutex = PTHREAD_MUTEX_INITIALIZER;
+static uint32_t gNlSeq = 0;
+
+/* ---- Private Functions ------------------------------------ */
+
+static WanMgr_NlIface6_t* NlCacheFindIface(WanMgr_NlCache6_t *pCache, int ifIndex, BOOL create)
+{
+    uint32_t i;
+
+    for (i = 0; i < pCache->numIface; i++)
+    {
+        if (pCache->iface[i].ifIndex == ifIndex)
+        {
+            return &pCache->iface[i];
+        }
+    }
+
+    if (!create)
+    {
+        return NULL;
+    }
+
+    if (pCache->numIface >= WANMGR_NL_MAX_IFACES)
+    {
+        if (!pCache->overflow)
+        {
+            CcspTraceWarning(("%s %d - more than %d interfaces with IPv6 addresses, ifindex %d not cached\n",
+                              __FUNCTION__, __LINE__, WANMGR_NL_MAX_IFACES, ifIndex));
+            pCache->overflow = TRUE;
+        }
+        return NULL;
+    }
+
+    memset(&pCache->iface[pCache->numIface], 0, sizeof(WanMgr_NlIface6_t));
+    pCache->iface[pCache->numIface].ifIndex = ifIndex;
+    return &pCache->iface[pCache->numIface++];
+}
+
+static void NlCacheApply(WanMgr_NlCache6_t *pCache, int msgType, int ifIndex, const WanMgr_NlAddr6_t *pAddr6)
+{
+    WanMgr_NlIface6_t *pIface = NlCacheFindIface(pCache, ifIndex, (msgType == RTM_NEWADDR));
+    uint32_t i;
+
+    if (pIface == NULL)
+    {
+        return;
+    }
+
+    for (i = 0; i < pIface->numAddr; i++)
+    {
+        if (memcmp(&pIface->addr[i].addr, &pAddr6->addr, sizeof(struct in6_addr)) == 0)
+        {
+            break;
+        }
+    }
+
+    if (msgType == RTM_NEWADDR)
+    {
+        if (i < pIface->numAddr)
+        {
+            pIface->addr[i] = *pAddr6;
+        }
+        else if (pIface->numAddr < WANMGR_NL_MAX_ADDR6_PER_IFACE)
+        {
+            pIface->addr[pIface->numAddr++] = *pAddr6;
+        }
+    }
+    else if (i < pIface->numAddr)
+    {
+        /* keep kernel order, the first global address is the one reported */
+        memmove(&pIface->addr[i], &pIface->addr[i + 1], (pIface->numAddr - i - 1) * sizeof(WanMgr_NlAddr6_t));
+        pIface->numAddr--;
+    }
+}
+
+/* Parse one RTM_NEWADDR/RTM_DELADDR message. Returns FALSE for non IPv6 messages. */
+static BOOL NlParseAddr6(struct nlmsghdr *nlh, int *pIfIndex, WanMgr_NlAddr6_t *pAddr6)
+{
+    struct ifaddrmsg *ifa = (struct ifaddrmsg *) NLMSG_DATA(nlh);
+    struct rtattr *rta = IFA_RTA(ifa);
+    int len = IFA_PAYLOAD(nlh);
+    BOOL haveLocal = FALSE;
+    BOOL haveAddr = FALSE;
+
+    if (ifa->ifa_family != AF_INET6)
+    {
+        return FALSE;
+    }
+
+    memset(pAddr6, 0, sizeof(WanMgr_NlAddr6_t));
+    *pIfIndex = ifa->ifa_index;
+    pAddr6->prefixLen = ifa->ifa_prefixlen;
+    pAddr6->scope = ifa->ifa_scope;
+    pAddr6->ifaFlags = ifa->ifa_flags;
+
+    for (; RTA_OK(rta, len); rta = RTA_NEXT(rta, len))
+    {
+        switch (rta->rta_type)
+        {
+            case IFA_LOCAL:
+                memcpy(&pAddr6->addr, RTA_DATA(rta), sizeof(struct in6_addr));
+                haveLocal = TRUE;
+                break;
+            case IFA_ADDRESS:
+                if (!haveLocal)
+                {
+                    memcpy(&pAddr6->addr, RTA_DATA(rta), sizeof(struct in6_addr));
+                }
+                haveAddr = TRUE;
+                break;
+#ifdef IFA_FLAGS
+            case IFA_FLAGS:
+                pAddr6->ifaFlags = *(uint32_t *) RTA_DATA(rta);
+                break;
+#endif
+            default:
+                break;
+        }
+    }
+
+    return (haveLocal || haveAddr);
+}
+
+static int NlOpenSocket(uint32_t groups)
+{
+    struct sockaddr_nl addr;
+    int fd = socket(AF_NETLINK, SOCK_RAW | SOCK_CLOEXEC, NETLINK_ROUTE);
+
+    if (fd < 0)
+    {
+        CcspTraceError(("%s %d - netlink socket failed (%s)\n", __FUNCTION__, __LINE__, strerror(errno)));
+        return -1;
+    }
+
+    memset(&addr, 0, sizeof(addr));
+    addr.nl_family = AF_NETLINK;
+    addr.nl_groups = groups;
+    if (bind(fd, (struct sockaddr *) &addr, sizeof(addr)) < 0)
+    {
+        CcspTraceError(("%s %d - netlink bind failed (%s)\n", __FUNCTION__, __LINE__, strerror(errno)));
+        close(fd);
+        return -1;
+    }
+
+    return fd;
+}
+
+static BOOL NlAddAttr(struct nlmsghdr *nlh, uint32_t maxLen, uint16_t type, const void *data, uint16_t dataLen)
+{
+    struct rtattr *rta;
+
+    if (NLMSG_ALIGN(nlh->nlmsg_len) + RTA_SPACE(dataLen) > maxLen)
+    {
+        return FALSE;
+    }
+
+    rta = (struct rtattr *)(((char *) nlh) + NLMSG_ALIGN(nlh->nlmsg_len));
+    rta->rta_type = type;
+    rta->rta_len = RTA_LENGTH(dataLen);
+    if (dataLen > 0)
+    {
+        memcpy(RTA_DATA(rta), data, dataLen);
+    }
+    nlh->nlmsg_len = NLMSG_ALIGN(nlh->nlmsg_len) + RTA_ALIGN(rta->rta_len);
+
+    return TRUE;
+}
+
+/* Send one request and wait for its ack. okErr is an errno which is not an error for this request. */
+static ANSC_STATUS NlTransact(struct nlmsghdr *req, const char *what, int okErr)
+{
+    char buf[NL_RECV_BUF_SIZE];
+    struct nlmsghdr *nlh;
+    ANSC_STATUS ret = ANSC_STATUS_FAILURE;
+    int len;
+    int fd;
+
+    if ((fd = NlOpenSocket(0)) < 0)
+    {
+        return ANSC_STATUS_FAILURE;
+    }
+
+    req->nlmsg_flags |= NLM_F_REQUEST | NLM_F_ACK;
+    req->nlmsg_seq = __sync_add_and_fetch(&gNlSeq, 1);
+
+    if (send(fd, req, req->nlmsg_len, 0) < 0)
+    {
+        CcspTraceError(("%s %d - %s send failed (%s)\n", __FUNCTION__, __LINE__, what, strerror(errno)));
+        close(fd);
+        return ANSC_STATUS_FAILURE;
+    }
+
+    while ((len = recv(fd, buf, sizeof(buf), 0)) < 0 && errno == EINTR);
+
+    for (nlh = (struct nlmsghdr *) buf; len > 0 && NLMSG_OK(nlh, (unsigned int) len); nlh = NLMSG_NEXT(nlh, len))
+    {
+        if (nlh->nlmsg_type == NLMSG_ERROR)
+        {
+            struct nlmsgerr *err = (struct nlmsgerr *) NLMSG_DATA(nlh);
+            if (err->error == 0 || (okErr != 0 && err->error == -okErr))
+            {
+                ret = ANSC_STATUS_SUCCESS;
+            }
+            else
+            {
+                CcspTraceError(("%s %d - %s failed (%s)\n", __FUNCTION__, __LINE__, what, strerror(-err->error)));
+            }
+            break;
+        }
+    }
+
+    close(fd);
+    return ret;
+}
+
+/* Dump request: cb is called for each reply message until it returns TRUE or the dump ends */
+typedef BOOL (*NlDumpCb_t)(struct nlmsghdr *nlh, void *ctx);
+
+static ANSC_STATUS NlDump(struct nlmsghdr *req, const char *what, NlDumpCb_t cb, void *ctx)
+{
+    char buf[NL_RECV_BUF_SIZE];
+    ANSC_STATUS ret = ANSC_STATUS_FAILURE;
+    BOOL done = FALSE;
+    int fd;
+
+    if ((fd = NlOpenSocket(0)) < 0)
+    {
+        return ANSC_STATUS_FAILURE;
+    }
+
+    req->nlmsg_flags = NLM_F_REQUEST | NLM_F_DUMP;
+    req->nlmsg_seq = __sync_add_and_fetch(&gNlSeq, 1);
+
+    if (send(fd, req, req->nlmsg_len, 0) < 0)
+    {
+        CcspTraceError(("%s %d - %s send failed (%s)\n", __FUNCTION__, __LINE__, what, strerror(errno)));
+        close(fd);
+        return ANSC_STATUS_FAILURE;
+    }
+
+    while (!done)
+    {
+        struct nlmsghdr *nlh;
+        int len = recv(fd, buf, sizeof(buf), 0);
+
+        if (len < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            CcspTraceError(("%s %d - %s recv failed (%s)\n", __FUNCTION__, __LINE__, what, strerror(errno)));
+            break;
+        }
+
+        for (nlh = (struct nlmsghdr *) buf; NLMSG_OK(nlh, (unsigned int) len); nlh = NLMSG_NEXT(nlh, len))
+        {
+            if (nlh->nlmsg_seq != req->nlmsg_seq)
+            {
+                continue;
+            }
+
+            if (nlh->nlmsg_type == NLMSG_DONE)
+            {
+                done = TRUE;
+                break;
+            }
+
+            if (nlh->nlmsg_type == NLMSG_ERROR)
+            {
+                CcspTraceError(("%s %d - %s dump returned an error\n", __FUNCTION__, __LINE__, what));
+                done = TRUE;
+                break;
+            }
+
+            if (ret != ANSC_STATUS_SUCCESS && cb(nlh, ctx) == TRUE)
+            {
+                //Found, drain the rest of the dump
+                ret = ANSC_STATUS_SUCCESS;
+            }
+        }
+    }
+
+    close(fd);
+    return ret;
+}
+
+typedef struct _NlNeighLookup_t
+{
+    int         ifIndex;
+    int         family;
+    const void *pAddr;
+    uint8_t    *pMac;
+} NlNeighLookup_t;
+
+static BOOL NlMatchNeigh(struct nlmsghdr *nlh, void *ctx)
+{
+    NlNeighLookup_t *pLookup = (NlNeighLookup_t *) ctx;
+    struct ndmsg *ndm = (struct ndmsg *) NLMSG_DATA(nlh);
+    size_t addrLen = (pLookup->family == AF_INET) ? sizeof(struct in_addr) : sizeof(struct in6_addr);
+    const void *pDst = NULL;
+    const void *pLladdr = NULL;
+    struct rtattr *rta;
+    int rtaLen;
+
+    if (nlh->nlmsg_type != RTM_NEWNEIGH || ndm->ndm_ifindex != pLookup->ifIndex ||
+        (ndm->ndm_state & (NUD_INCOMPLETE | NUD_FAILED | NUD_NOARP)) != 0)
+    {
+        return FALSE;
+    }
+
+    rtaLen = RTM_PAYLOAD(nlh);
+    for (rta = RTM_RTA(ndm); RTA_OK(rta, rtaLen); rta = RTA_NEXT(rta, rtaLen))
+    {
+        if (rta->rta_type == NDA_DST && RTA_PAYLOAD(rta) == addrLen)
+        {
+            pDst = RTA_DATA(rta);
+        }
+        else if (rta->rta_type == NDA_LLADDR && RTA_PAYLOAD(rta) == ETH_ALEN)
+        {
+            pLladdr = RTA_DATA(rta);
+        }
+    }
+
+    if (pDst == NULL || pLladdr == NULL || memcmp(pDst, pLookup->pAddr, addrLen) != 0)
+    {
+        return FALSE;
+    }
+
+    memcpy(pLookup->pMac, pLladdr, ETH_ALEN);
+    return TRUE;
+}
+
+typedef struct _NlGw6Lookup_t
+{
+    int              ifIndex;
+    struct in6_addr *pGateway;      /* NULL when any default route will do, with a router or not */
+} NlGw6Lookup_t;
+
+/* A next hop of a default route, taken if it goes through the interface looked
+ * for and has a router when one is asked for */
+static BOOL NlTakeNextHop6(NlGw6Lookup_t *pLookup, int oif, const void *pGateway)
+{
+    if ((pLookup->ifIndex != 0 && oif != pLookup->ifIndex) || (pLookup->pGateway != NULL && pGateway == NULL))
+    {
+        return FALSE;
+    }
+
+    if (pLookup->pGateway != NULL)
+    {
+        memcpy(pLookup->pGateway, pGateway, sizeof(struct in6_addr));
+    }
+    return TRUE;
+}
+
+static BOOL NlMatchDefaultRoute6(struct nlmsghdr *nlh, void *ctx)
+{
+    NlGw6Lookup_t *pLookup = (NlGw6Lookup_t *) ctx;
+    struct rtmsg *rtm = (struct rtmsg *) NLMSG_DATA(nlh);
+    const void *pGateway = NULL;
+    struct rtnexthop *rtnh = NULL;
+    int mpLen = 0;
+    int oif = 0;
+    struct rtattr *rta;
+    int rtaLen;
+
+    if (nlh->nlmsg_type != RTM_NEWROUTE || rtm->rtm_dst_len != 0 || rtm->rtm_table != RT_TABLE_MAIN || rtm->rtm_type != RTN_UNICAST)
+    {
+        return FALSE;
+    }
+
+    rtaLen = RTM_PAYLOAD(nlh);
+    for (rta = RTM_RTA(rtm); RTA_OK(rta, rtaLen); rta = RTA_NEXT(rta, rtaLen))
+    {
+        if (rta->rta_type == RTA_GATEWAY && RTA_PAYLOAD(rta) == sizeof(struct in6_addr))
+        {
+            pGateway = RTA_DATA(rta);
+        }
+        else if (rta->rta_type == RTA_OIF && RTA_PAYLOAD(rta) == sizeof(int))
+        {
+            oif = *(int *) RTA_DATA(rta);
+        }
+        else if (rta->rta_type == RTA_MULTIPATH)
+        {
+            rtnh = (struct rtnexthop *) RTA_DATA(rta);
+            mpLen = RTA_PAYLOAD(rta);
+        }
+    }
+
+    if (rtnh == NULL)
+    {
+        //A single next hop, a point to point link such as ppp0 has no router
+        return NlTakeNextHop6(pLookup, oif, pGateway);
+    }
+
+    //An ECMP route, each next hop carries its own interface and router
+    for (; RTNH_OK(rtnh, mpLen); mpLen -= RTNH_ALIGN(rtnh->rtnh_len), rtnh = RTNH_NEXT(rtnh))
+    {
+        int attrLen = rtnh->rtnh_len - sizeof(struct rtnexthop);
+
+        pGateway = NULL;
+        for (rta = RTNH_DATA(rtnh); RTA_OK(rta, attrLen); rta = RTA_NEXT(rta, attrLen))
+        {
+            if (rta->rta_type == RTA_GATEWAY && RTA_PAYLOAD(rta) == sizeof(struct in6_addr))
+            {
+                pGateway = RTA_DATA(rta);
+            }
+        }
+        if (NlTakeNextHop6(pLookup, rtnh->rtnh_ifindex, pGateway) == TRUE)
+        {
+            return TRUE;
+        }
+    }
+
+    return FALSE;
+}
+
+/* Dump the IPv6 addresses of one interface, or of all when onlyIfIndex is 0, into pCache */
+static ANSC_STATUS NlDumpAddr6(WanMgr_NlCache6_t *pCache, int onlyIfIndex)
+{
+    struct
+    {
+        struct nlmsghdr  nlh;
+        struct ifaddrmsg ifa;
+    } req;
+    char buf[NL_RECV_BUF_SIZE];
+    ANSC_STATUS ret = ANSC_STATUS_FAILURE;
+    BOOL done = FALSE;
+    uint32_t seq;
+    int fd;
+
+    if ((fd = NlOpenSocket(0)) < 0)
+    {
+        return ANSC_STATUS_FAILURE;
+    }
+
+    memset(pCache, 0, sizeof(WanMgr_NlCache6_t));
+    memset(&req, 0, sizeof(req));
+    seq = __sync_add_and_fetch(&gNlSeq, 1);
+    req.nlh.nlmsg_len = NLMSG_LENGTH(sizeof(struct ifaddrmsg));
+    req.nlh.nlmsg_type = RTM_GETADDR;
+    req.nlh.nlmsg_flags = NLM_F_REQUEST | NLM_F_DUMP;
+    req.nlh.nlmsg_seq = seq;
+    req.ifa.ifa_family = AF_INET6;
+
+    if (send(fd, &req, req.nlh.nlmsg_len, 0) < 0)
+    {
+        CcspTraceError(("%s %d - RTM_GETADDR send failed (%s)\n", __FUNCTION__, __LINE__, strerror(errno)));
+        close(fd);
+        return ANSC_STATUS_FAILURE;
+    }
+
+    while (!done)
+    {
+        struct nlmsghdr *nlh;
+        int len = recv(fd, buf, sizeof(buf), 0);
+
+        if (len < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            CcspTraceError(("%s %d - RTM_GETADDR recv failed (%s)\n", __FUNCTION__, __LINE__, strerror(errno)));
+            break;
+        }
+
+        for (nlh = (struct nlmsghdr *) buf; NLMSG_OK(nlh, (unsigned int) len); nlh = NLMSG_NEXT(nlh, len))
+        {
+            WanMgr_NlAddr6_t addr6;
+            int ifIndex = 0;
+
+            if (nlh->nlmsg_seq != seq)
+            {
+                continue;
+            }
+
+            if (nlh->nlmsg_type == NLMSG_DONE)
+            {
+                ret = ANSC_STATUS_SUCCESS;
+                done = TRUE;
+                break;
+            }
+
+            if (nlh->nlmsg_type == NLMSG_ERROR)
+            {
+                CcspTraceError(("%s %d - RTM_GETADDR dump returned an error\n", __FUNCTION__, __LINE__));
+                done = TRUE;
+                break;
+            }
+
+            if (nlh->nlmsg_type == RTM_NEWADDR && NlParseAddr6(nlh, &ifIndex, &addr6) &&
+                (onlyIfIndex == 0 || ifIndex == onlyIfIndex))
+            {
+                NlCacheApply(pCache, RTM_NEWADDR, ifIndex, &addr6);
+            }
+        }
+    }
+
+    close(fd);
+
+    return ret;
+}
+
+/* ---- Global Functions ------------------------------------ */
+
+ANSC_STATUS WanMgr_Netlink_DumpIfAddr6(void)
+{
+    WanMgr_NlCache6_t cache;
+
+    if (NlDumpAddr6(&cache, 0) != ANSC_STATUS_SUCCESS)
+    {
+        return ANSC_STATUS_FAILURE;
+    }
+
+    pthread_mutex_lock(&gAddr6CacheMutex);
+    memcpy(&gAddr6Cache, &cache, sizeof(gAddr6Cache));
+    pthread_mutex_unlock(&gAddr6CacheMutex);
+
+    return ANSC_STATUS_SUCCESS;
+}
+
+ANSC_STATUS WanMgr_Netlink_GetIfAddr6(const char *ifname, uint32_t addrIdx, WanMgr_NlAddr6_t *pAddr6)
+{
+    WanMgr_NlIface6_t *pIface = NULL;
+    ANSC_STATUS ret = ANSC_STATUS_FAILURE;
+    BOOL overflow = FALSE;
+    int ifIndex;
+
+    if (ifname == NULL || pAddr6 == NULL)
+    {
+        return ANSC_STATUS_BAD_PARAMETER;
+    }
+
+    /* exact name match, unlike a substring search on /proc/net/if_inet6 */
+    if ((ifIndex = if_nametoindex(ifname)) == 0)
+    {
+        return ANSC_STATUS_FAILURE;
+    }
+
+    if (!gAddr6CacheValid && WanMgr_Netlink_DumpIfAddr6() != ANSC_STATUS_SUCCESS)
+    {
+        return ANSC_STATUS_FAILURE;
+    }
+
+    pthread_mutex_lock(&gAddr6CacheMutex);
+    pIface = NlCacheFindIface(&gAddr6Cache, ifIndex, FALSE);
+    if (pIface != NULL && addrIdx < pIface->numAddr)
+    {
+        *pAddr6 = pIface->addr[addrIdx];
+        ret = ANSC_STATUS_SUCCESS;
+    }
+    overflow = (pIface == NULL && gAddr6Cache.overflow);
+    pthread_mutex_unlock(&gAddr6CacheMutex);
+
+    if (overflow)
+    {
+        /* the interface did not fit in the cache, ask the kernel directly */
+        WanMgr_NlCache6_t cache;
+
+        if (NlDumpAddr6(&cache, ifIndex) == ANSC_STATUS_SUCCESS &&
+            (pIface = NlCacheFindIface(&cache, ifIndex, FALSE)) != NULL && addrIdx < pIface->numAddr)
+        {
+            *pAddr6 = pIface->addr[addrIdx];
+            ret = ANSC_STATUS_SUCCESS;
+        }
+    }
+
+    return ret;
+}
+
+static void* WanMgr_Netlink_AddrMonitorThread(void *arg)
+{
+    int fd = (int)(intptr_t) arg;
+    char buf[NL_RECV_BUF_SIZE];
+
+    pthread_detach(pthread_self());
+
+    /* notifications queued since bind() are replayed on top of this dump */
+    if (WanMgr_Netlink_DumpIfAddr6() == ANSC_STATUS_SUCCESS)
+    {
+        gAddr6CacheValid = TRUE;
+    }
+
+    while (1)
+    {
+        struct nlmsghdr *nlh;
+        int len = recv(fd, buf, sizeof(buf), 0);
+
+        if (len < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            if (errno == ENOBUFS)
+            {
+                /* events were dropped, resync on next lookup */
+                CcspTraceWarning(("%s %d - netlink overrun, address cache invalidated\n", __FUNCTION__, __LINE__));
+                gAddr6CacheValid = FALSE;
+                if (WanMgr_Netlink_DumpIfAddr6() == ANSC_STATUS_SUCCESS)
+                {
+                    gAddr6CacheValid = TRUE;
+                }
+                continue;
+            }
+            CcspTraceError(("%s %d - netlink recv failed (%s)\n", __FUNCTION__, __LINE__, strerror(errno)));
+            break;
+        }
+
+        pthread_mutex_lock(&gAddr6CacheMutex);
+        for (nlh = (struct nlmsghdr *) buf; NLMSG_OK(nlh, (unsigned int) len); nlh = NLMSG_NEXT(nlh, len))
+        {
+            WanMgr_NlAddr6_t addr6;
+            int ifIndex = 0;
+
+            if ((nlh->nlmsg_type == RTM_NEWADDR || nlh->nlmsg_type == RTM_DELADDR) &&
+                NlParseAddr6(nlh, &ifIndex, &addr6))
+            {
+                NlCacheApply(&gAddr6Cache, nlh->nlmsg_type, ifIndex, &addr6);
+            }
+        }
+        pthread_mutex_unlock(&gAddr6CacheMutex);
+    }
+
+    gAddr6CacheValid = FALSE;
+    close(fd);
+    pthread_exit(NULL);
+}
+
+ANSC_STATUS WanMgr_Netlink_StartAddrMonitor(void)
+{
+    pthread_t monitorThreadId;
+    int fd;
+    int ret;
+
+    if ((fd = NlOpenSocket(RTMGRP_IPV6_IFADDR)) < 0)
+    {
+        return ANSC_STATUS_FAILURE;
+    }
+
+    ret = pthread_create(&monitorThreadId, NULL, &WanMgr_Netlink_AddrMonitorThread, (void *)(intptr_t) fd);
+    if (0 != ret)
+    {
+        CcspTraceError(("%s %d - Failed to start address monitor thread Error:%d\n", __FUNCTION__, __LINE__, ret));
+        close(fd);
+        return ANSC_STATUS_FAILURE;
+    }
+
+    CcspTraceInfo(("%s %d - Address monitor thread started\n", __FUNCTION__, __LINE__));
+    return ANSC_STATUS_SUCCESS;
+}
+
+ANSC_STATUS WanMgr_Netlink_SetAddr6(int ifIndex, BOOL add, const struct in6_addr *pAddr, uint32_t prefixLen, uint32_t preferred, uint32_t valid)
+{
+    struct
+    {
+        struct nlmsghdr  nlh;
+        struct ifaddrmsg ifa;
+        char             attrs[64];
+    } req;
+    struct ifa_cacheinfo cache;
+
+    if (pAddr == NULL || prefixLen > 128)
+    {
+        return ANSC_STATUS_BAD_PARAMETER;
+    }
+
+    memset(&req, 0, sizeof(req));
+    req.nlh.nlmsg_len = NLMSG_LENGTH(sizeof(struct ifaddrmsg));
+    req.ifa.ifa_family = AF_INET6;
+    req.ifa.ifa_prefixlen = prefixLen;
+    req.ifa.ifa_scope = RT_SCOPE_UNIVERSE;
+    req.ifa.ifa_index = ifIndex;
+
+    NlAddAttr(&req.nlh, sizeof(req), IFA_LOCAL, pAddr, sizeof(struct in6_addr));
+
+    if (add != TRUE)
+    {
+        req.nlh.nlmsg_type = RTM_DELADDR;
+        return NlTransact(&req.nlh, "delete address", EADDRNOTAVAIL);
+    }
+
+    /* replace so that a renewal only refreshes the lifetimes */
+    req.nlh.nlmsg_type = RTM_NEWADDR;
+    req.nlh.nlmsg_flags = NLM_F_CREATE | NLM_F_REPLACE;
+
+    memset(&cache, 0, sizeof(cache));
+    cache.ifa_prefered = preferred;
+    cache.ifa_valid = valid;
+    NlAddAttr(&req.nlh, sizeof(req), IFA_CACHEINFO, &cache, sizeof(cache));
+
+    return NlTransact(&req.nlh, "add address", 0);
+}
+
+ANSC_STATUS WanMgr_Netlink_ReplaceDefaultRoute(const char *ifname)
+{
+    struct
+    {
+        struct nlmsghdr nlh;
+        struct rtmsg    rtm;
+        char            attrs[64];
+    } req;
+    uint32_t ifIndex;
+
+    if (ifname == NULL || (ifIndex = if_nametoindex(ifname)) == 0)
+    {
+        return ANSC_STATUS_BAD_PARAMETER;
+    }
+
+    memset(&req, 0, sizeof(req));
+    req.nlh.nlmsg_len = NLMSG_LENGTH(sizeof(struct rtmsg));
+    req.nlh.nlmsg_type = RTM_NEWROUTE;
+    req.nlh.nlmsg_flags = NLM_F_CREATE | NLM_F_REPLACE;
+    req.rtm.rtm_family = AF_INET;
+    req.rtm.rtm_dst_len = 0;
+    req.rtm.rtm_table = RT_TABLE_MAIN;
+    req.rtm.rtm_protocol = RTPROT_BOOT;
+    req.rtm.rtm_scope = RT_SCOPE_LINK;
+    req.rtm.rtm_type = RTN_UNICAST;
+
+    NlAddAttr(&req.nlh, sizeof(req), RTA_OIF, &ifIndex, sizeof(uint32_t));
+
+    return NlTransact(&req.nlh, "default route", 0);
+}
+
+ANSC_STATUS WanMgr_Netlink_ReplaceDefaultRoute4(uint32_t table, const WanMgr_NlNexthop4_t *pHops, uint32_t numHops)
+{
+    struct
+    {
+        struct nlmsghdr nlh;
+        struct rtmsg    rtm;
+        char            attrs[64 + WANMGR_NL_MAX_NEXTHOPS * 32];
+    } req;
+    uint32_t ifIndex[WANMGR_NL_MAX_NEXTHOPS];
+    struct rtattr *mp;
+    struct rtnexthop *rtnh;
+    struct rtattr *gw;
+    char *p;
+    uint32_t i;
+
+    if (pHops == NULL || numHops == 0 || numHops > WANMGR_NL_MAX_NEXTHOPS)
+    {
+        return ANSC_STATUS_BAD_PARAMETER;
+    }
+
+    for (i = 0; i < numHops; i++)
+    {
+        if ((ifIndex[i] = if_nametoindex(pHops[i].ifname)) == 0)
+        {
+            CcspTraceError(("%s %d - unknown interface %s\n", __FUNCTION__, __LINE__, pHops[i].ifname));
+            return ANSC_STATUS_BAD_PARAMETER;
+        }
+    }
+
+    memset(&req, 0, sizeof(req));
+    req.nlh.nlmsg_len = NLMSG_LENGTH(sizeof(struct rtmsg));
+    req.nlh.nlmsg_type = RTM_NEWROUTE;
+    req.nlh.nlmsg_flags = NLM_F_CREATE | NLM_F_REPLACE;
+    req.rtm.rtm_family = AF_INET;
+    req.rtm.rtm_dst_len = 0;
+    req.rtm.rtm_table = (table < 256) ? table : RT_TABLE_UNSPEC;
+    req.rtm.rtm_protocol = RTPROT_BOOT;
+    req.rtm.rtm_type = RTN_UNICAST;
+
+    NlAddAttr(&req.nlh, sizeof(req), RTA_TABLE, &table, sizeof(uint32_t));
+
+    if (numHops == 1)
+    {
+        req.rtm.rtm_scope = (pHops[0].gateway.s_addr != 0) ? RT_SCOPE_UNIVERSE : RT_SCOPE_LINK;
+        NlAddAttr(&req.nlh, sizeof(req), RTA_OIF, &ifIndex[0], sizeof(uint32_t));
+        if (pHops[0].gateway.s_addr != 0)
+        {
+            NlAddAttr(&req.nlh, sizeof(req), RTA_GATEWAY, &pHops[0].gateway, sizeof(struct in_addr));
+        }
+    }
+    else
+    {
+        /* kernel hashes each flow onto one nexthop, in proportion to the weights */
+        req.rtm.rtm_scope = RT_SCOPE_UNIVERSE;
+        mp = (struct rtattr *)(((char *) &req) + NLMSG_ALIGN(req.nlh.nlmsg_len));
+        mp->rta_type = RTA_MULTIPATH;
+        p = RTA_DATA(mp);
+        for (i = 0; i < numHops; i++)
+        {
+            rtnh = (struct rtnexthop *) p;
+            memset(rtnh, 0, sizeof(struct rtnexthop));
+            rtnh->rtnh_ifindex = ifIndex[i];
+            rtnh->rtnh_hops = (pHops[i].weight > 0 && pHops[i].weight <= 256) ? pHops[i].weight - 1 : 0;
+            rtnh->rtnh_len = sizeof(struct rtnexthop);
+            if (pHops[i].gateway.s_addr != 0)
+            {
+                gw = RTNH_DATA(rtnh);
+                gw->rta_type = RTA_GATEWAY;
+                gw->rta_len = RTA_LENGTH(sizeof(struct in_addr));
+                memcpy(RTA_DATA(gw), &pHops[i].gateway, sizeof(struct in_addr));
+                rtnh->rtnh_len += RTA_SPACE(sizeof(struct in_addr));
+            }
+            p += RTNH_ALIGN(rtnh->rtnh_len);
+        }
+        mp->rta_len = RTA_LENGTH(p - (char *) RTA_DATA(mp));
+        req.nlh.nlmsg_len = NLMSG_ALIGN(req.nlh.nlmsg_len) + RTA_ALIGN(mp->rta_len);
+    }
+
+    return NlTransact(&req.nlh, "default route", 0);
+}
+
+ANSC_STATUS WanMgr_Netlink_DeleteDefaultRoute4(uint32_t table)
+{
+    struct
+    {
+        struct nlmsghdr nlh;
+        struct rtmsg    rtm;
+        char            attrs[16];
+    } req;
+
+    memset(&req, 0, sizeof(req));
+    req.nlh.nlmsg_len = NLMSG_LENGTH(sizeof(struct rtmsg));
+    req.nlh.nlmsg_type = RTM_DELROUTE;
+    req.rtm.rtm_family = AF_INET;
+    req.rtm.rtm_dst_len = 0;
+    req.rtm.rtm_table = (table < 256) ? table : RT_TABLE_UNSPEC;
+    req.rtm.rtm_scope = RT_SCOPE_NOWHERE;
+
+    NlAddAttr(&req.nlh, sizeof(req), RTA_TABLE, &table, sizeof(uint32_t));
+
+    return NlTransact(&req.nlh, "delete default route", ESRCH);
+}
+
+ANSC_STATUS WanMgr_Netlink_SetRule4(BOOL add, uint32_t pref, uint32_t table, uint32_t fwmark, uint32_t fwmask, const struct in_addr *pSrc)
+{
+    struct
+    {
+        struct nlmsghdr     nlh;
+        struct fib_rule_hdr frh;
+        char                attrs[64];
+    } req;
+
+    memset(&req, 0, sizeof(req));
+    req.nlh.nlmsg_len = NLMSG_LENGTH(sizeof(struct fib_rule_hdr));
+    req.frh.family = AF_INET;
+
+    NlAddAttr(&req.nlh, sizeof(req), FRA_PRIORITY, &pref, sizeof(uint32_t));
+
+    if (add != TRUE)
+    {
+        /* the priority alone selects the rule */
+        req.nlh.nlmsg_type = RTM_DELRULE;
+        return NlTransact(&req.nlh, "delete rule", ENOENT);
+    }
+
+    req.nlh.nlmsg_type = RTM_NEWRULE;
+    req.nlh.nlmsg_flags = NLM_F_CREATE | NLM_F_EXCL;
+    req.frh.action = FR_ACT_TO_TBL;
+    req.frh.table = (table < 256) ? table : RT_TABLE_UNSPEC;
+
+    NlAddAttr(&req.nlh, sizeof(req), FRA_TABLE, &table, sizeof(uint32_t));
+    if (fwmask != 0)
+    {
+        NlAddAttr(&req.nlh, sizeof(req), FRA_FWMARK, &fwmark, sizeof(uint32_t));
+        NlAddAttr(&req.nlh, sizeof(req), FRA_FWMASK, &fwmask, sizeof(uint32_t));
+    }
+    if (pSrc != NULL)
+    {
+        req.frh.src_len = 32;
+        NlAddAttr(&req.nlh, sizeof(req), FRA_SRC, pSrc, sizeof(struct in_addr));
+    }
+
+    return NlTransact(&req.nlh, "add rule", EEXIST);
+}
+
+ANSC_STATUS WanMgr_Netlink_GetNeighbour(int ifIndex, int family, const void *pAddr, uint8_t *pMac)
+{
+    struct
+    {
+        struct nlmsghdr nlh;
+        struct ndmsg    ndm;
+    } req;
+    NlNeighLookup_t lookup;
+
+    if (pAddr == NULL || pMac == NULL || (family != AF_INET && family != AF_INET6))
+    {
+        return ANSC_STATUS_BAD_PARAMETER;
+    }
+
+    memset(&req, 0, sizeof(req));
+    req.nlh.nlmsg_len = NLMSG_LENGTH(sizeof(struct ndmsg));
+    req.nlh.nlmsg_type = RTM_GETNEIGH;
+    req.ndm.ndm_family = family;
+
+    lookup.ifIndex = ifIndex;
+    lookup.family = family;
+    lookup.pAddr = pAddr;
+    lookup.pMac = pMac;
+
+    return NlDump(&req.nlh, "RTM_GETNEIGH", NlMatchNeigh, &lookup);
+}
+
+ANSC_STATUS WanMgr_Netlink_ResolveNeighbour(int ifIndex, int family, const void *pAddr)
+{
+    struct
+    {
+        struct nlmsghdr nlh;
+        struct ndmsg    ndm;
+        char            attrs[32];
+    } req;
+
+    if (pAddr == NULL || (family != AF_INET && family != AF_INET6))
+    {
+        return ANSC_STATUS_BAD_PARAMETER;
+    }
+
+    memset(&req, 0, sizeof(req));
+    req.nlh.nlmsg_len = NLMSG_LENGTH(sizeof(struct ndmsg));
+    req.nlh.nlmsg_type = RTM_NEWNEIGH;
+    req.nlh.nlmsg_flags = NLM_F_CREATE;
+    req.ndm.ndm_family = family;
+    req.ndm.ndm_ifindex = ifIndex;
+    req.ndm.ndm_state = NUD_NONE;
+    req.ndm.ndm_flags = NTF_USE;    /* kick off ARP/ND as if a packet was sent */
+
+    NlAddAttr(&req.nlh, sizeof(req), NDA_DST, pAddr, (family == AF_INET) ? sizeof(struct in_addr) : sizeof(struct in6_addr));
+
+    return NlTransact(&req.nlh, "resolve neighbour", 0);
+}
+
+static ANSC_STATUS NlLookupDefaultRoute6(int ifIndex, struct in6_addr *pGateway)
+{
+    struct
+    {
+        struct nlmsghdr nlh;
+        struct rtmsg    rtm;
+    } req;
+    NlGw6Lookup_t lookup;
+
+    memset(&req, 0, sizeof(req));
+    req.nlh.nlmsg_len = NLMSG_LENGTH(sizeof(struct rtmsg));
+    req.nlh.nlmsg_type = RTM_GETROUTE;
+    req.rtm.rtm_family = AF_INET6;
+
+    lookup.ifIndex = ifIndex;
+    lookup.pGateway = pGateway;
+
+    return NlDump(&req.nlh, "RTM_GETROUTE", NlMatchDefaultRoute6, &lookup);
+}
+
+ANSC_STATUS WanMgr_Netlink_GetDefaultGateway6(int ifIndex, struct in6_addr *pGateway)
+{
+    if (pGateway == NULL)
+    {
+        return ANSC_STATUS_BAD_PARAMETER;
+    }
+
+    return NlLookupDefaultRoute6(ifIndex, pGateway);
+}
+
+ANSC_STATUS WanMgr_Netlink_FindDefaultRoute6(int ifIndex)
+{
+    return NlLookupDefaultRoute6(ifIndex, NULL);
+}
+
+int WanMgr_Netlink_OpenRouteEvents(void)
+{
+    int fd = NlOpenSocket(RTMGRP_IPV4_ROUTE | RTMGRP_IPV6_ROUTE | RTMGRP_NEIGH);
+
+    if (fd >= 0 && fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK) < 0)
+    {
+        CcspTraceError(("%s %d - netlink socket not made non-blocking (%s)\n", __FUNCTION__, __LINE__, strerror(errno)));
+        close(fd);
+        return -1;
+    }
+
+    return fd;
+}
+
+static BOOL NlParseRouteEvent(struct nlmsghdr *nlh, WanMgr_NlRouteEvent_t *pEvent)
+{
+    struct rtattr *rta;
+    int rtaLen;
+
+    memset(pEvent, 0, sizeof(WanMgr_NlRouteEvent_t));
+    pEvent->type = nlh->nlmsg_type;
+
+    if (nlh->nlmsg_type == RTM_NEWNEIGH || nlh->nlmsg_type == RTM_DELNEIGH)
+    {
+        struct ndmsg *ndm = (struct ndmsg *) NLMSG_DATA(nlh);
+        size_t addrLen = (ndm->ndm_family == AF_INET) ? sizeof(struct in_addr) : sizeof(struct in6_addr);
+        BOOL haveDst = FALSE;
+        BOOL haveLladdr = FALSE;
+
+        pEvent->family = ndm->ndm_family;
+        pEvent->ifIndex = ndm->ndm_ifindex;
+
+        rtaLen = RTM_PAYLOAD(nlh);
+        for (rta = RTM_RTA(ndm); RTA_OK(rta, rtaLen); rta = RTA_NEXT(rta, rtaLen))
+        {
+            if (rta->rta_type == NDA_DST && RTA_PAYLOAD(rta) == addrLen)
+            {
+                memcpy(&pEvent->addr, RTA_DATA(rta), addrLen);
+                haveDst = TRUE;
+            }
+            else if (rta->rta_type == NDA_LLADDR && RTA_PAYLOAD(rta) == ETH_ALEN)
+            {
+                memcpy(pEvent->mac, RTA_DATA(rta), ETH_ALEN);
+                haveLladdr = TRUE;
+            }
+        }
+
+        pEvent->resolved = (nlh->nlmsg_type == RTM_NEWNEIGH && haveLladdr == TRUE &&
+                            (ndm->ndm_state & (NUD_INCOMPLETE | NUD_FAILED | NUD_NOARP)) == 0) ? TRUE : FALSE;
+        return haveDst;
+    }
+
+    if (nlh->nlmsg_type == RTM_NEWROUTE || nlh->nlmsg_type == RTM_DELROUTE)
+    {
+        struct rtmsg *rtm = (struct rtmsg *) NLMSG_DATA(nlh);
+        uint32_t table = rtm->rtm_table;
+
+        pEvent->family = rtm->rtm_family;
+
+        rtaLen = RTM_PAYLOAD(nlh);
+        for (rta = RTM_RTA(rtm); RTA_OK(rta, rtaLen); rta = RTA_NEXT(rta, rtaLen))
+        {
+            if (rta->rta_type == RTA_OIF && RTA_PAYLOAD(rta) == sizeof(int))
+            {
+                pEvent->ifIndex = *(int *) RTA_DATA(rta);
+            }
+            else if (rta->rta_type == RTA_TABLE && RTA_PAYLOAD(rta) == sizeof(uint32_t))
+            {
+                table = *(uint32_t *) RTA_DATA(rta);
+            }
+        }
+
+        pEvent->isDefault = (rtm->rtm_dst_len == 0 && table == RT_TABLE_MAIN) ? TRUE : FALSE;
+        return TRUE;
+    }
+
+    return FALSE;
+}
+
+ANSC_STATUS WanMgr_Netlink_ReadRouteEvents(int fd, WanMgr_NlRouteEventCb_t cb, void *arg)
+{
+    char buf[NL_RECV_BUF_SIZE];
+    BOOL bDropped = FALSE;
+
+    if (fd < 0 || cb == NULL)
+    {
+        return ANSC_STATUS_BAD_PARAMETER;
+    }
+
+    for (;;)
+    {
+        struct nlmsghdr *nlh;
+        int len = recv(fd, buf, sizeof(buf), 0);
+
+        if (len < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            if (errno == ENOBUFS)
+            {
+                CcspTraceWarning(("%s %d - netlink overrun, route events dropped\n", __FUNCTION__, __LINE__));
+                bDropped = TRUE;
+                continue;
+            }
+            break;
+        }
+
+        for (nlh = (struct nlmsghdr *) buf; NLMSG_OK(nlh, (unsigned int) len); nlh = NLMSG_NEXT(nlh, len))
+        {
+            WanMgr_NlRouteEvent_t event;
+
+            if (NlParseRouteEvent(nlh, &event) == TRUE)
+            {
+                cb(&event, arg);
+            }
+        }
+    }
+
+    return (bDropped == TRUE) ? ANSC_STATUS_FAILURE : ANSC_STATUS_SUCCESS;
+}
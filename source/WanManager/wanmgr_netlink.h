@@ -0,0 +1,199 @@
+/*
+ * If not stated otherwise in this file or this component's Licenses.txt file the
+ * following copyright and licenses apply:
+ *
+ * Copyright 2020 RDK Management
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+*/
+
+#ifndef _WANMGR_NETLINK_H_
+#define _WANMGR_NETLINK_H_
+
+/* ---- Include Files ---------------------------------------- */
+#include <stdint.h>
+#include <netinet/in.h>
+#include <net/if.h>
+#include <linux/if_ether.h>
+#include "ansc_platform.h"
+
+/* ---- Global Constants -------------------------------------- */
+#define WANMGR_NL_MAX_IFACES          32
+#define WANMGR_NL_MAX_ADDR6_PER_IFACE 16
+#define WANMGR_NL_MAX_NEXTHOPS        8
+
+/* ---- Global Types -------------------------------------------- */
+typedef struct _WanMgr_NlAddr6_t
+{
+    struct in6_addr addr;
+    uint32_t        prefixLen;
+    uint32_t        scope;      /* RT_SCOPE_UNIVERSE (0) for globally unique addresses */
+    uint32_t        ifaFlags;
+} WanMgr_NlAddr6_t;
+
+typedef struct _WanMgr_NlNexthop4_t
+{
+    char            ifname[IFNAMSIZ];
+    struct in_addr  gateway;    /* 0.0.0.0 for a point-to-point link */
+    uint32_t        weight;     /* 1..256, share of the flows */
+} WanMgr_NlNexthop4_t;
+
+typedef struct _WanMgr_NlRouteEvent_t
+{
+    int             type;       /* RTM_NEWROUTE, RTM_DELROUTE, RTM_NEWNEIGH or RTM_DELNEIGH */
+    int             family;     /* AF_INET or AF_INET6 */
+    int             ifIndex;    /* interface of the neighbour or route, 0 for a multipath route */
+    BOOL            isDefault;  /* route: default route of the main table */
+    BOOL            resolved;   /* neighbour: link layer address is usable */
+    struct in6_addr addr;       /* neighbour: address, IPv4 in the first 4 bytes */
+    uint8_t         mac[ETH_ALEN];
+} WanMgr_NlRouteEvent_t;
+
+typedef void (*WanMgr_NlRouteEventCb_t)(const WanMgr_NlRouteEvent_t *pEvent, void *arg);
+
+/* ---- Global Prototypes -------------------------------------- */
+
+/***************************************************************************
+ * @brief Dump all IPv6 addresses of the system with RTM_GETADDR and
+ * rebuild the per-interface address cache.
+ * @return ANSC_STATUS_SUCCESS upon success else returned error code.
+ ****************************************************************************/
+ANSC_STATUS WanMgr_Netlink_DumpIfAddr6(void);
+
+/***************************************************************************
+ * @brief Look up the n-th cached IPv6 address of an interface. The cache is
+ * refreshed with a netlink dump first if it is not known to be current.
+ * @param ifname exact interface name
+ * @param addrIdx index of the address on that interface
+ * @param pAddr6 output address entry
+ * @return ANSC_STATUS_SUCCESS if found else ANSC_STATUS_FAILURE.
+ ****************************************************************************/
+ANSC_STATUS WanMgr_Netlink_GetIfAddr6(const char *ifname, uint32_t addrIdx, WanMgr_NlAddr6_t *pAddr6);
+
+/***************************************************************************
+ * @brief Start the address-event monitor which keeps the IPv6 address
+ * cache current from RTM_NEWADDR/RTM_DELADDR notifications.
+ * @return ANSC_STATUS_SUCCESS upon success else returned error code.
+ ****************************************************************************/
+ANSC_STATUS WanMgr_Netlink_StartAddrMonitor(void);
+
+/***************************************************************************
+ * @brief Add, refresh or delete an IPv6 address of an interface (equivalent
+ * of "ip -6 addr replace|del <addr>/<len> dev <if> preferred_lft .. valid_lft ..").
+ * @param ifIndex interface index
+ * @param add TRUE to add or refresh the address, FALSE to delete it
+ * @param pAddr address
+ * @param prefixLen prefix length
+ * @param preferred preferred lifetime in seconds, 0xFFFFFFFF for infinite
+ * @param valid valid lifetime in seconds, 0xFFFFFFFF for infinite
+ * @return ANSC_STATUS_SUCCESS upon success else returned error code.
+ ****************************************************************************/
+ANSC_STATUS WanMgr_Netlink_SetAddr6(int ifIndex, BOOL add, const struct in6_addr *pAddr, uint32_t prefixLen, uint32_t preferred, uint32_t valid);
+
+/***************************************************************************
+ * @brief Replace the IPv4 default route in the main table with a route
+ * through the given device (equivalent of "ip ro rep default dev <ifname>").
+ * @param ifname output interface name
+ * @return ANSC_STATUS_SUCCESS upon success else returned error code.
+ ****************************************************************************/
+ANSC_STATUS WanMgr_Netlink_ReplaceDefaultRoute(const char *ifname);
+
+/***************************************************************************
+ * @brief Replace the IPv4 default route of a routing table. With more than
+ * one nexthop a multipath route is installed and the kernel spreads the
+ * flows over the nexthops by weight.
+ * @param table routing table id
+ * @param pHops nexthops
+ * @param numHops number of nexthops, 1..WANMGR_NL_MAX_NEXTHOPS
+ * @return ANSC_STATUS_SUCCESS upon success else returned error code.
+ ****************************************************************************/
+ANSC_STATUS WanMgr_Netlink_ReplaceDefaultRoute4(uint32_t table, const WanMgr_NlNexthop4_t *pHops, uint32_t numHops);
+
+/***************************************************************************
+ * @brief Delete the IPv4 default route of a routing table. A missing route
+ * is not an error.
+ * @param table routing table id
+ * @return ANSC_STATUS_SUCCESS upon success else returned error code.
+ ****************************************************************************/
+ANSC_STATUS WanMgr_Netlink_DeleteDefaultRoute4(uint32_t table);
+
+/***************************************************************************
+ * @brief Add or delete an IPv4 policy routing rule. Rules are identified by
+ * their priority, so every rule must get its own.
+ * @param add TRUE to add the rule, FALSE to delete the rule with that priority
+ * @param pref rule priority
+ * @param table routing table to look up
+ * @param fwmark firewall mark to match, used when fwmask is not 0
+ * @param fwmask mask applied to the packet mark before the match
+ * @param pSrc source address to match, NULL for any
+ * @return ANSC_STATUS_SUCCESS upon success else returned error code.
+ ****************************************************************************/
+ANSC_STATUS WanMgr_Netlink_SetRule4(BOOL add, uint32_t pref, uint32_t table, uint32_t fwmark, uint32_t fwmask, const struct in_addr *pSrc);
+
+/***************************************************************************
+ * @brief Look up the link layer address of a resolved neighbour.
+ * @param ifIndex interface the neighbour is on
+ * @param family AF_INET or AF_INET6
+ * @param pAddr neighbour address, struct in_addr or struct in6_addr
+ * @param pMac output, ETH_ALEN bytes
+ * @return ANSC_STATUS_SUCCESS if the neighbour is resolved else ANSC_STATUS_FAILURE.
+ ****************************************************************************/
+ANSC_STATUS WanMgr_Netlink_GetNeighbour(int ifIndex, int family, const void *pAddr, uint8_t *pMac);
+
+/***************************************************************************
+ * @brief Start resolving a neighbour (ARP/ND) without sending any traffic
+ * to it. The result is read later with WanMgr_Netlink_GetNeighbour.
+ * @param ifIndex interface the neighbour is on
+ * @param family AF_INET or AF_INET6
+ * @param pAddr neighbour address, struct in_addr or struct in6_addr
+ * @return ANSC_STATUS_SUCCESS upon success else returned error code.
+ ****************************************************************************/
+ANSC_STATUS WanMgr_Netlink_ResolveNeighbour(int ifIndex, int family, const void *pAddr);
+
+/***************************************************************************
+ * @brief Look up the router of the IPv6 default route through an interface.
+ * For an ECMP route, the router of the first next hop through the interface.
+ * @param ifIndex interface of the default route, 0 for any interface
+ * @param pGateway output router address, usually link local
+ * @return ANSC_STATUS_SUCCESS if found else ANSC_STATUS_FAILURE.
+ ****************************************************************************/
+ANSC_STATUS WanMgr_Netlink_GetDefaultGateway6(int ifIndex, struct in6_addr *pGateway);
+
+/***************************************************************************
+ * @brief Check for an IPv6 default route through an interface, whether it
+ * names a router, has several next hops or only an interface such as ppp0.
+ * @param ifIndex interface of the default route, 0 for any interface
+ * @return ANSC_STATUS_SUCCESS if found else ANSC_STATUS_FAILURE.
+ ****************************************************************************/
+ANSC_STATUS WanMgr_Netlink_FindDefaultRoute6(int ifIndex);
+
+/***************************************************************************
+ * @brief Open a non-blocking netlink socket notified of route and neighbour
+ * changes, for the caller to poll and drain with
+ * WanMgr_Netlink_ReadRouteEvents().
+ * @return the socket, -1 on error.
+ ****************************************************************************/
+int WanMgr_Netlink_OpenRouteEvents(void);
+
+/***************************************************************************
+ * @brief Read the pending route and neighbour changes of a socket opened
+ * by WanMgr_Netlink_OpenRouteEvents().
+ * @param fd route event socket
+ * @param cb called for each change
+ * @param arg passed to cb
+ * @return ANSC_STATUS_SUCCESS upon success, ANSC_STATUS_FAILURE if changes
+ * were dropped and whatever depends on them has to be looked up again.
+ ****************************************************************************/
+ANSC_STATUS WanMgr_Netlink_ReadRouteEvents(int fd, WanMgr_NlRouteEventCb_t cb, void *arg);
+
+#endif /* _WANMGR_NETLINK_H_ */
@@ -106,7 +106,11 @@ static INT WanMgr_Policy_FM_SelectWANActive(void)
 /*********************************************************************************/
 static WcFmPolicyState_t Transition_Start(WanMgr_Policy_Controller_t* pWanController)
 {
-    WanMgr_UpdatePlatformStatus(WANMGR_DISCONNECTED);
+    //Nothing to report while taking over a running WAN from the previous policy
+    if(pWanController->handOffPending == FALSE)
+    {
+        WanMgr_UpdatePlatformStatus(WANMGR_DISCONNECTED);
+    }
     return STATE_FIXING_WAN_INTERFACE;
 }
 
@@ -127,6 +131,13 @@ static WcFmPolicyState_t Transition_WanInterfaceFixed(WanMgr_Policy_Controller_t
     //ActiveLink
     pFixedInterface->Wan.ActiveLink = TRUE;
 
+    /* The previous policy already runs the interface state machine on it */
+    if(WanMgr_Controller_AdoptIfaceSM(pWanController, pWanController->activeInterfaceIdx) == TRUE)
+    {
+        CcspTraceInfo(("%s %d - State changed to STATE_FIXED_WAN_INTERFACE_UP \n", __FUNCTION__, __LINE__));
+        return STATE_FIXED_WAN_INTERFACE_UP;
+    }
+
     WanMgr_UpdatePlatformStatus(WANMGR_LINK_UP);
 
     return STATE_FIXED_WAN_INTERFACE_DOWN;
@@ -207,6 +218,9 @@ static WcFmPolicyState_t State_FixingWanInterface(WanMgr_Policy_Controller_t* pW
         return Transition_WanInterfaceFixed(pWanController);
     }
 
+    /* Nothing to take over, release what the previous policy left running */
+    WanMgr_Controller_AdoptIfaceSM(pWanController, -1);
+
     return STATE_FIXING_WAN_INTERFACE;
 }
 
@@ -231,7 +245,8 @@ static WcFmPolicyState_t State_FixedWanInterfaceDown(WanMgr_Policy_Controller_t*
         pFixedInterface->Phy.Status == WAN_IFACE_PHY_STATUS_INITIALIZING) &&
         pWanController->WanEnable &&
         pFixedInterface->Wan.Status == WAN_IFACE_STATUS_DISABLED &&
-        pFixedInterface->Wan.LinkStatus == WAN_IFACE_LINKSTATUS_DOWN)
+        pFixedInterface->Wan.LinkStatus == WAN_IFACE_LINKSTATUS_DOWN &&
+        WanMgr_Controller_HandOffDone(pWanController) == TRUE)
     {
         return Transition_FixedInterfaceUp(pWanController);
     }
@@ -298,9 +313,6 @@ ANSC_STATUS WanMgr_Policy_FixedModePolicy(void)
 {
     CcspTraceInfo(("%s %d \n", __FUNCTION__, __LINE__));
 
-    //detach thread from caller stack
-    pthread_detach(pthread_self());
-
     //policy variables
     ANSC_STATUS retStatus = ANSC_STATUS_SUCCESS;
     WanMgr_Policy_Controller_t    WanPolicyCtrl;
@@ -341,10 +353,18 @@ ANSC_STATUS WanMgr_Policy_FixedModePolicy(void)
         if(pWanConfigData != NULL)
         {
             WanPolicyCtrl.WanEnable = pWanConfigData->data.Enable;
+            bRunning = (pWanConfigData->data.Policy == FIXED_MODE);
 
             WanMgrDml_GetConfigData_release(pWanConfigData);
         }
 
+        if(bRunning == false)
+        {
+            //Policy changed, the interface state machines are left to the next policy
+            CcspTraceInfo(("%s %d - Policy changed, stopping\n", __FUNCTION__, __LINE__));
+            break;
+        }
+
         //Lock Iface Data
         WanPolicyCtrl.pWanActiveIfaceData = WanMgr_GetIfaceData_locked(WanPolicyCtrl.activeInterfaceIdx);
 
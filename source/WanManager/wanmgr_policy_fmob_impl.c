@@ -104,7 +104,11 @@ static INT WanMgr_Policy_FM_SelectWANActive(void)
 /*********************************************************************************/
 static WcFmobPolicyState_t Transition_Start(WanMgr_Policy_Controller_t* pWanController)
 {
-    WanMgr_UpdatePlatformStatus(WANMGR_DISCONNECTED);
+    //Nothing to report while taking over a running WAN from the previous policy
+    if(pWanController->handOffPending == FALSE)
+    {
+        WanMgr_UpdatePlatformStatus(WANMGR_DISCONNECTED);
+    }
     CcspTraceInfo(("%s %d - State changed to STATE_FIXING_WAN_INTERFACE \n", __FUNCTION__, __LINE__));
     return STATE_FIXING_WAN_INTERFACE;
 }
@@ -126,6 +130,13 @@ static WcFmobPolicyState_t Transition_WanInterfaceFixed(WanMgr_Policy_Controller
     //ActiveLink
     pFixedInterface->Wan.ActiveLink = TRUE;
 
+    /* The previous policy already runs the interface state machine on it */
+    if(WanMgr_Controller_AdoptIfaceSM(pWanController, pWanController->activeInterfaceIdx) == TRUE)
+    {
+        CcspTraceInfo(("%s %d - State changed to STATE_FIXED_WAN_INTERFACE_UP \n", __FUNCTION__, __LINE__));
+        return STATE_FIXED_WAN_INTERFACE_UP;
+    }
+
     WanMgr_UpdatePlatformStatus(WANMGR_LINK_UP);
 
     CcspTraceInfo(("%s %d - State changed to STATE_FIXED_WAN_INTERFACE_DOWN \n", __FUNCTION__, __LINE__));
@@ -180,6 +191,9 @@ static WcFmobPolicyState_t State_FixingWanInterface(WanMgr_Policy_Controller_t*
         return Transition_WanInterfaceFixed(pWanController);
     }
 
+    /* Nothing to take over, release what the previous policy left running */
+    WanMgr_Controller_AdoptIfaceSM(pWanController, -1);
+
     return STATE_FIXING_WAN_INTERFACE;
 }
 
@@ -203,7 +217,8 @@ static WcFmobPolicyState_t State_FixedWanInterfaceDown(WanMgr_Policy_Controller_
         (pFixedInterface->Phy.Status == WAN_IFACE_PHY_STATUS_UP ||
          pFixedInterface->Phy.Status == WAN_IFACE_PHY_STATUS_INITIALIZING) &&
         pFixedInterface->Wan.Status == WAN_IFACE_STATUS_DISABLED &&
-        pFixedInterface->Wan.LinkStatus == WAN_IFACE_LINKSTATUS_DOWN )
+        pFixedInterface->Wan.LinkStatus == WAN_IFACE_LINKSTATUS_DOWN &&
+        WanMgr_Controller_HandOffDone(pWanController) == TRUE )
     {
         return Transition_FixedInterfaceUp(pWanController);
     }
@@ -242,9 +257,6 @@ ANSC_STATUS WanMgr_Policy_FixedModeOnBootupPolicy(void)
 {
     CcspTraceInfo(("%s %d \n", __FUNCTION__, __LINE__));
 
-    //detach thread from caller stack
-    pthread_detach(pthread_self());
-
     //policy variables
     ANSC_STATUS retStatus = ANSC_STATUS_SUCCESS;
     WanMgr_Policy_Controller_t    WanPolicyCtrl;
@@ -284,9 +296,17 @@ ANSC_STATUS WanMgr_Policy_FixedModeOnBootupPolicy(void)
         if(pWanConfigData != NULL)
         {
             WanPolicyCtrl.WanEnable = pWanConfigData->data.Enable;
+            bRunning = (pWanConfigData->data.Policy == FIXED_MODE_ON_BOOTUP);
             WanMgrDml_GetConfigData_release(pWanConfigData);
         }
 
+        if(bRunning == false)
+        {
+            //Policy changed, the interface state machines are left to the next policy
+            CcspTraceInfo(("%s %d - Policy changed, stopping\n", __FUNCTION__, __LINE__));
+            break;
+        }
+
         //Lock Iface Data
         WanPolicyCtrl.pWanActiveIfaceData = WanMgr_GetIfaceData_locked(WanPolicyCtrl.activeInterfaceIdx);
 
@@ -0,0 +1,438 @@
+/*
+   If not stated otherwise in this file or this component's Licenses.txt file the
+ * following copyright and licenses apply:
+ *
+ * Copyright 2020 RDK Management
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+*/
+
+/* ---- Include Files ---------------------------------------- */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <linux/rtnetlink.h>
+#include "wanmgr_controller.h"
+#include "wanmgr_data.h"
+#include "wanmgr_rdkbus_utils.h"
+#include "wanmgr_interface_sm.h"
+#include "wanmgr_platform_events.h"
+#include "wanmgr_net_utils.h"
+#include "wanmgr_netlink.h"
+#include "wanmgr_link_metrics.h"
+
+/* ---- Global Constants -------------------------- */
+#define LOOP_TIMEOUT 500000 // timeout in milliseconds. This is the state machine loop interval
+
+#define MW_MAX_WANS                 WANMGR_NL_MAX_NEXTHOPS
+#define MW_ROUTE_TABLE_BASE         100     // routing table of a WAN is MW_ROUTE_TABLE_BASE + iface idx
+#define MW_RULE_PREF_BASE           10000   // rules of a WAN start at MW_RULE_PREF_BASE + iface idx * MW_RULE_PREF_PER_WAN
+#define MW_RULE_PREF_PER_WAN        (WAN_IF_MARKING_MAX_LIMIT + 1)
+#define MW_SKB_MARK_MASK            0xFFF00000  // SKBMark is the marking instance number << 20
+#define MW_MULTIPATH_HASH_POLICY    "/proc/sys/net/ipv4/fib_multipath_hash_policy"
+#define MW_DEGRADED_WEIGHT_DIV      4       // a degraded WAN keeps this fraction of its share of new flows
+
+/* Routing state of one WAN */
+typedef struct _WcMwRoute_t
+{
+    BOOL            bRouted;
+    CHAR            wanName[BUFLEN_64];     // link metrics key
+    CHAR            ifname[IFNAMSIZ];
+    struct in_addr  ip;
+    struct in_addr  gateway;
+    UINT            weight;
+    UINT            numMarks;
+    UINT            marks[WAN_IF_MARKING_MAX_LIMIT];
+} WcMwRoute_t;
+
+
+/*********************************************************************************/
+/**************************** ACTIONS ********************************************/
+/*********************************************************************************/
+/* Same table and rules, the weight only matters to the main multipath route */
+static BOOL WanMgr_Policy_MW_RouteEqual(const WcMwRoute_t* pA, const WcMwRoute_t* pB)
+{
+    if (pA->bRouted != pB->bRouted)
+    {
+        return FALSE;
+    }
+
+    if (pA->bRouted == FALSE)
+    {
+        return TRUE;
+    }
+
+    return (strcmp(pA->ifname, pB->ifname) == 0 &&
+            pA->ip.s_addr == pB->ip.s_addr &&
+            pA->gateway.s_addr == pB->gateway.s_addr &&
+            pA->numMarks == pB->numMarks &&
+            memcmp(pA->marks, pB->marks, pA->numMarks * sizeof(UINT)) == 0) ? TRUE : FALSE;
+}
+
+static void WanMgr_Policy_MW_GetMarks(DML_WAN_IFACE* pWanIfaceData, WcMwRoute_t* pRoute)
+{
+#ifdef FEATURE_802_1P_COS_MARKING
+    PSINGLE_LINK_ENTRY pSListEntry = AnscSListGetFirstEntry(&(pWanIfaceData->Marking.MarkingList));
+
+    while (pSListEntry != NULL && pRoute->numMarks < WAN_IF_MARKING_MAX_LIMIT)
+    {
+        CONTEXT_MARKING_LINK_OBJECT* pCxtLink = ACCESS_CONTEXT_MARKING_LINK_OBJECT(pSListEntry);
+        DML_MARKING* p_Marking = (DML_MARKING*)pCxtLink->hContext;
+
+        if (p_Marking != NULL && p_Marking->SKBMark != 0)
+        {
+            pRoute->marks[pRoute->numMarks++] = p_Marking->SKBMark;
+        }
+
+        pSListEntry = AnscSListGetNextEntry(pSListEntry);
+    }
+#endif /* FEATURE_802_1P_COS_MARKING */
+}
+
+/* Start the interface state machine of every usable WAN, release the others,
+   and collect the routing state of the WANs which have an IPv4 lease */
+static void WanMgr_Policy_MW_UpdateIfaces(WanMgr_Policy_Controller_t* pWanController, WcMwRoute_t* pWanted)
+{
+    UINT uiLoopCount;
+    UINT uiTotalIfaces = 0;
+    WanMgr_IfaceSM_Controller_t wanIfCtrl;
+
+    memset(pWanted, 0, MW_MAX_WANS * sizeof(WcMwRoute_t));
+
+    WanMgr_IfaceCtrl_Data_t*   pWanIfaceCtrl = WanMgr_GetIfaceCtrl_locked();
+    if(pWanIfaceCtrl != NULL)
+    {
+        uiTotalIfaces = pWanIfaceCtrl->ulTotalNumbWanInterfaces;
+
+        WanMgrDml_GetIfaceCtrl_release(pWanIfaceCtrl);
+    }
+
+    if(uiTotalIfaces > MW_MAX_WANS)
+    {
+        uiTotalIfaces = MW_MAX_WANS;
+    }
+
+    for( uiLoopCount = 0; uiLoopCount < uiTotalIfaces; uiLoopCount++ )
+    {
+        WanMgr_Iface_Data_t*   pWanDmlIfaceData = WanMgr_GetIfaceData_locked(uiLoopCount);
+        if(pWanDmlIfaceData != NULL)
+        {
+            DML_WAN_IFACE* pWanIfaceData = &(pWanDmlIfaceData->data);
+            BOOL bUsable = (pWanController->WanEnable == TRUE &&
+                            pWanIfaceData->Wan.Enable == TRUE &&
+                            pWanIfaceData->Wan.Weight > 0 &&
+                            (pWanIfaceData->Phy.Status == WAN_IFACE_PHY_STATUS_UP ||
+                             pWanIfaceData->Phy.Status == WAN_IFACE_PHY_STATUS_INITIALIZING)) ? TRUE : FALSE;
+
+            if(bUsable == TRUE)
+            {
+                if(pWanIfaceData->Wan.Status == WAN_IFACE_STATUS_DISABLED &&
+                   pWanIfaceData->Wan.LinkStatus == WAN_IFACE_LINKSTATUS_DOWN)
+                {
+                    pWanIfaceData->Wan.ActiveLink = TRUE;
+
+                    CcspTraceInfo(("%s %d - Starting WAN '%s'\n", __FUNCTION__, __LINE__, pWanIfaceData->Name));
+
+                    /* Starts an instance of the WAN Interface State Machine on
+                    the interface to begin configuring the WAN link */
+                    WanMgr_IfaceSM_Init(&wanIfCtrl, pWanIfaceData->uiIfaceIdx);
+                    WanMgr_StartInterfaceStateMachine(&wanIfCtrl);
+                }
+                else if(pWanIfaceData->Wan.Status != WAN_IFACE_STATUS_DISABLED)
+                {
+                    //Running, possibly taken over from the previous policy
+                    pWanIfaceData->Wan.ActiveLink = TRUE;
+                }
+
+                if(pWanIfaceData->Wan.Status == WAN_IFACE_STATUS_UP &&
+                   pWanIfaceData->IP.Ipv4Status == WAN_IFACE_IPV4_STATE_UP &&
+                   pWanIfaceData->IP.Ipv4Data.ifname[0] != '\0')
+                {
+                    WcMwRoute_t* pRoute = &pWanted[uiLoopCount];
+
+                    //The lease carries a BUFLEN_64 name, routes take kernel names only
+                    if(strlen(pWanIfaceData->IP.Ipv4Data.ifname) >= sizeof(pRoute->ifname))
+                    {
+                        CcspTraceError(("%s %d - interface name '%s' too long to route\n", __FUNCTION__, __LINE__, pWanIfaceData->IP.Ipv4Data.ifname));
+                        WanMgrDml_GetIfaceData_release(pWanDmlIfaceData);
+                        continue;
+                    }
+
+                    pRoute->bRouted = TRUE;
+                    snprintf(pRoute->ifname, sizeof(pRoute->ifname), "%s", pWanIfaceData->IP.Ipv4Data.ifname);
+                    pRoute->ip = pWanIfaceData->IP.Ipv4Data.bin.ip;
+                    pRoute->gateway = pWanIfaceData->IP.Ipv4Data.bin.gateway;
+                    pRoute->weight = (pWanIfaceData->Wan.Weight > 256) ? 256 : pWanIfaceData->Wan.Weight;
+                    snprintf(pRoute->wanName, sizeof(pRoute->wanName), "%s", pWanIfaceData->Wan.Name);
+                    WanMgr_Policy_MW_GetMarks(pWanIfaceData, pRoute);
+                }
+            }
+            else if(pWanIfaceData->Wan.ActiveLink == TRUE)
+            {
+                //Let the interface state machine tear the WAN down
+                pWanIfaceData->Wan.ActiveLink = FALSE;
+                CcspTraceInfo(("%s %d - Stopping WAN '%s'\n", __FUNCTION__, __LINE__, pWanIfaceData->Name));
+            }
+
+            WanMgrDml_GetIfaceData_release(pWanDmlIfaceData);
+        }
+    }
+
+    //Measured without the interface data locked, the sysfs reads can be slow
+    for( uiLoopCount = 0; uiLoopCount < uiTotalIfaces; uiLoopCount++ )
+    {
+        WcMwRoute_t* pRoute = &pWanted[uiLoopCount];
+
+        if(pRoute->bRouted == TRUE)
+        {
+            WanMgr_LinkMetrics_Update(pRoute->wanName);
+            if(WanMgr_LinkMetrics_IsDegraded(pRoute->wanName) == TRUE)
+            {
+                pRoute->weight = (pRoute->weight / MW_DEGRADED_WEIGHT_DIV > 0) ? pRoute->weight / MW_DEGRADED_WEIGHT_DIV : 1;
+            }
+        }
+    }
+}
+
+static void WanMgr_Policy_MW_Unroute(UINT idx, WcMwRoute_t* pRoute)
+{
+    UINT pref = MW_RULE_PREF_BASE + idx * MW_RULE_PREF_PER_WAN;
+    UINT i;
+
+    for (i = 0; i <= pRoute->numMarks; i++)
+    {
+        WanMgr_Netlink_SetRule4(FALSE, pref + i, 0, 0, 0, NULL);
+    }
+    WanMgr_Netlink_DeleteDefaultRoute4(MW_ROUTE_TABLE_BASE + idx);
+
+    CcspTraceInfo(("%s %d - WAN %u (%s) removed from the routing\n", __FUNCTION__, __LINE__, idx, pRoute->ifname));
+    memset(pRoute, 0, sizeof(WcMwRoute_t));
+}
+
+static void WanMgr_Policy_MW_Route(UINT idx, WcMwRoute_t* pRoute, const WcMwRoute_t* pRouted)
+{
+    UINT pref = MW_RULE_PREF_BASE + idx * MW_RULE_PREF_PER_WAN;
+    UINT table = MW_ROUTE_TABLE_BASE + idx;
+    WanMgr_NlNexthop4_t hop;
+    UINT i;
+    UINT j;
+    UINT k;
+
+    memset(&hop, 0, sizeof(hop));
+    snprintf(hop.ifname, sizeof(hop.ifname), "%s", pRoute->ifname);
+    hop.gateway = pRoute->gateway;
+    hop.weight = 1;
+
+    if (WanMgr_Netlink_ReplaceDefaultRoute4(table, &hop, 1) != ANSC_STATUS_SUCCESS)
+    {
+        pRoute->bRouted = FALSE;
+        return;
+    }
+
+    //Traffic sourced from the WAN address leaves through that WAN
+    WanMgr_Netlink_SetRule4(TRUE, pref, table, 0, 0, &pRoute->ip);
+
+    //Traffic classified by the Marking table is pinned to its WAN
+    for (i = 0; i < pRoute->numMarks; i++)
+    {
+        BOOL bClaimed = FALSE;
+
+        for (j = 0; j < MW_MAX_WANS && bClaimed == FALSE; j++)
+        {
+            if (j == idx || pRouted[j].bRouted == FALSE)
+            {
+                continue;
+            }
+            for (k = 0; k < pRouted[j].numMarks; k++)
+            {
+                if (pRouted[j].marks[k] == pRoute->marks[i])
+                {
+                    bClaimed = TRUE;
+                    break;
+                }
+            }
+        }
+
+        if (bClaimed == TRUE)
+        {
+            CcspTraceWarning(("%s %d - mark 0x%x of %s already routed to another WAN\n", __FUNCTION__, __LINE__, pRoute->marks[i], pRoute->ifname));
+            continue;
+        }
+
+        WanMgr_Netlink_SetRule4(TRUE, pref + 1 + i, table, pRoute->marks[i], MW_SKB_MARK_MASK, NULL);
+    }
+
+    CcspTraceInfo(("%s %d - WAN %u (%s) routed through table %u, weight %u\n", __FUNCTION__, __LINE__, idx, pRoute->ifname, table, pRoute->weight));
+}
+
+/* Bring the kernel routing in line with the WANs that are up */
+static void WanMgr_Policy_MW_ApplyRoutes(WcMwRoute_t* pRouted, const WcMwRoute_t* pWanted)
+{
+    WanMgr_NlNexthop4_t hops[MW_MAX_WANS];
+    BOOL bChanged = FALSE;
+    UINT numHops = 0;
+    UINT idx;
+
+    for (idx = 0; idx < MW_MAX_WANS; idx++)
+    {
+        if (WanMgr_Policy_MW_RouteEqual(&pRouted[idx], &pWanted[idx]) == TRUE)
+        {
+            //Only the share of new flows changed, the WAN table and rules stay
+            if (pRouted[idx].bRouted == TRUE && pRouted[idx].weight != pWanted[idx].weight)
+            {
+                pRouted[idx].weight = pWanted[idx].weight;
+                bChanged = TRUE;
+            }
+            continue;
+        }
+
+        bChanged = TRUE;
+        if (pRouted[idx].bRouted == TRUE)
+        {
+            WanMgr_Policy_MW_Unroute(idx, &pRouted[idx]);
+        }
+        if (pWanted[idx].bRouted == TRUE)
+        {
+            pRouted[idx] = pWanted[idx];
+            WanMgr_Policy_MW_Route(idx, &pRouted[idx], pRouted);
+        }
+    }
+
+    if (bChanged == FALSE)
+    {
+        return;
+    }
+
+    //New flows are spread over the WANs by weight
+    memset(hops, 0, sizeof(hops));
+    for (idx = 0; idx < MW_MAX_WANS; idx++)
+    {
+        if (pRouted[idx].bRouted == TRUE)
+        {
+            snprintf(hops[numHops].ifname, sizeof(hops[numHops].ifname), "%s", pRouted[idx].ifname);
+            hops[numHops].gateway = pRouted[idx].gateway;
+            hops[numHops].weight = pRouted[idx].weight;
+            numHops++;
+        }
+    }
+
+    if (numHops > 0)
+    {
+        WanMgr_Netlink_ReplaceDefaultRoute4(RT_TABLE_MAIN, hops, numHops);
+    }
+    else
+    {
+        //No WAN left, drop the default route rather than keep dead next hops
+        WanMgr_Netlink_DeleteDefaultRoute4(RT_TABLE_MAIN);
+    }
+
+    CcspTraceInfo(("%s %d - %u WAN(s) active\n", __FUNCTION__, __LINE__, numHops));
+}
+
+
+/*********************************************************************************/
+/*********************************************************************************/
+/*********************************************************************************/
+/* WanMgr_Policy_MultiWanPolicy */
+ANSC_STATUS WanMgr_Policy_MultiWanPolicy(void)
+{
+    CcspTraceInfo(("%s %d \n", __FUNCTION__, __LINE__));
+
+    //policy variables
+    ANSC_STATUS retStatus = ANSC_STATUS_SUCCESS;
+    WanMgr_Policy_Controller_t    WanPolicyCtrl;
+    WcMwRoute_t routed[MW_MAX_WANS];
+    WcMwRoute_t wanted[MW_MAX_WANS];
+    bool bRunning = true;
+    BOOL bMainRouted = FALSE;
+    UINT idx;
+
+    // event handler
+    int n = 0;
+    struct timeval tv;
+
+    if(WanMgr_Controller_PolicyCtrlInit(&WanPolicyCtrl) != ANSC_STATUS_SUCCESS)
+    {
+        CcspTraceError(("%s %d Policy Controller Error \n", __FUNCTION__, __LINE__));
+        return ANSC_STATUS_FAILURE;
+    }
+
+    CcspTraceInfo(("%s %d  Multi WAN Policy Thread Starting \n", __FUNCTION__, __LINE__));
+
+    //Every usable WAN is kept, a running WAN is taken over as it is
+    if(WanPolicyCtrl.handOffPending == FALSE)
+    {
+        WanMgr_UpdatePlatformStatus(WANMGR_DISCONNECTED);
+    }
+    WanPolicyCtrl.handOffPending = FALSE;
+
+    //Hash on the ports too, so flows between the same hosts still spread
+    WanManager_SetProcSysValue(MW_MULTIPATH_HASH_POLICY, "1", NULL, 0);
+
+    memset(routed, 0, sizeof(routed));
+
+    while (bRunning)
+    {
+        /* Wait up to 500 milliseconds */
+        tv.tv_sec = 0;
+        tv.tv_usec = LOOP_TIMEOUT;
+
+        n = select(0, NULL, NULL, NULL, &tv);
+        if (n < 0)
+        {
+            /* interrupted by signal or something, continue */
+            continue;
+        }
+
+        //Update Wan config
+        WanMgr_Config_Data_t*   pWanConfigData = WanMgr_GetConfigData_locked();
+        if(pWanConfigData != NULL)
+        {
+            WanPolicyCtrl.WanEnable = pWanConfigData->data.Enable;
+            bRunning = (pWanConfigData->data.Policy == MULTIWAN_MODE);
+
+            WanMgrDml_GetConfigData_release(pWanConfigData);
+        }
+
+        if(bRunning == false)
+        {
+            //Policy changed, the interface state machines are left to the next policy
+            CcspTraceInfo(("%s %d - Policy changed, stopping\n", __FUNCTION__, __LINE__));
+            break;
+        }
+
+        WanMgr_Policy_MW_UpdateIfaces(&WanPolicyCtrl, wanted);
+        WanMgr_Policy_MW_ApplyRoutes(routed, wanted);
+    }
+
+    //The per WAN tables and rules only make sense with this policy
+    for (idx = 0; idx < MW_MAX_WANS; idx++)
+    {
+        if (routed[idx].bRouted == TRUE)
+        {
+            bMainRouted = TRUE;
+            WanMgr_Policy_MW_Unroute(idx, &routed[idx]);
+        }
+    }
+
+    //So does the multipath default route, the adopting policy sets its own
+    if (bMainRouted == TRUE)
+    {
+        WanMgr_Netlink_DeleteDefaultRoute4(RT_TABLE_MAIN);
+    }
+
+    CcspTraceInfo(("%s %d - Exit from state machine\n", __FUNCTION__, __LINE__));
+
+    return retStatus;
+}
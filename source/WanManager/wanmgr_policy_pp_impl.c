@@ -27,10 +27,21 @@
 #include "wanmgr_rdkbus_utils.h"
 #include "wanmgr_interface_sm.h"
 #include "wanmgr_platform_events.h"
+#include "wanmgr_link_metrics.h"
+#ifdef WAN_ENABLE_STANDBY
+#include <linux/rtnetlink.h>
+#include "wanmgr_netlink.h"
+#endif //WAN_ENABLE_STANDBY
 
 /* ---- Global Constants -------------------------- */
 #define LOOP_TIMEOUT 500000 // timeout in milliseconds. This is the state machine loop interval
 
+#ifdef WAN_ENABLE_STANDBY
+/* Multipath weights while new flows of a degraded primary are steered to the secondary */
+#define PP_SHED_PRIMARY_WEIGHT      1
+#define PP_SHED_SECONDARY_WEIGHT    3
+#endif //WAN_ENABLE_STANDBY
+
 
 /* primary priority policy */
 typedef enum {
@@ -172,6 +183,95 @@ static bool WanMgr_CheckAllIfacesDown(void)
     return bAllDown;
 }
 
+/* Samples the counters of a running WAN, the sysfs reads are done without the interface data locked */
+static void WanMgr_Policy_PP_UpdateLinkMetrics(INT iface_idx)
+{
+    CHAR wanName[BUFLEN_64] = {0};
+
+    if(iface_idx < 0)
+    {
+        return;
+    }
+
+    WanMgr_Iface_Data_t*   pWanDmlIfaceData = WanMgr_GetIfaceData_locked(iface_idx);
+    if(pWanDmlIfaceData != NULL)
+    {
+        if(pWanDmlIfaceData->data.Wan.Status == WAN_IFACE_STATUS_UP)
+        {
+            snprintf(wanName, sizeof(wanName), "%s", pWanDmlIfaceData->data.Wan.Name);
+        }
+
+        WanMgrDml_GetIfaceData_release(pWanDmlIfaceData);
+    }
+
+    if(wanName[0] != '\0')
+    {
+        WanMgr_LinkMetrics_Update(wanName);
+    }
+}
+
+#ifdef WAN_ENABLE_STANDBY
+/* While the standby secondary is up, steer most new flows of a degraded primary to it.
+   Flows already running keep their path, the primary is not torn down. */
+static void WanMgr_Policy_PP_ShedFlows(WanMgr_Policy_Controller_t* pWanController)
+{
+    DML_WAN_IFACE* pActiveInterface = &(pWanController->pWanActiveIfaceData->data);
+    WanMgr_NlNexthop4_t hops[2];
+    BOOL bShed = FALSE;
+
+    if(pActiveInterface->IP.Ipv4Status != WAN_IFACE_IPV4_STATE_UP)
+    {
+        //The interface state machine owns the default route again once the primary comes back
+        pWanController->flowsShed = FALSE;
+        return;
+    }
+
+    memset(hops, 0, sizeof(hops));
+    snprintf(hops[0].ifname, sizeof(hops[0].ifname), "%s", pActiveInterface->IP.Ipv4Data.ifname);
+    hops[0].gateway = pActiveInterface->IP.Ipv4Data.bin.gateway;
+    hops[0].weight = PP_SHED_PRIMARY_WEIGHT;
+
+    WanMgr_Iface_Data_t*   pWanDmlIfaceData = WanMgr_GetIfaceData_locked(pWanController->selSecondaryInterfaceIdx);
+    if(pWanDmlIfaceData != NULL)
+    {
+        DML_WAN_IFACE* pSecondaryInterface = &(pWanDmlIfaceData->data);
+
+        if(pSecondaryInterface->IP.Ipv4Status == WAN_IFACE_IPV4_STATE_UP &&
+           pSecondaryInterface->IP.Ipv4Data.ifname[0] != '\0' &&
+           strcmp(pSecondaryInterface->IP.Ipv4Data.ifname, hops[0].ifname) != 0)
+        {
+            bShed = (WanMgr_LinkMetrics_IsDegraded(pActiveInterface->Wan.Name) == TRUE &&
+                     WanMgr_LinkMetrics_IsDegraded(pSecondaryInterface->Wan.Name) == FALSE) ? TRUE : FALSE;
+
+            snprintf(hops[1].ifname, sizeof(hops[1].ifname), "%s", pSecondaryInterface->IP.Ipv4Data.ifname);
+            hops[1].gateway = pSecondaryInterface->IP.Ipv4Data.bin.gateway;
+            hops[1].weight = PP_SHED_SECONDARY_WEIGHT;
+        }
+
+        WanMgrDml_GetIfaceData_release(pWanDmlIfaceData);
+    }
+
+    if(bShed == pWanController->flowsShed)
+    {
+        return;
+    }
+
+    if(bShed == TRUE)
+    {
+        CcspTraceInfo(("%s %d - %s degraded, steering new flows to %s\n", __FUNCTION__, __LINE__, hops[0].ifname, hops[1].ifname));
+        WanMgr_Netlink_ReplaceDefaultRoute4(RT_TABLE_MAIN, hops, 2);
+    }
+    else
+    {
+        CcspTraceInfo(("%s %d - new flows back on %s\n", __FUNCTION__, __LINE__, hops[0].ifname));
+        hops[0].weight = 1;
+        WanMgr_Netlink_ReplaceDefaultRoute4(RT_TABLE_MAIN, hops, 1);
+    }
+
+    pWanController->flowsShed = bShed;
+}
+#endif //WAN_ENABLE_STANDBY
+
 /*********************************************************************************/
 /************************** TRANSITIONS ******************************************/
 /*********************************************************************************/
@@ -183,7 +283,11 @@ static WcPpPolicyState_t Transition_Start(WanMgr_Policy_Controller_t* pWanContro
         return ANSC_STATUS_FAILURE;
     }
 
-    WanMgr_UpdatePlatformStatus(WANMGR_DISCONNECTED);
+    //Nothing to report while taking over a running WAN from the previous policy
+    if(pWanController->handOffPending == FALSE)
+    {
+        WanMgr_UpdatePlatformStatus(WANMGR_DISCONNECTED);
+    }
 
     CcspTraceInfo(("%s %d - State changed to STATE_INTERFACE_DOWN \n", __FUNCTION__, __LINE__));
     return STATE_INTERFACE_DOWN;
@@ -487,6 +591,29 @@ static WcPpPolicyState_t State_WanDown(WanMgr_Policy_Controller_t* pWanControlle
         return ANSC_STATUS_FAILURE;
     }
 
+    /* Take over the WAN the previous policy left running if this policy selects it too */
+    if(pWanController->handOffPending == TRUE)
+    {
+        WanMgr_Policy_FM_SelectWANActive(pWanController, &selectedPrimaryInterface, &selectedSecondaryInterface);
+
+        if(selectedPrimaryInterface != -1)
+        {
+            if(WanMgr_Controller_AdoptIfaceSM(pWanController, selectedPrimaryInterface) == TRUE)
+            {
+                pWanController->activeInterfaceIdx = selectedPrimaryInterface;
+                CcspTraceInfo(("%s %d - State changed to STATE_PRIMARY_WAN_ACTIVE \n", __FUNCTION__, __LINE__));
+                return STATE_PRIMARY_WAN_ACTIVE;
+            }
+        }
+        else if(WanMgr_Controller_AdoptIfaceSM(pWanController, selectedSecondaryInterface) == TRUE)
+        {
+            pWanController->activeInterfaceIdx = selectedSecondaryInterface;
+            pWanController->selSecondaryInterfaceIdx = selectedSecondaryInterface;
+            CcspTraceInfo(("%s %d - State changed to STATE_SECONDARY_WAN_ACTIVE \n", __FUNCTION__, __LINE__));
+            return STATE_SECONDARY_WAN_ACTIVE;
+        }
+    }
+
 #ifndef WAN_ENABLE_STANDBY
     /* Waiting to tear down all in active wan connection */
     if(WanMgr_CheckAllIfacesDown() == FALSE)
@@ -663,6 +790,10 @@ static WcPpPolicyState_t State_PrimaryWanActiveSecondaryWanUp(WanMgr_Policy_Cont
         return Transition_SecondaryInterfaceUp(pWanController);
     }
 
+#ifdef WAN_ENABLE_STANDBY
+    WanMgr_Policy_PP_ShedFlows(pWanController);
+#endif //WAN_ENABLE_STANDBY
+
     return STATE_PRIMARY_WAN_ACTIVE_SECONDARY_WAN_UP;
 }
 
@@ -675,9 +806,6 @@ ANSC_STATUS WanMgr_Policy_PrimaryPriorityPolicy(void)
 {
     CcspTraceInfo(("%s %d \n", __FUNCTION__, __LINE__));
 
-    //detach thread from caller stack
-    pthread_detach(pthread_self());
-
     //policy variables
     ANSC_STATUS retStatus = ANSC_STATUS_SUCCESS;
     WanMgr_Policy_Controller_t    WanPolicyCtrl;
@@ -717,10 +845,24 @@ ANSC_STATUS WanMgr_Policy_PrimaryPriorityPolicy(void)
         if(pWanConfigData != NULL)
         {
             WanPolicyCtrl.WanEnable = pWanConfigData->data.Enable;
+            bRunning = (pWanConfigData->data.Policy == PRIMARY_PRIORITY);
 
             WanMgrDml_GetConfigData_release(pWanConfigData);
         }
 
+        if(bRunning == false)
+        {
+            //Policy changed, the interface state machines are left to the next policy
+            CcspTraceInfo(("%s %d - Policy changed, stopping\n", __FUNCTION__, __LINE__));
+            break;
+        }
+
+        //Measure the links before locking, a degraded primary sheds new flows but stays selected
+        WanMgr_Policy_PP_UpdateLinkMetrics(WanPolicyCtrl.activeInterfaceIdx);
+#ifdef WAN_ENABLE_STANDBY
+        WanMgr_Policy_PP_UpdateLinkMetrics(WanPolicyCtrl.selSecondaryInterfaceIdx);
+#endif //WAN_ENABLE_STANDBY
+
         //Lock Iface Data
         WanPolicyCtrl.pWanActiveIfaceData = WanMgr_GetIfaceData_locked(WanPolicyCtrl.activeInterfaceIdx);
 
@@ -48,10 +48,41 @@ static WcPpobPolicyState_t Transition_Start(WanMgr_Policy_Controller_t* pWanCont
 static WcPpobPolicyState_t Transition_WanInterfaceSelected(WanMgr_Policy_Controller_t* pWanController);
 static WcPpobPolicyState_t Transition_SelectedInterfaceUp(WanMgr_Policy_Controller_t* pWanController);
 static WcPpobPolicyState_t Transition_SelectedInterfaceDown(WanMgr_Policy_Controller_t* pWanController);
+static WcPpobPolicyState_t Transition_SelectedInterfaceValidationFailed(WanMgr_Policy_Controller_t* pWanController);
 
 /*********************************************************************************/
 /**************************** ACTIONS ********************************************/
 /*********************************************************************************/
+static BOOL WanMgr_Policy_PPOB_IsBetterCandidate(INT priority, BOOL bFailed, INT selPriority, BOOL bSelFailed)
+{
+    if(priority < 0)
+    {
+        return FALSE;
+    }
+
+    //A link that failed validation is only picked over other failed links
+    if(bFailed != bSelFailed)
+    {
+        return (bFailed == FALSE) ? TRUE : FALSE;
+    }
+
+    return (priority < selPriority) ? TRUE : FALSE;
+}
+
+static BOOL WanMgr_Policy_PPOB_ValidationFailed(INT iIfaceIdx)
+{
+    BOOL bFailed = FALSE;
+
+    WanMgr_Iface_Data_t*   pWanDmlIfaceData = WanMgr_GetIfaceData_locked(iIfaceIdx);
+    if(pWanDmlIfaceData != NULL)
+    {
+        bFailed = pWanDmlIfaceData->data.Wan.ValidationFailed;
+        WanMgrDml_GetIfaceData_release(pWanDmlIfaceData);
+    }
+
+    return bFailed;
+}
+
 static void WanMgr_Policy_FM_SelectWANActive(WanMgr_Policy_Controller_t* pWanController, INT* pPrimaryInterface, INT* pSecondaryInterface)
 {
     UINT uiLoopCount;
@@ -60,6 +91,8 @@ static void WanMgr_Policy_FM_SelectWANActive(WanMgr_Policy_Controller_t* pWanCon
     INT iSelSecondaryInterface = -1;
     INT iSelPrimaryPriority = DML_WAN_IFACE_PRIORITY_MAX;
     INT iSelSecondaryPriority = DML_WAN_IFACE_PRIORITY_MAX;
+    BOOL bSelPrimaryFailed = TRUE;
+    BOOL bSelSecondaryFailed = TRUE;
 
     //Get uiTotalIfaces
     WanMgr_IfaceCtrl_Data_t*   pWanIfaceCtrl = WanMgr_GetIfaceCtrl_locked();
@@ -87,26 +120,24 @@ static void WanMgr_Policy_FM_SelectWANActive(WanMgr_Policy_Controller_t* pWanCon
                        (pWanIfaceData->Phy.Status == WAN_IFACE_PHY_STATUS_UP ||
                         pWanIfaceData->Phy.Status == WAN_IFACE_PHY_STATUS_INITIALIZING))
                     {
+                        BOOL bFailed = pWanIfaceData->Wan.ValidationFailed;
+
                         if(pWanIfaceData->Wan.Type == WAN_IFACE_TYPE_PRIMARY)
                         {
-                            if(pWanIfaceData->Wan.Priority < iSelPrimaryPriority)
+                            if(WanMgr_Policy_PPOB_IsBetterCandidate(pWanIfaceData->Wan.Priority, bFailed, iSelPrimaryPriority, bSelPrimaryFailed) == TRUE)
                             {
-                                if(pWanIfaceData->Wan.Priority >= 0)
-                                {
-                                    iSelPrimaryInterface = uiLoopCount;
-                                    iSelPrimaryPriority = pWanIfaceData->Wan.Priority;
-                                }
+                                iSelPrimaryInterface = uiLoopCount;
+                                iSelPrimaryPriority = pWanIfaceData->Wan.Priority;
+                                bSelPrimaryFailed = bFailed;
                             }
                         }
                         else
                         {
-                            if(pWanIfaceData->Wan.Priority < iSelSecondaryPriority)
+                            if(WanMgr_Policy_PPOB_IsBetterCandidate(pWanIfaceData->Wan.Priority, bFailed, iSelSecondaryPriority, bSelSecondaryFailed) == TRUE)
                             {
-                                if(pWanIfaceData->Wan.Priority >= 0)
-                                {
-                                    iSelSecondaryInterface = uiLoopCount;
-                                    iSelSecondaryPriority = pWanIfaceData->Wan.Priority;
-                                }
+                                iSelSecondaryInterface = uiLoopCount;
+                                iSelSecondaryPriority = pWanIfaceData->Wan.Priority;
+                                bSelSecondaryFailed = bFailed;
                             }
                         }
                     }
@@ -134,7 +165,11 @@ static WcPpobPolicyState_t Transition_Start(WanMgr_Policy_Controller_t* pWanCont
         return ANSC_STATUS_FAILURE;
     }
 
-    WanMgr_UpdatePlatformStatus(WANMGR_DISCONNECTED);
+    //Nothing to report while taking over a running WAN from the previous policy
+    if(pWanController->handOffPending == FALSE)
+    {
+        WanMgr_UpdatePlatformStatus(WANMGR_DISCONNECTED);
+    }
 
     return SELECTING_WAN_INTERFACE;
 }
@@ -151,6 +186,11 @@ static WcPpobPolicyState_t Transition_WanInterfaceSelected(WanMgr_Policy_Control
         return ANSC_STATUS_FAILURE;
     }
 
+    /* The previous policy already runs the interface state machine on it */
+    if(WanMgr_Controller_AdoptIfaceSM(pWanController, pWanController->activeInterfaceIdx) == TRUE)
+    {
+        return SELECTED_INTERFACE_UP;
+    }
 
     /* Select WAN as Active */
     WanMgr_Iface_Data_t*   pWanDmlIfaceData = WanMgr_GetIfaceData_locked(pWanController->activeInterfaceIdx);
@@ -172,6 +212,12 @@ static WcPpobPolicyState_t Transition_WanInterfaceSelected(WanMgr_Policy_Control
         return SELECTED_INTERFACE_DOWN;
     }
 
+    /* Wait for the WAN released by the policy hand-off to tear down */
+    if(WanMgr_Controller_HandOffDone(pWanController) == FALSE)
+    {
+        return SELECTED_INTERFACE_DOWN;
+    }
+
     WanMgr_UpdatePlatformStatus(WANMGR_CONNECTING);
 
     /* Starts an instance of the WAN Interface State Machine on
@@ -227,6 +273,35 @@ static WcPpobPolicyState_t Transition_SelectedInterfaceDown(WanMgr_Policy_Contro
     return SELECTED_INTERFACE_DOWN;
 }
 
+static WcPpobPolicyState_t Transition_SelectedInterfaceValidationFailed(WanMgr_Policy_Controller_t* pWanController)
+{
+    DML_WAN_IFACE* pActiveInterface = NULL;
+
+    if(pWanController == NULL)
+    {
+        CcspTraceError(("%s %d pWanController object is NULL \n", __FUNCTION__, __LINE__));
+        return ANSC_STATUS_FAILURE;
+    }
+
+    if(pWanController->pWanActiveIfaceData == NULL)
+    {
+        return SELECTED_INTERFACE_DOWN;
+    }
+
+    pActiveInterface = &(pWanController->pWanActiveIfaceData->data);
+
+    CcspTraceInfo(("%s %d - Interface '%s' failed validation, selecting another interface\n", __FUNCTION__, __LINE__, pActiveInterface->Name));
+
+    //Set ActiveLink to FALSE, its state machine tears the WAN down
+    pActiveInterface->Wan.ActiveLink = FALSE;
+
+    pWanController->activeInterfaceIdx = -1;
+
+    WanMgr_UpdatePlatformStatus(WANMGR_DISCONNECTED);
+
+    return SELECTING_WAN_INTERFACE;
+}
+
 /*********************************************************************************/
 /**************************** STATES *********************************************/
 /*********************************************************************************/
@@ -250,6 +325,13 @@ static WcPpobPolicyState_t State_SelectingWanInterface(WanMgr_Policy_Controller_
         if selectiontimeout timer > maximum selection timeout of the connected interfaces,
         use the highest priority interface */
         pWanController->activeInterfaceIdx = selectedPrimaryInterface;
+
+        //The secondary is used while the primary fails validation
+        if(WanMgr_Policy_PPOB_ValidationFailed(selectedPrimaryInterface) == TRUE &&
+           WanMgr_Policy_PPOB_ValidationFailed(selectedSecondaryInterface) == FALSE)
+        {
+            pWanController->activeInterfaceIdx = selectedSecondaryInterface;
+        }
     }
     else if(selectedPrimaryInterface != -1)
     {
@@ -265,6 +347,9 @@ static WcPpobPolicyState_t State_SelectingWanInterface(WanMgr_Policy_Controller_
         return Transition_WanInterfaceSelected(pWanController);
     }
 
+    /* Nothing to take over, release what the previous policy left running */
+    WanMgr_Controller_AdoptIfaceSM(pWanController, -1);
+
     return SELECTING_WAN_INTERFACE;
 }
 
@@ -293,6 +378,33 @@ static WcPpobPolicyState_t State_SelectedInterfaceUp(WanMgr_Policy_Controller_t*
         return Transition_SelectedInterfaceDown(pWanController);
     }
 
+    /* Fail over when the interface state machine found no DHCP service on the
+    link and another interface has not failed validation */
+    if(pActiveInterface->Wan.ValidationFailed == TRUE)
+    {
+        int selectedInterfaces[2] = { -1, -1 };
+        BOOL bCandidate = FALSE;
+        int i;
+
+        //Primary first, the secondary when the primary failed as well
+        WanMgr_Policy_FM_SelectWANActive(pWanController, &selectedInterfaces[0], &selectedInterfaces[1]);
+
+        for(i = 0; i < 2 && bCandidate == FALSE; i++)
+        {
+            if(selectedInterfaces[i] != -1 &&
+               selectedInterfaces[i] != pWanController->activeInterfaceIdx &&
+               WanMgr_Policy_PPOB_ValidationFailed(selectedInterfaces[i]) == FALSE)
+            {
+                bCandidate = TRUE;
+            }
+        }
+
+        if(bCandidate == TRUE)
+        {
+            return Transition_SelectedInterfaceValidationFailed(pWanController);
+        }
+    }
+
     /* TODO: Traffic to the WAN Interface has been idle for a time that exceeds
     the configured IdleTimeout value */
     //return Transition_SelectedInterfaceDown(pWanController);
@@ -321,7 +433,8 @@ static WcPpobPolicyState_t State_SelectedInterfaceDown(WanMgr_Policy_Controller_
        (pActiveInterface->Phy.Status == WAN_IFACE_PHY_STATUS_UP ||
        pActiveInterface->Phy.Status == WAN_IFACE_PHY_STATUS_INITIALIZING) &&
        pActiveInterface->Wan.LinkStatus == WAN_IFACE_LINKSTATUS_DOWN &&
-       pActiveInterface->Wan.Status == WAN_IFACE_STATUS_DISABLED)
+       pActiveInterface->Wan.Status == WAN_IFACE_STATUS_DISABLED &&
+       WanMgr_Controller_HandOffDone(pWanController) == TRUE)
     {
         return Transition_SelectedInterfaceUp(pWanController);
     }
@@ -338,9 +451,6 @@ ANSC_STATUS WanMgr_Policy_PrimaryPriorityOnBootupPolicy(void)
 {
     CcspTraceInfo(("%s %d \n", __FUNCTION__, __LINE__));
 
-    //detach thread from caller stack
-    pthread_detach(pthread_self());
-
     //policy variables
     ANSC_STATUS retStatus = ANSC_STATUS_SUCCESS;
     WanMgr_Policy_Controller_t    WanPolicyCtrl;
@@ -381,10 +491,18 @@ ANSC_STATUS WanMgr_Policy_PrimaryPriorityOnBootupPolicy(void)
         if(pWanConfigData != NULL)
         {
             WanPolicyCtrl.WanEnable = pWanConfigData->data.Enable;
+            bRunning = (pWanConfigData->data.Policy == PRIMARY_PRIORITY_ON_BOOTUP);
 
             WanMgrDml_GetConfigData_release(pWanConfigData);
         }
 
+        if(bRunning == false)
+        {
+            //Policy changed, the interface state machines are left to the next policy
+            CcspTraceInfo(("%s %d - Policy changed, stopping\n", __FUNCTION__, __LINE__));
+            break;
+        }
+
         //Lock Iface Data
         WanPolicyCtrl.pWanActiveIfaceData = WanMgr_GetIfaceData_locked(WanPolicyCtrl.activeInterfaceIdx);
 
@@ -0,0 +1,1181 @@
+/*
+ * If not stated otherwise in this file or this component's Licenses.txt file the
+ * following copyright and licenses apply:
+ *
+ * Copyright 2020 RDK Management
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+*/
+
+/* ---- Include Files ---------------------------------------- */
+#define _GNU_SOURCE     /* struct in6_pktinfo */
+#include <errno.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <time.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <sys/ioctl.h>
+#include <sys/socket.h>
+#include <sys/timerfd.h>
+#include <net/if.h>
+#include <netinet/icmp6.h>
+#include <netinet/ip_icmp.h>
+#include <linux/if_packet.h>
+#include <linux/if_ether.h>
+#include <linux/filter.h>
+#include <linux/rtnetlink.h>
+#include "wanmgr_probe.h"
+#include "wanmgr_event_loop.h"
+#include "wanmgr_netlink.h"
+#include "wanmgr_dhcp_client.h"
+#include "wanmgr_data.h"
+#include "wanmgr_interface_sm.h"
+#include "wanmgr_net_utils.h"
+
+#define PROBE_FAMILY_V4         0
+#define PROBE_FAMILY_V6         1
+#define PROBE_NUM_FAMILIES      2
+
+#define PROBE_PKT_MAX           256
+#define PROBE_ARP_LEN           28
+#define PROBE_DNS_PORT          53
+
+#ifndef ICMP_FILTER
+#define ICMP_FILTER             1   /* <linux/icmp.h>, clashes with <netinet/ip_icmp.h> */
+#endif
+
+typedef enum
+{
+    PROBE_PATH_IDLE = 0,        /* not probed */
+    PROBE_PATH_UP,              /* probed, reported up */
+    PROBE_PATH_DOWN             /* reported down, gateway watched for recovery */
+} ProbePathState_t;
+
+typedef enum
+{
+    PROBE_ACTION_DOWN = 0,
+    PROBE_ACTION_RENEW
+} ProbeAction_t;
+
+/* One address family of a probed interface, IPv4 addresses use the first 4 bytes */
+typedef struct _ProbePath_t
+{
+    ProbePathState_t    state;
+    struct in6_addr     local;
+    struct in6_addr     gateway;
+    struct in6_addr     host;           /* ICMP target */
+    struct in6_addr     dns;
+    BOOL                gatewayValid;
+    BOOL                gatewayDue;     /* IPv6 router to be looked up again, the default route changed */
+    BOOL                dnsValid;
+    BOOL                macValid;       /* IPv4 gateway MAC learnt from its ARP */
+    uint8_t             gwMac[ETH_ALEN];
+    BOOL                sent;           /* a round is outstanding */
+    BOOL                answered;       /* the outstanding round was answered */
+    uint16_t            seq;
+    UINT                misses;
+    UINT                recovered;
+    UINT                recoverNeeded;
+    uint64_t            upSinceMs;
+} ProbePath_t;
+
+typedef struct _ProbeSession_t
+{
+    BOOL                    inUse;
+    char                    ifName[IFNAMSIZ];
+    int                     ifIndex;
+    uint8_t                 ifMac[ETH_ALEN];
+    WanMgr_ProbeConfig_t    cfg;
+    uint16_t                ident;
+    uint64_t                nextMs;
+    ProbePath_t             path[PROBE_NUM_FAMILIES];
+} ProbeSession_t;
+
+typedef struct _ProbeWork_t
+{
+    char            ifName[IFNAMSIZ];
+    int             family;
+    ProbeAction_t   action;
+} ProbeWork_t;
+
+/* ---- Private Variables ------------------------------------ */
+static ProbeSession_t gSessions[WANMGR_PROBE_MAX_IFACES];
+static int gTimerFd = -1;
+static int gArpFd = -1;
+static int gNlFd = -1;
+static int gIcmpFd[PROBE_NUM_FAMILIES] = { -1, -1 };
+static int gDnsFd[PROBE_NUM_FAMILIES] = { -1, -1 };
+static unsigned int gSeed = 0;
+static BOOL gProbeReady = FALSE;
+static pthread_mutex_t gProbeMutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_once_t gProbeOnce = PTHREAD_ONCE_INIT;
+
+/* ---- Private Functions ------------------------------------ */
+
+static uint64_t Probe_NowMs(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t) ts.tv_sec * 1000ULL + (uint64_t) ts.tv_nsec / 1000000ULL;
+}
+
+static uint16_t Probe_Checksum(const void *data, size_t len)
+{
+    const uint8_t *p = (const uint8_t *) data;
+    uint32_t sum = 0;
+
+    while (len > 1)
+    {
+        sum += (uint32_t)((p[0] << 8) | p[1]);
+        p += 2;
+        len -= 2;
+    }
+    if (len > 0)
+    {
+        sum += (uint32_t)(p[0] << 8);
+    }
+    while (sum >> 16)
+    {
+        sum = (sum & 0xFFFF) + (sum >> 16);
+    }
+
+    return htons((uint16_t) ~sum);
+}
+
+static BOOL Probe_IsSet(const struct in6_addr *pAddr, int family)
+{
+    static const struct in6_addr zero;
+
+    return (memcmp(pAddr, &zero, (family == PROBE_FAMILY_V4) ? sizeof(struct in_addr) : sizeof(struct in6_addr)) != 0) ? TRUE : FALSE;
+}
+
+static BOOL Probe_AddrEqual(const struct in6_addr *pA, const void *pB, int family)
+{
+    return (memcmp(pA, pB, (family == PROBE_FAMILY_V4) ? sizeof(struct in_addr) : sizeof(struct in6_addr)) == 0) ? TRUE : FALSE;
+}
+
+/* ---- Sending, called with gProbeMutex held ---- */
+
+/* Send with the source address and interface given, so policy routing picks the WAN table */
+static void Probe_SendTo(int fd, int family, const ProbeSession_t *pSession, const void *pSrc,
+                         const struct in6_addr *pDst, uint16_t port, const void *data, size_t len)
+{
+    char cbuf[CMSG_SPACE(sizeof(struct in6_pktinfo))];
+    struct sockaddr_storage ss;
+    struct cmsghdr *cmsg;
+    struct msghdr msg;
+    struct iovec iov;
+
+    memset(&ss, 0, sizeof(ss));
+    memset(cbuf, 0, sizeof(cbuf));
+    memset(&msg, 0, sizeof(msg));
+    iov.iov_base = (void *) data;
+    iov.iov_len = len;
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_name = &ss;
+    msg.msg_control = cbuf;
+    cmsg = (struct cmsghdr *) cbuf;
+
+    if (family == PROBE_FAMILY_V4)
+    {
+        struct sockaddr_in *sin = (struct sockaddr_in *) &ss;
+        struct in_pktinfo pi;
+
+        sin->sin_family = AF_INET;
+        sin->sin_port = htons(port);
+        memcpy(&sin->sin_addr, pDst, sizeof(struct in_addr));
+        msg.msg_namelen = sizeof(*sin);
+
+        memset(&pi, 0, sizeof(pi));
+        pi.ipi_ifindex = pSession->ifIndex;
+        if (pSrc != NULL)
+        {
+            memcpy(&pi.ipi_spec_dst, pSrc, sizeof(struct in_addr));
+        }
+        cmsg->cmsg_level = IPPROTO_IP;
+        cmsg->cmsg_type = IP_PKTINFO;
+        cmsg->cmsg_len = CMSG_LEN(sizeof(pi));
+        memcpy(CMSG_DATA(cmsg), &pi, sizeof(pi));
+        msg.msg_controllen = CMSG_SPACE(sizeof(pi));
+    }
+    else
+    {
+        struct sockaddr_in6 *sin6 = (struct sockaddr_in6 *) &ss;
+        struct in6_pktinfo pi;
+
+        sin6->sin6_family = AF_INET6;
+        sin6->sin6_port = htons(port);
+        sin6->sin6_addr = *pDst;
+        if (IN6_IS_ADDR_LINKLOCAL(pDst))
+        {
+            sin6->sin6_scope_id = pSession->ifIndex;
+        }
+        msg.msg_namelen = sizeof(*sin6);
+
+        memset(&pi, 0, sizeof(pi));
+        pi.ipi6_ifindex = pSession->ifIndex;
+        if (pSrc != NULL)
+        {
+            memcpy(&pi.ipi6_addr, pSrc, sizeof(struct in6_addr));
+        }
+        cmsg->cmsg_level = IPPROTO_IPV6;
+        cmsg->cmsg_type = IPV6_PKTINFO;
+        cmsg->cmsg_len = CMSG_LEN(sizeof(pi));
+        memcpy(CMSG_DATA(cmsg), &pi, sizeof(pi));
+        msg.msg_controllen = CMSG_SPACE(sizeof(pi));
+    }
+
+    if (sendmsg(fd, &msg, MSG_DONTWAIT) < 0 && errno != EAGAIN)
+    {
+        CcspTraceWarning(("%s %d - %s probe send failed (%s)\n", __FUNCTION__, __LINE__, pSession->ifName, strerror(errno)));
+    }
+}
+
+static void Probe_SendArp(const ProbeSession_t *pSession, const ProbePath_t *pPath)
+{
+    static const uint8_t broadcast[ETH_ALEN] = { 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF };
+    uint8_t arp[PROBE_ARP_LEN];
+    struct sockaddr_ll sll;
+
+    //Request for the gateway, unicast once its MAC is known as the kernel does to confirm a neighbour
+    memset(arp, 0, sizeof(arp));
+    arp[0] = 0x00; arp[1] = 0x01;               /* Ethernet */
+    arp[2] = 0x08; arp[3] = 0x00;               /* IPv4 */
+    arp[4] = ETH_ALEN;
+    arp[5] = sizeof(struct in_addr);
+    arp[6] = 0x00; arp[7] = 0x01;               /* request */
+    memcpy(&arp[8], pSession->ifMac, ETH_ALEN);
+    memcpy(&arp[14], &pPath->local, sizeof(struct in_addr));
+    memcpy(&arp[24], &pPath->gateway, sizeof(struct in_addr));
+
+    memset(&sll, 0, sizeof(sll));
+    sll.sll_family = AF_PACKET;
+    sll.sll_protocol = htons(ETH_P_ARP);
+    sll.sll_ifindex = pSession->ifIndex;
+    sll.sll_halen = ETH_ALEN;
+    memcpy(sll.sll_addr, (pPath->macValid == TRUE) ? pPath->gwMac : broadcast, ETH_ALEN);
+
+    if (sendto(gArpFd, arp, sizeof(arp), MSG_DONTWAIT, (struct sockaddr *) &sll, sizeof(sll)) < 0 && errno != EAGAIN)
+    {
+        CcspTraceWarning(("%s %d - %s ARP send failed (%s)\n", __FUNCTION__, __LINE__, pSession->ifName, strerror(errno)));
+    }
+}
+
+static void Probe_SendNeighbourSolicit(const ProbeSession_t *pSession, const ProbePath_t *pPath)
+{
+    uint8_t ns[sizeof(struct nd_neighbor_solicit) + 8];
+    struct nd_neighbor_solicit *pNs = (struct nd_neighbor_solicit *) ns;
+
+    memset(ns, 0, sizeof(ns));
+    pNs->nd_ns_type = ND_NEIGHBOR_SOLICIT;
+    pNs->nd_ns_target = pPath->gateway;
+    ns[sizeof(*pNs)] = ND_OPT_SOURCE_LINKADDR;
+    ns[sizeof(*pNs) + 1] = 1;
+    memcpy(&ns[sizeof(*pNs) + 2], pSession->ifMac, ETH_ALEN);
+
+    //Unicast to the router, the kernel picks the link local source and fills in the checksum
+    Probe_SendTo(gIcmpFd[PROBE_FAMILY_V6], PROBE_FAMILY_V6, pSession, NULL, &pPath->gateway, 0, ns, sizeof(ns));
+}
+
+static void Probe_SendEcho(const ProbeSession_t *pSession, const ProbePath_t *pPath, int family)
+{
+    const struct in6_addr *pDst = Probe_IsSet(&pPath->host, family) ? &pPath->host : &pPath->gateway;
+    uint8_t echo[16];
+
+    memset(echo, 0, sizeof(echo));
+    echo[0] = (family == PROBE_FAMILY_V4) ? ICMP_ECHO : ICMP6_ECHO_REQUEST;
+    echo[4] = pSession->ident >> 8;
+    echo[5] = pSession->ident & 0xFF;
+    echo[6] = pPath->seq >> 8;
+    echo[7] = pPath->seq & 0xFF;
+    if (family == PROBE_FAMILY_V4)
+    {
+        uint16_t sum = Probe_Checksum(echo, sizeof(echo));
+        memcpy(&echo[2], &sum, sizeof(sum));
+    }
+
+    Probe_SendTo(gIcmpFd[family], family, pSession, &pPath->local, pDst, 0, echo, sizeof(echo));
+}
+
+static uint16_t Probe_DnsId(const ProbeSession_t *pSession, const ProbePath_t *pPath)
+{
+    return (uint16_t)(pSession->ident ^ pPath->seq);
+}
+
+static void Probe_SendDns(const ProbeSession_t *pSession, const ProbePath_t *pPath, int family)
+{
+    uint8_t query[17];
+    uint16_t id = Probe_DnsId(pSession, pPath);
+
+    //". IN NS", answered from cache by any resolver
+    memset(query, 0, sizeof(query));
+    query[0] = id >> 8;
+    query[1] = id & 0xFF;
+    query[2] = 0x01;                            /* recursion desired */
+    query[5] = 1;                               /* one question */
+    query[12] = 0;                              /* root */
+    query[14] = 2;                              /* NS */
+    query[16] = 1;                              /* IN */
+
+    Probe_SendTo(gDnsFd[family], family, pSession, &pPath->local, &pPath->dns, PROBE_DNS_PORT, query, sizeof(query));
+}
+
+static void Probe_SendRound(ProbeSession_t *pSession, int family)
+{
+    ProbePath_t *pPath = &pSession->path[family];
+    UINT methods = pSession->cfg.methods;
+
+    //Our address is gone while down, only the gateway can still be reached
+    if (pPath->state == PROBE_PATH_DOWN)
+    {
+        methods = WANMGR_PROBE_METHOD_GATEWAY;
+    }
+
+    if ((methods & WANMGR_PROBE_METHOD_GATEWAY) && pPath->gatewayValid == TRUE)
+    {
+        if (family == PROBE_FAMILY_V4)
+        {
+            Probe_SendArp(pSession, pPath);
+        }
+        else
+        {
+            Probe_SendNeighbourSolicit(pSession, pPath);
+        }
+    }
+
+    if ((methods & WANMGR_PROBE_METHOD_ICMP) && (pPath->gatewayValid == TRUE || Probe_IsSet(&pPath->host, family)))
+    {
+        Probe_SendEcho(pSession, pPath, family);
+    }
+
+    if ((methods & WANMGR_PROBE_METHOD_DNS) && pPath->dnsValid == TRUE)
+    {
+        Probe_SendDns(pSession, pPath, family);
+    }
+}
+
+/* ---- Rounds ---- */
+
+static void Probe_QueueAction(const ProbeSession_t *pSession, int family, ProbeAction_t action);
+
+static void Probe_Round(ProbeSession_t *pSession, uint64_t now)
+{
+    int family;
+
+    for (family = 0; family < PROBE_NUM_FAMILIES; family++)
+    {
+        ProbePath_t *pPath = &pSession->path[family];
+
+        if (pPath->state == PROBE_PATH_IDLE)
+        {
+            continue;
+        }
+
+        if (pPath->sent == TRUE && pPath->state == PROBE_PATH_UP)
+        {
+            if (pPath->answered == TRUE)
+            {
+                pPath->misses = 0;
+            }
+            else if (++pPath->misses >= pSession->cfg.failureCount)
+            {
+                //Down again soon after coming up: ask for longer proof before the next renew
+                if (now - pPath->upSinceMs < WANMGR_PROBE_STABLE_MS)
+                {
+                    pPath->recoverNeeded = (pPath->recoverNeeded * 2 < WANMGR_PROBE_MAX_RECOVER_ROUNDS) ? pPath->recoverNeeded * 2 : WANMGR_PROBE_MAX_RECOVER_ROUNDS;
+                }
+                else
+                {
+                    pPath->recoverNeeded = pSession->cfg.failureCount;
+                }
+
+                CcspTraceWarning(("%s %d - %s IPv%c lost %u probe rounds, connection down\n", __FUNCTION__, __LINE__,
+                                  pSession->ifName, (family == PROBE_FAMILY_V4) ? '4' : '6', pPath->misses));
+                pPath->state = PROBE_PATH_DOWN;
+                pPath->recovered = 0;
+                Probe_QueueAction(pSession, family, PROBE_ACTION_DOWN);
+            }
+        }
+        else if (pPath->sent == TRUE && pPath->state == PROBE_PATH_DOWN)
+        {
+            if (pPath->answered != TRUE)
+            {
+                pPath->recovered = 0;
+            }
+            else if (++pPath->recovered >= pPath->recoverNeeded)
+            {
+                CcspTraceInfo(("%s %d - %s IPv%c gateway back for %u rounds, renewing\n", __FUNCTION__, __LINE__,
+                               pSession->ifName, (family == PROBE_FAMILY_V4) ? '4' : '6', pPath->recovered));
+                pPath->state = PROBE_PATH_IDLE;
+                Probe_QueueAction(pSession, family, PROBE_ACTION_RENEW);
+                continue;
+            }
+        }
+
+        pPath->seq++;
+        pPath->answered = FALSE;
+        pPath->sent = TRUE;
+        Probe_SendRound(pSession, family);
+    }
+}
+
+static BOOL Probe_IsActive(const ProbeSession_t *pSession)
+{
+    return (pSession->inUse == TRUE &&
+            (pSession->path[PROBE_FAMILY_V4].state != PROBE_PATH_IDLE ||
+             pSession->path[PROBE_FAMILY_V6].state != PROBE_PATH_IDLE)) ? TRUE : FALSE;
+}
+
+static uint64_t Probe_NextDeadline(const ProbeSession_t *pSession, uint64_t now)
+{
+    UINT interval = pSession->cfg.intervalMs;
+    UINT spread = interval * WANMGR_PROBE_JITTER_PCT / 100;
+
+    //Jitter keeps the interfaces, and other CPEs, from probing in lock step
+    if (spread > 0)
+    {
+        interval = interval - spread + (UINT)(rand_r(&gSeed) % (2 * spread + 1));
+    }
+    return now + interval;
+}
+
+/* Arm the timer for the earliest session, called with gProbeMutex held */
+static void Probe_ArmTimer(void)
+{
+    struct itimerspec its;
+    uint64_t next = 0;
+    int idx;
+
+    for (idx = 0; idx < WANMGR_PROBE_MAX_IFACES; idx++)
+    {
+        if (Probe_IsActive(&gSessions[idx]) == TRUE && (next == 0 || gSessions[idx].nextMs < next))
+        {
+            next = gSessions[idx].nextMs;
+        }
+    }
+
+    memset(&its, 0, sizeof(its));
+    if (next != 0)
+    {
+        its.it_value.tv_sec = next / 1000;
+        its.it_value.tv_nsec = (long)(next % 1000) * 1000000L;
+    }
+    timerfd_settime(gTimerFd, TFD_TIMER_ABSTIME, &its, NULL);
+}
+
+static void Probe_OnTimer(int fd, uint32_t events, void *arg)
+{
+    uint64_t expirations;
+    uint64_t now;
+    int idx;
+
+    if (read(fd, &expirations, sizeof(expirations)) != sizeof(expirations))
+    {
+        return;
+    }
+
+    pthread_mutex_lock(&gProbeMutex);
+    now = Probe_NowMs();
+    for (idx = 0; idx < WANMGR_PROBE_MAX_IFACES; idx++)
+    {
+        ProbeSession_t *pSession = &gSessions[idx];
+
+        if (Probe_IsActive(pSession) == TRUE && pSession->nextMs <= now)
+        {
+            Probe_Round(pSession, now);
+            pSession->nextMs = Probe_NextDeadline(pSession, now);
+        }
+    }
+    Probe_ArmTimer();
+    pthread_mutex_unlock(&gProbeMutex);
+}
+
+/* ---- Receiving ---- */
+
+/* Mark the outstanding round of the session on ifIndex answered when match() accepts the reply */
+typedef BOOL (*ProbeMatch_t)(const ProbeSession_t *pSession, ProbePath_t *pPath, const void *pSrc, const uint8_t *data, size_t len);
+
+static void Probe_Answered(int family, int ifIndex, const void *pSrc, const uint8_t *data, size_t len, ProbeMatch_t match)
+{
+    int idx;
+
+    pthread_mutex_lock(&gProbeMutex);
+    for (idx = 0; idx < WANMGR_PROBE_MAX_IFACES; idx++)
+    {
+        ProbeSession_t *pSession = &gSessions[idx];
+        ProbePath_t *pPath = &pSession->path[family];
+
+        if (pSession->inUse == TRUE && pSession->ifIndex == ifIndex && pPath->state != PROBE_PATH_IDLE &&
+            match(pSession, pPath, pSrc, data, len) == TRUE)
+        {
+            pPath->answered = TRUE;
+            break;
+        }
+    }
+    pthread_mutex_unlock(&gProbeMutex);
+}
+
+static BOOL Probe_MatchArp(const ProbeSession_t *pSession, ProbePath_t *pPath, const void *pSrc, const uint8_t *data, size_t len)
+{
+    //Any ARP reply sent by the gateway shows it is alive
+    if (pPath->gatewayValid != TRUE || Probe_AddrEqual(&pPath->gateway, &data[14], PROBE_FAMILY_V4) != TRUE)
+    {
+        return FALSE;
+    }
+
+    memcpy(pPath->gwMac, &data[8], ETH_ALEN);
+    pPath->macValid = TRUE;
+    return TRUE;
+}
+
+static BOOL Probe_MatchIcmp4(const ProbeSession_t *pSession, ProbePath_t *pPath, const void *pSrc, const uint8_t *data, size_t len)
+{
+    uint16_t ident = (uint16_t)((data[4] << 8) | data[5]);
+    uint16_t seq = (uint16_t)((data[6] << 8) | data[7]);
+
+    return (data[0] == ICMP_ECHOREPLY && ident == pSession->ident && seq == pPath->seq) ? TRUE : FALSE;
+}
+
+static BOOL Probe_MatchIcmp6(const ProbeSession_t *pSession, ProbePath_t *pPath, const void *pSrc, const uint8_t *data, size_t len)
+{
+    if (data[0] == ND_NEIGHBOR_ADVERT)
+    {
+        const struct nd_neighbor_advert *pNa = (const struct nd_neighbor_advert *) data;
+        return (len >= sizeof(*pNa) && pPath->gatewayValid == TRUE &&
+                Probe_AddrEqual(&pPath->gateway, &pNa->nd_na_target, PROBE_FAMILY_V6) == TRUE) ? TRUE : FALSE;
+    }
+
+    return (data[0] == ICMP6_ECHO_REPLY &&
+            (uint16_t)((data[4] << 8) | data[5]) == pSession->ident &&
+            (uint16_t)((data[6] << 8) | data[7]) == pPath->seq) ? TRUE : FALSE;
+}
+
+static BOOL Probe_MatchDns4(const ProbeSession_t *pSession, ProbePath_t *pPath, const void *pSrc, const uint8_t *data, size_t len)
+{
+    uint16_t id = (uint16_t)((data[0] << 8) | data[1]);
+
+    //Any answer, even an error, shows the resolver is reachable
+    return (pPath->dnsValid == TRUE && Probe_AddrEqual(&pPath->dns, pSrc, PROBE_FAMILY_V4) == TRUE &&
+            (data[2] & 0x80) && id == Probe_DnsId(pSession, pPath)) ? TRUE : FALSE;
+}
+
+static BOOL Probe_MatchDns6(const ProbeSession_t *pSession, ProbePath_t *pPath, const void *pSrc, const uint8_t *data, size_t len)
+{
+    uint16_t id = (uint16_t)((data[0] << 8) | data[1]);
+
+    return (pPath->dnsValid == TRUE && Probe_AddrEqual(&pPath->dns, pSrc, PROBE_FAMILY_V6) == TRUE &&
+            (data[2] & 0x80) && id == Probe_DnsId(pSession, pPath)) ? TRUE : FALSE;
+}
+
+static void Probe_OnArp(int fd, uint32_t events, void *arg)
+{
+    uint8_t pkt[PROBE_PKT_MAX];
+    struct sockaddr_ll sll;
+    socklen_t sllLen;
+    int len;
+
+    for (;;)
+    {
+        sllLen = sizeof(sll);
+        if ((len = recvfrom(fd, pkt, sizeof(pkt), 0, (struct sockaddr *) &sll, &sllLen)) < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            break;
+        }
+
+        if (len < PROBE_ARP_LEN || sll.sll_pkttype == PACKET_OUTGOING ||
+            pkt[4] != ETH_ALEN || pkt[5] != sizeof(struct in_addr))
+        {
+            continue;
+        }
+
+        Probe_Answered(PROBE_FAMILY_V4, sll.sll_ifindex, NULL, pkt, len, Probe_MatchArp);
+    }
+}
+
+/* Receive the next datagram with its source and interface, FALSE when drained */
+static BOOL Probe_Recv(int fd, uint8_t *buf, size_t size, int *pLen, struct sockaddr_storage *pFrom, int *pIfIndex)
+{
+    char cbuf[CMSG_SPACE(sizeof(struct in6_pktinfo))];
+    struct cmsghdr *cmsg;
+    struct msghdr msg;
+    struct iovec iov;
+    int len;
+
+    for (;;)
+    {
+        memset(&msg, 0, sizeof(msg));
+        iov.iov_base = buf;
+        iov.iov_len = size;
+        msg.msg_iov = &iov;
+        msg.msg_iovlen = 1;
+        msg.msg_name = pFrom;
+        msg.msg_namelen = sizeof(*pFrom);
+        msg.msg_control = cbuf;
+        msg.msg_controllen = sizeof(cbuf);
+
+        if ((len = recvmsg(fd, &msg, 0)) >= 0)
+        {
+            break;
+        }
+        if (errno != EINTR)
+        {
+            return FALSE;
+        }
+    }
+
+    *pLen = len;
+    *pIfIndex = 0;
+    for (cmsg = CMSG_FIRSTHDR(&msg); cmsg != NULL; cmsg = CMSG_NXTHDR(&msg, cmsg))
+    {
+        if (cmsg->cmsg_level == IPPROTO_IP && cmsg->cmsg_type == IP_PKTINFO)
+        {
+            *pIfIndex = ((struct in_pktinfo *) CMSG_DATA(cmsg))->ipi_ifindex;
+        }
+        else if (cmsg->cmsg_level == IPPROTO_IPV6 && cmsg->cmsg_type == IPV6_PKTINFO)
+        {
+            *pIfIndex = ((struct in6_pktinfo *) CMSG_DATA(cmsg))->ipi6_ifindex;
+        }
+    }
+    return TRUE;
+}
+
+static void Probe_OnIcmp4(int fd, uint32_t events, void *arg)
+{
+    uint8_t pkt[PROBE_PKT_MAX];
+    struct sockaddr_storage from;
+    int ifIndex;
+    int len;
+
+    while (Probe_Recv(fd, pkt, sizeof(pkt), &len, &from, &ifIndex) == TRUE)
+    {
+        //Raw IPv4 sockets deliver the IP header
+        size_t hlen = (size_t)(pkt[0] & 0x0F) * 4;
+
+        if ((size_t) len >= hlen + 8)
+        {
+            Probe_Answered(PROBE_FAMILY_V4, ifIndex, &((struct sockaddr_in *) &from)->sin_addr, pkt + hlen, len - hlen, Probe_MatchIcmp4);
+        }
+    }
+}
+
+static void Probe_OnIcmp6(int fd, uint32_t events, void *arg)
+{
+    uint8_t pkt[PROBE_PKT_MAX];
+    struct sockaddr_storage from;
+    int ifIndex;
+    int len;
+
+    while (Probe_Recv(fd, pkt, sizeof(pkt), &len, &from, &ifIndex) == TRUE)
+    {
+        if (len >= 8)
+        {
+            Probe_Answered(PROBE_FAMILY_V6, ifIndex, &((struct sockaddr_in6 *) &from)->sin6_addr, pkt, len, Probe_MatchIcmp6);
+        }
+    }
+}
+
+static void Probe_OnDns(int fd, uint32_t events, void *arg)
+{
+    int family = (int)(intptr_t) arg;
+    uint8_t pkt[PROBE_PKT_MAX];
+    struct sockaddr_storage from;
+    int ifIndex;
+    int len;
+
+    while (Probe_Recv(fd, pkt, sizeof(pkt), &len, &from, &ifIndex) == TRUE)
+    {
+        if (len < 12)
+        {
+            continue;
+        }
+
+        if (family == PROBE_FAMILY_V4)
+        {
+            Probe_Answered(family, ifIndex, &((struct sockaddr_in *) &from)->sin_addr, pkt, len, Probe_MatchDns4);
+        }
+        else
+        {
+            Probe_Answered(family, ifIndex, &((struct sockaddr_in6 *) &from)->sin6_addr, pkt, len, Probe_MatchDns6);
+        }
+    }
+}
+
+/* ---- Actions, run on the event loop urgent worker ---- */
+
+static int Probe_FindSession(const char *ifName);
+
+/* Default route change, called with gProbeMutex held */
+static void Probe_OnRouteEvent(const WanMgr_NlRouteEvent_t *pEvent, void *arg)
+{
+    int idx;
+
+    (void) arg;
+
+    if (pEvent->family != AF_INET6 || pEvent->isDefault != TRUE ||
+        (pEvent->type != RTM_NEWROUTE && pEvent->type != RTM_DELROUTE))
+    {
+        return;
+    }
+
+    for (idx = 0; idx < WANMGR_PROBE_MAX_IFACES; idx++)
+    {
+        ProbeSession_t *pSession = &gSessions[idx];
+
+        if (pSession->inUse == TRUE && pSession->path[PROBE_FAMILY_V6].state != PROBE_PATH_IDLE &&
+            (pEvent->ifIndex == 0 || pEvent->ifIndex == pSession->ifIndex))
+        {
+            pSession->path[PROBE_FAMILY_V6].gatewayDue = TRUE;
+        }
+    }
+}
+
+/* The IPv6 gateway is the router of the default route, looked up again when that route changes */
+static void Probe_OnNetlink(int fd, uint32_t events, void *arg)
+{
+    char dueName[WANMGR_PROBE_MAX_IFACES][IFNAMSIZ];
+    int dueIfIndex[WANMGR_PROBE_MAX_IFACES];
+    BOOL dropped;
+    int idx;
+
+    memset(dueName, 0, sizeof(dueName));
+
+    pthread_mutex_lock(&gProbeMutex);
+    dropped = (WanMgr_Netlink_ReadRouteEvents(fd, Probe_OnRouteEvent, NULL) != ANSC_STATUS_SUCCESS) ? TRUE : FALSE;
+    for (idx = 0; idx < WANMGR_PROBE_MAX_IFACES; idx++)
+    {
+        ProbeSession_t *pSession = &gSessions[idx];
+        ProbePath_t *pPath = &pSession->path[PROBE_FAMILY_V6];
+
+        if (pSession->inUse == TRUE && pPath->state != PROBE_PATH_IDLE && (pPath->gatewayDue == TRUE || dropped == TRUE))
+        {
+            pPath->gatewayDue = FALSE;
+            snprintf(dueName[idx], IFNAMSIZ, "%s", pSession->ifName);
+            dueIfIndex[idx] = pSession->ifIndex;
+        }
+    }
+    pthread_mutex_unlock(&gProbeMutex);
+
+    //The route dumps are done unlocked
+    for (idx = 0; idx < WANMGR_PROBE_MAX_IFACES; idx++)
+    {
+        struct in6_addr gateway;
+        BOOL found;
+        int sessionIdx;
+
+        if (dueName[idx][0] == '\0')
+        {
+            continue;
+        }
+
+        found = (WanMgr_Netlink_GetDefaultGateway6(dueIfIndex[idx], &gateway) == ANSC_STATUS_SUCCESS) ? TRUE : FALSE;
+
+        pthread_mutex_lock(&gProbeMutex);
+        if ((sessionIdx = Probe_FindSession(dueName[idx])) >= 0 && gSessions[sessionIdx].ifIndex == dueIfIndex[idx])
+        {
+            ProbePath_t *pPath = &gSessions[sessionIdx].path[PROBE_FAMILY_V6];
+
+            pPath->gatewayValid = found;
+            if (found == TRUE)
+            {
+                pPath->gateway = gateway;
+            }
+        }
+        pthread_mutex_unlock(&gProbeMutex);
+    }
+}
+
+static void Probe_RunAction(void *arg)
+{
+    ProbeWork_t *pWork = (ProbeWork_t *) arg;
+    BOOL bV4 = (pWork->family == PROBE_FAMILY_V4) ? TRUE : FALSE;
+
+    if (pWork->action == PROBE_ACTION_DOWN)
+    {
+        WanMgr_Iface_Data_t* pWanDmlIfaceData = WanMgr_GetIfaceDataByName_locked(pWork->ifName);
+        if (pWanDmlIfaceData != NULL)
+        {
+            WanManager_UpdateInterfaceStatus(&(pWanDmlIfaceData->data), bV4 ? WANMGR_IFACE_CONNECTION_DOWN : WANMGR_IFACE_CONNECTION_IPV6_DOWN);
+            WanMgrDml_GetIfaceData_release(pWanDmlIfaceData);
+        }
+    }
+    else
+    {
+        /* the renewed lease brings the connection back up */
+        WanMgr_DhcpClient_Renew(pWork->ifName, bV4 ? WANMGR_DHCPC_V4 : WANMGR_DHCPC_V6);
+    }
+
+    free(pWork);
+}
+
+static void Probe_QueueAction(const ProbeSession_t *pSession, int family, ProbeAction_t action)
+{
+    ProbeWork_t *pWork = (ProbeWork_t *) malloc(sizeof(ProbeWork_t));
+
+    if (pWork == NULL)
+    {
+        return;
+    }
+
+    snprintf(pWork->ifName, sizeof(pWork->ifName), "%s", pSession->ifName);
+    pWork->family = family;
+    pWork->action = action;
+
+    if (WanMgr_EventLoop_QueueUrgentWork(Probe_RunAction, pWork) != ANSC_STATUS_SUCCESS)
+    {
+        free(pWork);
+    }
+}
+
+/* ---- Setup ---- */
+
+static int Probe_OpenSocket(int domain, int type, int protocol)
+{
+    int fd = socket(domain, type | SOCK_NONBLOCK | SOCK_CLOEXEC, protocol);
+    int on = 1;
+
+    if (fd < 0)
+    {
+        CcspTraceError(("%s %d - probe socket %d/%d failed (%s)\n", __FUNCTION__, __LINE__, domain, protocol, strerror(errno)));
+        return -1;
+    }
+
+    if (domain == AF_INET)
+    {
+        setsockopt(fd, IPPROTO_IP, IP_PKTINFO, &on, sizeof(on));
+    }
+    else if (domain == AF_INET6)
+    {
+        setsockopt(fd, IPPROTO_IPV6, IPV6_RECVPKTINFO, &on, sizeof(on));
+        setsockopt(fd, IPPROTO_IPV6, IPV6_V6ONLY, &on, sizeof(on));
+    }
+
+    return fd;
+}
+
+static void Probe_Init(void)
+{
+    /* ARP replies for IPv4 over Ethernet only, the socket sees the ARP of every interface */
+    struct sock_filter arpFilter[] =
+    {
+        BPF_STMT(BPF_LD | BPF_W | BPF_ABS, SKF_AD_OFF + SKF_AD_PKTTYPE),
+        BPF_JUMP(BPF_JMP | BPF_JEQ | BPF_K, PACKET_OUTGOING, 5, 0),
+        BPF_STMT(BPF_LD | BPF_W | BPF_ABS, 0),
+        BPF_JUMP(BPF_JMP | BPF_JEQ | BPF_K, 0x00010800, 0, 3),     /* Ethernet, IPv4 */
+        BPF_STMT(BPF_LD | BPF_W | BPF_ABS, 4),
+        BPF_JUMP(BPF_JMP | BPF_JEQ | BPF_K, 0x06040002, 0, 1),     /* address lengths, reply */
+        BPF_STMT(BPF_RET | BPF_K, 0xFFFF),
+        BPF_STMT(BPF_RET | BPF_K, 0),
+    };
+    struct sock_fprog arpProg;
+    struct icmp6_filter filter6;
+    int hops = 255;
+    uint32_t filter4 = ~(1U << ICMP_ECHOREPLY);
+
+    gSeed = (unsigned int)(Probe_NowMs() ^ (uint64_t) getpid());
+
+    if ((gTimerFd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC)) < 0 ||
+        (gArpFd = Probe_OpenSocket(AF_PACKET, SOCK_DGRAM, htons(ETH_P_ARP))) < 0 ||
+        (gIcmpFd[PROBE_FAMILY_V4] = Probe_OpenSocket(AF_INET, SOCK_RAW, IPPROTO_ICMP)) < 0 ||
+        (gIcmpFd[PROBE_FAMILY_V6] = Probe_OpenSocket(AF_INET6, SOCK_RAW, IPPROTO_ICMPV6)) < 0 ||
+        (gDnsFd[PROBE_FAMILY_V4] = Probe_OpenSocket(AF_INET, SOCK_DGRAM, 0)) < 0 ||
+        (gDnsFd[PROBE_FAMILY_V6] = Probe_OpenSocket(AF_INET6, SOCK_DGRAM, 0)) < 0 ||
+        (gNlFd = WanMgr_Netlink_OpenRouteEvents()) < 0)
+    {
+        return;
+    }
+
+    arpProg.len = sizeof(arpFilter) / sizeof(arpFilter[0]);
+    arpProg.filter = arpFilter;
+    if (setsockopt(gArpFd, SOL_SOCKET, SO_ATTACH_FILTER, &arpProg, sizeof(arpProg)) < 0)
+    {
+        CcspTraceError(("%s %d - attaching ARP filter failed (%s)\n", __FUNCTION__, __LINE__, strerror(errno)));
+        return;
+    }
+
+    //Only what a probe can be answered with, neighbour discovery needs the full hop limit
+    setsockopt(gIcmpFd[PROBE_FAMILY_V4], SOL_RAW, ICMP_FILTER, &filter4, sizeof(filter4));
+    ICMP6_FILTER_SETBLOCKALL(&filter6);
+    ICMP6_FILTER_SETPASS(ND_NEIGHBOR_ADVERT, &filter6);
+    ICMP6_FILTER_SETPASS(ICMP6_ECHO_REPLY, &filter6);
+    setsockopt(gIcmpFd[PROBE_FAMILY_V6], IPPROTO_ICMPV6, ICMP6_FILTER, &filter6, sizeof(filter6));
+    setsockopt(gIcmpFd[PROBE_FAMILY_V6], IPPROTO_IPV6, IPV6_UNICAST_HOPS, &hops, sizeof(hops));
+
+    if (WanMgr_EventLoop_AddFd(gTimerFd, "probe-timer", Probe_OnTimer, NULL) != ANSC_STATUS_SUCCESS ||
+        WanMgr_EventLoop_AddFd(gArpFd, "probe-arp", Probe_OnArp, NULL) != ANSC_STATUS_SUCCESS ||
+        WanMgr_EventLoop_AddFd(gIcmpFd[PROBE_FAMILY_V4], "probe-icmp4", Probe_OnIcmp4, NULL) != ANSC_STATUS_SUCCESS ||
+        WanMgr_EventLoop_AddFd(gIcmpFd[PROBE_FAMILY_V6], "probe-icmp6", Probe_OnIcmp6, NULL) != ANSC_STATUS_SUCCESS ||
+        WanMgr_EventLoop_AddFd(gDnsFd[PROBE_FAMILY_V4], "probe-dns4", Probe_OnDns, (void *)(intptr_t) PROBE_FAMILY_V4) != ANSC_STATUS_SUCCESS ||
+        WanMgr_EventLoop_AddFd(gDnsFd[PROBE_FAMILY_V6], "probe-dns6", Probe_OnDns, (void *)(intptr_t) PROBE_FAMILY_V6) != ANSC_STATUS_SUCCESS ||
+        WanMgr_EventLoop_AddFd(gNlFd, "probe-netlink", Probe_OnNetlink, NULL) != ANSC_STATUS_SUCCESS)
+    {
+        return;
+    }
+
+    gProbeReady = TRUE;
+}
+
+/* Session of ifName, called with gProbeMutex held */
+static int Probe_FindSession(const char *ifName)
+{
+    int idx;
+
+    for (idx = 0; idx < WANMGR_PROBE_MAX_IFACES; idx++)
+    {
+        if (gSessions[idx].inUse == TRUE && strcmp(gSessions[idx].ifName, ifName) == 0)
+        {
+            return idx;
+        }
+    }
+    return -1;
+}
+
+static ANSC_STATUS Probe_SetPath(const char *ifName, int family, BOOL up, const void *pAddr, const void *pGateway, const void *pDns)
+{
+    size_t addrLen = (family == PROBE_FAMILY_V4) ? sizeof(struct in_addr) : sizeof(struct in6_addr);
+    ProbeSession_t *pSession;
+    ProbePath_t *pPath;
+    int idx;
+
+    if (ifName == NULL || (up == TRUE && pAddr == NULL))
+    {
+        return ANSC_STATUS_BAD_PARAMETER;
+    }
+
+    pthread_mutex_lock(&gProbeMutex);
+    if ((idx = Probe_FindSession(ifName)) < 0)
+    {
+        pthread_mutex_unlock(&gProbeMutex);
+        return ANSC_STATUS_FAILURE;
+    }
+
+    pSession = &gSessions[idx];
+    pPath = &pSession->path[family];
+
+    if (up != TRUE)
+    {
+        //Our own report took the lease down, keep watching the gateway
+        if (pPath->state != PROBE_PATH_DOWN)
+        {
+            pPath->state = PROBE_PATH_IDLE;
+        }
+        pthread_mutex_unlock(&gProbeMutex);
+        return ANSC_STATUS_SUCCESS;
+    }
+
+    memset(&pPath->local, 0, sizeof(pPath->local));
+    memset(&pPath->gateway, 0, sizeof(pPath->gateway));
+    memset(&pPath->dns, 0, sizeof(pPath->dns));
+    memcpy(&pPath->local, pAddr, addrLen);
+    if (pGateway != NULL)
+    {
+        memcpy(&pPath->gateway, pGateway, addrLen);
+    }
+    if (pDns != NULL)
+    {
+        memcpy(&pPath->dns, pDns, addrLen);
+    }
+    pPath->gatewayValid = Probe_IsSet(&pPath->gateway, family);
+    pPath->gatewayDue = FALSE;
+    pPath->dnsValid = Probe_IsSet(&pPath->dns, family);
+    pPath->macValid = FALSE;
+    pPath->sent = FALSE;
+    pPath->answered = FALSE;
+    pPath->misses = 0;
+    pPath->upSinceMs = Probe_NowMs();
+    if (pPath->recoverNeeded == 0)
+    {
+        pPath->recoverNeeded = pSession->cfg.failureCount;
+    }
+
+    //The interface index and MAC can change across link flaps
+    pSession->ifIndex = if_nametoindex(ifName);
+    if (family == PROBE_FAMILY_V4)
+    {
+        struct ifreq ifr;
+
+        memset(&ifr, 0, sizeof(ifr));
+        snprintf(ifr.ifr_name, sizeof(ifr.ifr_name), "%s", ifName);
+        if (ioctl(gArpFd, SIOCGIFHWADDR, &ifr) == 0)
+        {
+            memcpy(pSession->ifMac, ifr.ifr_hwaddr.sa_data, ETH_ALEN);
+        }
+    }
+
+    //First family up probes right away, the other joins the running rounds
+    if (Probe_IsActive(pSession) != TRUE)
+    {
+        pSession->nextMs = Probe_NowMs();
+    }
+    pPath->state = PROBE_PATH_UP;
+    Probe_ArmTimer();
+    pthread_mutex_unlock(&gProbeMutex);
+
+    CcspTraceInfo(("%s %d - %s IPv%c probes started\n", __FUNCTION__, __LINE__, ifName, (family == PROBE_FAMILY_V4) ? '4' : '6'));
+    return ANSC_STATUS_SUCCESS;
+}
+
+/* ---- Public Functions ------------------------------------- */
+
+UINT WanMgr_Probe_ParseMethods(const char *pMethods)
+{
+    char buf[BUFLEN_64] = {0};
+    char *savePtr = NULL;
+    char *tok;
+    UINT methods = 0;
+
+    if (pMethods == NULL)
+    {
+        return 0;
+    }
+
+    snprintf(buf, sizeof(buf), "%s", pMethods);
+    for (tok = strtok_r(buf, ", ", &savePtr); tok != NULL; tok = strtok_r(NULL, ", ", &savePtr))
+    {
+        if (strcasecmp(tok, "Gateway") == 0)
+        {
+            methods |= WANMGR_PROBE_METHOD_GATEWAY;
+        }
+        else if (strcasecmp(tok, "ICMP") == 0)
+        {
+            methods |= WANMGR_PROBE_METHOD_ICMP;
+        }
+        else if (strcasecmp(tok, "DNS") == 0)
+        {
+            methods |= WANMGR_PROBE_METHOD_DNS;
+        }
+    }
+
+    return methods;
+}
+
+ANSC_STATUS WanMgr_Probe_Start(const char *ifName, const WanMgr_ProbeConfig_t *pConfig)
+{
+    ProbeSession_t *pSession;
+    int idx;
+
+    if (ifName == NULL || ifName[0] == '\0' || pConfig == NULL || pConfig->intervalMs == 0 || pConfig->methods == 0)
+    {
+        return ANSC_STATUS_BAD_PARAMETER;
+    }
+
+    pthread_once(&gProbeOnce, Probe_Init);
+    if (gProbeReady != TRUE)
+    {
+        CcspTraceError(("%s %d - WAN probes unavailable\n", __FUNCTION__, __LINE__));
+        return ANSC_STATUS_FAILURE;
+    }
+
+    pthread_mutex_lock(&gProbeMutex);
+    if ((idx = Probe_FindSession(ifName)) < 0)
+    {
+        for (idx = 0; idx < WANMGR_PROBE_MAX_IFACES; idx++)
+        {
+            if (gSessions[idx].inUse != TRUE)
+            {
+                break;
+            }
+        }
+    }
+
+    if (idx >= WANMGR_PROBE_MAX_IFACES)
+    {
+        pthread_mutex_unlock(&gProbeMutex);
+        CcspTraceError(("%s %d - no free probe session for %s\n", __FUNCTION__, __LINE__, ifName));
+        return ANSC_STATUS_FAILURE;
+    }
+
+    pSession = &gSessions[idx];
+    memset(pSession, 0, sizeof(ProbeSession_t));
+    snprintf(pSession->ifName, sizeof(pSession->ifName), "%s", ifName);
+    pSession->cfg = *pConfig;
+    if (pSession->cfg.intervalMs < WANMGR_PROBE_MIN_INTERVAL_MS)
+    {
+        pSession->cfg.intervalMs = WANMGR_PROBE_MIN_INTERVAL_MS;
+    }
+    if (pSession->cfg.failureCount < WANMGR_PROBE_MIN_FAILURES)
+    {
+        pSession->cfg.failureCount = WANMGR_PROBE_MIN_FAILURES;
+    }
+
+    //A host of either family only applies to that family
+    if (pSession->cfg.host[0] != '\0' &&
+        inet_pton(AF_INET, pSession->cfg.host, &pSession->path[PROBE_FAMILY_V4].host) != 1 &&
+        inet_pton(AF_INET6, pSession->cfg.host, &pSession->path[PROBE_FAMILY_V6].host) != 1)
+    {
+        CcspTraceWarning(("%s %d - probe host %s is not an address, probing the gateway\n", __FUNCTION__, __LINE__, pSession->cfg.host));
+    }
+
+    pSession->ident = (uint16_t)(rand_r(&gSeed) ^ idx);
+    pSession->inUse = TRUE;
+    pthread_mutex_unlock(&gProbeMutex);
+
+    CcspTraceInfo(("%s %d - probing %s every %u ms, down after %u rounds\n", __FUNCTION__, __LINE__,
+                   ifName, pSession->cfg.intervalMs, pSession->cfg.failureCount));
+    return ANSC_STATUS_SUCCESS;
+}
+
+ANSC_STATUS WanMgr_Probe_Stop(const char *ifName)
+{
+    int idx;
+
+    if (ifName == NULL)
+    {
+        return ANSC_STATUS_BAD_PARAMETER;
+    }
+
+    pthread_mutex_lock(&gProbeMutex);
+    if ((idx = Probe_FindSession(ifName)) < 0)
+    {
+        pthread_mutex_unlock(&gProbeMutex);
+        return ANSC_STATUS_FAILURE;
+    }
+
+    gSessions[idx].inUse = FALSE;
+    Probe_ArmTimer();
+    pthread_mutex_unlock(&gProbeMutex);
+
+    CcspTraceInfo(("%s %d - probing stopped on %s\n", __FUNCTION__, __LINE__, ifName));
+    return ANSC_STATUS_SUCCESS;
+}
+
+ANSC_STATUS WanMgr_Probe_SetIpv4(const char *ifName, BOOL up, const struct in_addr *pAddr,
+                                 const struct in_addr *pGateway, const struct in_addr *pDns)
+{
+    return Probe_SetPath(ifName, PROBE_FAMILY_V4, up, pAddr, pGateway, pDns);
+}
+
+ANSC_STATUS WanMgr_Probe_SetIpv6(const char *ifName, BOOL up, const struct in6_addr *pAddr,
+                                 const struct in6_addr *pDns)
+{
+    struct in6_addr gateway;
+    BOOL found = FALSE;
+
+    //Looked up once here, then again only when the default route changes
+    if (ifName != NULL && up == TRUE)
+    {
+        found = (WanMgr_Netlink_GetDefaultGateway6(if_nametoindex(ifName), &gateway) == ANSC_STATUS_SUCCESS) ? TRUE : FALSE;
+    }
+
+    return Probe_SetPath(ifName, PROBE_FAMILY_V6, up, pAddr, (found == TRUE) ? &gateway : NULL, pDns);
+}
@@ -0,0 +1,106 @@
+/*
+ * If not stated otherwise in this file or this component's Licenses.txt file the
+ * following copyright and licenses apply:
+ *
+ * Copyright 2020 RDK Management
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+*/
+
+#ifndef _WANMGR_PROBE_H_
+#define _WANMGR_PROBE_H_
+
+/* WAN liveness probes. Every probed interface sends one round of probes per
+ * interval: ARP/NDP to the gateway, ICMP echo and DNS queries, as configured.
+ * A round is answered if any probe of it is answered. After FailureCount
+ * unanswered rounds the connection of that address family is reported down.
+ * The gateway is probed on while down, once it answers again the DHCP client
+ * is asked to renew so the lease brings the connection back up. */
+
+/* ---- Include Files ---------------------------------------- */
+#include <netinet/in.h>
+#include "ansc_platform.h"
+
+/* ---- Global Constants -------------------------------------- */
+#define WANMGR_PROBE_MAX_IFACES         8
+#define WANMGR_PROBE_MIN_INTERVAL_MS    100
+#define WANMGR_PROBE_JITTER_PCT         10      /* rounds are spread by up to this much of the interval */
+#define WANMGR_PROBE_MIN_FAILURES       2
+#define WANMGR_PROBE_STABLE_MS          60000   /* up for less than this before going down again is a flap */
+#define WANMGR_PROBE_MAX_RECOVER_ROUNDS 256     /* recovery rounds needed after repeated flaps */
+
+#define WANMGR_PROBE_METHOD_GATEWAY     0x01    /* ARP (IPv4) or neighbour solicitation (IPv6) */
+#define WANMGR_PROBE_METHOD_ICMP        0x02    /* echo to the probe host, the gateway if none */
+#define WANMGR_PROBE_METHOD_DNS         0x04    /* root NS query to the DNS servers of the lease */
+
+/* ---- Global Types -------------------------------------------- */
+typedef struct _WanMgr_ProbeConfig_t
+{
+    UINT    intervalMs;
+    UINT    failureCount;
+    UINT    methods;            /* WANMGR_PROBE_METHOD_* */
+    char    host[BUFLEN_64];    /* IPv4 or IPv6 literal, empty for the gateway */
+} WanMgr_ProbeConfig_t;
+
+/* ---- Global Prototypes -------------------------------------- */
+
+/***************************************************************************
+ * @brief Convert a comma separated list of probe methods (Gateway, ICMP, DNS)
+ * into WANMGR_PROBE_METHOD_* flags. Unknown names are ignored.
+ * @param pMethods list of method names
+ * @return method flags.
+ ****************************************************************************/
+UINT WanMgr_Probe_ParseMethods(const char *pMethods);
+
+/***************************************************************************
+ * @brief Start probing an interface. Probing starts per address family once
+ * its address is set with WanMgr_Probe_SetIpv4/6.
+ * @param ifName WAN interface name
+ * @param pConfig probe configuration, copied
+ * @return ANSC_STATUS_SUCCESS upon success else returned error code.
+ ****************************************************************************/
+ANSC_STATUS WanMgr_Probe_Start(const char *ifName, const WanMgr_ProbeConfig_t *pConfig);
+
+/***************************************************************************
+ * @brief Stop probing an interface.
+ * @param ifName WAN interface name
+ * @return ANSC_STATUS_SUCCESS upon success else returned error code.
+ ****************************************************************************/
+ANSC_STATUS WanMgr_Probe_Stop(const char *ifName);
+
+/***************************************************************************
+ * @brief Start or stop IPv4 probes. Stopping is ignored while the probes
+ * themselves took the connection down, the gateway is watched for recovery.
+ * @param ifName WAN interface name
+ * @param up TRUE when the IPv4 lease is configured, FALSE when it is gone
+ * @param pAddr WAN address
+ * @param pGateway default gateway
+ * @param pDns DNS server of the lease, NULL or INADDR_ANY if none
+ * @return ANSC_STATUS_SUCCESS upon success else returned error code.
+ ****************************************************************************/
+ANSC_STATUS WanMgr_Probe_SetIpv4(const char *ifName, BOOL up, const struct in_addr *pAddr,
+                                 const struct in_addr *pGateway, const struct in_addr *pDns);
+
+/***************************************************************************
+ * @brief Start or stop IPv6 probes. The gateway is the router of the IPv6
+ * default route through the interface.
+ * @param ifName WAN interface name
+ * @param up TRUE when IPv6 is configured, FALSE when it is gone
+ * @param pAddr WAN address
+ * @param pDns DNS server of the lease, NULL or unspecified if none
+ * @return ANSC_STATUS_SUCCESS upon success else returned error code.
+ ****************************************************************************/
+ANSC_STATUS WanMgr_Probe_SetIpv6(const char *ifName, BOOL up, const struct in6_addr *pAddr,
+                                 const struct in6_addr *pDns);
+
+#endif /* _WANMGR_PROBE_H_ */
@@ -19,11 +19,13 @@
 
 #include <sysevent/sysevent.h>
 #include <pthread.h>
+#include <time.h>
 #include <syscfg.h>
 #include <syscfg/syscfg.h>
 
 #include "wanmgr_sysevents.h"
 #include "wanmgr_rdkbus_utils.h"
+#include "wanmgr_event_loop.h"
 
 int sysevent_fd = -1;
 token_t sysevent_token;
@@ -59,6 +61,42 @@ static void set_vendor_spec_conf();
 static int getVendorClassInfo(char *buffer, int length);
 static int set_default_conf_entry();
 
+#define SYSEVENT_HASH_SIZE      32      /* power of two, > WANMGR_SYSEVENT_MAX_HANDLERS */
+
+typedef struct _WanMgr_SyseventHandler_t
+{
+    const char*                 name;
+    WanMgr_SyseventHandlerFn    fn;
+    BOOL                        offload;    /* run on the event loop worker */
+    async_id_t                  asyncid;
+} WanMgr_SyseventHandler_t;
+
+typedef struct _WanMgr_SyseventJob_t
+{
+    WanMgr_SyseventHandlerFn    fn;
+    char                        name[BUFLEN_42];
+    char                        val[BUFLEN_42];
+} WanMgr_SyseventJob_t;
+
+typedef struct _WanMgr_RestartSched_t
+{
+    const char*     name;           /* sysevent emitted at the end of the window */
+    BOOL            pending;
+    struct timespec deadline;
+    UINT            emitted;
+    UINT            suppressed;
+} WanMgr_RestartSched_t;
+
+static WanMgr_RestartSched_t gRestartSched[WANMGR_RESTART_MAX] =
+{
+    [WANMGR_RESTART_FIREWALL]       = { SYSEVENT_FIREWALL_RESTART, FALSE, {0, 0}, 0, 0 },
+    [WANMGR_RESTART_DHCP_SERVER]    = { SYSEVENT_DHCP_SERVER_RESTART, FALSE, {0, 0}, 0, 0 },
+};
+static pthread_mutex_t gRestartSchedMutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t gRestartSchedCond;
+static BOOL gRestartSchedRunning = FALSE;
+static UINT gRestartDebounceMs = WANMGR_RESTART_DEBOUNCE_MS_DEF;
+
 static ANSC_STATUS WanMgr_SyseventInit()
 {
     ANSC_STATUS ret = ANSC_STATUS_SUCCESS;
@@ -157,6 +195,147 @@ ANSC_STATUS syscfg_set_bool(const char* name, int value)
     return ret;
 }
 
+static void RestartSched_AddMs(struct timespec *ts, UINT ms)
+{
+    ts->tv_sec += ms / 1000;
+    ts->tv_nsec += (long)(ms % 1000) * 1000000L;
+    if (ts->tv_nsec >= 1000000000L)
+    {
+        ts->tv_sec++;
+        ts->tv_nsec -= 1000000000L;
+    }
+}
+
+static BOOL RestartSched_IsDue(const struct timespec *deadline, const struct timespec *now)
+{
+    return (now->tv_sec > deadline->tv_sec ||
+            (now->tv_sec == deadline->tv_sec && now->tv_nsec >= deadline->tv_nsec)) ? TRUE : FALSE;
+}
+
+static void *WanMgr_RestartSchedThread(void *arg)
+{
+    struct timespec now;
+    struct timespec wakeup;
+    BOOL due[WANMGR_RESTART_MAX];
+    BOOL havePending;
+    int i;
+
+    pthread_detach(pthread_self());
+
+    pthread_mutex_lock(&gRestartSchedMutex);
+    for (;;)
+    {
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        havePending = FALSE;
+        for (i = 0; i < WANMGR_RESTART_MAX; i++)
+        {
+            due[i] = FALSE;
+            if (gRestartSched[i].pending != TRUE)
+            {
+                continue;
+            }
+
+            if (RestartSched_IsDue(&gRestartSched[i].deadline, &now) == TRUE)
+            {
+                gRestartSched[i].pending = FALSE;
+                gRestartSched[i].emitted++;
+                due[i] = TRUE;
+            }
+            else if (havePending == FALSE || RestartSched_IsDue(&wakeup, &gRestartSched[i].deadline) == TRUE)
+            {
+                wakeup = gRestartSched[i].deadline;
+                havePending = TRUE;
+            }
+        }
+
+        /* sysevent_set() talks to syseventd, don't hold the lock over it */
+        pthread_mutex_unlock(&gRestartSchedMutex);
+        for (i = 0; i < WANMGR_RESTART_MAX; i++)
+        {
+            if (due[i] == TRUE)
+            {
+                CcspTraceInfo(("%s %d - %s (emitted %u, suppressed %u)\n", __FUNCTION__, __LINE__,
+                               gRestartSched[i].name, gRestartSched[i].emitted, gRestartSched[i].suppressed));
+                sysevent_set(sysevent_fd, sysevent_token, gRestartSched[i].name, NULL, 0);
+            }
+        }
+        pthread_mutex_lock(&gRestartSchedMutex);
+
+        if (havePending == TRUE)
+        {
+            pthread_cond_timedwait(&gRestartSchedCond, &gRestartSchedMutex, &wakeup);
+        }
+        else
+        {
+            pthread_cond_wait(&gRestartSchedCond, &gRestartSchedMutex);
+        }
+    }
+    pthread_mutex_unlock(&gRestartSchedMutex);
+
+    return NULL;
+}
+
+static ANSC_STATUS WanMgr_RestartSchedInit(void)
+{
+    pthread_condattr_t attr;
+    pthread_t tid;
+    char buf[BUFLEN_16] = {0};
+
+    if (syscfg_get(NULL, SYSCFG_RESTART_DEBOUNCE_MS, buf, sizeof(buf)) == 0 && buf[0] != '\0')
+    {
+        gRestartDebounceMs = (UINT) strtoul(buf, NULL, 10);
+    }
+
+    pthread_condattr_init(&attr);
+    pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+    pthread_cond_init(&gRestartSchedCond, &attr);
+    pthread_condattr_destroy(&attr);
+
+    if (pthread_create(&tid, NULL, WanMgr_RestartSchedThread, NULL) != 0)
+    {
+        CcspTraceError(("%s %d - restart scheduler pthread_create failed, restarts will not be coalesced\n", __FUNCTION__, __LINE__));
+        return ANSC_STATUS_FAILURE;
+    }
+
+    pthread_mutex_lock(&gRestartSchedMutex);
+    gRestartSchedRunning = TRUE;
+    pthread_mutex_unlock(&gRestartSchedMutex);
+
+    CcspTraceInfo(("%s %d - restart debounce window %u ms\n", __FUNCTION__, __LINE__, gRestartDebounceMs));
+    return ANSC_STATUS_SUCCESS;
+}
+
+void wanmgr_sysevents_scheduleRestart(WanMgr_RestartEvent_t event)
+{
+    if (event >= WANMGR_RESTART_MAX)
+    {
+        return;
+    }
+
+    pthread_mutex_lock(&gRestartSchedMutex);
+    if (gRestartSchedRunning != TRUE || gRestartDebounceMs == 0)
+    {
+        gRestartSched[event].emitted++;
+        pthread_mutex_unlock(&gRestartSchedMutex);
+        sysevent_set(sysevent_fd, sysevent_token, gRestartSched[event].name, NULL, 0);
+        return;
+    }
+
+    if (gRestartSched[event].pending == TRUE)
+    {
+        /* already due at the end of the current window */
+        gRestartSched[event].suppressed++;
+    }
+    else
+    {
+        clock_gettime(CLOCK_MONOTONIC, &gRestartSched[event].deadline);
+        RestartSched_AddMs(&gRestartSched[event].deadline, gRestartDebounceMs);
+        gRestartSched[event].pending = TRUE;
+        pthread_cond_signal(&gRestartSchedCond);
+    }
+    pthread_mutex_unlock(&gRestartSchedMutex);
+}
+
 ANSC_STATUS wanmgr_sysevents_ipv6Info_init()
 {
     sysevent_set(sysevent_fd, sysevent_token, SYSEVENT_FIELD_IPV6_DNS_PRIMARY, "", 0);
@@ -394,224 +573,346 @@ static int set_default_conf_entry()
     return 0;
 }
 
-static void *WanManagerSyseventHandler(void *args)
+static void SyseventHandle_UlaAddress(const char *name, const char *val)
 {
-    CcspTraceInfo(("%s %d \n", __FUNCTION__, __LINE__));
+    char *datamodel_value = NULL;
+    ANSC_STATUS result = 0;
 
-    //detach thread from caller stack
-    pthread_detach(pthread_self());
+    datamodel_value = (char *) malloc(sizeof(char) * 256);
+    if(datamodel_value != NULL)
+    {
+        memset(datamodel_value, 0, 256);
+        strncpy(datamodel_value, val, 255);
+        result = WanMgr_RdkBus_SetParamValues( PAM_COMPONENT_NAME, PAM_DBUS_PATH, "Device.DHCPv6.Server.Pool.1.X_RDKCENTRAL-COM_DNSServersEnabled", "true", ccsp_boolean, TRUE );
+        if(result == ANSC_STATUS_SUCCESS)
+        {
+            result = WanMgr_RdkBus_SetParamValues( PAM_COMPONENT_NAME, PAM_DBUS_PATH, "Device.DHCPv6.Server.Pool.1.X_RDKCENTRAL-COM_DNSServers", datamodel_value, ccsp_string, TRUE );
+            if(result != ANSC_STATUS_SUCCESS) {
+                CcspTraceError(("%s %d - SetDataModelParameter() failed for X_RDKCENTRAL-COM_DNSServers parameter \n", __FUNCTION__, __LINE__));
+            }
+        }
+        else {
+            CcspTraceError(("%s %d - SetDataModelParameter() failed for X_RDKCENTRAL-COM_DNSServersEnabled parameter \n", __FUNCTION__, __LINE__));
+        }
+        free(datamodel_value);
+    }
+}
+
+static void SyseventHandle_UlaEnable(const char *name, const char *val)
+{
+    char *datamodel_value = NULL;
+    ANSC_STATUS result = 0;
 
-    async_id_t wanamangr_status_asyncid;
-    async_id_t lan_ula_address_event_asyncid;
-    async_id_t lan_ula_enable_asyncid;
-    async_id_t lan_ipv6_enable_asyncid;
-    async_id_t wan_status_asyncid;
-    async_id_t wan_service_status_asyncid;
-    async_id_t pnm_status_asyncid;
-    async_id_t lan_status_asyncid;
-    async_id_t primary_lan_l3net_asyncid;
-    async_id_t radvd_restart_asyncid;
-    async_id_t ipv6_down_asyncid;
-
-    sysevent_set_options(sysevent_msg_fd, sysevent_msg_token, SYSEVENT_ULA_ADDRESS, TUPLE_FLAG_EVENT);
-    sysevent_setnotification(sysevent_msg_fd, sysevent_msg_token, SYSEVENT_ULA_ADDRESS, &lan_ula_address_event_asyncid);
-
-    sysevent_set_options(sysevent_msg_fd, sysevent_msg_token, SYSEVENT_ULA_ENABLE, TUPLE_FLAG_EVENT);
-    sysevent_setnotification(sysevent_msg_fd, sysevent_msg_token, SYSEVENT_ULA_ENABLE, &lan_ula_enable_asyncid);
-
-    sysevent_set_options(sysevent_msg_fd, sysevent_msg_token, SYSEVENT_IPV6_ENABLE, TUPLE_FLAG_EVENT);
-    sysevent_setnotification(sysevent_msg_fd, sysevent_msg_token, SYSEVENT_IPV6_ENABLE, &lan_ipv6_enable_asyncid);
-
-    sysevent_set_options(sysevent_msg_fd, sysevent_msg_token, SYSEVENT_WAN_STATUS, TUPLE_FLAG_EVENT);
-    sysevent_setnotification(sysevent_msg_fd, sysevent_msg_token, SYSEVENT_WAN_STATUS,  &wan_status_asyncid);
-
-    sysevent_set_options(sysevent_msg_fd, sysevent_msg_token, SYSEVENT_WAN_SERVICE_STATUS, TUPLE_FLAG_EVENT);
-    sysevent_setnotification(sysevent_msg_fd, sysevent_msg_token, SYSEVENT_WAN_SERVICE_STATUS, &wan_service_status_asyncid);
-
-    sysevent_set_options(sysevent_msg_fd, sysevent_msg_token, SYSEVENT_PNM_STATUS, TUPLE_FLAG_EVENT);
-    sysevent_setnotification(sysevent_msg_fd, sysevent_msg_token, SYSEVENT_PNM_STATUS, &pnm_status_asyncid);
-
-    sysevent_set_options(sysevent_msg_fd, sysevent_msg_token, SYSEVENT_LAN_STATUS, TUPLE_FLAG_EVENT);
-    sysevent_setnotification(sysevent_msg_fd, sysevent_msg_token, SYSEVENT_LAN_STATUS,  &lan_status_asyncid);
-
-    sysevent_set_options(sysevent_msg_fd, sysevent_msg_token, SYSEVENT_PRIMARY_LAN_L3NET, TUPLE_FLAG_EVENT);
-    sysevent_setnotification(sysevent_msg_fd, sysevent_msg_token, SYSEVENT_PRIMARY_LAN_L3NET,  &primary_lan_l3net_asyncid);
-
-    sysevent_set_options(sysevent_msg_fd, sysevent_msg_token, SYSEVENT_RADVD_RESTART, TUPLE_FLAG_EVENT);
-    sysevent_setnotification(sysevent_msg_fd, sysevent_msg_token, SYSEVENT_RADVD_RESTART, &radvd_restart_asyncid);
-
-    sysevent_set_options(sysevent_msg_fd, sysevent_msg_token, SYSEVENT_GLOBAL_IPV6_PREFIX_CLEAR, TUPLE_FLAG_EVENT);
-    sysevent_setnotification(sysevent_msg_fd, sysevent_msg_token, SYSEVENT_GLOBAL_IPV6_PREFIX_CLEAR, &ipv6_down_asyncid);
-    for(;;)
-    {
-        char name[BUFLEN_42] = {0};
-        char val[BUFLEN_42] = {0};
-        char buf[BUF_SIZE] = {0};
-        int namelen = sizeof(name);
-        int vallen  = sizeof(val);
-        async_id_t getnotification_asyncid;
-        int err = 0;
-        ANSC_STATUS result = 0;
-        char *datamodel_value = NULL;
-        char brlan0_inst[BRG_INST_SIZE];
-        char* l3net_inst = NULL;
-        int l2net_inst_up = FALSE;
-
-        err = sysevent_getnotification(sysevent_msg_fd, sysevent_msg_token, name, &namelen,  val, &vallen, &getnotification_asyncid);
-
-        if(err)
+    datamodel_value = (char *) malloc(sizeof(char) * 256);
+    if(datamodel_value != NULL)
+    {
+        memset(datamodel_value, 0, 256);
+        strncpy(datamodel_value, val, 255);
+        result = WanMgr_RdkBus_SetParamValues( PAM_COMPONENT_NAME, PAM_DBUS_PATH, "Device.DHCPv6.Server.Pool.1.X_RDKCENTRAL-COM_DNSServersEnabled", datamodel_value, ccsp_boolean, TRUE );
+        if(result != ANSC_STATUS_SUCCESS)
         {
-            CcspTraceError(("%s %d sysevent_getnotification failed with error: %d \n", __FUNCTION__, __LINE__, err ));
-            sleep(2);
+            CcspTraceError(("%s %d - SetDataModelParameter failed on dns_enable request \n", __FUNCTION__, __LINE__));
         }
-        else
+    }
+    free(datamodel_value);
+}
+
+static void SyseventHandle_Ipv6Enable(const char *name, const char *val)
+{
+    char *datamodel_value = NULL;
+    ANSC_STATUS result = 0;
+
+    datamodel_value = (char *) malloc(sizeof(char) * 256);
+    if(datamodel_value != NULL)
+    {
+        memset(datamodel_value, 0, 256);
+        strncpy(datamodel_value, val, 255);
+        result = WanMgr_RdkBus_SetParamValues( PAM_COMPONENT_NAME, PAM_DBUS_PATH, "Device.DHCPv6.Server.Pool.1.Enable", datamodel_value, ccsp_boolean, TRUE );
+        if(result != ANSC_STATUS_SUCCESS)
         {
-            CcspTraceInfo(("%s %d - received notification event %s:%s\n", __FUNCTION__, __LINE__, name, val ));
-            if ( strcmp(name, SYSEVENT_ULA_ADDRESS) == 0 )
-            {
-                datamodel_value = (char *) malloc(sizeof(char) * 256);
-                if(datamodel_value != NULL)
-                {
-                    memset(datamodel_value, 0, 256);
-                    strncpy(datamodel_value, val, sizeof(val));
-                    result = WanMgr_RdkBus_SetParamValues( PAM_COMPONENT_NAME, PAM_DBUS_PATH, "Device.DHCPv6.Server.Pool.1.X_RDKCENTRAL-COM_DNSServersEnabled", "true", ccsp_boolean, TRUE );
-                    if(result == ANSC_STATUS_SUCCESS)
-                    {
-                        result = WanMgr_RdkBus_SetParamValues( PAM_COMPONENT_NAME, PAM_DBUS_PATH, "Device.DHCPv6.Server.Pool.1.X_RDKCENTRAL-COM_DNSServers", datamodel_value, ccsp_string, TRUE );
-                        if(result != ANSC_STATUS_SUCCESS) {
-                            CcspTraceError(("%s %d - SetDataModelParameter() failed for X_RDKCENTRAL-COM_DNSServers parameter \n", __FUNCTION__, __LINE__));
-                        }
-                    }
-                    else {
-                        CcspTraceError(("%s %d - SetDataModelParameter() failed for X_RDKCENTRAL-COM_DNSServersEnabled parameter \n", __FUNCTION__, __LINE__));
-                    }
-                    free(datamodel_value);
-                }
-            }
-            else if ( strcmp(name, SYSEVENT_ULA_ENABLE) == 0 )
-            {
-                datamodel_value = (char *) malloc(sizeof(char) * 256);
-                if(datamodel_value != NULL)
-                {
-                    memset(datamodel_value, 0, 256);
-                    strncpy(datamodel_value, val, sizeof(val));
-                    result = WanMgr_RdkBus_SetParamValues( PAM_COMPONENT_NAME, PAM_DBUS_PATH, "Device.DHCPv6.Server.Pool.1.X_RDKCENTRAL-COM_DNSServersEnabled", datamodel_value, ccsp_boolean, TRUE );
-                    if(result != ANSC_STATUS_SUCCESS)
-                    {
-                        CcspTraceError(("%s %d - SetDataModelParameter failed on dns_enable request \n", __FUNCTION__, __LINE__));
-                    }
-                }
-                free(datamodel_value);
-            }
-            else if ( strcmp(name, SYSEVENT_IPV6_ENABLE) == 0 )
-            {
-                datamodel_value = (char *) malloc(sizeof(char) * 256);
-                if(datamodel_value != NULL)
-                {
-                    memset(datamodel_value, 0, 256);
-                    strncpy(datamodel_value, val, sizeof(val));
-                    result = WanMgr_RdkBus_SetParamValues( PAM_COMPONENT_NAME, PAM_DBUS_PATH, "Device.DHCPv6.Server.Pool.1.Enable", datamodel_value, ccsp_boolean, TRUE );
-                    if(result != ANSC_STATUS_SUCCESS)
-                    {
-                        CcspTraceError(("%s %d - SetDataModelParameter failed on ipv6_enable request \n", __FUNCTION__, __LINE__ ));
-                    }
-                    free(datamodel_value);
-                    system("sysevent set zebra-restart");
-                }
-            }
-            else if ((strcmp(name, SYSEVENT_WAN_STATUS) == 0) && (strcmp(val, SYSEVENT_VALUE_STARTED) == 0))
-            {
-                if (!lan_wan_started)
-                {
-                    check_lan_wan_ready();
-                }
-                system("touch /tmp/phylink_wan_state_up");
-            }
-            else if (strcmp(name, SYSEVENT_WAN_SERVICE_STATUS) == 0)
-            {
-                CcspTraceError(("%s %d - received notification event %s:%s\n", __FUNCTION__, __LINE__, name, val ));
-                if (strcmp(val, SYSEVENT_VALUE_STARTED) == 0) {
-                    do_toggle_v6_status();
-                }
-            }
-            else if (strcmp(name, SYSEVENT_PNM_STATUS) == 0)
-            {
-                if (strcmp(val, STATUS_UP_STRING)==0)
-                {
-                    pnm_inited = 1;
-                    lan_start();
-                    system("firewall && execute_dir /etc/utopia/post.d/ restart");
-                }
-            }
-            else if (strcmp(name, SYSEVENT_PRIMARY_LAN_L3NET) == 0)
+            CcspTraceError(("%s %d - SetDataModelParameter failed on ipv6_enable request \n", __FUNCTION__, __LINE__ ));
+        }
+        free(datamodel_value);
+        system("sysevent set zebra-restart");
+    }
+}
+
+static void SyseventHandle_WanStatus(const char *name, const char *val)
+{
+    if (strcmp(val, SYSEVENT_VALUE_STARTED) == 0)
+    {
+        if (!lan_wan_started)
+        {
+            check_lan_wan_ready();
+        }
+        system("touch /tmp/phylink_wan_state_up");
+    }
+}
+
+static void SyseventHandle_WanServiceStatus(const char *name, const char *val)
+{
+    if (strcmp(val, SYSEVENT_VALUE_STARTED) == 0) {
+        do_toggle_v6_status();
+    }
+}
+
+static void SyseventHandle_PnmStatus(const char *name, const char *val)
+{
+    if (strcmp(val, STATUS_UP_STRING)==0)
+    {
+        pnm_inited = 1;
+        lan_start();
+        system("firewall && execute_dir /etc/utopia/post.d/ restart");
+    }
+}
+
+static void SyseventHandle_PrimaryLanL3Net(const char *name, const char *val)
+{
+    if (pnm_inited)
+    {
+        lan_start();
+    }
+}
+
+static void SyseventHandle_LanStatus(const char *name, const char *val)
+{
+    char wanStatus[BUFLEN_16] = {0};
+    char buf[BUF_SIZE] = {0};
+    char brlan0_inst[BRG_INST_SIZE] = {0};
+    char* l3net_inst = NULL;
+    char* saveptr = NULL;
+    int l2net_inst_up = FALSE;
+
+    if (strcmp(val, SYSEVENT_VALUE_STARTED) == 0)
+    {
+        sysevent_get(sysevent_fd, sysevent_token, SYSEVENT_PRIMARY_LAN_L3NET, buf, sizeof(buf));
+        strncpy(brlan0_inst, buf, BRG_INST_SIZE-1);
+        sysevent_get(sysevent_fd, sysevent_token, SYSEVENT_L3NET_INSTANCES, buf, sizeof(buf));
+        l3net_inst = strtok_r(buf, " ", &saveptr);
+        while(l3net_inst != NULL)
+        {
+            if(!(strcmp(l3net_inst, brlan0_inst)==0))
             {
-                if (pnm_inited)
-                {
-                    lan_start();
-                }
+                sysevent_set(sysevent_fd, sysevent_token, SYSEVENT_IPV4_UP, l3net_inst, 0);
+                l2net_inst_up = TRUE;
             }
-            else if (strcmp(name, SYSEVENT_LAN_STATUS) == 0 )
-            {
-                char wanStatus[BUFLEN_16] = {0};
-                if (strcmp(val, SYSEVENT_VALUE_STARTED) == 0)
-                {
-                    sysevent_get(sysevent_fd, sysevent_token, SYSEVENT_PRIMARY_LAN_L3NET, buf, sizeof(buf));
-                    strncpy(brlan0_inst, buf, BRG_INST_SIZE-1);
-                    sysevent_get(sysevent_fd, sysevent_token, SYSEVENT_L3NET_INSTANCES, buf, sizeof(buf));
-                    l3net_inst = strtok(buf, " ");
-                    while(l3net_inst != NULL)
-                    {
-                        if(!(strcmp(l3net_inst, brlan0_inst)==0))
-                        {
-                            sysevent_set(sysevent_fd, sysevent_token, SYSEVENT_IPV4_UP, l3net_inst, 0);
-                            l2net_inst_up = TRUE;
-                        }
-                        l3net_inst = strtok(NULL, " ");
-                    }
-                    if(l2net_inst_up == FALSE)
-                    {
-                        sysevent_set(sysevent_fd, sysevent_token, SYSEVENT_IPV4_UP, brlan0_inst, 0);
-                    }
-                    sysevent_get(sysevent_fd, sysevent_token, SYSEVENT_WAN_SERVICE_STATUS, wanStatus, sizeof(wanStatus));
-                    if(strcmp(wanStatus, SYSEVENT_VALUE_STARTED) == 0)
-                    {
-                        do_toggle_v6_status();
-                    }
-                    memset(buf, '\0', sizeof(buf));
-                    sysevent_get(sysevent_fd, sysevent_token, SYSEVENT_ULA_ADDRESS, buf, sizeof(buf));
-                    if(buf[0] != '\0') {
-                        sysevent_set(sysevent_fd, sysevent_token, SYSEVENT_LAN_ULA_ADDRESS, buf, 0);
-                    }
-                    set_vendor_spec_conf();
-                    system("gw_lan_refresh &");
+            l3net_inst = strtok_r(NULL, " ", &saveptr);
+        }
+        if(l2net_inst_up == FALSE)
+        {
+            sysevent_set(sysevent_fd, sysevent_token, SYSEVENT_IPV4_UP, brlan0_inst, 0);
+        }
+        sysevent_get(sysevent_fd, sysevent_token, SYSEVENT_WAN_SERVICE_STATUS, wanStatus, sizeof(wanStatus));
+        if(strcmp(wanStatus, SYSEVENT_VALUE_STARTED) == 0)
+        {
+            do_toggle_v6_status();
+        }
+        memset(buf, '\0', sizeof(buf));
+        sysevent_get(sysevent_fd, sysevent_token, SYSEVENT_ULA_ADDRESS, buf, sizeof(buf));
+        if(buf[0] != '\0') {
+            sysevent_set(sysevent_fd, sysevent_token, SYSEVENT_LAN_ULA_ADDRESS, buf, 0);
+        }
+        set_vendor_spec_conf();
+        system("gw_lan_refresh &");
 #ifdef FEATURE_MAPT
-                    memset(buf, '\0', sizeof(buf));
-                    sysevent_get(sysevent_fd, sysevent_token, SYSEVENT_MAP_TRANSPORT_MODE, buf, sizeof(buf));
-                    if( !strcmp(buf, "MAPT") || !strcmp(buf, "MAPE") )  {
-                        set_mapt_rule();
-                    }
+        memset(buf, '\0', sizeof(buf));
+        sysevent_get(sysevent_fd, sysevent_token, SYSEVENT_MAP_TRANSPORT_MODE, buf, sizeof(buf));
+        if( !strcmp(buf, "MAPT") || !strcmp(buf, "MAPE") )  {
+            set_mapt_rule();
+        }
 #endif
-                }
-            }
-            else if (strcmp(name, SYSEVENT_RADVD_RESTART) == 0)
-            {
-                sysevent_set(sysevent_fd, sysevent_token, SYSEVENT_FIELD_SERVICE_ROUTED_STATUS, "", 0);
-                system("service_routed radv-restart");
-            }
-            else if (strcmp(name, SYSEVENT_GLOBAL_IPV6_PREFIX_CLEAR) == 0)
-            {
-                sysevent_set(sysevent_fd, sysevent_token, SYSEVENT_IPV6_CONNECTION_STATE, STATUS_DOWN_STRING, 0);
-                sysevent_set(sysevent_fd, sysevent_token, SYSEVENT_FIREWALL_RESTART, NULL, 0);
-            }
-            else
-            {
-                CcspTraceError(("%s %d undefined event %s:%s \n", __FUNCTION__, __LINE__, name, val));
-            }
+    }
+}
+
+static void SyseventHandle_RadvdRestart(const char *name, const char *val)
+{
+    sysevent_set(sysevent_fd, sysevent_token, SYSEVENT_FIELD_SERVICE_ROUTED_STATUS, "", 0);
+    system("service_routed radv-restart");
+}
+
+static void SyseventHandle_Ipv6PrefixClear(const char *name, const char *val)
+{
+    sysevent_set(sysevent_fd, sysevent_token, SYSEVENT_IPV6_CONNECTION_STATE, STATUS_DOWN_STRING, 0);
+    wanmgr_sysevents_scheduleRestart(WANMGR_RESTART_FIREWALL);
+}
+
+/* Events handled by this module. Handlers marked offload block (D-Bus,
+ * system(), popen) and run in order on the event loop worker, the others
+ * run on the event loop thread. Handlers sharing state (pnm_inited,
+ * lan_wan_started) are all offloaded so they stay serialised. */
+static const WanMgr_SyseventHandler_t gSyseventBuiltinHandlers[] =
+{
+    { SYSEVENT_ULA_ADDRESS,              SyseventHandle_UlaAddress,       TRUE  },
+    { SYSEVENT_ULA_ENABLE,               SyseventHandle_UlaEnable,        TRUE  },
+    { SYSEVENT_IPV6_ENABLE,              SyseventHandle_Ipv6Enable,       TRUE  },
+    { SYSEVENT_WAN_STATUS,               SyseventHandle_WanStatus,        TRUE  },
+    { SYSEVENT_WAN_SERVICE_STATUS,       SyseventHandle_WanServiceStatus, TRUE  },
+    { SYSEVENT_PNM_STATUS,               SyseventHandle_PnmStatus,        TRUE  },
+    { SYSEVENT_LAN_STATUS,               SyseventHandle_LanStatus,        TRUE  },
+    { SYSEVENT_PRIMARY_LAN_L3NET,        SyseventHandle_PrimaryLanL3Net,  TRUE  },
+    { SYSEVENT_RADVD_RESTART,            SyseventHandle_RadvdRestart,     TRUE  },
+    { SYSEVENT_GLOBAL_IPV6_PREFIX_CLEAR, SyseventHandle_Ipv6PrefixClear,  FALSE },
+};
+
+static WanMgr_SyseventHandler_t gSyseventHandlers[WANMGR_SYSEVENT_MAX_HANDLERS];
+static UINT gSyseventHandlerCount = 0;
+/* set once the subscriptions are made, the table is read-only from then on */
+static BOOL gSyseventReceiving = FALSE;
+static pthread_mutex_t gSyseventHandlerMutex = PTHREAD_MUTEX_INITIALIZER;
+
+/* name -> handler index, open addressing, 0 means empty slot */
+static UINT gSyseventHashTable[SYSEVENT_HASH_SIZE];
+
+static UINT SyseventHash(const char *name)
+{
+    UINT hash = 2166136261u;    /* FNV-1a */
+
+    while (*name != '\0')
+    {
+        hash ^= (unsigned char) *name++;
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+/* called with gSyseventHandlerMutex held */
+static void SyseventHashInsert(UINT index)
+{
+    UINT slot = SyseventHash(gSyseventHandlers[index].name) & (SYSEVENT_HASH_SIZE - 1);
+
+    while (gSyseventHashTable[slot] != 0)
+    {
+        slot = (slot + 1) & (SYSEVENT_HASH_SIZE - 1);
+    }
+    gSyseventHashTable[slot] = index + 1;
+}
+
+static WanMgr_SyseventHandler_t* SyseventHashLookup(const char *name)
+{
+    UINT slot = SyseventHash(name) & (SYSEVENT_HASH_SIZE - 1);
+    UINT index;
+
+    while ((index = gSyseventHashTable[slot]) != 0)
+    {
+        if (strcmp(gSyseventHandlers[index - 1].name, name) == 0)
+        {
+            return &gSyseventHandlers[index - 1];
         }
+        slot = (slot + 1) & (SYSEVENT_HASH_SIZE - 1);
     }
+    return NULL;
+}
 
-    CcspTraceInfo(("%s %d - WanManagerSyseventHandler Exit \n", __FUNCTION__, __LINE__));
-    return 0;
+static void SyseventRunJob(void *arg)
+{
+    WanMgr_SyseventJob_t *pJob = (WanMgr_SyseventJob_t *) arg;
+
+    pJob->fn(pJob->name, pJob->val);
+    free(pJob);
+}
+
+static ANSC_STATUS SyseventQueueJob(WanMgr_SyseventHandlerFn fn, const char *name, const char *val)
+{
+    WanMgr_SyseventJob_t *pJob = NULL;
+
+    pJob = (WanMgr_SyseventJob_t *) malloc(sizeof(WanMgr_SyseventJob_t));
+    if (pJob == NULL)
+    {
+        return ANSC_STATUS_FAILURE;
+    }
+
+    memset(pJob, 0, sizeof(WanMgr_SyseventJob_t));
+    pJob->fn = fn;
+    snprintf(pJob->name, sizeof(pJob->name), "%s", name);
+    snprintf(pJob->val, sizeof(pJob->val), "%s", val);
+
+    if (WanMgr_EventLoop_QueueWork(SyseventRunJob, pJob) != ANSC_STATUS_SUCCESS)
+    {
+        free(pJob);
+        return ANSC_STATUS_FAILURE;
+    }
+
+    return ANSC_STATUS_SUCCESS;
+}
+
+ANSC_STATUS wanmgr_sysevents_registerHandler(const char *name, WanMgr_SyseventHandlerFn fn, BOOL offload)
+{
+    if (name == NULL || fn == NULL)
+    {
+        return ANSC_STATUS_FAILURE;
+    }
+
+    pthread_mutex_lock(&gSyseventHandlerMutex);
+    if (gSyseventReceiving == TRUE || gSyseventHandlerCount >= WANMGR_SYSEVENT_MAX_HANDLERS)
+    {
+        pthread_mutex_unlock(&gSyseventHandlerMutex);
+        CcspTraceError(("%s %d - can't register handler for %s\n", __FUNCTION__, __LINE__, name));
+        return ANSC_STATUS_FAILURE;
+    }
+
+    gSyseventHandlers[gSyseventHandlerCount].name = name;
+    gSyseventHandlers[gSyseventHandlerCount].fn = fn;
+    gSyseventHandlers[gSyseventHandlerCount].offload = offload;
+    SyseventHashInsert(gSyseventHandlerCount);
+    gSyseventHandlerCount++;
+    pthread_mutex_unlock(&gSyseventHandlerMutex);
+
+    return ANSC_STATUS_SUCCESS;
+}
+
+/* One notification per call, the fd is readable so this does not block */
+static void WanMgr_SyseventOnReadable(int fd, uint32_t events, void *arg)
+{
+    char name[BUFLEN_42] = {0};
+    char val[BUFLEN_42] = {0};
+    int namelen = sizeof(name);
+    int vallen  = sizeof(val);
+    async_id_t getnotification_asyncid;
+    int err = 0;
+    WanMgr_SyseventHandler_t *pHandler = NULL;
+
+    err = sysevent_getnotification(sysevent_msg_fd, sysevent_msg_token, name, &namelen,  val, &vallen, &getnotification_asyncid);
+    if(err)
+    {
+        CcspTraceError(("%s %d sysevent_getnotification failed with error: %d \n", __FUNCTION__, __LINE__, err ));
+        return;
+    }
+
+    CcspTraceInfo(("%s %d - received notification event %s:%s\n", __FUNCTION__, __LINE__, name, val ));
+
+    if ((pHandler = SyseventHashLookup(name)) == NULL)
+    {
+        CcspTraceError(("%s %d undefined event %s:%s \n", __FUNCTION__, __LINE__, name, val));
+        return;
+    }
+
+    if (pHandler->offload == TRUE && SyseventQueueJob(pHandler->fn, name, val) == ANSC_STATUS_SUCCESS)
+    {
+        return;
+    }
+
+    pHandler->fn(name, val);
+}
+
+static ANSC_STATUS WanMgr_SyseventSubscribe(void)
+{
+    UINT i;
+
+    for (i = 0; i < sizeof(gSyseventBuiltinHandlers) / sizeof(gSyseventBuiltinHandlers[0]); i++)
+    {
+        wanmgr_sysevents_registerHandler(gSyseventBuiltinHandlers[i].name, gSyseventBuiltinHandlers[i].fn, gSyseventBuiltinHandlers[i].offload);
+    }
+
+    pthread_mutex_lock(&gSyseventHandlerMutex);
+    for (i = 0; i < gSyseventHandlerCount; i++)
+    {
+        sysevent_set_options(sysevent_msg_fd, sysevent_msg_token, gSyseventHandlers[i].name, TUPLE_FLAG_EVENT);
+        sysevent_setnotification(sysevent_msg_fd, sysevent_msg_token, gSyseventHandlers[i].name, &gSyseventHandlers[i].asyncid);
+    }
+    gSyseventReceiving = TRUE;
+    pthread_mutex_unlock(&gSyseventHandlerMutex);
+
+    return WanMgr_EventLoop_AddFd(sysevent_msg_fd, "sysevent", WanMgr_SyseventOnReadable, NULL);
 }
 
 static void lan_start()
@@ -720,7 +1021,6 @@ static int getVendorClassInfo(char *buffer, int length)
 ANSC_STATUS WanMgr_SysEvents_Init(void)
 {
     ANSC_STATUS retStatus = ANSC_STATUS_SUCCESS;
-    pthread_t sysevent_tid;
 
     // Initialise syscfg
     if (syscfg_init() < 0)
@@ -739,12 +1039,10 @@ ANSC_STATUS WanMgr_SysEvents_Init(void)
     }
 
     set_default_conf_entry();
-    //Init msg status handler
-    if(pthread_create(&sysevent_tid, NULL, WanManagerSyseventHandler, NULL) == 0) {
-        CcspTraceError(("%s %d - DmlWanMsgHandler -- pthread_create successfully \n", __FUNCTION__, __LINE__));    
-    }
-    else {
-        CcspTraceError(("%s %d - DmlWanMsgHandler -- pthread_create failed \n", __FUNCTION__, __LINE__));
+    WanMgr_RestartSchedInit();
+    //Subscribe and hand the notification fd to the event loop
+    if (WanMgr_SyseventSubscribe() != ANSC_STATUS_SUCCESS) {
+        CcspTraceError(("%s %d - sysevent notifications not registered with the event loop \n", __FUNCTION__, __LINE__));
     }
 
     //Initialize syscfg value of ipv6 address to release previous value
@@ -139,6 +139,22 @@
 #define UNSET "unset"
 #define RESET "reset"
 
+// Downstream restarts requested through the restart scheduler
+typedef enum
+{
+    WANMGR_RESTART_FIREWALL = 0,
+    WANMGR_RESTART_DHCP_SERVER,
+    WANMGR_RESTART_MAX
+} WanMgr_RestartEvent_t;
+
+#define WANMGR_SYSEVENT_MAX_HANDLERS    24
+
+// Sysevent notification handler, val is the new value of the event
+typedef void (*WanMgr_SyseventHandlerFn)(const char *name, const char *val);
+
+#define SYSCFG_RESTART_DEBOUNCE_MS      "wanmanager_restart_debounce_ms"
+#define WANMGR_RESTART_DEBOUNCE_MS_DEF  300
+
 /**********************************************************************
                 FUNCTION PROTOTYPES
 **********************************************************************/
@@ -190,6 +206,25 @@ ANSC_STATUS wanmgr_sysevents_ipv4Info_set(const ipc_dhcpv4_data_t* dhcp4Info, co
 */
 void wanmgr_sysevents_setWanLedState(const char * LedState);
 
+/*
+ * @brief Request a downstream restart (firewall, dhcp server). Requests of the
+ * same kind made within the debounce window are coalesced and the restart
+ * sysevent is emitted once at the end of the window.
+ * @param[in] WanMgr_RestartEvent_t event - Indicates the restart to request
+ * @return Returns NONE.
+*/
+void wanmgr_sysevents_scheduleRestart(WanMgr_RestartEvent_t event);
+
+/*
+ * @brief Register a handler for a sysevent notification. Handlers must be
+ * registered before WanMgr_SysEvents_Init() makes the subscriptions.
+ * @param[in] const char* name - Indicates the sysevent name, must stay valid
+ * @param[in] WanMgr_SyseventHandlerFn fn - Indicates the handler
+ * @param[in] BOOL offload - TRUE if the handler blocks and has to run on the event loop worker
+ * @return Returns ANSC_STATUS.
+*/
+ANSC_STATUS wanmgr_sysevents_registerHandler(const char *name, WanMgr_SyseventHandlerFn fn, BOOL offload);
+
 
 
 //#ifdef FEATURE_MAPT
@@ -383,6 +383,80 @@ int util_getPidByName(const char *name)
    return rval;
 }
 
+int util_getPidByNameAndArg(const char *name, const char *arg)
+{
+   DIR *dir;
+   FILE *fp;
+   struct dirent *dent;
+   int pid, i;
+   int rval = 0;
+   size_t len;
+   char processName[BUFLEN_256];
+   char cmdLine[BUFLEN_1024];
+   char filename[BUFLEN_256];
+
+   if (name == NULL || arg == NULL)
+   {
+      return rval;
+   }
+
+   if (NULL == (dir = opendir("/proc")))
+   {
+      CcspTraceError(("could not open /proc"));
+      return rval;
+   }
+
+   while (rval == 0 && (dent = readdir(dir)) != NULL)
+   {
+      if ((dent->d_type != DT_DIR) ||
+          (RETURN_OK != strtol64(dent->d_name, NULL, 10, (int64_t*)&pid)))
+      {
+         continue;
+      }
+
+      /* processes can exit while we walk /proc, so failures here are silent */
+      snprintf(filename, sizeof(filename), "/proc/%d/stat", pid);
+      if ((fp = fopen(filename, "r")) == NULL)
+      {
+         continue;
+      }
+      memset(processName, 0, sizeof(processName));
+      i = fscanf(fp, "%*d (%255[^)]", processName);
+      fclose(fp);
+      if (i != 1 || strcmp(processName, name) != 0)
+      {
+         continue;
+      }
+
+      snprintf(filename, sizeof(filename), "/proc/%d/cmdline", pid);
+      if ((fp = fopen(filename, "r")) == NULL)
+      {
+         continue;
+      }
+      len = fread(cmdLine, 1, sizeof(cmdLine) - 1, fp);
+      fclose(fp);
+
+      /* arguments are NUL separated, join them like ps does */
+      cmdLine[len] = '\0';
+      for (i = 0; i < (int) len; i++)
+      {
+         if (cmdLine[i] == '\0')
+         {
+            cmdLine[i] = ' ';
+         }
+      }
+
+      if (strstr(cmdLine, arg) != NULL)
+      {
+         rval = pid;
+      }
+   }
+
+   closedir(dir);
+
+   return rval;
+}
+
 int util_collectProcess(int pid, int timeout)
 {
    int32_t rc, status, waitOption=0;
@@ -740,41 +814,6 @@ void WanManager_DoCollectApp(const char *appName)
 
 
 #ifdef FEATURE_IPOE_HEALTH_CHECK
-UINT WanManager_StartIpoeHealthCheckService(const char *ifName)
-{
-    if (ifName == NULL)
-    {
-        CcspTraceError(("could not start %s. Invalid intfername name.\n", IHC_CLIENT_NAME));
-        return 0;
-    }
-
-    int IhcPid = 0;
-    char cmdArgs[BUFLEN_128] = {0};
-
-    snprintf(cmdArgs, BUFLEN_128, "-i %s", ifName);
-    CcspTraceInfo(("%s [%d]: Starting IHC with args - %s %s\n", __FUNCTION__, __LINE__, IHC_CLIENT_NAME, cmdArgs));
-
-    IhcPid = WanManager_DoStartApp(IHC_CLIENT_NAME, cmdArgs);
-    if (IhcPid == 0)
-    {
-        CcspTraceError(("%s [%d]: could not start %s", __FUNCTION__, __LINE__, IHC_CLIENT_NAME));
-        return 0;
-    }
-    return IhcPid;
-}
-
-ANSC_STATUS WanManager_StopIpoeHealthCheckService(UINT IhcPid)
-{
-    if (IhcPid == 0 )
-    {
-        CcspTraceError(("Invalid PID %d. Cannot Stop IHC App.\n", IhcPid));
-        return ANSC_STATUS_FAILURE;
-    }
-    util_signalProcess(IhcPid, SIGTERM);
-    CollectApp(IhcPid);
-    return ANSC_STATUS_SUCCESS;
-}
-
 static ANSC_STATUS readIAPDPrefixFromFile(char *prefix, int buflen, int *plen, int *pltime, int *vltime)
 {
     FILE *fp = NULL;
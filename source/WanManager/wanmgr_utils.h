@@ -49,7 +49,6 @@
 #define MSECS_IN_SEC  1000
 
 #ifdef FEATURE_IPOE_HEALTH_CHECK
-#define IHC_CLIENT_NAME "ipoe_health_check"
 #define DHCP6C_RENEW_PREFIX_FILE    "/tmp/erouter0.dhcpc6c_renew_prefix.conf"
 #endif /* FEATURE_IPOE_HEALTH_CHECK */
 
@@ -107,20 +106,6 @@ int WanManager_DoSystemActionWithStatus(const char* from, char *cmd);
 void CollectApp(int pid);
 
 
-#ifdef FEATURE_IPOE_HEALTH_CHECK
-/***************************************************************************
- * @brief API used to start IPoE health check application.
- * @return PID upon success else returns 0.
- ***************************************************************************/
-UINT WanManager_StartIpoeHealthCheckService();
-
-/***************************************************************************
- * @brief API used to atop IPoE health check application.
- * @return ANSC_STATUS_SUCCESS upon success else returned error code.
- ***************************************************************************/
-ANSC_STATUS WanManager_StopIpoeHealthCheckService(UINT IhcPid);
-#endif //FEATURE_IPOE_HEALTH_CHECK
-
 /***************************************************************************
  * @brief API used to find path of the requested application
  * @param name Name of the application
@@ -148,6 +133,7 @@ int util_spawnProcess(const char *execName, const char *processInfo, int * proce
 int util_terminateProcessForcefully(int32_t pid);
 int util_signalProcess(int32_t pid, int32_t sig);
 int util_getPidByName(const char *name);
+int util_getPidByNameAndArg(const char *name, const char *arg);
 int util_getNameByPid(int pid, char *nameBuf, int nameBufLen);
 int util_collectProcess(int pid, int timeout);
 int util_runCommandInShellBlocking(char *command);
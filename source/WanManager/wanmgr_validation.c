@@ -0,0 +1,856 @@
+/*
+ * If not stated otherwise in this file or this component's Licenses.txt file the
+ * following copyright and licenses apply:
+ *
+ * Copyright 2020 RDK Management
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+*/
+
+/* ---- Include Files ---------------------------------------- */
+#define _GNU_SOURCE     /* struct in6_pktinfo */
+#include <errno.h>
+#include <pthread.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <sys/ioctl.h>
+#include <sys/socket.h>
+#include <sys/timerfd.h>
+#include <net/if.h>
+#include <netinet/in.h>
+#include <netinet/ip.h>
+#include <netinet/udp.h>
+#include <linux/if_packet.h>
+#include <linux/if_ether.h>
+#include <linux/filter.h>
+#include "wanmgr_validation.h"
+#include "wanmgr_event_loop.h"
+
+#define VALIDATION_V4_CLIENT_PORT   68
+#define VALIDATION_V4_SERVER_PORT   67
+#define VALIDATION_V4_MAGIC_COOKIE  0x63825363
+#define VALIDATION_V4_OPTIONS_LEN   308     /* a 548 byte BOOTP message, the minimum a server must accept */
+#define VALIDATION_V4_BOOTREQUEST   1
+#define VALIDATION_V4_BOOTREPLY     2
+#define VALIDATION_V4_DISCOVER      1
+#define VALIDATION_V4_OFFER         2
+#define VALIDATION_V4_OPT_PAD       0
+#define VALIDATION_V4_OPT_MSG_TYPE  53
+#define VALIDATION_V4_OPT_CLIENT_ID 61
+#define VALIDATION_V4_OPT_END       255
+
+#define VALIDATION_V6_CLIENT_PORT   546
+#define VALIDATION_V6_SERVER_PORT   547
+#define VALIDATION_V6_ALL_SERVERS   "ff02::1:2"     /* All_DHCP_Relay_Agents_and_Servers */
+#define VALIDATION_V6_SOLICIT       1
+#define VALIDATION_V6_ADVERTISE     2
+#define VALIDATION_V6_OPT_CLIENTID  1
+#define VALIDATION_V6_OPT_IA_NA     3
+#define VALIDATION_V6_OPT_ELAPSED   8
+#define VALIDATION_V6_OPT_IA_PD     25
+#define VALIDATION_V6_IAID          1
+#define VALIDATION_V6_DUID_LEN      (4 + ETH_ALEN)  /* DUID-LL over Ethernet */
+
+#define VALIDATION_PKT_MAX          1536
+
+typedef struct __attribute__((packed)) _ValidationMsg4_t
+{
+    uint8_t     op;
+    uint8_t     htype;
+    uint8_t     hlen;
+    uint8_t     hops;
+    uint32_t    xid;
+    uint16_t    secs;
+    uint16_t    flags;
+    uint32_t    ciaddr;
+    uint32_t    yiaddr;
+    uint32_t    siaddr;
+    uint32_t    giaddr;
+    uint8_t     chaddr[16];
+    uint8_t     sname[64];
+    uint8_t     file[128];
+    uint32_t    cookie;
+    uint8_t     options[VALIDATION_V4_OPTIONS_LEN];
+} ValidationMsg4_t;
+
+/* One check, DHCPv4 or DHCPv6 */
+typedef struct _ValidationCheck_t
+{
+    BOOL        enabled;
+    BOOL        answered;
+    uint32_t    xid;
+    uint64_t    nextMs;         /* next transmission, 0 for none */
+    UINT        rtMs;
+} ValidationCheck_t;
+
+typedef struct _ValidationSession_t
+{
+    BOOL                        inUse;
+    char                        ifName[IFNAMSIZ];
+    int                         ifIndex;
+    uint8_t                     ifMac[ETH_ALEN];
+    int                         wakeFd;
+    uint64_t                    startMs;
+    uint64_t                    deadlineMs;
+    ValidationCheck_t           v4;
+    ValidationCheck_t           v6;
+    WanMgr_Validation_Result_t  result;
+} ValidationSession_t;
+
+/* ---- Private Variables ------------------------------------ */
+static ValidationSession_t gSessions[WANMGR_VALIDATION_MAX_IFACES];
+static int gTimerFd = -1;
+static int gPktFd = -1;
+static int gRawFd = -1;
+static unsigned int gSeed = 0;
+static BOOL gValidationReady = FALSE;
+static pthread_mutex_t gValidationMutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_once_t gValidationOnce = PTHREAD_ONCE_INIT;
+
+static const uint8_t gBroadcastMac[ETH_ALEN] = { 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF };
+
+/* ---- Private Functions ------------------------------------ */
+
+static uint64_t Validation_NowMs(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t) ts.tv_sec * 1000ULL + (uint64_t) ts.tv_nsec / 1000000ULL;
+}
+
+static uint16_t Validation_Checksum(uint32_t sum, const void *data, size_t len)
+{
+    const uint8_t *p = (const uint8_t *) data;
+
+    while (len > 1)
+    {
+        sum += (uint32_t)((p[0] << 8) | p[1]);
+        p += 2;
+        len -= 2;
+    }
+    if (len > 0)
+    {
+        sum += (uint32_t)(p[0] << 8);
+    }
+    while (sum >> 16)
+    {
+        sum = (sum & 0xFFFF) + (sum >> 16);
+    }
+
+    return htons((uint16_t) ~sum);
+}
+
+/* Next retransmission delay, doubled from the min up to the max */
+static UINT Validation_NextRt(ValidationCheck_t *pCheck)
+{
+    if (pCheck->rtMs == 0)
+    {
+        pCheck->rtMs = WANMGR_VALIDATION_MIN_RT_MS;
+    }
+    else if (pCheck->rtMs < WANMGR_VALIDATION_MAX_RT_MS)
+    {
+        pCheck->rtMs *= 2;
+    }
+    return pCheck->rtMs;
+}
+
+/* Record the result and wake the state machine, called with gValidationMutex held */
+static void Validation_Finish(ValidationSession_t *pSession, WanMgr_Validation_Result_t result, uint64_t now)
+{
+    uint64_t one = 1;
+
+    pSession->result = result;
+    pSession->v4.nextMs = 0;
+    pSession->v6.nextMs = 0;
+
+    if (result == WANMGR_VALIDATION_PASSED)
+    {
+        CcspTraceInfo(("%s %d - %s: validated by %s in %llu ms\n", __FUNCTION__, __LINE__, pSession->ifName,
+                       (pSession->v4.answered == TRUE) ? "DHCPv4 Discover-Offer" : "DHCPv6 Solicit-Advertise",
+                       (unsigned long long)(now - pSession->startMs)));
+    }
+    else
+    {
+        CcspTraceWarning(("%s %d - %s: no DHCP server answered within %d ms\n", __FUNCTION__, __LINE__, pSession->ifName, WANMGR_VALIDATION_TIMEOUT_MS));
+    }
+
+    if (pSession->wakeFd >= 0 && write(pSession->wakeFd, &one, sizeof(one)) != sizeof(one))
+    {
+        CcspTraceWarning(("%s %d - %s: state machine not woken (%s)\n", __FUNCTION__, __LINE__, pSession->ifName, strerror(errno)));
+    }
+}
+
+/* ---- Sending, called with gValidationMutex held ---- */
+
+/* The interface index and MAC are looked up on every send, the interface can be created late or flap */
+static BOOL Validation_GetLink(ValidationSession_t *pSession)
+{
+    struct ifreq ifr;
+
+    if ((pSession->ifIndex = if_nametoindex(pSession->ifName)) == 0)
+    {
+        return FALSE;
+    }
+
+    memset(&ifr, 0, sizeof(ifr));
+    snprintf(ifr.ifr_name, sizeof(ifr.ifr_name), "%s", pSession->ifName);
+    if (ioctl(gPktFd, SIOCGIFHWADDR, &ifr) < 0)
+    {
+        return FALSE;
+    }
+    memcpy(pSession->ifMac, ifr.ifr_hwaddr.sa_data, ETH_ALEN);
+    return TRUE;
+}
+
+static void Validation_SendDiscover(ValidationSession_t *pSession, uint64_t now)
+{
+    uint8_t pkt[sizeof(struct iphdr) + sizeof(struct udphdr) + sizeof(ValidationMsg4_t)];
+    uint8_t clientId[1 + ETH_ALEN];
+    uint8_t type = VALIDATION_V4_DISCOVER;
+    struct sockaddr_ll sll;
+    struct iphdr ip;
+    struct udphdr udp;
+    ValidationMsg4_t msg;
+    uint8_t *pOpt;
+    uint32_t sum;
+
+    memset(&msg, 0, sizeof(msg));
+    msg.op = VALIDATION_V4_BOOTREQUEST;
+    msg.htype = 1;
+    msg.hlen = ETH_ALEN;
+    msg.xid = pSession->v4.xid;
+    msg.secs = htons((uint16_t)((now - pSession->startMs) / 1000));
+    msg.flags = htons(0x8000);      //broadcast, nothing is configured from the OFFER
+    msg.cookie = htonl(VALIDATION_V4_MAGIC_COOKIE);
+    memcpy(msg.chaddr, pSession->ifMac, ETH_ALEN);
+
+    clientId[0] = 1;
+    memcpy(clientId + 1, pSession->ifMac, ETH_ALEN);
+    pOpt = msg.options;
+    *pOpt++ = VALIDATION_V4_OPT_MSG_TYPE;
+    *pOpt++ = 1;
+    *pOpt++ = type;
+    *pOpt++ = VALIDATION_V4_OPT_CLIENT_ID;
+    *pOpt++ = sizeof(clientId);
+    memcpy(pOpt, clientId, sizeof(clientId));
+    pOpt += sizeof(clientId);
+    *pOpt = VALIDATION_V4_OPT_END;
+
+    memset(&ip, 0, sizeof(ip));
+    ip.version = 4;
+    ip.ihl = sizeof(ip) / 4;
+    ip.tot_len = htons(sizeof(pkt));
+    ip.id = htons((uint16_t) rand_r(&gSeed));
+    ip.ttl = 64;
+    ip.protocol = IPPROTO_UDP;
+    ip.saddr = htonl(INADDR_ANY);
+    ip.daddr = htonl(INADDR_BROADCAST);
+    ip.check = Validation_Checksum(0, &ip, sizeof(ip));
+
+    memset(&udp, 0, sizeof(udp));
+    udp.source = htons(VALIDATION_V4_CLIENT_PORT);
+    udp.dest = htons(VALIDATION_V4_SERVER_PORT);
+    udp.len = htons(sizeof(udp) + sizeof(msg));
+
+    //UDP checksum over the pseudo header first, the source address is 0
+    sum = 0xFFFF + 0xFFFF + IPPROTO_UDP + ntohs(udp.len);
+    memcpy(pkt + sizeof(ip), &udp, sizeof(udp));
+    memcpy(pkt + sizeof(ip) + sizeof(udp), &msg, sizeof(msg));
+    udp.check = Validation_Checksum(sum, pkt + sizeof(ip), sizeof(udp) + sizeof(msg));
+    if (udp.check == 0)
+    {
+        udp.check = 0xFFFF;
+    }
+    memcpy(pkt, &ip, sizeof(ip));
+    memcpy(pkt + sizeof(ip), &udp, sizeof(udp));
+
+    memset(&sll, 0, sizeof(sll));
+    sll.sll_family = AF_PACKET;
+    sll.sll_protocol = htons(ETH_P_IP);
+    sll.sll_ifindex = pSession->ifIndex;
+    sll.sll_halen = ETH_ALEN;
+    memcpy(sll.sll_addr, gBroadcastMac, ETH_ALEN);
+
+    if (sendto(gPktFd, pkt, sizeof(pkt), 0, (struct sockaddr *) &sll, sizeof(sll)) < 0)
+    {
+        CcspTraceWarning(("%s %d - %s: DISCOVER not sent (%s)\n", __FUNCTION__, __LINE__, pSession->ifName, strerror(errno)));
+    }
+}
+
+static uint8_t *Validation_AddOption6(uint8_t *pOpt, uint16_t code, const void *data, uint16_t len)
+{
+    pOpt[0] = (uint8_t)(code >> 8);
+    pOpt[1] = (uint8_t) code;
+    pOpt[2] = (uint8_t)(len >> 8);
+    pOpt[3] = (uint8_t) len;
+    if (len > 0)
+    {
+        memcpy(pOpt + 4, data, len);
+    }
+    return pOpt + 4 + len;
+}
+
+/* DUID-LL of the interface, the same on every retransmission and answer */
+static void Validation_GetDuid(const ValidationSession_t *pSession, uint8_t *pDuid)
+{
+    pDuid[0] = 0;
+    pDuid[1] = 3;
+    pDuid[2] = 0;
+    pDuid[3] = 1;
+    memcpy(pDuid + 4, pSession->ifMac, ETH_ALEN);
+}
+
+/* Sent from a raw socket, the client port is left to the DHCPv6 client of the interface */
+static void Validation_SendSolicit(ValidationSession_t *pSession, uint64_t now)
+{
+    uint8_t pkt[sizeof(struct udphdr) + 128];
+    uint8_t duid[VALIDATION_V6_DUID_LEN];
+    uint8_t ia[12];
+    uint8_t elapsed[2];
+    uint64_t elapsedCs = (now - pSession->startMs) / 10;
+    struct sockaddr_in6 dst;
+    struct udphdr udp;
+    uint8_t *pMsg = pkt + sizeof(udp);
+    uint8_t *pOpt;
+
+    pMsg[0] = VALIDATION_V6_SOLICIT;
+    pMsg[1] = (uint8_t)(pSession->v6.xid >> 16);
+    pMsg[2] = (uint8_t)(pSession->v6.xid >> 8);
+    pMsg[3] = (uint8_t) pSession->v6.xid;
+
+    Validation_GetDuid(pSession, duid);
+    pOpt = Validation_AddOption6(pMsg + 4, VALIDATION_V6_OPT_CLIENTID, duid, sizeof(duid));
+    if (elapsedCs > 0xFFFF)
+    {
+        elapsedCs = 0xFFFF;
+    }
+    elapsed[0] = (uint8_t)(elapsedCs >> 8);
+    elapsed[1] = (uint8_t) elapsedCs;
+    pOpt = Validation_AddOption6(pOpt, VALIDATION_V6_OPT_ELAPSED, elapsed, sizeof(elapsed));
+
+    //Servers may not answer a SOLICIT without an IA, times are left to the server
+    memset(ia, 0, sizeof(ia));
+    ia[3] = VALIDATION_V6_IAID;
+    pOpt = Validation_AddOption6(pOpt, VALIDATION_V6_OPT_IA_NA, ia, sizeof(ia));
+    pOpt = Validation_AddOption6(pOpt, VALIDATION_V6_OPT_IA_PD, ia, sizeof(ia));
+
+    //The kernel fills in the checksum (IPV6_CHECKSUM)
+    memset(&udp, 0, sizeof(udp));
+    udp.source = htons(VALIDATION_V6_CLIENT_PORT);
+    udp.dest = htons(VALIDATION_V6_SERVER_PORT);
+    udp.len = htons(pOpt - pkt);
+    memcpy(pkt, &udp, sizeof(udp));
+
+    memset(&dst, 0, sizeof(dst));
+    dst.sin6_family = AF_INET6;
+    dst.sin6_scope_id = pSession->ifIndex;
+    inet_pton(AF_INET6, VALIDATION_V6_ALL_SERVERS, &dst.sin6_addr);
+
+    //Fails until the link local address has passed DAD, the retransmission covers that
+    if (sendto(gRawFd, pkt, pOpt - pkt, 0, (struct sockaddr *) &dst, sizeof(dst)) < 0)
+    {
+        CcspTraceWarning(("%s %d - %s: SOLICIT not sent (%s)\n", __FUNCTION__, __LINE__, pSession->ifName, strerror(errno)));
+    }
+}
+
+static void Validation_OnDeadline(ValidationSession_t *pSession, uint64_t now)
+{
+    BOOL linkReady;
+
+    if (now >= pSession->deadlineMs)
+    {
+        Validation_Finish(pSession, WANMGR_VALIDATION_FAILED, now);
+        return;
+    }
+
+    linkReady = Validation_GetLink(pSession);
+
+    if (pSession->v4.nextMs != 0 && pSession->v4.nextMs <= now)
+    {
+        if (linkReady == TRUE)
+        {
+            Validation_SendDiscover(pSession, now);
+        }
+        pSession->v4.nextMs = now + Validation_NextRt(&pSession->v4);
+    }
+    if (pSession->v6.nextMs != 0 && pSession->v6.nextMs <= now)
+    {
+        if (linkReady == TRUE)
+        {
+            Validation_SendSolicit(pSession, now);
+        }
+        pSession->v6.nextMs = now + Validation_NextRt(&pSession->v6);
+    }
+}
+
+/* ---- Receiving ---- */
+
+/* Arm the timer for the earliest session, called with gValidationMutex held */
+static void Validation_ArmTimer(void)
+{
+    struct itimerspec its;
+    uint64_t next = 0;
+    int idx;
+
+    for (idx = 0; idx < WANMGR_VALIDATION_MAX_IFACES; idx++)
+    {
+        ValidationSession_t *pSession = &gSessions[idx];
+        uint64_t deadlines[3];
+        int i;
+
+        if (pSession->inUse != TRUE || pSession->result != WANMGR_VALIDATION_PENDING)
+        {
+            continue;
+        }
+
+        deadlines[0] = pSession->v4.nextMs;
+        deadlines[1] = pSession->v6.nextMs;
+        deadlines[2] = pSession->deadlineMs;
+        for (i = 0; i < 3; i++)
+        {
+            if (deadlines[i] != 0 && (next == 0 || deadlines[i] < next))
+            {
+                next = deadlines[i];
+            }
+        }
+    }
+
+    memset(&its, 0, sizeof(its));
+    if (next != 0)
+    {
+        its.it_value.tv_sec = next / 1000;
+        its.it_value.tv_nsec = (long)(next % 1000) * 1000000L;
+    }
+    timerfd_settime(gTimerFd, TFD_TIMER_ABSTIME, &its, NULL);
+}
+
+/* A check answered, called with gValidationMutex held */
+static void Validation_OnAnswer(ValidationSession_t *pSession, ValidationCheck_t *pCheck, const char *pFrom)
+{
+    uint64_t now = Validation_NowMs();
+
+    CcspTraceInfo(("%s %d - %s: %s from %s\n", __FUNCTION__, __LINE__, pSession->ifName,
+                   (pCheck == &pSession->v4) ? "OFFER" : "ADVERTISE", pFrom));
+    pCheck->answered = TRUE;
+    Validation_Finish(pSession, WANMGR_VALIDATION_PASSED, now);
+}
+
+/* Message type of a BOOTREPLY, 0 if there is none */
+static uint8_t Validation_GetMsgType4(const ValidationMsg4_t *pMsg, size_t msgLen)
+{
+    const uint8_t *p = pMsg->options;
+    size_t len = msgLen - offsetof(ValidationMsg4_t, options);
+    size_t off = 0;
+
+    while (off < len && p[off] != VALIDATION_V4_OPT_END)
+    {
+        if (p[off] == VALIDATION_V4_OPT_PAD)
+        {
+            off++;
+            continue;
+        }
+        if (off + 2 > len || off + 2 + p[off + 1] > len)
+        {
+            break;
+        }
+        if (p[off] == VALIDATION_V4_OPT_MSG_TYPE && p[off + 1] == 1)
+        {
+            return p[off + 2];
+        }
+        off += 2 + p[off + 1];
+    }
+    return 0;
+}
+
+static void Validation_OnPacket4(int fd, uint32_t events, void *arg)
+{
+    uint8_t pkt[VALIDATION_PKT_MAX];
+    const struct iphdr *pIp = (const struct iphdr *) pkt;
+    const ValidationMsg4_t *pMsg;
+    struct sockaddr_ll sll;
+    socklen_t sllLen;
+    size_t ipLen;
+    size_t totLen;
+    int len;
+    int idx;
+
+    for (;;)
+    {
+        sllLen = sizeof(sll);
+        if ((len = recvfrom(fd, pkt, sizeof(pkt), 0, (struct sockaddr *) &sll, &sllLen)) < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            break;
+        }
+
+        if (len < (int) sizeof(struct iphdr) || pIp->version != 4)
+        {
+            continue;
+        }
+        ipLen = pIp->ihl * 4;
+        totLen = ntohs(pIp->tot_len);
+        if (ipLen < sizeof(struct iphdr) || totLen > (size_t) len ||
+            totLen < ipLen + sizeof(struct udphdr) + offsetof(ValidationMsg4_t, options))
+        {
+            continue;
+        }
+        pMsg = (const ValidationMsg4_t *)(pkt + ipLen + sizeof(struct udphdr));
+        if (pMsg->op != VALIDATION_V4_BOOTREPLY || pMsg->cookie != htonl(VALIDATION_V4_MAGIC_COOKIE) ||
+            Validation_GetMsgType4(pMsg, totLen - ipLen - sizeof(struct udphdr)) != VALIDATION_V4_OFFER)
+        {
+            continue;
+        }
+
+        pthread_mutex_lock(&gValidationMutex);
+        for (idx = 0; idx < WANMGR_VALIDATION_MAX_IFACES; idx++)
+        {
+            ValidationSession_t *pSession = &gSessions[idx];
+
+            if (pSession->inUse == TRUE && pSession->result == WANMGR_VALIDATION_PENDING && pSession->v4.enabled == TRUE &&
+                pSession->ifIndex == sll.sll_ifindex && pSession->v4.xid == pMsg->xid &&
+                memcmp(pMsg->chaddr, pSession->ifMac, ETH_ALEN) == 0)
+            {
+                char from[INET_ADDRSTRLEN] = {0};
+
+                inet_ntop(AF_INET, &pIp->saddr, from, sizeof(from));
+                Validation_OnAnswer(pSession, &pSession->v4, from);
+                break;
+            }
+        }
+        Validation_ArmTimer();
+        pthread_mutex_unlock(&gValidationMutex);
+    }
+}
+
+/* TRUE if the DHCPv6 message carries the client identifier of the session */
+static BOOL Validation_HasDuid(const uint8_t *pMsg, size_t len, const ValidationSession_t *pSession)
+{
+    uint8_t duid[VALIDATION_V6_DUID_LEN];
+    size_t off = 4;
+
+    Validation_GetDuid(pSession, duid);
+    while (off + 4 <= len)
+    {
+        uint16_t code = (uint16_t)((pMsg[off] << 8) | pMsg[off + 1]);
+        uint16_t optLen = (uint16_t)((pMsg[off + 2] << 8) | pMsg[off + 3]);
+
+        if (off + 4 + optLen > len)
+        {
+            break;
+        }
+        if (code == VALIDATION_V6_OPT_CLIENTID)
+        {
+            return (optLen == sizeof(duid) && memcmp(pMsg + off + 4, duid, sizeof(duid)) == 0) ? TRUE : FALSE;
+        }
+        off += 4 + optLen;
+    }
+    return FALSE;
+}
+
+/* The raw socket gets the UDP header on, the checksum is already verified */
+static void Validation_OnPacket6(int fd, uint32_t events, void *arg)
+{
+    uint8_t pkt[VALIDATION_PKT_MAX];
+    uint8_t control[CMSG_SPACE(sizeof(struct in6_pktinfo))];
+    const uint8_t *pMsg = pkt + sizeof(struct udphdr);
+    struct sockaddr_in6 from;
+    struct cmsghdr *pCmsg;
+    struct msghdr msg;
+    struct udphdr udp;
+    struct iovec iov;
+    uint32_t xid;
+    int ifIndex;
+    int len;
+    int idx;
+
+    for (;;)
+    {
+        iov.iov_base = pkt;
+        iov.iov_len = sizeof(pkt);
+        memset(&msg, 0, sizeof(msg));
+        msg.msg_name = &from;
+        msg.msg_namelen = sizeof(from);
+        msg.msg_iov = &iov;
+        msg.msg_iovlen = 1;
+        msg.msg_control = control;
+        msg.msg_controllen = sizeof(control);
+
+        if ((len = recvmsg(fd, &msg, 0)) < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            break;
+        }
+
+        if (len < (int)(sizeof(udp) + 4))
+        {
+            continue;
+        }
+        memcpy(&udp, pkt, sizeof(udp));
+        if (udp.source != htons(VALIDATION_V6_SERVER_PORT) || pMsg[0] != VALIDATION_V6_ADVERTISE)
+        {
+            continue;
+        }
+        xid = ((uint32_t) pMsg[1] << 16) | ((uint32_t) pMsg[2] << 8) | pMsg[3];
+
+        ifIndex = 0;
+        for (pCmsg = CMSG_FIRSTHDR(&msg); pCmsg != NULL; pCmsg = CMSG_NXTHDR(&msg, pCmsg))
+        {
+            if (pCmsg->cmsg_level == IPPROTO_IPV6 && pCmsg->cmsg_type == IPV6_PKTINFO)
+            {
+                ifIndex = ((struct in6_pktinfo *) CMSG_DATA(pCmsg))->ipi6_ifindex;
+            }
+        }
+
+        pthread_mutex_lock(&gValidationMutex);
+        for (idx = 0; idx < WANMGR_VALIDATION_MAX_IFACES; idx++)
+        {
+            ValidationSession_t *pSession = &gSessions[idx];
+
+            if (pSession->inUse == TRUE && pSession->result == WANMGR_VALIDATION_PENDING && pSession->v6.enabled == TRUE &&
+                pSession->ifIndex == ifIndex && pSession->v6.xid == xid &&
+                Validation_HasDuid(pMsg, len - sizeof(udp), pSession) == TRUE)
+            {
+                char addr[INET6_ADDRSTRLEN] = {0};
+
+                inet_ntop(AF_INET6, &from.sin6_addr, addr, sizeof(addr));
+                Validation_OnAnswer(pSession, &pSession->v6, addr);
+                break;
+            }
+        }
+        Validation_ArmTimer();
+        pthread_mutex_unlock(&gValidationMutex);
+    }
+}
+
+static void Validation_OnTimer(int fd, uint32_t events, void *arg)
+{
+    uint64_t expirations;
+    uint64_t now;
+    int idx;
+
+    if (read(fd, &expirations, sizeof(expirations)) != sizeof(expirations))
+    {
+        return;
+    }
+
+    pthread_mutex_lock(&gValidationMutex);
+    now = Validation_NowMs();
+    for (idx = 0; idx < WANMGR_VALIDATION_MAX_IFACES; idx++)
+    {
+        ValidationSession_t *pSession = &gSessions[idx];
+
+        if (pSession->inUse == TRUE && pSession->result == WANMGR_VALIDATION_PENDING)
+        {
+            Validation_OnDeadline(pSession, now);
+        }
+    }
+    Validation_ArmTimer();
+    pthread_mutex_unlock(&gValidationMutex);
+}
+
+/* ---- Setup ---- */
+
+static void Validation_Init(void)
+{
+    /* Runs on the packet from the IP header: UDP, not a fragment, to the client port, not our own */
+    struct sock_filter filter4[] =
+    {
+        BPF_STMT(BPF_LD | BPF_W | BPF_ABS, SKF_AD_OFF + SKF_AD_PKTTYPE),
+        BPF_JUMP(BPF_JMP | BPF_JEQ | BPF_K, PACKET_OUTGOING, 8, 0),
+        BPF_STMT(BPF_LD | BPF_B | BPF_ABS, 9),
+        BPF_JUMP(BPF_JMP | BPF_JEQ | BPF_K, IPPROTO_UDP, 0, 6),
+        BPF_STMT(BPF_LD | BPF_H | BPF_ABS, 6),
+        BPF_JUMP(BPF_JMP | BPF_JSET | BPF_K, 0x1FFF, 4, 0),
+        BPF_STMT(BPF_LDX | BPF_B | BPF_MSH, 0),
+        BPF_STMT(BPF_LD | BPF_H | BPF_IND, 2),
+        BPF_JUMP(BPF_JMP | BPF_JEQ | BPF_K, VALIDATION_V4_CLIENT_PORT, 0, 1),
+        BPF_STMT(BPF_RET | BPF_K, 0xFFFF),
+        BPF_STMT(BPF_RET | BPF_K, 0),
+    };
+    /* Runs on the UDP header, the raw socket sees every UDP packet to this host otherwise */
+    struct sock_filter filter6[] =
+    {
+        BPF_STMT(BPF_LD | BPF_H | BPF_ABS, 2),
+        BPF_JUMP(BPF_JMP | BPF_JEQ | BPF_K, VALIDATION_V6_CLIENT_PORT, 0, 1),
+        BPF_STMT(BPF_RET | BPF_K, 0xFFFF),
+        BPF_STMT(BPF_RET | BPF_K, 0),
+    };
+    struct sock_fprog prog4 = { sizeof(filter4) / sizeof(filter4[0]), filter4 };
+    struct sock_fprog prog6 = { sizeof(filter6) / sizeof(filter6[0]), filter6 };
+    int csumOffset = offsetof(struct udphdr, check);
+    int on = 1;
+
+    gSeed = (unsigned int)(Validation_NowMs() ^ (uint64_t) getpid());
+
+    if ((gTimerFd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC)) < 0 ||
+        (gPktFd = socket(AF_PACKET, SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC, htons(ETH_P_IP))) < 0 ||
+        (gRawFd = socket(AF_INET6, SOCK_RAW | SOCK_NONBLOCK | SOCK_CLOEXEC, IPPROTO_UDP)) < 0)
+    {
+        CcspTraceError(("%s %d - validation sockets failed (%s)\n", __FUNCTION__, __LINE__, strerror(errno)));
+        return;
+    }
+
+    if (setsockopt(gPktFd, SOL_SOCKET, SO_ATTACH_FILTER, &prog4, sizeof(prog4)) < 0 ||
+        setsockopt(gRawFd, SOL_SOCKET, SO_ATTACH_FILTER, &prog6, sizeof(prog6)) < 0 ||
+        setsockopt(gRawFd, IPPROTO_IPV6, IPV6_CHECKSUM, &csumOffset, sizeof(csumOffset)) < 0 ||
+        setsockopt(gRawFd, IPPROTO_IPV6, IPV6_RECVPKTINFO, &on, sizeof(on)) < 0)
+    {
+        CcspTraceError(("%s %d - validation socket options failed (%s)\n", __FUNCTION__, __LINE__, strerror(errno)));
+        return;
+    }
+
+    if (WanMgr_EventLoop_AddFd(gTimerFd, "validation-timer", Validation_OnTimer, NULL) != ANSC_STATUS_SUCCESS ||
+        WanMgr_EventLoop_AddFd(gPktFd, "validation-dhcpv4", Validation_OnPacket4, NULL) != ANSC_STATUS_SUCCESS ||
+        WanMgr_EventLoop_AddFd(gRawFd, "validation-dhcpv6", Validation_OnPacket6, NULL) != ANSC_STATUS_SUCCESS)
+    {
+        return;
+    }
+
+    gValidationReady = TRUE;
+}
+
+/* Session of ifName, called with gValidationMutex held */
+static int Validation_FindSession(const char *ifName)
+{
+    int idx;
+
+    for (idx = 0; idx < WANMGR_VALIDATION_MAX_IFACES; idx++)
+    {
+        if (gSessions[idx].inUse == TRUE && strcmp(gSessions[idx].ifName, ifName) == 0)
+        {
+            return idx;
+        }
+    }
+    return -1;
+}
+
+/* ---- Public Functions ------------------------------------- */
+
+ANSC_STATUS WanMgr_Validation_Start(const char *ifName, BOOL discoverOffer, BOOL solicitAdvertise, int wakeFd)
+{
+    ValidationSession_t *pSession;
+    uint64_t now;
+    int idx;
+
+    if (ifName == NULL || ifName[0] == '\0' || (discoverOffer != TRUE && solicitAdvertise != TRUE))
+    {
+        return ANSC_STATUS_BAD_PARAMETER;
+    }
+
+    pthread_once(&gValidationOnce, Validation_Init);
+    if (gValidationReady != TRUE)
+    {
+        CcspTraceError(("%s %d - WAN validation unavailable\n", __FUNCTION__, __LINE__));
+        return ANSC_STATUS_FAILURE;
+    }
+
+    pthread_mutex_lock(&gValidationMutex);
+    if (Validation_FindSession(ifName) >= 0)
+    {
+        pthread_mutex_unlock(&gValidationMutex);
+        CcspTraceInfo(("%s %d - %s already being validated\n", __FUNCTION__, __LINE__, ifName));
+        return ANSC_STATUS_SUCCESS;
+    }
+
+    for (idx = 0; idx < WANMGR_VALIDATION_MAX_IFACES; idx++)
+    {
+        if (gSessions[idx].inUse != TRUE)
+        {
+            break;
+        }
+    }
+
+    if (idx >= WANMGR_VALIDATION_MAX_IFACES)
+    {
+        pthread_mutex_unlock(&gValidationMutex);
+        CcspTraceError(("%s %d - no free validation session for %s\n", __FUNCTION__, __LINE__, ifName));
+        return ANSC_STATUS_RESOURCES;
+    }
+
+    now = Validation_NowMs();
+    pSession = &gSessions[idx];
+    memset(pSession, 0, sizeof(ValidationSession_t));
+    snprintf(pSession->ifName, sizeof(pSession->ifName), "%s", ifName);
+    pSession->inUse = TRUE;
+    pSession->wakeFd = wakeFd;
+    pSession->startMs = now;
+    pSession->deadlineMs = now + WANMGR_VALIDATION_TIMEOUT_MS;
+    pSession->result = WANMGR_VALIDATION_PENDING;
+    pSession->v4.enabled = discoverOffer;
+    pSession->v4.xid = (uint32_t) rand_r(&gSeed);
+    pSession->v4.nextMs = (discoverOffer == TRUE) ? now : 0;
+    pSession->v6.enabled = solicitAdvertise;
+    pSession->v6.xid = (uint32_t) rand_r(&gSeed) & 0xFFFFFF;
+    pSession->v6.nextMs = (solicitAdvertise == TRUE) ? now : 0;
+    Validation_ArmTimer();
+    pthread_mutex_unlock(&gValidationMutex);
+
+    CcspTraceInfo(("%s %d - validating %s:%s%s\n", __FUNCTION__, __LINE__, ifName,
+                   (discoverOffer == TRUE) ? " Discover-Offer" : "", (solicitAdvertise == TRUE) ? " Solicit-Advertise" : ""));
+    return ANSC_STATUS_SUCCESS;
+}
+
+ANSC_STATUS WanMgr_Validation_Stop(const char *ifName)
+{
+    int idx;
+
+    pthread_mutex_lock(&gValidationMutex);
+    for (idx = 0; idx < WANMGR_VALIDATION_MAX_IFACES; idx++)
+    {
+        if (gSessions[idx].inUse == TRUE && (ifName == NULL || strcmp(gSessions[idx].ifName, ifName) == 0))
+        {
+            gSessions[idx].inUse = FALSE;
+        }
+    }
+
+    if (gValidationReady == TRUE)
+    {
+        Validation_ArmTimer();
+    }
+    pthread_mutex_unlock(&gValidationMutex);
+
+    return ANSC_STATUS_SUCCESS;
+}
+
+WanMgr_Validation_Result_t WanMgr_Validation_GetResult(const char *ifName)
+{
+    WanMgr_Validation_Result_t result = WANMGR_VALIDATION_FAILED;
+    int idx;
+
+    if (ifName == NULL)
+    {
+        return result;
+    }
+
+    pthread_mutex_lock(&gValidationMutex);
+    if ((idx = Validation_FindSession(ifName)) >= 0)
+    {
+        result = gSessions[idx].result;
+    }
+    pthread_mutex_unlock(&gValidationMutex);
+
+    return result;
+}
@@ -0,0 +1,78 @@
+/*
+ * If not stated otherwise in this file or this component's Licenses.txt file the
+ * following copyright and licenses apply:
+ *
+ * Copyright 2020 RDK Management
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+*/
+
+#ifndef _WANMGR_VALIDATION_H_
+#define _WANMGR_VALIDATION_H_
+
+/* WAN validation. Before the DHCP clients of an interface are started, a
+ * DHCPv4 DISCOVER and a DHCPv6 SOLICIT are sent on it, as enabled by the
+ * Wan.Validation flags, and retransmitted until a server answers with an
+ * OFFER or an ADVERTISE. Nothing is accepted or requested, the answers only
+ * show a DHCP service is reachable over the link. The interface passes as
+ * soon as one enabled check is answered and fails when none is answered by
+ * the deadline. Both checks of every interface run concurrently on the
+ * event loop, the state machine is woken through an eventfd on the result. */
+
+/* ---- Include Files ---------------------------------------- */
+#include "ansc_platform.h"
+
+/* ---- Global Constants -------------------------------------- */
+#define WANMGR_VALIDATION_MAX_IFACES        8
+#define WANMGR_VALIDATION_TIMEOUT_MS        10000   /* deadline for an answer to any check */
+#define WANMGR_VALIDATION_MIN_RT_MS         1000    /* first retransmission, doubled up to the max */
+#define WANMGR_VALIDATION_MAX_RT_MS         4000
+
+/* ---- Global Types -------------------------------------------- */
+typedef enum
+{
+    WANMGR_VALIDATION_PENDING = 0,
+    WANMGR_VALIDATION_PASSED,
+    WANMGR_VALIDATION_FAILED
+} WanMgr_Validation_Result_t;
+
+/* ---- Global Prototypes -------------------------------------- */
+
+/***************************************************************************
+ * @brief Start validating an interface. The checks are sent right away,
+ * nothing is done if the interface is already being validated.
+ * @param ifName WAN interface name
+ * @param discoverOffer TRUE to run the DHCPv4 Discover-Offer check
+ * @param solicitAdvertise TRUE to run the DHCPv6 Solicit-Advertise check
+ * @param wakeFd eventfd written once the result is known, -1 for none
+ * @return ANSC_STATUS_SUCCESS upon success else returned error code.
+ ****************************************************************************/
+ANSC_STATUS WanMgr_Validation_Start(const char *ifName, BOOL discoverOffer, BOOL solicitAdvertise, int wakeFd);
+
+/***************************************************************************
+ * @brief Stop validating an interface. Its wake fd is not written to once
+ * this returns.
+ * @param ifName WAN interface name, NULL for every interface
+ * @return ANSC_STATUS_SUCCESS upon success else returned error code.
+ ****************************************************************************/
+ANSC_STATUS WanMgr_Validation_Stop(const char *ifName);
+
+/***************************************************************************
+ * @brief Get the validation result of an interface, without blocking.
+ * @param ifName WAN interface name
+ * @return the result, WANMGR_VALIDATION_FAILED if the interface is not
+ * being validated.
+ ****************************************************************************/
+WanMgr_Validation_Result_t WanMgr_Validation_GetResult(const char *ifName);
+
+#endif /* _WANMGR_VALIDATION_H_ */